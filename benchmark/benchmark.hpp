@@ -0,0 +1,390 @@
+#ifndef XSOUND_BENCHMARK_HPP
+#define XSOUND_BENCHMARK_HPP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+#include <vector>
+#include <initializer_list>
+
+// Exported by every WebAssembly Module (number of allocations by kernels)
+extern "C" size_t get_number_of_allocations(void);
+
+// Exported by every WebAssembly Module (generation of memory layout for views of JavaScript)
+extern "C" size_t get_memory_generation(void);
+
+// Minimum measuring time per kernel (seconds)
+static const double benchmark_seconds = 0.2;
+
+// Number of failed golden checks (exit status)
+static int number_of_failures = 0;
+
+// `--check` runs golden checks only (for `ctest`)
+static bool is_check_only(const int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--check") == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void print_benchmark_header(void) {
+  printf("%-40s %8s %14s %12s %18s\n", "kernel", "size", "ns/call", "ns/sample", "allocations/call");
+}
+
+// Call `kernel` repeatedly for `benchmark_seconds` at least, then report cost per call and per sample.
+// The first call is excluded (it may build plans and allocate scratch buffers).
+template <typename Kernel>
+static void benchmark(const char *const name, const size_t size, const size_t samples_per_call, Kernel kernel) {
+  kernel();
+
+  const size_t allocations = get_number_of_allocations();
+
+  size_t number_of_calls = 0;
+  size_t batch           = 1;
+
+  double elapsed = 0.0;
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  while (elapsed < benchmark_seconds) {
+    for (size_t i = 0; i < batch; i++) {
+      kernel();
+    }
+
+    number_of_calls += batch;
+
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (batch < 1024) {
+      batch *= 2;
+    }
+  }
+
+  const double ns_per_call          = (elapsed * 1e9) / number_of_calls;
+  const double ns_per_sample        = ns_per_call / samples_per_call;
+  const double allocations_per_call = (double)(get_number_of_allocations() - allocations) / number_of_calls;
+
+  printf("%-40s %8zu %14.1f %12.3f %18.3f\n", name, size, ns_per_call, ns_per_sample, allocations_per_call);
+}
+
+// Compare `actuals` with `expecteds` (golden output).
+// Tolerance is relative to peak of `expecteds` (absolute if peak is less than 1).
+static bool check(const char *const name, const size_t size, const float *const actuals, const double *const expecteds, const size_t length, const double tolerance) {
+  double peak = 1.0;
+  double diff = 0.0;
+
+  for (size_t n = 0; n < length; n++) {
+    peak = fmax(peak, fabs(expecteds[n]));
+    diff = fmax(diff, fabs(actuals[n] - expecteds[n]));
+  }
+
+  // NaN never passes
+  const bool passed = (diff / peak) <= tolerance;
+
+  printf("%s %-40s %8zu max diff %.3e (tolerance %.1e)\n", (passed ? "PASS" : "FAIL"), name, size, (diff / peak), tolerance);
+
+  if (!passed) {
+    ++number_of_failures;
+  }
+
+  return passed;
+}
+
+// Compare count (e.g. the number of skipped frames) with expected count
+static bool check_count(const char *const name, const size_t size, const size_t actual, const size_t expected) {
+  const bool passed = actual == expected;
+
+  printf("%s %-40s %8zu count %zu (expected %zu)\n", (passed ? "PASS" : "FAIL"), name, size, actual, expected);
+
+  if (!passed) {
+    ++number_of_failures;
+  }
+
+  return passed;
+}
+
+// Streaming API rejects frame sizes that are not multiple of render quantum size (e.g. 480 and 960 of mixed-radix FFT),
+// so buffers of render quanta and outputs are `nullptr` instead of being read and written out of bounds.
+static bool check_rejected_stream(const char *const name, const size_t size, const std::initializer_list<const float *> pointers) {
+  size_t number_of_buffers = 0;
+
+  for (const float *pointer : pointers) {
+    if (pointer != nullptr) {
+      ++number_of_buffers;
+    }
+  }
+
+  return check_count(name, size, number_of_buffers, 0);
+}
+
+// Buffers that JavaScript views are allocated once. `process()` returns the same pointer as `outputs()` every call
+// and does not change generation of memory layout, and `reallocate()` (e.g. the number of channels) changes it.
+template <typename Outputs, typename Process, typename Reallocate>
+static void check_stable_buffers(const char *const name, const size_t size, Outputs outputs, Process process, Reallocate reallocate) {
+  const size_t generation = get_memory_generation();
+
+  const float *pointer = outputs();
+
+  size_t number_of_moved_outputs = 0;
+
+  for (size_t n = 0; n < 64; n++) {
+    if (process() != pointer) {
+      ++number_of_moved_outputs;
+    }
+  }
+
+  check_count(name, size, number_of_moved_outputs, 0);
+  check_count(name, size, (get_memory_generation() - generation), 0);
+
+  reallocate();
+
+  check_count(name, size, ((get_memory_generation() != generation) ? 1 : 0), 1);
+}
+
+// Deterministic test signal (sum of sinusoids and small noise)
+static void generate_signal(float *const signal, const size_t size, const unsigned int seed) {
+  unsigned int state = seed;
+
+  for (size_t n = 0; n < size; n++) {
+    state = (1664525u * state) + 1013904223u;
+
+    const double noise = ((double)(state >> 8) / 16777216.0) - 0.5;
+
+    signal[n] = (float)((0.5 * sin(0.031 * n * (1 + (seed % 3))))
+                      + (0.25 * sin((0.173 * n) + seed))
+                      + (0.125 * cos(0.547 * n))
+                      + (0.01 * noise));
+  }
+}
+
+// Hanning window as `window_function` in `FFT.hpp` (odd indexes are offset by half a sample)
+static void reference_hanning_window(double *const window, const size_t size) {
+  for (size_t n = 0; n < size; n++) {
+    const double t = (n & 1) ? (n + 0.5) : (double)n;
+
+    window[n] = 0.5 - (0.5 * cos((2.0 * M_PI * t) / (size - 1)));
+  }
+}
+
+// Naive DFT on `double`. `sign` is -1 (forward) or +1 (inverse, not normalized).
+// Trigonometric table is indexed by (k * n) mod size, so that sin(0) and sin(pi) are exact zero.
+static void reference_dft(const double *const input_reals, const double *const input_imags, double *const output_reals, double *const output_imags, const size_t size, const int sign) {
+  std::vector<double> cosines(size);
+  std::vector<double> sines(size);
+
+  for (size_t k = 0; k < size; k++) {
+    if ((2 * k) == size) {
+      cosines[k] = -1.0;
+      sines[k]   = 0.0;
+    } else if (k == 0) {
+      cosines[k] = 1.0;
+      sines[k]   = 0.0;
+    } else {
+      cosines[k] = cos((2.0 * M_PI * k) / size);
+      sines[k]   = sign * sin((2.0 * M_PI * k) / size);
+    }
+  }
+
+  for (size_t k = 0; k < size; k++) {
+    double real = 0.0;
+    double imag = 0.0;
+
+    for (size_t n = 0; n < size; n++) {
+      const size_t index = (k * n) % size;
+
+      const double c = cosines[index];
+      const double s = sines[index];
+
+      const double x_real = input_reals[n];
+      const double x_imag = (input_imags == nullptr) ? 0.0 : input_imags[n];
+
+      real += (x_real * c) - (x_imag * s);
+      imag += (x_real * s) + (x_imag * c);
+    }
+
+    output_reals[k] = real;
+    output_imags[k] = imag;
+  }
+}
+
+// Inverse of the real DFT from the non-redundant bins `0 .. size / 2` (imaginary parts of DC and Nyquist are ignored, as `IRFFT`)
+static void reference_inverse_real_dft(const double *const reals, const double *const imags, double *const outputs, const size_t size) {
+  const size_t half_size = size / 2;
+
+  std::vector<double> full_reals(size);
+  std::vector<double> full_imags(size);
+  std::vector<double> output_imags(size);
+
+  full_reals[0]         = reals[0];
+  full_reals[half_size] = reals[half_size];
+
+  for (size_t k = 1; k < half_size; k++) {
+    full_reals[k]        = reals[k];
+    full_imags[k]        = imags[k];
+    full_reals[size - k] = reals[k];
+    full_imags[size - k] = 0.0 - imags[k];
+  }
+
+  reference_dft(full_reals.data(), full_imags.data(), outputs, output_imags.data(), size, 1);
+
+  for (size_t n = 0; n < size; n++) {
+    outputs[n] /= size;
+  }
+}
+
+// Render quantum size of Web Audio API
+static const size_t reference_render_quantum_size = 128;
+
+// Overlap-add of TypeScript processors before streaming API (1 / number of overlaps) on `double` (golden output of streaming API).
+// `process_frame(frame, outputs)` processes the latest `frame_size` samples of `inputs` every `hop_size` samples (multiple of render quantum).
+// Only the latest `synthesis_size` samples of processed frame are overlap-added (`2 * hop_size` in low-latency mode of streaming API).
+// Every render quantum of `inputs` yields a render quantum of `outputs` (delayed by `synthesis_size - 128` samples).
+template <typename ProcessFrame>
+static void reference_overlap_add(const float *const inputs, double *const outputs, const size_t frame_size, const size_t hop_size, const size_t synthesis_size, const size_t number_of_quanta, ProcessFrame process_frame) {
+  const size_t quantum_size = reference_render_quantum_size;
+
+  std::vector<float> input_buffer(frame_size + quantum_size);
+  std::vector<double> output_buffer(frame_size);
+  std::vector<double> frame_outputs(frame_size);
+
+  const double number_of_overlaps = (double)synthesis_size / hop_size;
+
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    memcpy((input_buffer.data() + frame_size), (inputs + (quantum * quantum_size)), (quantum_size * sizeof(float)));
+    memmove(input_buffer.data(), (input_buffer.data() + quantum_size), (frame_size * sizeof(float)));
+
+    if ((((quantum + 1) * quantum_size) % hop_size) == 0) {
+      process_frame(input_buffer.data(), frame_outputs.data());
+
+      for (size_t n = 0; n < synthesis_size; n++) {
+        output_buffer[n] += frame_outputs[(frame_size - synthesis_size) + n] / number_of_overlaps;
+      }
+    }
+
+    memcpy((outputs + (quantum * quantum_size)), output_buffer.data(), (quantum_size * sizeof(double)));
+    memmove(output_buffer.data(), (output_buffer.data() + quantum_size), ((frame_size - quantum_size) * sizeof(double)));
+    memset((output_buffer.data() + (frame_size - quantum_size)), 0, (quantum_size * sizeof(double)));
+  }
+}
+
+template <typename ProcessFrame>
+static void reference_overlap_add(const float *const inputs, double *const outputs, const size_t frame_size, const size_t hop_size, const size_t number_of_quanta, ProcessFrame process_frame) {
+  reference_overlap_add(inputs, outputs, frame_size, hop_size, frame_size, number_of_quanta, process_frame);
+}
+
+// Asymmetric windows of low-latency mode of streaming API on `double` (`stft_build_windows`).
+// Analysis window rises on `frame_size - hop_size` samples and falls on the latest `hop_size` samples,
+// and product of windows is Hanning window of `2 * hop_size` samples on the latest `2 * hop_size` samples (scaled by 3 / 4).
+static void reference_low_latency_windows(double *const analysis_window, double *const synthesis_window, const size_t frame_size, const size_t hop_size) {
+  const size_t rise_size = frame_size - hop_size;
+  const size_t tail_size = 2 * hop_size;
+
+  for (size_t n = 0; n < frame_size; n++) {
+    const size_t rise_index = n;
+    const size_t tail_index = n + tail_size - frame_size;
+
+    const double tail = (n < (frame_size - tail_size)) ? 0.0 : (0.5 - (0.5 * cos((2.0 * M_PI * tail_index) / tail_size)));
+
+    analysis_window[n]  = (n < rise_size) ? sqrt(0.5 - (0.5 * cos((2.0 * M_PI * rise_index) / (2 * rise_size)))) : sqrt(tail);
+    synthesis_window[n] = (analysis_window[n] > 0.0) ? ((0.75 * tail) / analysis_window[n]) : 0.0;
+  }
+}
+
+// Samples whose magnitude is not more than this floor are silence for streaming API
+static const float reference_silence_floor = 1e-6f;
+
+// Silence from render quantum `begin` to render quantum `end` (exclusive)
+static void mute(float *const signal, const size_t begin, const size_t end) {
+  for (size_t n = begin * reference_render_quantum_size; n < (end * reference_render_quantum_size); n++) {
+    signal[n] = 0.0f;
+  }
+}
+
+// Number of frames (per channel) whose `frame_size` samples are silence (frames before `inputs` are silence).
+// `inputs` holds `number_of_quanta * 128` samples per channel (channel `c` starts at `c * number_of_quanta * 128`).
+static size_t reference_number_of_silent_frames(const float *const inputs, const size_t number_of_channels, const size_t frame_size, const size_t hop_size, const size_t number_of_quanta) {
+  const size_t quantum_size = reference_render_quantum_size;
+
+  size_t number_of_silent_frames = 0;
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    const float *signal = inputs + (channel_number * number_of_quanta * quantum_size);
+
+    // Index of the latest sample that is not silence (`frame_size` samples before the first sample at first)
+    long long last_sound = -1 - (long long)frame_size;
+
+    for (size_t n = 0; n < (number_of_quanta * quantum_size); n++) {
+      if (fabsf(signal[n]) > reference_silence_floor) {
+        last_sound = n;
+      }
+
+      if (((n + 1) % hop_size) == 0) {
+        if (((long long)n - last_sound) >= (long long)frame_size) {
+          ++number_of_silent_frames;
+        }
+      }
+    }
+  }
+
+  return number_of_silent_frames;
+}
+
+// Feed `inputs` to streaming API by render quantum, and gather every render quantum that `process_quantum()` returns into `outputs`.
+// `inputs` and `outputs` hold `number_of_quanta * 128` samples per channel (channel `c` starts at `c * number_of_quanta * 128`),
+// and `quantum_inputs` (`*_stream_inputs`) and return value of `process_quantum` are planar render quanta.
+template <typename ProcessQuantum>
+static void stream(float *const quantum_inputs, const float *const inputs, float *const outputs, const size_t number_of_channels, const size_t number_of_quanta, ProcessQuantum process_quantum) {
+  const size_t quantum_size = reference_render_quantum_size;
+  const size_t length       = number_of_quanta * quantum_size;
+
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+      memcpy((quantum_inputs + (channel_number * quantum_size)), (inputs + (channel_number * length) + (quantum * quantum_size)), (quantum_size * sizeof(float)));
+    }
+
+    const float *quantum_outputs = process_quantum();
+
+    for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+      memcpy((outputs + (channel_number * length) + (quantum * quantum_size)), (quantum_outputs + (channel_number * quantum_size)), (quantum_size * sizeof(float)));
+    }
+  }
+}
+
+
+// Offline rendering (`*_render`) is checked on these numbers of threads (signal is split into jobs differently)
+static const size_t render_numbers_of_threads[] = { 1, 2, 3, 4 };
+
+// Offline rendering is benchmarked on these numbers of threads (scaling depends on the number of cores)
+static const size_t benchmark_render_numbers_of_threads[] = { 1, 2, 4, 8 };
+
+// Length of signal for offline rendering is shorter than render quanta by this size (streaming API is fed the zero-padded signal)
+static const size_t render_tail_size = 37;
+
+// Copy `inputs` for streaming API (`number_of_quanta * 128` samples per channel) into planar signal of `length` samples per channel (`*_render_inputs`)
+static void copy_render_signal(float *const signal, const float *const inputs, const size_t number_of_channels, const size_t number_of_quanta, const size_t length) {
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    memcpy((signal + (channel_number * length)), (inputs + (channel_number * number_of_quanta * reference_render_quantum_size)), (length * sizeof(float)));
+  }
+}
+
+// Offline rendering must be bit-identical to streaming API (tolerance is `0`).
+// `actuals` holds `length` samples per channel, and `expecteds` (by `stream`) holds `number_of_quanta * 128` samples per channel.
+static bool check_render(const char *const name, const size_t size, const float *const actuals, const float *const expecteds, const size_t number_of_channels, const size_t number_of_quanta, const size_t length) {
+  std::vector<double> truncated_expecteds(number_of_channels * length);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    for (size_t n = 0; n < length; n++) {
+      truncated_expecteds[(channel_number * length) + n] = expecteds[(channel_number * number_of_quanta * reference_render_quantum_size) + n];
+    }
+  }
+
+  return check(name, size, actuals, truncated_expecteds.data(), (number_of_channels * length), 0.0);
+}
+
+#endif
@@ -0,0 +1,519 @@
+#include "benchmark.hpp"
+
+// Exports (`profile_*`) are defined by module
+#define ARENA_WITHOUT_EXPORTS
+
+// `Profile` of instrumentation
+#include "../src/SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/profile.hpp"
+
+extern "C" {
+void *noisegate_create(void);
+void noisegate_destroy(void *const context);
+void noisegate_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *noisegate_inputs(void *const context);
+float *noisegate_process(void *const context, const float level);
+void *noisesuppressor_create(const size_t fft_size);
+void noisesuppressor_destroy(void *const context);
+void noisesuppressor_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *noisesuppressor_stream_inputs(void *const context);
+float *noisesuppressor_stream_process(void *const context, const float threshold);
+void *pitchshifter_create(const size_t fft_size);
+void pitchshifter_destroy(void *const context);
+void pitchshifter_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *pitchshifter_stream_inputs(void *const context);
+float *pitchshifter_stream_process(void *const context, const float pitch, const float speed, const float dry, const float wet);
+void *vocalcanceler_create(const size_t fft_size);
+void vocalcanceler_destroy(void *const context);
+void vocalcanceler_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *vocalcanceler_stream_inputs(void *const context);
+float *vocalcanceler_stream_process(void *const context, const float depth);
+void *spectralchain_create(const size_t fft_size);
+void spectralchain_destroy(void *const context);
+void spectralchain_set_number_of_channels(void *const context, const size_t number_of_channels);
+size_t spectralchain_set_number_of_stages(void *const context, const size_t number_of_stages);
+bool spectralchain_set_noise_suppressor(void *const context, const size_t index, const float threshold);
+bool spectralchain_set_vocal_canceler(void *const context, const size_t index, const bool on_spectrum, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold);
+bool spectralchain_set_pitch_shifter(void *const context, const size_t index, const float pitch, const float speed, const float dry, const float wet);
+size_t spectralchain_set_hop_size(void *const context, const size_t hop_size);
+float *spectralchain_stream_inputs(void *const context);
+float *spectralchain_stream_process(void *const context);
+void *noisegenerator_create(const unsigned int seed);
+void noisegenerator_destroy(void *const context);
+float *noisegenerator_whitenoise(void *const context);
+size_t noisesuppressor_get_number_of_skipped_frames(void *const context);
+Profile *noisegate_profile(void *const context);
+Profile *noisesuppressor_profile(void *const context);
+Profile *pitchshifter_profile(void *const context);
+Profile *vocalcanceler_profile(void *const context);
+Profile *noisegenerator_profile(void *const context);
+void profile_set_enabled(Profile *const profile, const bool enabled);
+void profile_reset(Profile *const profile);
+size_t profile_get_number_of_calls(const Profile *const profile);
+double profile_get_total_time(const Profile *const profile);
+double profile_get_max_time(const Profile *const profile);
+size_t profile_get_number_of_allocations(const Profile *const profile);
+size_t profile_get_number_of_skipped_frames(const Profile *const profile);
+const void *dsp_find_fft_plan(const size_t size, const bool inverse);
+bool profile_write_trace(const char *const path, const char *const *const names, const Profile *const *const profiles, const size_t number_of_profiles);
+}
+
+// Render quantum size
+static const size_t buffer_size = 128;
+
+static const size_t fft_size = 1024;
+
+static const size_t number_of_channels = 2;
+
+static const size_t number_of_quanta = 4 * (fft_size / buffer_size);
+
+static const double tolerance = 1e-4;
+
+// Golden outputs of modules are checked by their own benchmarks.
+// Effector and stage of spectral chain in the same (combined) module must have the same outputs.
+template <typename ConfigureStage, typename ProcessEffector>
+static void check_stage(const char *const name, ConfigureStage configure_stage, float *const effector_inputs, ProcessEffector process_effector) {
+  const size_t length = number_of_quanta * buffer_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<float> effector_outputs(number_of_channels * length);
+
+  generate_signal(inputs.data(), inputs.size(), 23);
+
+  void *chain = spectralchain_create(fft_size);
+
+  spectralchain_set_number_of_channels(chain, number_of_channels);
+
+  configure_stage(chain);
+
+  spectralchain_set_number_of_stages(chain, 1);
+
+  stream(spectralchain_stream_inputs(chain), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return spectralchain_stream_process(chain);
+  });
+
+  stream(effector_inputs, inputs.data(), effector_outputs.data(), number_of_channels, number_of_quanta, process_effector);
+
+  std::vector<double> expecteds(effector_outputs.begin(), effector_outputs.end());
+
+  check(name, fft_size, actuals.data(), expecteds.data(), expecteds.size(), tolerance);
+
+  spectralchain_destroy(chain);
+}
+
+static void check_stages(void) {
+  void *noisesuppressor = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(noisesuppressor, number_of_channels);
+
+  // Chain of noise suppressor only (hop size is 128, the same as standalone effector)
+  check_stage("dsp (noise suppressor, spectral chain)", [](void *const chain) {
+    spectralchain_set_noise_suppressor(chain, 0, 0.05f);
+  }, noisesuppressor_stream_inputs(noisesuppressor), [&]() {
+    return noisesuppressor_stream_process(noisesuppressor, 0.05f);
+  });
+
+  noisesuppressor_destroy(noisesuppressor);
+
+  void *pitchshifter = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+
+  check_stage("dsp (pitch shifter, spectral chain)", [](void *const chain) {
+    spectralchain_set_pitch_shifter(chain, 0, 1.5f, 1.0f, 0.0f, 1.0f);
+  }, pitchshifter_stream_inputs(pitchshifter), [&]() {
+    return pitchshifter_stream_process(pitchshifter, 1.5f, 1.0f, 0.0f, 1.0f);
+  });
+
+  pitchshifter_destroy(pitchshifter);
+
+  // Dry components are mixed on time domain, so chain has the same level as effectors
+  pitchshifter = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+
+  check_stage("dsp (pitch shifter, dry / wet, spectral chain)", [](void *const chain) {
+    spectralchain_set_pitch_shifter(chain, 0, 1.5f, 1.0f, 0.5f, 0.5f);
+  }, pitchshifter_stream_inputs(pitchshifter), [&]() {
+    return pitchshifter_stream_process(pitchshifter, 1.5f, 1.0f, 0.5f, 0.5f);
+  });
+
+  pitchshifter_destroy(pitchshifter);
+
+  void *vocalcanceler = vocalcanceler_create(fft_size);
+
+  vocalcanceler_set_number_of_channels(vocalcanceler, number_of_channels);
+
+  check_stage("dsp (vocal canceler, spectral chain)", [](void *const chain) {
+    spectralchain_set_vocal_canceler(chain, 0, false, 0.75f, 0.0f, 0.0f, 0.0f, 0.0f);
+  }, vocalcanceler_stream_inputs(vocalcanceler), [&]() {
+    return vocalcanceler_stream_process(vocalcanceler, 0.75f);
+  });
+
+  vocalcanceler_destroy(vocalcanceler);
+}
+
+// Stages share hop size of chain (hop size of fused pitch shifter), while standalone noise suppressor is processed every 128 samples.
+// Spectral subtraction is not linear, so noise suppressor in chain of larger hop size doesn't have the same output as standalone effector
+// (overlap-add gain is normalized by hop size, so level is the same). If this check fails, stages are processed by their own hop size.
+static void check_shared_hop_size(void) {
+  const size_t length = number_of_quanta * buffer_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<float> effector_outputs(number_of_channels * length);
+
+  generate_signal(inputs.data(), inputs.size(), 23);
+
+  void *chain           = spectralchain_create(fft_size);
+  void *noisesuppressor = noisesuppressor_create(fft_size);
+
+  spectralchain_set_number_of_channels(chain, number_of_channels);
+  spectralchain_set_noise_suppressor(chain, 0, 0.05f);
+  spectralchain_set_number_of_stages(chain, 1);
+  spectralchain_set_hop_size(chain, 256);
+
+  noisesuppressor_set_number_of_channels(noisesuppressor, number_of_channels);
+
+  stream(spectralchain_stream_inputs(chain), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return spectralchain_stream_process(chain);
+  });
+
+  stream(noisesuppressor_stream_inputs(noisesuppressor), inputs.data(), effector_outputs.data(), number_of_channels, number_of_quanta, [&]() {
+    return noisesuppressor_stream_process(noisesuppressor, 0.05f);
+  });
+
+  double diff = 0.0;
+
+  for (size_t n = 0; n < actuals.size(); n++) {
+    diff = fmax(diff, fabs(actuals[n] - effector_outputs[n]));
+  }
+
+  check_count("dsp (noise suppressor, hop size of pitch shifter, spectral chain)", fft_size, ((diff > tolerance) ? 1 : 0), 1);
+
+  spectralchain_destroy(chain);
+  noisesuppressor_destroy(noisesuppressor);
+}
+
+// Spectral chain of pitch shifter (dry / wet) and vocal canceler must have the same outputs as effectors in series.
+// Vocal canceler (on time domain) is linear, so its frames are the same as frames of the latter effector (delayed by the latency of the former).
+static void check_series(void) {
+  const size_t length  = number_of_quanta * buffer_size;
+  const size_t latency = fft_size - buffer_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<float> intermediates(number_of_channels * length);
+  std::vector<float> effector_outputs(number_of_channels * length);
+
+  generate_signal(inputs.data(), inputs.size(), 29);
+
+  void *chain = spectralchain_create(fft_size);
+
+  spectralchain_set_number_of_channels(chain, number_of_channels);
+  spectralchain_set_pitch_shifter(chain, 0, 0.75f, 1.0f, 0.25f, 0.75f);
+  spectralchain_set_vocal_canceler(chain, 1, false, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+  stream(spectralchain_stream_inputs(chain), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return spectralchain_stream_process(chain);
+  });
+
+  void *pitchshifter  = pitchshifter_create(fft_size);
+  void *vocalcanceler = vocalcanceler_create(fft_size);
+
+  pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+  vocalcanceler_set_number_of_channels(vocalcanceler, number_of_channels);
+
+  stream(pitchshifter_stream_inputs(pitchshifter), inputs.data(), intermediates.data(), number_of_channels, number_of_quanta, [&]() {
+    return pitchshifter_stream_process(pitchshifter, 0.75f, 1.0f, 0.25f, 0.75f);
+  });
+
+  stream(vocalcanceler_stream_inputs(vocalcanceler), intermediates.data(), effector_outputs.data(), number_of_channels, number_of_quanta, [&]() {
+    return vocalcanceler_stream_process(vocalcanceler, 0.5f);
+  });
+
+  // Outputs of chain are compared with outputs of effectors `latency` samples later
+  std::vector<float> delayed_actuals;
+  std::vector<double> expecteds;
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    const size_t offset = channel_number * length;
+
+    delayed_actuals.insert(delayed_actuals.end(), (actuals.begin() + offset), (actuals.begin() + offset + (length - latency)));
+    expecteds.insert(expecteds.end(), (effector_outputs.begin() + offset + latency), (effector_outputs.begin() + offset + length));
+  }
+
+  check("dsp (pitch shifter -> vocal canceler, spectral chain)", fft_size, delayed_actuals.data(), expecteds.data(), expecteds.size(), tolerance);
+
+  spectralchain_destroy(chain);
+  pitchshifter_destroy(pitchshifter);
+  vocalcanceler_destroy(vocalcanceler);
+}
+
+// Shared headers are compiled once (include guards), so every effector looks up one list of FFT plans.
+// Vocal canceler of `size` and the other effectors of `2 * size` (real FFT) transform `size` points by the same plans.
+static void check_shared_plans(void) {
+  const size_t size = 768;
+
+  const void *forward = dsp_find_fft_plan(size, false);
+  const void *inverse = dsp_find_fft_plan(size, true);
+
+  check_count("dsp (plans are not built yet)", size, (((forward == nullptr) && (inverse == nullptr)) ? 1 : 0), 1);
+
+  void *vocalcanceler = vocalcanceler_create(size);
+
+  forward = dsp_find_fft_plan(size, false);
+  inverse = dsp_find_fft_plan(size, true);
+
+  check_count("dsp (plans are built by vocalcanceler)", size, (((forward != nullptr) && (inverse != nullptr)) ? 1 : 0), 1);
+
+  void *noisesuppressor = noisesuppressor_create(2 * size);
+  void *pitchshifter    = pitchshifter_create(2 * size);
+  void *spectralchain   = spectralchain_create(2 * size);
+
+  const bool is_shared = (dsp_find_fft_plan(size, false) == forward) && (dsp_find_fft_plan(size, true) == inverse);
+
+  check_count("dsp (plans are shared by effectors)", size, (is_shared ? 1 : 0), 1);
+
+  vocalcanceler_destroy(vocalcanceler);
+  noisesuppressor_destroy(noisesuppressor);
+  pitchshifter_destroy(pitchshifter);
+  spectralchain_destroy(spectralchain);
+}
+
+// Every module in one WebAssembly Module shares linear memory (and generation of memory layout),
+// so processing all of them in turn must not allocate or reallocate on steady state.
+static void check_steady_state(void) {
+  void *noisegate       = noisegate_create();
+  void *noisesuppressor = noisesuppressor_create(fft_size);
+  void *pitchshifter    = pitchshifter_create(fft_size);
+  void *vocalcanceler   = vocalcanceler_create(fft_size);
+  void *noisegenerator  = noisegenerator_create(7);
+
+  noisegate_set_number_of_channels(noisegate, number_of_channels);
+  noisesuppressor_set_number_of_channels(noisesuppressor, number_of_channels);
+  pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+  vocalcanceler_set_number_of_channels(vocalcanceler, number_of_channels);
+
+  const auto process_quantum = [&]() {
+    generate_signal(noisegate_inputs(noisegate), (number_of_channels * buffer_size), 5);
+    generate_signal(noisesuppressor_stream_inputs(noisesuppressor), (number_of_channels * buffer_size), 6);
+    generate_signal(pitchshifter_stream_inputs(pitchshifter), (number_of_channels * buffer_size), 7);
+    generate_signal(vocalcanceler_stream_inputs(vocalcanceler), (number_of_channels * buffer_size), 8);
+
+    noisegate_process(noisegate, 0.25f);
+    noisesuppressor_stream_process(noisesuppressor, 0.05f);
+    pitchshifter_stream_process(pitchshifter, 1.5f, 1.0f, 0.0f, 1.0f);
+    vocalcanceler_stream_process(vocalcanceler, 1.0f);
+    noisegenerator_whitenoise(noisegenerator);
+  };
+
+  // FFT plans and work buffers are allocated by the first frame
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    process_quantum();
+  }
+
+  const size_t number_of_allocations = get_number_of_allocations();
+  const size_t memory_generation     = get_memory_generation();
+
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    process_quantum();
+  }
+
+  check_count("dsp (steady state, allocations)", fft_size, (get_number_of_allocations() - number_of_allocations), 0);
+  check_count("dsp (steady state, memory generation)", fft_size, (get_memory_generation() - memory_generation), 0);
+
+  noisegate_destroy(noisegate);
+  noisesuppressor_destroy(noisesuppressor);
+  pitchshifter_destroy(pitchshifter);
+  vocalcanceler_destroy(vocalcanceler);
+  noisegenerator_destroy(noisegenerator);
+}
+
+// Trace of `check_profiles` (Chrome trace event format) is written into build directory (not into working directory of `ctest`), or path by `--trace <path>`
+#ifndef XSOUND_BENCHMARK_BINARY_DIR
+#define XSOUND_BENCHMARK_BINARY_DIR "."
+#endif
+
+static const char *trace_path = XSOUND_BENCHMARK_BINARY_DIR "/dsp.trace.json";
+
+static size_t count_occurrences(const char *const path, const char *const pattern) {
+  FILE *file = fopen(path, "r");
+
+  if (file == nullptr) {
+    return 0;
+  }
+
+  std::vector<char> text;
+
+  for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+    text.push_back((char)c);
+  }
+
+  text.push_back('\0');
+
+  fclose(file);
+
+  size_t count = 0;
+
+  for (const char *found = strstr(text.data(), pattern); found != nullptr; found = strstr((found + 1), pattern)) {
+    ++count;
+  }
+
+  return count;
+}
+
+// Instrumentation counts only calls while profiling is enabled, and steady state must not allocate
+static void check_profiles(void) {
+  void *noisegate       = noisegate_create();
+  void *noisesuppressor = noisesuppressor_create(fft_size);
+  void *pitchshifter    = pitchshifter_create(fft_size);
+  void *vocalcanceler   = vocalcanceler_create(fft_size);
+  void *noisegenerator  = noisegenerator_create(7);
+
+  noisegate_set_number_of_channels(noisegate, number_of_channels);
+  noisesuppressor_set_number_of_channels(noisesuppressor, number_of_channels);
+  pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+  vocalcanceler_set_number_of_channels(vocalcanceler, number_of_channels);
+
+  const char *const names[] = { "noisegate", "noisesuppressor", "pitchshifter", "vocalcanceler", "noisegenerator" };
+
+  Profile *const profiles[] = {
+    noisegate_profile(noisegate),
+    noisesuppressor_profile(noisesuppressor),
+    pitchshifter_profile(pitchshifter),
+    vocalcanceler_profile(vocalcanceler),
+    noisegenerator_profile(noisegenerator)
+  };
+
+  const size_t number_of_profiles = sizeof(profiles) / sizeof(profiles[0]);
+
+  // The second half of quanta is silence (frames of noise suppressor are skipped)
+  const auto process_quantum = [&](const size_t quantum) {
+    const unsigned int seed = (quantum < (number_of_quanta / 2)) ? 5 : 0;
+
+    float *inputs[] = {
+      noisegate_inputs(noisegate),
+      noisesuppressor_stream_inputs(noisesuppressor),
+      pitchshifter_stream_inputs(pitchshifter),
+      vocalcanceler_stream_inputs(vocalcanceler)
+    };
+
+    for (float *input : inputs) {
+      if (seed == 0) {
+        memset(input, 0, (number_of_channels * buffer_size * sizeof(float)));
+      } else {
+        generate_signal(input, (number_of_channels * buffer_size), seed);
+      }
+    }
+
+    noisegate_process(noisegate, 0.25f);
+    noisesuppressor_stream_process(noisesuppressor, 0.05f);
+    pitchshifter_stream_process(pitchshifter, 1.5f, 1.0f, 0.0f, 1.0f);
+    vocalcanceler_stream_process(vocalcanceler, 1.0f);
+    noisegenerator_whitenoise(noisegenerator);
+  };
+
+  // Disabled (default) profiles count nothing
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    process_quantum(quantum);
+  }
+
+  check_count("dsp (profile, disabled)", fft_size, profile_get_number_of_calls(profiles[0]), 0);
+
+  for (size_t n = 0; n < number_of_profiles; n++) {
+    profile_set_enabled(profiles[n], true);
+  }
+
+  const size_t number_of_skipped_frames = noisesuppressor_get_number_of_skipped_frames(noisesuppressor);
+
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    process_quantum(quantum);
+  }
+
+  size_t number_of_allocations = 0;
+  size_t number_of_inconsistent_times = 0;
+
+  for (size_t n = 0; n < number_of_profiles; n++) {
+    check_count("dsp (profile, calls)", fft_size, profile_get_number_of_calls(profiles[n]), number_of_quanta);
+
+    number_of_allocations += profile_get_number_of_allocations(profiles[n]);
+
+    const double total_time = profile_get_total_time(profiles[n]);
+    const double max_time   = profile_get_max_time(profiles[n]);
+
+    if ((max_time <= 0.0) || (max_time > total_time)) {
+      ++number_of_inconsistent_times;
+    }
+  }
+
+  check_count("dsp (profile, allocations)", fft_size, number_of_allocations, 0);
+  check_count("dsp (profile, max time <= total time)", fft_size, number_of_inconsistent_times, 0);
+  check_count("dsp (profile, skipped frames)", fft_size, profile_get_number_of_skipped_frames(profiles[1]), (noisesuppressor_get_number_of_skipped_frames(noisesuppressor) - number_of_skipped_frames));
+  check_count("dsp (profile, frames are skipped)", fft_size, ((profile_get_number_of_skipped_frames(profiles[1]) > 0) ? 1 : 0), 1);
+
+  // Every call is one complete event, and every profile is one track
+  const bool written = profile_write_trace(trace_path, names, profiles, number_of_profiles);
+
+  check_count("dsp (profile, trace is written)", fft_size, (written ? 1 : 0), 1);
+  check_count("dsp (profile, trace events)", fft_size, count_occurrences(trace_path, "\"ph\":\"X\""), (number_of_profiles * number_of_quanta));
+  check_count("dsp (profile, trace tracks)", fft_size, count_occurrences(trace_path, "\"thread_name\""), number_of_profiles);
+
+  profile_reset(profiles[0]);
+
+  check_count("dsp (profile, reset)", fft_size, profile_get_number_of_calls(profiles[0]), 0);
+
+  noisegate_destroy(noisegate);
+  noisesuppressor_destroy(noisesuppressor);
+  pitchshifter_destroy(pitchshifter);
+  vocalcanceler_destroy(vocalcanceler);
+  noisegenerator_destroy(noisegenerator);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; (i + 1) < argc; i++) {
+    if (strcmp(argv[i], "--trace") == 0) {
+      trace_path = argv[i + 1];
+    }
+  }
+
+  check_stages();
+  check_shared_hop_size();
+  check_series();
+  check_shared_plans();
+  check_steady_state();
+  check_profiles();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  // Session that opens with many effectors (contexts are created, and first frame is processed)
+  benchmark("dsp (cold start, 4 effectors)", fft_size, fft_size, [&]() {
+    void *noisegate       = noisegate_create();
+    void *noisesuppressor = noisesuppressor_create(fft_size);
+    void *pitchshifter    = pitchshifter_create(fft_size);
+    void *vocalcanceler   = vocalcanceler_create(fft_size);
+
+    noisegate_set_number_of_channels(noisegate, number_of_channels);
+    noisesuppressor_set_number_of_channels(noisesuppressor, number_of_channels);
+    pitchshifter_set_number_of_channels(pitchshifter, number_of_channels);
+    vocalcanceler_set_number_of_channels(vocalcanceler, number_of_channels);
+
+    for (size_t quantum = 0; quantum < (fft_size / buffer_size); quantum++) {
+      noisegate_process(noisegate, 0.25f);
+      noisesuppressor_stream_process(noisesuppressor, 0.05f);
+      pitchshifter_stream_process(pitchshifter, 1.5f, 1.0f, 0.0f, 1.0f);
+      vocalcanceler_stream_process(vocalcanceler, 1.0f);
+    }
+
+    noisegate_destroy(noisegate);
+    noisesuppressor_destroy(noisesuppressor);
+    pitchshifter_destroy(pitchshifter);
+    vocalcanceler_destroy(vocalcanceler);
+  });
+
+  return number_of_failures;
+}
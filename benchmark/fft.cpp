@@ -0,0 +1,442 @@
+#include "benchmark.hpp"
+
+extern "C" {
+void *fft_create(const size_t size);
+void fft_destroy(void *const context);
+float *fft_reals(void *const context);
+float *fft_imags(void *const context);
+bool fft_process(void *const context);
+bool ifft_process(void *const context);
+void fft_set_algorithm(const int algorithm);
+int fft_get_algorithm(void *const context);
+int fft_plan_measure(const size_t size);
+void *spectrogram_create(const size_t frame_size, const size_t hop_size, const int window);
+void spectrogram_destroy(void *const context);
+float *spectrogram_inputs(void *const context, const size_t length);
+float *spectrogram_process(void *const context, const size_t length, const bool decibels);
+size_t spectrogram_get_number_of_frames(void *const context);
+float *alloc_memory_reals(const size_t buffer_size);
+float *alloc_memory_imags(const size_t buffer_size);
+bool FFT(const size_t size);
+}
+
+// `FFT_ALGORITHM` in `FFT.hpp`
+static const int number_of_algorithms = 4;
+
+static const char *algorithm_names[] = { "auto", "radix-2", "mixed-radix", "codelet" };
+
+static const size_t min_fft_size = 256;
+static const size_t max_fft_size = 65536;
+
+// Naive DFT is O(N^2), so golden checks against it are limited to this size
+static const size_t max_golden_fft_size = 4096;
+
+// Mixed-radix sizes (2^a * 3^b * 5^c). 480, 960 and 1920 are 10 ms, 20 ms and 40 ms at 48 kHz.
+// Sizes that are transformed by codelet only (or by codelet after 1 stage)
+static const size_t small_fft_sizes[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+static const size_t mixed_radix_fft_sizes[] = { 3, 5, 6, 12, 15, 20, 45, 60, 100, 375, 480, 960, 1920, 3840, 6144 };
+
+// Sizes that have the other prime factor (7, 11, 13, ...)
+static const size_t invalid_fft_sizes[] = { 0, 7, 14, 441, 1001, 44100 };
+
+static const double tolerance = 1e-5;
+
+// Spectrogram of signal that is not multiple of hop size (the last frame is zero-padded)
+static const size_t spectrogram_length = 4000;
+
+// Spectrogram of 10 seconds at 48 kHz for benchmark (as preview of a whole track)
+static const size_t spectrogram_benchmark_length = 480000;
+
+// `SPECTROGRAM_WINDOW` in `FFT.cpp` (same order as `WindowFunction` in `index.ts`)
+static const char *window_names[] = { "rect", "hanning", "hamming", "blackman" };
+
+// Name of check or benchmark row (algorithm is appended unless `FFT_AUTO`)
+static const char *name_of(const char *const kernel, const int algorithm) {
+  static char name[64];
+
+  if (algorithm == 0) {
+    snprintf(name, sizeof(name), "%s", kernel);
+  } else {
+    snprintf(name, sizeof(name), "%s (%s)", kernel, algorithm_names[algorithm]);
+  }
+
+  return name;
+}
+
+static void check_fft(const size_t size, const bool inverse, const int algorithm) {
+  void *context = fft_create(size);
+
+  float *reals = fft_reals(context);
+  float *imags = fft_imags(context);
+
+  generate_signal(reals, size, 1);
+  generate_signal(imags, size, 2);
+
+  std::vector<double> input_reals(reals, reals + size);
+  std::vector<double> input_imags(imags, imags + size);
+  std::vector<double> expecteds(2 * size);
+
+  reference_dft(input_reals.data(), input_imags.data(), expecteds.data(), (expecteds.data() + size), size, (inverse ? 1 : -1));
+
+  if (inverse) {
+    for (size_t k = 0; k < (2 * size); k++) {
+      expecteds[k] /= size;
+    }
+
+    ifft_process(context);
+  } else {
+    fft_process(context);
+  }
+
+  std::vector<float> actuals(2 * size);
+
+  memcpy(actuals.data(), reals, (size * sizeof(float)));
+  memcpy((actuals.data() + size), imags, (size * sizeof(float)));
+
+  check(name_of((inverse ? "IFFT" : "FFT"), algorithm), size, actuals.data(), expecteds.data(), (2 * size), tolerance);
+
+  fft_destroy(context);
+}
+
+static void check_round_trip(const size_t size, const int algorithm) {
+  void *context = fft_create(size);
+
+  float *reals = fft_reals(context);
+  float *imags = fft_imags(context);
+
+  generate_signal(reals, size, 3);
+  generate_signal(imags, size, 4);
+
+  std::vector<double> expecteds(2 * size);
+
+  for (size_t n = 0; n < size; n++) {
+    expecteds[n]        = reals[n];
+    expecteds[size + n] = imags[n];
+  }
+
+  fft_process(context);
+  ifft_process(context);
+
+  std::vector<float> actuals(2 * size);
+
+  memcpy(actuals.data(), reals, (size * sizeof(float)));
+  memcpy((actuals.data() + size), imags, (size * sizeof(float)));
+
+  check(name_of("IFFT(FFT(x))", algorithm), size, actuals.data(), expecteds.data(), (2 * size), tolerance);
+
+  fft_destroy(context);
+}
+
+// Invalid size is rejected instead of wrong output
+static void check_invalid_size(const size_t size) {
+  void *context = fft_create(size);
+
+  const bool passed = context == nullptr;
+
+  printf("%s %-40s %8zu\n", (passed ? "PASS" : "FAIL"), "fft_create (invalid size)", size);
+
+  if (!passed) {
+    ++number_of_failures;
+
+    fft_destroy(context);
+  }
+}
+
+// Magnitudes of frames on `double` with naive DFT (golden output)
+static void reference_spectrogram(const float *const inputs, double *const outputs, const size_t length, const size_t number_of_frames, const size_t frame_size, const size_t hop_size, const int window_type, const bool decibels) {
+  const size_t bin_count = frame_size / 2;
+
+  std::vector<double> window(frame_size);
+  std::vector<double> frame(frame_size);
+  std::vector<double> reals(frame_size);
+  std::vector<double> imags(frame_size);
+
+  for (size_t n = 0; n < frame_size; n++) {
+    const double w = (2.0 * M_PI * n) / (frame_size - 1);
+
+    const double windows[] = { 1.0, (0.5 - (0.5 * cos(w))), (0.54 - (0.46 * cos(w))), (0.42 - (0.5 * cos(w)) + (0.08 * cos(2.0 * w))) };
+
+    window[n] = windows[window_type];
+  }
+
+  for (size_t i = 0; i < number_of_frames; i++) {
+    const size_t offset = i * hop_size;
+
+    for (size_t n = 0; n < frame_size; n++) {
+      frame[n] = ((offset + n) < length) ? (window[n] * inputs[offset + n]) : 0.0;
+    }
+
+    reference_dft(frame.data(), nullptr, reals.data(), imags.data(), frame_size, -1);
+
+    for (size_t k = 0; k < bin_count; k++) {
+      const double magnitude = sqrt((reals[k] * reals[k]) + (imags[k] * imags[k]));
+
+      outputs[(i * bin_count) + k] = decibels ? (20.0 * log10(fmax(magnitude, 1e-6))) : magnitude;
+    }
+  }
+}
+
+static void check_spectrogram(const size_t frame_size, const size_t hop_size, const int window_type, const bool decibels) {
+  void *context = spectrogram_create(frame_size, hop_size, window_type);
+
+  float *inputs = spectrogram_inputs(context, spectrogram_length);
+
+  generate_signal(inputs, spectrogram_length, 7);
+
+  const float *actuals = spectrogram_process(context, spectrogram_length, decibels);
+
+  const size_t bin_count        = frame_size / 2;
+  // Until the frame that covers the last sample
+  const size_t number_of_frames = 1 + (((spectrogram_length - frame_size) + (hop_size - 1)) / hop_size);
+
+  std::vector<double> expecteds(number_of_frames * bin_count);
+
+  reference_spectrogram(inputs, expecteds.data(), spectrogram_length, number_of_frames, frame_size, hop_size, window_type, decibels);
+
+  char name[64];
+
+  snprintf(name, sizeof(name), "spectrogram (%s%s)", window_names[window_type], (decibels ? ", dB" : ""));
+
+  // Decibels are compared by absolute difference (in dB) of bins that are more than noise floor of `float`
+  if (decibels) {
+    std::vector<float> clipped(actuals, (actuals + (number_of_frames * bin_count)));
+
+    for (size_t k = 0; k < expecteds.size(); k++) {
+      if (expecteds[k] < -60.0) {
+        clipped[k]   = -60.0f;
+        expecteds[k] = -60.0;
+      }
+    }
+
+    check(name, frame_size, clipped.data(), expecteds.data(), expecteds.size(), 1e-3);
+  } else {
+    check(name, frame_size, actuals, expecteds.data(), expecteds.size(), tolerance);
+  }
+
+  check_count(name, frame_size, spectrogram_get_number_of_frames(context), number_of_frames);
+
+  spectrogram_destroy(context);
+}
+
+// Odd frame size or half frame size that has the other prime factor is rejected
+static void check_invalid_spectrogram(const size_t frame_size, const size_t hop_size) {
+  void *context = spectrogram_create(frame_size, hop_size, 1);
+
+  const bool passed = context == nullptr;
+
+  printf("%s %-40s %8zu\n", (passed ? "PASS" : "FAIL"), "spectrogram_create (invalid size)", frame_size);
+
+  if (!passed) {
+    ++number_of_failures;
+
+    spectrogram_destroy(context);
+  }
+}
+
+// Forced algorithm falls back to mixed-radix if it is not valid for size
+static void check_algorithm(const size_t size, const int algorithm) {
+  void *context = fft_create(size);
+
+  const int expected = ((algorithm == 1) && ((size & (size - 1)) != 0)) || ((algorithm == 3) && ((size % 8) != 0)) ? 2 : algorithm;
+
+  check_count(name_of("fft_get_algorithm", algorithm), size, fft_get_algorithm(context), expected);
+
+  fft_destroy(context);
+}
+
+// `FFT_AUTO` runs the first valid candidate until the size is measured, then it runs the fastest (and transforms are the same)
+static void check_measured_plan(const size_t size) {
+  void *context = fft_create(size);
+
+  const int heuristic = fft_get_algorithm(context);
+
+  const int measured = fft_plan_measure(size);
+
+  check_count("fft_get_algorithm (not measured)", size, heuristic, ((size % 8) == 0) ? 3 : 2);
+  check_count("fft_get_algorithm (measured)", size, fft_get_algorithm(context), measured);
+  check_count("fft_plan_measure (once per size)", size, fft_plan_measure(size), measured);
+
+  fft_destroy(context);
+
+  check_fft(size, false, 0);
+  check_fft(size, true, 0);
+  check_round_trip(size, 0);
+}
+
+static void benchmark_fft(const size_t size, const int algorithm) {
+  // Planner's selection is measured (as hosts do before rendering)
+  if (algorithm == 0) {
+    fft_plan_measure(size);
+  }
+
+  fft_set_algorithm(algorithm);
+
+  void *context = fft_create(size);
+
+  float *reals = fft_reals(context);
+  float *imags = fft_imags(context);
+
+  std::vector<float> input_reals(size);
+  std::vector<float> input_imags(size);
+
+  generate_signal(input_reals.data(), size, 5);
+  generate_signal(input_imags.data(), size, 6);
+
+  char name[64];
+
+  // Planner's selection is shown on `FFT_AUTO`
+  if (algorithm == 0) {
+    snprintf(name, sizeof(name), "FFT (auto: %s)", algorithm_names[fft_get_algorithm(context)]);
+  } else {
+    snprintf(name, sizeof(name), "%s", name_of("FFT", algorithm));
+  }
+
+  // Input is copied on every call (as `XSound.fft` does), otherwise repeated transforms overflow
+  benchmark(name, size, size, [&]() {
+    memcpy(reals, input_reals.data(), (size * sizeof(float)));
+    memcpy(imags, input_imags.data(), (size * sizeof(float)));
+
+    fft_process(context);
+  });
+
+  if (algorithm == 0) {
+    benchmark("IFFT", size, size, [&]() {
+      memcpy(reals, input_reals.data(), (size * sizeof(float)));
+      memcpy(imags, input_imags.data(), (size * sizeof(float)));
+
+      ifft_process(context);
+    });
+  }
+
+  fft_destroy(context);
+
+  fft_set_algorithm(0);
+}
+
+int main(int argc, char **argv) {
+  // Every algorithm (forced), then the planner's selection
+  for (int algorithm = 1; algorithm <= number_of_algorithms; algorithm++) {
+    const int a = algorithm % number_of_algorithms;
+
+    fft_set_algorithm(a);
+
+    for (const size_t size : small_fft_sizes) {
+      check_fft(size, false, a);
+      check_fft(size, true, a);
+    }
+
+    for (size_t size = min_fft_size; size <= max_golden_fft_size; size *= 2) {
+      check_fft(size, false, a);
+      check_fft(size, true, a);
+    }
+
+    for (size_t size = min_fft_size; size <= max_fft_size; size *= 2) {
+      check_round_trip(size, a);
+    }
+
+    for (const size_t size : mixed_radix_fft_sizes) {
+      check_fft(size, false, a);
+      check_fft(size, true, a);
+      check_round_trip(size, a);
+    }
+
+    if (a > 0) {
+      check_algorithm(1024, a);
+      check_algorithm(480, a);
+      check_algorithm(45, a);
+    }
+  }
+
+  fft_set_algorithm(0);
+
+  check_measured_plan(1536);
+  check_measured_plan(375);
+
+  for (const size_t size : invalid_fft_sizes) {
+    check_invalid_size(size);
+  }
+
+  for (int window_type = 0; window_type < 4; window_type++) {
+    check_spectrogram(512, 128, window_type, false);
+  }
+
+  check_spectrogram(1024, 256, 1, true);
+  check_spectrogram(480, 160, 1, false);
+
+  check_invalid_spectrogram(375, 128);
+  check_invalid_spectrogram(882, 128);
+  check_invalid_spectrogram(512, 0);
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  for (size_t size = min_fft_size; size <= max_fft_size; size *= 2) {
+    for (int algorithm = 0; algorithm < number_of_algorithms; algorithm++) {
+      benchmark_fft(size, algorithm);
+    }
+  }
+
+  for (const size_t size : mixed_radix_fft_sizes) {
+    if (size < min_fft_size) {
+      continue;
+    }
+
+    benchmark_fft(size, 0);
+    benchmark_fft(size, 2);
+
+    if ((size % 8) == 0) {
+      benchmark_fft(size, 3);
+    }
+  }
+
+  std::vector<float> signal(spectrogram_benchmark_length);
+
+  generate_signal(signal.data(), spectrogram_benchmark_length, 8);
+
+  for (size_t frame_size = 1024; frame_size <= 4096; frame_size *= 2) {
+    const size_t hop_size = frame_size / 4;
+    const size_t bin_count = frame_size / 2;
+
+    // As `spectrum` per frame (buffers are set, windowed and transformed by 1 call per frame, then magnitudes are computed)
+    std::vector<float> window(frame_size, 1.0f);
+    std::vector<float> magnitudes(bin_count);
+
+    benchmark("spectrum (per frame)", frame_size, spectrogram_benchmark_length, [&]() {
+      for (size_t offset = 0; (offset + frame_size) <= spectrogram_benchmark_length; offset += hop_size) {
+        float *reals = alloc_memory_reals(frame_size);
+        float *imags = alloc_memory_imags(frame_size);
+
+        for (size_t n = 0; n < frame_size; n++) {
+          reals[n] = window[n] * signal[offset + n];
+          imags[n] = 0.0f;
+        }
+
+        FFT(frame_size);
+
+        for (size_t k = 0; k < bin_count; k++) {
+          magnitudes[k] = sqrtf((reals[k] * reals[k]) + (imags[k] * imags[k]));
+        }
+      }
+    });
+
+    void *context = spectrogram_create(frame_size, hop_size, 1);
+
+    memcpy(spectrogram_inputs(context, spectrogram_benchmark_length), signal.data(), (spectrogram_benchmark_length * sizeof(float)));
+
+    benchmark("spectrogram", frame_size, spectrogram_benchmark_length, [&]() {
+      spectrogram_process(context, spectrogram_benchmark_length, false);
+    });
+
+    benchmark("spectrogram (dB)", frame_size, spectrogram_benchmark_length, [&]() {
+      spectrogram_process(context, spectrogram_benchmark_length, true);
+    });
+
+    spectrogram_destroy(context);
+  }
+
+  return number_of_failures;
+}
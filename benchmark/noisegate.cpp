@@ -0,0 +1,90 @@
+#include "benchmark.hpp"
+
+extern "C" {
+void *noisegate_create(void);
+void noisegate_destroy(void *const context);
+void noisegate_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *noisegate_inputs(void *const context);
+float *noisegate_outputs(void *const context);
+float *noisegate_process(void *const context, const float level);
+}
+
+// Render quantum size
+static const size_t buffer_size = 128;
+
+static const double tolerance = 0.0;
+
+static void check_noisegate(const float level, const size_t number_of_channels, const char *const name) {
+  void *context = noisegate_create();
+
+  noisegate_set_number_of_channels(context, number_of_channels);
+
+  float *inputs = noisegate_inputs(context);
+
+  const size_t length = number_of_channels * buffer_size;
+
+  std::vector<double> expecteds(length);
+
+  generate_signal(inputs, length, 14);
+
+  // Amplitude that equals `level` is gated
+  inputs[0] = level;
+  inputs[1] = 0.0f - level;
+
+  for (size_t n = 0; n < length; n++) {
+    expecteds[n] = (fabs(inputs[n]) > level) ? inputs[n] : 0.0;
+  }
+
+  check(name, buffer_size, noisegate_process(context, level), expecteds.data(), length, tolerance);
+
+  noisegate_destroy(context);
+}
+
+static void check_stable_outputs(void) {
+  void *context = noisegate_create();
+
+  check_stable_buffers("noisegate (stable buffers)", buffer_size, [&]() {
+    return noisegate_outputs(context);
+  }, [&]() {
+    return noisegate_process(context, 0.25f);
+  }, [&]() {
+    noisegate_set_number_of_channels(context, 2);
+  });
+
+  noisegate_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  check_noisegate(0.0f, 1, "noisegate (level 0)");
+  check_noisegate(0.25f, 1, "noisegate (level 0.25)");
+  check_noisegate(1.0f, 1, "noisegate (level 1)");
+  check_noisegate(0.25f, 2, "noisegate (planar)");
+
+  check_stable_outputs();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  void *context = noisegate_create();
+
+  generate_signal(noisegate_inputs(context), buffer_size, 15);
+
+  benchmark("noisegate", buffer_size, buffer_size, [&]() {
+    noisegate_process(context, 0.25f);
+  });
+
+  noisegate_set_number_of_channels(context, 2);
+
+  generate_signal(noisegate_inputs(context), (2 * buffer_size), 15);
+
+  benchmark("noisegate (2 channels)", buffer_size, (2 * buffer_size), [&]() {
+    noisegate_process(context, 0.25f);
+  });
+
+  noisegate_destroy(context);
+
+  return number_of_failures;
+}
@@ -0,0 +1,307 @@
+#include "benchmark.hpp"
+
+#include <stdint.h>
+
+extern "C" {
+void *noisegenerator_create(const unsigned int seed);
+void noisegenerator_destroy(void *const context);
+float *noisegenerator_whitenoise(void *const context);
+float *noisegenerator_pinknoise(void *const context);
+float *noisegenerator_browniannoise(void *const context);
+float *noisegenerator_render_whitenoise(void *const context, const size_t length);
+float *noisegenerator_render_pinknoise(void *const context, const size_t length);
+float *noisegenerator_render_browniannoise(void *const context, const size_t length);
+float *whitenoise(const unsigned int time);
+}
+
+// Render quantum size
+static const size_t buffer_size = 128;
+
+static const size_t number_of_blocks = 4;
+
+static const double tolerance = 1e-5;
+
+// Lengths of calls in order (not multiple of 4 and longer than 1 second at 48 kHz)
+static const size_t render_lengths[] = { 1, 3, 128, 130, 1021, 4096, 48000 };
+
+// Lengths for bulk rendering benchmark
+static const size_t render_sizes[] = { 128, 1024, 48000 };
+
+typedef float *(*NoiseGenerator)(void *const context);
+typedef float *(*NoiseRenderer)(void *const context, const size_t length);
+
+typedef enum {
+  WHITE_NOISE,
+  PINK_NOISE,
+  BROWNIAN_NOISE
+} NOISE_TYPE;
+
+// 1 xoshiro128+ generator (ref: https://prng.di.unimi.it/xoshiro128plus.c)
+typedef struct {
+  uint32_t s[4];
+} ReferenceXoshiro128;
+
+static uint32_t reference_xoshiro128_next(ReferenceXoshiro128 *const generator) {
+  uint32_t *s = generator->s;
+
+  const uint32_t result = s[0] + s[3];
+  const uint32_t t      = s[1] << 9;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3]  = (s[3] << 11) | (s[3] >> 21);
+
+  return result;
+}
+
+// 4 generators (lanes) whose states are drawn from SplitMix64 of `seed` in order (ref: https://prng.di.unimi.it/splitmix64.c)
+static void reference_seed(ReferenceXoshiro128 *const generators, const unsigned int seed) {
+  uint64_t state = seed;
+
+  for (size_t lane = 0; lane < 4; lane++) {
+    for (size_t word = 0; word < 4; word += 2) {
+      uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z = z ^ (z >> 31);
+
+      generators[lane].s[word]     = (uint32_t)z;
+      generators[lane].s[word + 1] = (uint32_t)(z >> 32);
+    }
+  }
+}
+
+// Noise on `double` from the same uniform sequence (golden output).
+// Sample `n` is drawn from lane `n % 4` and mapped to [-1, 1) by the upper 24 bits.
+// Filter states (`states[0 .. 6]` for pink noise, `states[7]` for brownian noise) are carried over blocks.
+// Sample `n` is counted from `offset` (the number of samples so far), so the stream is split into calls at any length.
+static void reference_noise(const NOISE_TYPE type, double *const outputs, double *const states, ReferenceXoshiro128 *const generators, const size_t offset, const size_t length) {
+  for (size_t n = 0; n < length; n++) {
+    const double white = (ldexp((double)(reference_xoshiro128_next(&generators[(offset + n) % 4]) >> 8), -23)) - 1.0;
+
+    switch (type) {
+      case WHITE_NOISE: {
+        outputs[n] = white;
+        break;
+      }
+
+      case PINK_NOISE: {
+        states[0] = (0.99886 * states[0]) + (white * 0.0555179);
+        states[1] = (0.99332 * states[1]) + (white * 0.0750759);
+        states[2] = (0.96900 * states[2]) + (white * 0.1538520);
+        states[3] = (0.86650 * states[3]) + (white * 0.3104856);
+        states[4] = (0.55000 * states[4]) + (white * 0.5329522);
+        states[5] = (-0.7616 * states[5]) - (white * 0.0168980);
+
+        outputs[n] = 0.11 * (states[0] + states[1] + states[2] + states[3] + states[4] + states[5] + states[6] + (white * 0.5362));
+
+        states[6] = white * 0.115926;
+        break;
+      }
+
+      case BROWNIAN_NOISE: {
+        states[7] = (states[7] + (0.02 * white)) / 1.02;
+
+        outputs[n] = 3.5 * states[7];
+        break;
+      }
+    }
+  }
+}
+
+static void check_noise(const NOISE_TYPE type, const NoiseGenerator generator, const char *const name) {
+  const unsigned int seed = 1000 + type;
+
+  void *context = noisegenerator_create(seed);
+
+  std::vector<double> expecteds(buffer_size);
+
+  double states[8] = { 0.0 };
+
+  ReferenceXoshiro128 generators[4];
+
+  reference_seed(generators, seed);
+
+  for (size_t block = 0; block < number_of_blocks; block++) {
+    const float *actuals = generator(context);
+
+    reference_noise(type, expecteds.data(), states, generators, (block * buffer_size), buffer_size);
+
+    check(name, buffer_size, actuals, expecteds.data(), buffer_size, tolerance);
+  }
+
+  noisegenerator_destroy(context);
+}
+
+// Stream that is rendered by calls of various lengths (states are carried over calls)
+static void check_render(const NOISE_TYPE type, const NoiseRenderer renderer, const char *const name) {
+  const unsigned int seed = 2000 + type;
+
+  void *context = noisegenerator_create(seed);
+
+  size_t total = 0;
+
+  for (const size_t length : render_lengths) {
+    total += length;
+  }
+
+  std::vector<float> actuals(total);
+  std::vector<double> expecteds(total);
+
+  double states[8] = { 0.0 };
+
+  ReferenceXoshiro128 generators[4];
+
+  reference_seed(generators, seed);
+
+  reference_noise(type, expecteds.data(), states, generators, 0, total);
+
+  size_t offset = 0;
+
+  for (const size_t length : render_lengths) {
+    const float *outputs = renderer(context, length);
+
+    for (size_t n = 0; n < length; n++) {
+      actuals[offset + n] = outputs[n];
+    }
+
+    offset += length;
+  }
+
+  check(name, total, actuals.data(), expecteds.data(), total, tolerance);
+
+  noisegenerator_destroy(context);
+}
+
+// Same seed yields the same output and another seed (or another instance) yields the other output
+static void check_determinism(void) {
+  void *context1 = noisegenerator_create(7);
+  void *context2 = noisegenerator_create(7);
+  void *context3 = noisegenerator_create(8);
+
+  std::vector<double> expecteds(number_of_blocks * buffer_size);
+  std::vector<float> actuals(number_of_blocks * buffer_size);
+
+  size_t number_of_differences = 0;
+
+  for (size_t block = 0; block < number_of_blocks; block++) {
+    const float *outputs1 = noisegenerator_pinknoise(context1);
+    const float *outputs2 = noisegenerator_pinknoise(context2);
+    const float *outputs3 = noisegenerator_pinknoise(context3);
+
+    for (size_t n = 0; n < buffer_size; n++) {
+      expecteds[(block * buffer_size) + n] = outputs1[n];
+      actuals[(block * buffer_size) + n]   = outputs2[n];
+
+      if (outputs1[n] != outputs3[n]) {
+        ++number_of_differences;
+      }
+    }
+  }
+
+  check("pinknoise (same seed)", buffer_size, actuals.data(), expecteds.data(), (number_of_blocks * buffer_size), 0.0);
+
+  const bool passed = number_of_differences >= ((number_of_blocks * buffer_size) / 2);
+
+  printf("%s %-40s %8zu different samples %zu\n", (passed ? "PASS" : "FAIL"), "pinknoise (another seed)", buffer_size, number_of_differences);
+
+  if (!passed) {
+    ++number_of_failures;
+  }
+
+  noisegenerator_destroy(context1);
+  noisegenerator_destroy(context2);
+  noisegenerator_destroy(context3);
+}
+
+// API without context is seeded by `time` on every call
+static void check_whitenoise_by_time(void) {
+  void *context = noisegenerator_create(1234);
+
+  const float *actuals1 = whitenoise(1234);
+
+  std::vector<double> expecteds(buffer_size);
+
+  const float *outputs = noisegenerator_whitenoise(context);
+
+  for (size_t n = 0; n < buffer_size; n++) {
+    expecteds[n] = outputs[n];
+  }
+
+  check("whitenoise (time)", buffer_size, actuals1, expecteds.data(), buffer_size, 0.0);
+
+  // Again by the same time
+  check("whitenoise (same time)", buffer_size, whitenoise(1234), expecteds.data(), buffer_size, 0.0);
+
+  noisegenerator_destroy(context);
+}
+
+// Previous implementation (`srand` per block and `rand` per sample) for comparison
+static float legacy_outputs[buffer_size];
+
+static float *legacy_whitenoise(const unsigned int time) {
+  srand(time);
+
+  for (size_t n = 0; n < buffer_size; n++) {
+    legacy_outputs[n] = (2.0f * ((float)rand() / ((float)RAND_MAX + 1.0f))) - 1.0f;
+  }
+
+  return legacy_outputs;
+}
+
+int main(int argc, char **argv) {
+  check_noise(WHITE_NOISE, noisegenerator_whitenoise, "whitenoise");
+  check_noise(PINK_NOISE, noisegenerator_pinknoise, "pinknoise");
+  check_noise(BROWNIAN_NOISE, noisegenerator_browniannoise, "browniannoise");
+  check_render(WHITE_NOISE, noisegenerator_render_whitenoise, "whitenoise (render)");
+  check_render(PINK_NOISE, noisegenerator_render_pinknoise, "pinknoise (render)");
+  check_render(BROWNIAN_NOISE, noisegenerator_render_browniannoise, "browniannoise (render)");
+  check_determinism();
+  check_whitenoise_by_time();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  unsigned int time = 0;
+
+  benchmark("whitenoise (srand / rand)", buffer_size, buffer_size, [&]() {
+    legacy_whitenoise(time++);
+  });
+
+  const NoiseGenerator generators[] = { noisegenerator_whitenoise, noisegenerator_pinknoise, noisegenerator_browniannoise };
+  const char *names[]               = { "whitenoise", "pinknoise", "browniannoise" };
+
+  for (int i = 0; i < 3; i++) {
+    void *context = noisegenerator_create(0);
+
+    benchmark(names[i], buffer_size, buffer_size, [&]() {
+      generators[i](context);
+    });
+
+    noisegenerator_destroy(context);
+  }
+
+  const NoiseRenderer renderers[] = { noisegenerator_render_whitenoise, noisegenerator_render_pinknoise, noisegenerator_render_browniannoise };
+  const char *render_names[]      = { "whitenoise (render)", "pinknoise (render)", "browniannoise (render)" };
+
+  for (int i = 0; i < 3; i++) {
+    for (const size_t render_size : render_sizes) {
+      void *context = noisegenerator_create(0);
+
+      benchmark(render_names[i], render_size, render_size, [&]() {
+        renderers[i](context, render_size);
+      });
+
+      noisegenerator_destroy(context);
+    }
+  }
+
+  return number_of_failures;
+}
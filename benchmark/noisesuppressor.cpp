@@ -0,0 +1,418 @@
+#include "benchmark.hpp"
+
+extern "C" {
+void *noisesuppressor_create(const size_t fft_size);
+void noisesuppressor_destroy(void *const context);
+void noisesuppressor_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *noisesuppressor_inputs(void *const context);
+float *noisesuppressor_process(void *const context, const float threshold);
+float *noisesuppressor_stream_inputs(void *const context);
+float *noisesuppressor_stream_outputs(void *const context);
+float *noisesuppressor_stream_process(void *const context, const float threshold);
+size_t noisesuppressor_get_number_of_skipped_frames(void *const context);
+bool noisesuppressor_set_low_latency(void *const context, const bool low_latency);
+size_t noisesuppressor_get_latency(void *const context);
+float *noisesuppressor_render_inputs(void *const context, const size_t length);
+float *noisesuppressor_render(void *const context, const size_t length, const float threshold, const size_t number_of_threads);
+}
+
+static const size_t fft_sizes[] = { 512, 1024, 2048, 4096 };
+
+// Mixed-radix sizes (10 ms, 20 ms and 40 ms at 48 kHz). 1920 is multiple of render quantum size, so it is checked by streaming API too.
+static const size_t mixed_radix_fft_sizes[] = { 480, 960, 1920 };
+
+// Naive DFT per hop is expensive, so golden checks of streaming API are limited to these sizes
+static const size_t stream_fft_sizes[] = { 512, 1024 };
+
+static const size_t hop_size = 128;
+
+static const double tolerance = 1e-4;
+
+// Small FFT sizes of low-latency mode (streaming API)
+static const size_t low_latency_fft_sizes[] = { 256, 512 };
+
+// Spectral subtraction on `double` with naive DFT (golden output).
+// Windows are Hanning window unless they are given (low-latency mode).
+static void reference_noisesuppressor(const float *const inputs, double *const outputs, const size_t fft_size, const double threshold, const double *const analysis_window = nullptr, const double *const synthesis_window = nullptr) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  std::vector<double> window(fft_size);
+  std::vector<double> frame(fft_size);
+  std::vector<double> reals(fft_size);
+  std::vector<double> imags(fft_size);
+
+  reference_hanning_window(window.data(), fft_size);
+
+  const double *analysis  = (analysis_window == nullptr) ? window.data() : analysis_window;
+  const double *synthesis = (synthesis_window == nullptr) ? window.data() : synthesis_window;
+
+  for (size_t n = 0; n < fft_size; n++) {
+    frame[n] = analysis[n] * inputs[n];
+  }
+
+  reference_dft(frame.data(), nullptr, reals.data(), imags.data(), fft_size, -1);
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    const double amplitude = fmax((sqrt((reals[k] * reals[k]) + (imags[k] * imags[k])) - threshold), 0.0);
+    const double phase     = atan2(imags[k], reals[k]);
+
+    reals[k] = amplitude * cos(phase);
+    imags[k] = amplitude * sin(phase);
+  }
+
+  reference_inverse_real_dft(reals.data(), imags.data(), outputs, fft_size);
+
+  for (size_t n = 0; n < fft_size; n++) {
+    outputs[n] *= synthesis[n];
+  }
+}
+
+static void check_noisesuppressor(const size_t fft_size, const float threshold, const char *const name) {
+  void *context = noisesuppressor_create(fft_size);
+
+  float *inputs = noisesuppressor_inputs(context);
+
+  std::vector<double> expecteds(fft_size);
+
+  generate_signal(inputs, fft_size, 9);
+
+  reference_noisesuppressor(inputs, expecteds.data(), fft_size, threshold);
+
+  const float *actuals = noisesuppressor_process(context, threshold);
+
+  check(name, fft_size, actuals, expecteds.data(), fft_size, tolerance);
+
+  noisesuppressor_destroy(context);
+}
+
+// All channels (planar) are processed by one call
+static void check_planar_noisesuppressor(const size_t fft_size, const size_t number_of_channels) {
+  void *context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, number_of_channels);
+
+  float *inputs = noisesuppressor_inputs(context);
+
+  std::vector<double> expecteds(number_of_channels * fft_size);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs + (channel_number * fft_size)), fft_size, (16 + channel_number));
+
+    reference_noisesuppressor((inputs + (channel_number * fft_size)), (expecteds.data() + (channel_number * fft_size)), fft_size, 0.5);
+  }
+
+  check("noisesuppressor (planar)", fft_size, noisesuppressor_process(context, 0.5f), expecteds.data(), (number_of_channels * fft_size), tolerance);
+
+  noisesuppressor_destroy(context);
+}
+
+// Streaming API against `reference_overlap_add`.
+// If `with_silence`, signal is muted for 2 frames in the middle (transforms of silent frames are skipped).
+static void check_stream_noisesuppressor(const size_t fft_size, const size_t number_of_channels, const bool with_silence) {
+  void *context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, number_of_channels);
+
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  // Until the accumulators are filled and a little more
+  const size_t number_of_quanta = ((with_silence ? 4 : 2) * number_of_quanta_per_frame) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<double> expecteds(number_of_channels * length);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs.data() + (channel_number * length)), length, (20 + channel_number));
+
+    if (with_silence) {
+      mute((inputs.data() + (channel_number * length)), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+    }
+
+    reference_overlap_add((inputs.data() + (channel_number * length)), (expecteds.data() + (channel_number * length)), fft_size, hop_size, number_of_quanta, [&](const float *frame, double *outputs) {
+      reference_noisesuppressor(frame, outputs, fft_size, 0.5);
+    });
+  }
+
+  stream(noisesuppressor_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return noisesuppressor_stream_process(context, 0.5f);
+  });
+
+  const char *name = with_silence ? "noisesuppressor (stream, silence)" : "noisesuppressor (stream)";
+
+  check(name, fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  if (with_silence) {
+    check_count(name, fft_size, noisesuppressor_get_number_of_skipped_frames(context), reference_number_of_silent_frames(inputs.data(), number_of_channels, fft_size, hop_size, number_of_quanta));
+  }
+
+  noisesuppressor_destroy(context);
+}
+
+// Low-latency mode of streaming API against overlap-add of the latest 2 hops of frames by asymmetric windows.
+// Latency is `2 * hop_size - 128` samples instead of `fft_size - 128` samples, and bypass (threshold `0`) is input that is delayed by latency exactly.
+static void check_low_latency_noisesuppressor(const size_t fft_size, const size_t number_of_channels) {
+  void *context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, number_of_channels);
+
+  check_count("noisesuppressor (latency)", fft_size, noisesuppressor_get_latency(context), (fft_size - reference_render_quantum_size));
+  check_count("noisesuppressor (low latency, set)", fft_size, noisesuppressor_set_low_latency(context, true), 1);
+
+  const size_t latency = (2 * hop_size) - reference_render_quantum_size;
+
+  check_count("noisesuppressor (low latency, latency)", fft_size, noisesuppressor_get_latency(context), latency);
+
+  const size_t number_of_quanta = (4 * (fft_size / hop_size)) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<double> analysis_window(fft_size);
+  std::vector<double> synthesis_window(fft_size);
+
+  reference_low_latency_windows(analysis_window.data(), synthesis_window.data(), fft_size, hop_size);
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<double> expecteds(number_of_channels * length);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs.data() + (channel_number * length)), length, (24 + channel_number));
+
+    reference_overlap_add((inputs.data() + (channel_number * length)), (expecteds.data() + (channel_number * length)), fft_size, hop_size, (2 * hop_size), number_of_quanta, [&](const float *frame, double *outputs) {
+      reference_noisesuppressor(frame, outputs, fft_size, 0.5, analysis_window.data(), synthesis_window.data());
+    });
+  }
+
+  stream(noisesuppressor_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return noisesuppressor_stream_process(context, 0.5f);
+  });
+
+  check("noisesuppressor (stream, low latency)", fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  noisesuppressor_destroy(context);
+
+  context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, number_of_channels);
+  noisesuppressor_set_low_latency(context, true);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    for (size_t n = 0; n < length; n++) {
+      expecteds[(channel_number * length) + n] = (n < latency) ? 0.0 : inputs[(channel_number * length) + (n - latency)];
+    }
+  }
+
+  stream(noisesuppressor_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return noisesuppressor_stream_process(context, 0.0f);
+  });
+
+  check("noisesuppressor (stream, low latency, bypass)", fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  noisesuppressor_destroy(context);
+}
+
+// Offline rendering against streaming API on any number of threads.
+// Signal is long enough to be split into jobs of render quanta (24 frames), and channel `0` is muted across the boundary of jobs.
+static void check_render_noisesuppressor(const size_t fft_size, const size_t number_of_channels, const bool low_latency = false) {
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  const size_t number_of_quanta = (24 * number_of_quanta_per_frame) + 3;
+  const size_t length           = number_of_quanta * hop_size;
+  const size_t render_length    = length - render_tail_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> expecteds(number_of_channels * length);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    float *signal = inputs.data() + (channel_number * length);
+
+    generate_signal(signal, length, (30 + channel_number));
+
+    memset((signal + render_length), 0, (render_tail_size * sizeof(float)));
+
+    if (channel_number == 0) {
+      mute(signal, (10 * number_of_quanta_per_frame), (14 * number_of_quanta_per_frame));
+    }
+  }
+
+  void *context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, number_of_channels);
+  noisesuppressor_set_low_latency(context, low_latency);
+
+  stream(noisesuppressor_stream_inputs(context), inputs.data(), expecteds.data(), number_of_channels, number_of_quanta, [&]() {
+    return noisesuppressor_stream_process(context, 0.5f);
+  });
+
+  const size_t number_of_skipped_frames = noisesuppressor_get_number_of_skipped_frames(context);
+
+  noisesuppressor_destroy(context);
+
+  for (const size_t number_of_threads : render_numbers_of_threads) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "noisesuppressor (render, %zu ch%s) x%zu", number_of_channels, (low_latency ? ", low latency" : ""), number_of_threads);
+
+    context = noisesuppressor_create(fft_size);
+
+    noisesuppressor_set_number_of_channels(context, number_of_channels);
+    noisesuppressor_set_low_latency(context, low_latency);
+
+    copy_render_signal(noisesuppressor_render_inputs(context, render_length), inputs.data(), number_of_channels, number_of_quanta, render_length);
+
+    const float *actuals = noisesuppressor_render(context, render_length, 0.5f, number_of_threads);
+
+    check_render(name, fft_size, actuals, expecteds.data(), number_of_channels, number_of_quanta, render_length);
+    check_count(name, fft_size, noisesuppressor_get_number_of_skipped_frames(context), number_of_skipped_frames);
+
+    noisesuppressor_destroy(context);
+  }
+}
+
+// Streaming API and offline rendering are rejected (`nullptr`) for mixed-radix sizes that are not multiple of render quantum size
+static void check_rejected_stream_noisesuppressor(const size_t fft_size) {
+  void *context = noisesuppressor_create(fft_size);
+
+  noisesuppressor_set_number_of_channels(context, 2);
+
+  noisesuppressor_render_inputs(context, fft_size);
+
+  check_rejected_stream("noisesuppressor (stream, mixed-radix)", fft_size, {
+    noisesuppressor_stream_inputs(context),
+    noisesuppressor_stream_outputs(context),
+    noisesuppressor_stream_process(context, 0.5f),
+    noisesuppressor_render(context, fft_size, 0.5f, 2)
+  });
+
+  check_count("noisesuppressor (latency, mixed-radix)", fft_size, noisesuppressor_get_latency(context), 0);
+
+  noisesuppressor_destroy(context);
+}
+
+// Render quanta are fixed until the number of channels is changed
+static void check_stable_stream_buffers(void) {
+  void *context = noisesuppressor_create(1024);
+
+  noisesuppressor_set_number_of_channels(context, 2);
+
+  generate_signal(noisesuppressor_stream_inputs(context), (2 * hop_size), 8);
+
+  check_stable_buffers("noisesuppressor (stable buffers)", 1024, [&]() {
+    return noisesuppressor_stream_outputs(context);
+  }, [&]() {
+    return noisesuppressor_stream_process(context, 0.5f);
+  }, [&]() {
+    noisesuppressor_set_number_of_channels(context, 1);
+  });
+
+  noisesuppressor_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  for (const size_t fft_size : fft_sizes) {
+    check_noisesuppressor(fft_size, 0.5f, "noisesuppressor (threshold 0.5)");
+    check_noisesuppressor(fft_size, 4.0f, "noisesuppressor (threshold 4)");
+    check_planar_noisesuppressor(fft_size, 2);
+  }
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_stream_noisesuppressor(fft_size, 2, false);
+    check_stream_noisesuppressor(fft_size, 2, true);
+  }
+
+  for (const size_t fft_size : mixed_radix_fft_sizes) {
+    check_noisesuppressor(fft_size, 0.5f, "noisesuppressor (mixed-radix)");
+
+    if ((fft_size % hop_size) != 0) {
+      check_rejected_stream_noisesuppressor(fft_size);
+    }
+  }
+
+  check_stream_noisesuppressor(1920, 1, false);
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_render_noisesuppressor(fft_size, 1);
+    check_render_noisesuppressor(fft_size, 2);
+  }
+
+  for (const size_t fft_size : low_latency_fft_sizes) {
+    check_low_latency_noisesuppressor(fft_size, 2);
+  }
+
+  check_render_noisesuppressor(512, 2, true);
+
+  check_stable_stream_buffers();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  for (const size_t fft_size : fft_sizes) {
+    void *context = noisesuppressor_create(fft_size);
+
+    generate_signal(noisesuppressor_inputs(context), fft_size, 10);
+
+    benchmark("noisesuppressor", fft_size, fft_size, [&]() {
+      noisesuppressor_process(context, 0.5f);
+    });
+
+    noisesuppressor_set_number_of_channels(context, 2);
+
+    generate_signal(noisesuppressor_inputs(context), (2 * fft_size), 10);
+
+    benchmark("noisesuppressor (2 channels)", fft_size, (2 * fft_size), [&]() {
+      noisesuppressor_process(context, 0.5f);
+    });
+
+    generate_signal(noisesuppressor_stream_inputs(context), (2 * hop_size), 10);
+
+    benchmark("noisesuppressor (stream, 2 channels)", fft_size, (2 * hop_size), [&]() {
+      noisesuppressor_stream_process(context, 0.5f);
+    });
+
+    // Transforms of silent frames are skipped
+    memset(noisesuppressor_stream_inputs(context), 0, (2 * hop_size * sizeof(float)));
+
+    benchmark("noisesuppressor (stream, silence)", fft_size, (2 * hop_size), [&]() {
+      noisesuppressor_stream_process(context, 0.5f);
+    });
+
+    // 1 second of stereo at 48 kHz (jobs are split by channels, then by render quanta)
+    const size_t render_length = 48000;
+
+    generate_signal(noisesuppressor_render_inputs(context, render_length), (2 * render_length), 10);
+
+    for (const size_t number_of_threads : benchmark_render_numbers_of_threads) {
+      char name[64];
+
+      snprintf(name, sizeof(name), "noisesuppressor (render, %zu threads)", number_of_threads);
+
+      benchmark(name, fft_size, (2 * render_length), [&]() {
+        noisesuppressor_render(context, render_length, 0.5f, number_of_threads);
+      });
+    }
+
+    noisesuppressor_destroy(context);
+  }
+
+  // Small frames of low-latency mode (output is delayed by 128 samples)
+  for (const size_t fft_size : low_latency_fft_sizes) {
+    void *context = noisesuppressor_create(fft_size);
+
+    noisesuppressor_set_number_of_channels(context, 2);
+    noisesuppressor_set_low_latency(context, true);
+
+    generate_signal(noisesuppressor_stream_inputs(context), (2 * hop_size), 10);
+
+    benchmark("noisesuppressor (stream, low latency)", fft_size, (2 * hop_size), [&]() {
+      noisesuppressor_stream_process(context, 0.5f);
+    });
+
+    noisesuppressor_destroy(context);
+  }
+
+  return number_of_failures;
+}
@@ -0,0 +1,709 @@
+#include "benchmark.hpp"
+
+extern "C" {
+void *pitchshifter_create(const size_t fft_size);
+void pitchshifter_destroy(void *const context);
+void pitchshifter_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *pitchshifter_inputs(void *const context);
+float *pitchshifter_process(void *const context, const float pitch, const float speed, const size_t time_cursor);
+float *pitchshifter_stream_inputs(void *const context);
+float *pitchshifter_stream_outputs(void *const context);
+float *pitchshifter_stream_process(void *const context, const float pitch, const float speed, const float dry, const float wet);
+float *pitchshifter_stream_process_by_phase_vocoder(void *const context, const float pitch, const float speed, const float dry, const float wet);
+bool pitchshifter_set_voice(void *const context, const size_t index, const float pitch, const float wet);
+size_t pitchshifter_set_number_of_voices(void *const context, const size_t number_of_voices);
+float *pitchshifter_stream_process_by_voices(void *const context, const float speed, const float dry);
+size_t pitchshifter_set_hop_size(void *const context, const size_t hop_size);
+size_t pitchshifter_get_number_of_skipped_frames(void *const context);
+bool pitchshifter_set_low_latency(void *const context, const bool low_latency);
+size_t pitchshifter_get_latency(void *const context);
+float *pitchshifter_render_inputs(void *const context, const size_t length);
+float *pitchshifter_render(void *const context, const size_t length, const float pitch, const float speed, const float dry, const float wet, const size_t number_of_threads);
+float *pitchshifter_render_by_phase_vocoder(void *const context, const size_t length, const float pitch, const float speed, const float dry, const float wet, const size_t number_of_threads);
+}
+
+static const size_t fft_sizes[] = { 512, 1024, 2048, 4096 };
+
+// Naive DFT per hop is expensive, so golden checks of streaming API are limited to these sizes
+static const size_t stream_fft_sizes[] = { 512, 1024 };
+
+static const size_t hop_size = 128;
+
+static const double tolerance = 1e-4;
+
+// Small FFT sizes of low-latency mode (streaming API)
+static const size_t low_latency_fft_sizes[] = { 256, 512 };
+
+// Mixed-radix sizes that are not multiple of render quantum size (only frame-based API is available)
+static const size_t mixed_radix_fft_sizes[] = { 480, 960 };
+
+// Peak shifting on `double` with naive DFT (golden output).
+// Windows are Hanning window unless they are given (low-latency mode).
+static void reference_pitchshifter(const float *const inputs, double *const outputs, const size_t fft_size, const double pitch, const double speed, const size_t time_cursor, const double *const analysis_window = nullptr, const double *const synthesis_window = nullptr) {
+  const size_t half_fft_size = fft_size / 2;
+  const size_t buffer_size   = half_fft_size + 1;
+
+  std::vector<double> window(fft_size);
+  std::vector<double> frame(fft_size);
+  std::vector<double> reals(fft_size);
+  std::vector<double> imags(fft_size);
+  std::vector<double> magnitudes(buffer_size);
+  std::vector<int> peak_indexes;
+  std::vector<double> shifted_reals(buffer_size);
+  std::vector<double> shifted_imags(buffer_size);
+
+  reference_hanning_window(window.data(), fft_size);
+
+  const double *analysis  = (analysis_window == nullptr) ? window.data() : analysis_window;
+  const double *synthesis = (synthesis_window == nullptr) ? window.data() : synthesis_window;
+
+  for (size_t n = 0; n < fft_size; n++) {
+    frame[n] = analysis[n] * inputs[n];
+  }
+
+  reference_dft(frame.data(), nullptr, reals.data(), imags.data(), fft_size, -1);
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    magnitudes[k] = (reals[k] * reals[k]) + (imags[k] * imags[k]);
+  }
+
+  for (int index = 2; index < (int)(buffer_size - 2);) {
+    const double magnitude = magnitudes[index];
+
+    if ((magnitudes[index - 1] >= magnitude) || (magnitudes[index - 2] >= magnitude) || (magnitudes[index + 1] >= magnitude) || (magnitudes[index + 2] >= magnitude)) {
+      ++index;
+      continue;
+    }
+
+    peak_indexes.push_back(index);
+
+    index += 2;
+  }
+
+  const int number_of_peaks = (int)peak_indexes.size();
+
+  for (int k = 0; k < number_of_peaks; k++) {
+    const int peak_index         = peak_indexes[k];
+    const int shifted_peak_index = (int)round(peak_index * pitch * (1 / speed));
+
+    if (shifted_peak_index > (int)buffer_size) {
+      break;
+    }
+
+    int start_index = 0;
+    int end_index   = (int)fft_size;
+
+    if (k > 0) {
+      start_index = peak_index - (int)floor((peak_index - peak_indexes[k - 1]) / 2.0);
+    }
+
+    if (k < (number_of_peaks - 1)) {
+      end_index = peak_index + (int)ceil((peak_indexes[k + 1] - peak_index) / 2.0);
+    }
+
+    for (int m = (start_index - peak_index); m < (end_index - peak_index); m++) {
+      const int bin_count_index         = peak_index + m;
+      const int shifted_bin_count_index = shifted_peak_index + m;
+
+      if (shifted_bin_count_index >= (int)buffer_size) {
+        break;
+      }
+
+      if (shifted_bin_count_index < 0) {
+        continue;
+      }
+
+      const double real = reals[bin_count_index];
+      const double imag = imags[bin_count_index];
+
+      const double omega = (2.0 * M_PI * (shifted_bin_count_index - bin_count_index)) / fft_size;
+
+      shifted_reals[shifted_bin_count_index] += (real * cos(omega * time_cursor)) - (imag * sin(omega * time_cursor));
+      shifted_imags[shifted_bin_count_index] += (real * sin(omega * time_cursor)) + (imag * cos(omega * time_cursor));
+    }
+  }
+
+  reference_inverse_real_dft(shifted_reals.data(), shifted_imags.data(), outputs, fft_size);
+
+  for (size_t n = 0; n < fft_size; n++) {
+    outputs[n] *= synthesis[n];
+  }
+}
+
+// Phase vocoder on `double` with naive DFT (golden output). `analysis_phases` and `synthesis_phases` are kept between frames.
+static void reference_phase_vocoder(const float *const inputs, double *const outputs, const size_t fft_size, const double pitch, const double speed, const size_t frame_hop_size, std::vector<double> &analysis_phases, std::vector<double> &synthesis_phases, const double *const analysis_window = nullptr, const double *const synthesis_window = nullptr) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  std::vector<double> window(fft_size);
+  std::vector<double> frame(fft_size);
+  std::vector<double> reals(fft_size);
+  std::vector<double> imags(fft_size);
+  std::vector<double> magnitudes(buffer_size);
+  std::vector<double> frequencies(buffer_size);
+
+  reference_hanning_window(window.data(), fft_size);
+
+  const double *analysis  = (analysis_window == nullptr) ? window.data() : analysis_window;
+  const double *synthesis = (synthesis_window == nullptr) ? window.data() : synthesis_window;
+
+  for (size_t n = 0; n < fft_size; n++) {
+    frame[n] = analysis[n] * inputs[n];
+  }
+
+  reference_dft(frame.data(), nullptr, reals.data(), imags.data(), fft_size, -1);
+
+  const double ratio          = pitch / speed;
+  const double expected_phase = (2.0 * M_PI * frame_hop_size) / fft_size;
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    const size_t shifted_k = (size_t)round(k * ratio);
+
+    const double phase = atan2(imags[k], reals[k]);
+
+    double deviation = phase - analysis_phases[k] - (k * expected_phase);
+
+    deviation -= 2.0 * M_PI * round(deviation / (2.0 * M_PI));
+
+    analysis_phases[k] = phase;
+
+    if (shifted_k >= buffer_size) {
+      continue;
+    }
+
+    magnitudes[shifted_k] += sqrt((reals[k] * reals[k]) + (imags[k] * imags[k]));
+    frequencies[shifted_k] = ((k * expected_phase) + deviation) * ratio;
+  }
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    synthesis_phases[k] += frequencies[k];
+
+    reals[k] = magnitudes[k] * cos(synthesis_phases[k]);
+    imags[k] = magnitudes[k] * sin(synthesis_phases[k]);
+  }
+
+  reference_inverse_real_dft(reals.data(), imags.data(), outputs, fft_size);
+
+  for (size_t n = 0; n < fft_size; n++) {
+    outputs[n] *= synthesis[n];
+  }
+}
+
+// Samples of 10 hours at 48 kHz (phase rotation by `time_cursor` must not lose precision over long sessions)
+static const size_t long_session_time_cursor = 10 * 3600 * 48000;
+
+static void check_pitchshifter(const size_t fft_size, const float pitch, const char *const name, const size_t first_time_cursor = 0) {
+  void *context = pitchshifter_create(fft_size);
+
+  std::vector<float> signal(fft_size + (4 * hop_size));
+  std::vector<double> expecteds(fft_size);
+
+  generate_signal(signal.data(), signal.size(), 7);
+
+  // Several hops, so that phase rotation by `time_cursor` is covered
+  for (size_t offset = 0; offset <= (4 * hop_size); offset += hop_size) {
+    const float *inputs = signal.data() + offset;
+
+    const size_t time_cursor = first_time_cursor + offset;
+
+    memcpy(pitchshifter_inputs(context), inputs, (fft_size * sizeof(float)));
+
+    const float *actuals = pitchshifter_process(context, pitch, 1.0f, time_cursor);
+
+    reference_pitchshifter(inputs, expecteds.data(), fft_size, pitch, 1.0, time_cursor);
+
+    check(name, fft_size, actuals, expecteds.data(), fft_size, tolerance);
+  }
+
+  pitchshifter_destroy(context);
+}
+
+// All channels (planar) are processed by one call
+static void check_planar_pitchshifter(const size_t fft_size, const size_t number_of_channels) {
+  void *context = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(context, number_of_channels);
+
+  float *inputs = pitchshifter_inputs(context);
+
+  std::vector<double> expecteds(number_of_channels * fft_size);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs + (channel_number * fft_size)), fft_size, (16 + channel_number));
+
+    reference_pitchshifter((inputs + (channel_number * fft_size)), (expecteds.data() + (channel_number * fft_size)), fft_size, 1.5, 1.0, hop_size);
+  }
+
+  check("pitchshifter (planar)", fft_size, pitchshifter_process(context, 1.5f, 1.0f, hop_size), expecteds.data(), (number_of_channels * fft_size), tolerance);
+
+  pitchshifter_destroy(context);
+}
+
+// Streaming API against `reference_overlap_add` (pitch `1` is bypass).
+// If `with_silence`, signal is muted for 2 frames in the middle (transforms of silent frames are skipped).
+// If `low_latency`, frames are windowed by asymmetric windows, and only the latest 2 hops of them are overlap-added.
+static void check_stream_pitchshifter(const size_t fft_size, const size_t number_of_channels, const bool phase_vocoder, const size_t frame_hop_size, const float pitch, const float dry, const float wet, const bool with_silence, const char *const name, const bool low_latency = false) {
+  void *context = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(context, number_of_channels);
+  pitchshifter_set_low_latency(context, low_latency);
+
+  if (pitchshifter_set_hop_size(context, frame_hop_size) != frame_hop_size) {
+    printf("FAIL %-40s %8zu hop size %zu is not set\n", name, fft_size, frame_hop_size);
+
+    ++number_of_failures;
+  }
+
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  // Until the accumulators are filled and a little more
+  const size_t number_of_quanta = ((with_silence ? 4 : 2) * number_of_quanta_per_frame) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<double> expecteds(number_of_channels * length);
+
+  std::vector<double> analysis_window(fft_size);
+  std::vector<double> synthesis_window(fft_size);
+
+  reference_low_latency_windows(analysis_window.data(), synthesis_window.data(), fft_size, frame_hop_size);
+
+  const double *analysis  = low_latency ? analysis_window.data() : nullptr;
+  const double *synthesis = low_latency ? synthesis_window.data() : nullptr;
+
+  const size_t synthesis_size = low_latency ? (2 * frame_hop_size) : fft_size;
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs.data() + (channel_number * length)), length, (20 + channel_number));
+
+    if (with_silence) {
+      mute((inputs.data() + (channel_number * length)), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+    }
+
+    size_t time_cursor = 0;
+
+    std::vector<double> analysis_phases((fft_size / 2) + 1);
+    std::vector<double> synthesis_phases((fft_size / 2) + 1);
+
+    reference_overlap_add((inputs.data() + (channel_number * length)), (expecteds.data() + (channel_number * length)), fft_size, frame_hop_size, synthesis_size, number_of_quanta, [&](const float *frame, double *outputs) {
+      if (pitch == 1.0f) {
+        for (size_t n = 0; n < fft_size; n++) {
+          outputs[n] = frame[n];
+        }
+
+        return;
+      }
+
+      if (phase_vocoder) {
+        reference_phase_vocoder(frame, outputs, fft_size, pitch, 1.0, frame_hop_size, analysis_phases, synthesis_phases, analysis, synthesis);
+      } else {
+        reference_pitchshifter(frame, outputs, fft_size, pitch, 1.0, time_cursor, analysis, synthesis);
+      }
+
+      if (dry != 0.0f) {
+        for (size_t n = 0; n < fft_size; n++) {
+          outputs[n] = (dry * frame[n]) + (wet * outputs[n]);
+        }
+      }
+
+      time_cursor += frame_hop_size;
+    });
+  }
+
+  stream(pitchshifter_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    if (phase_vocoder) {
+      return pitchshifter_stream_process_by_phase_vocoder(context, pitch, 1.0f, dry, wet);
+    }
+
+    return pitchshifter_stream_process(context, pitch, 1.0f, dry, wet);
+  });
+
+  check(name, fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  if (with_silence) {
+    check_count(name, fft_size, pitchshifter_get_number_of_skipped_frames(context), reference_number_of_silent_frames(inputs.data(), number_of_channels, fft_size, frame_hop_size, number_of_quanta));
+  }
+
+  // Golden output is delayed by `synthesis_size - 128` samples
+  check_count(name, fft_size, pitchshifter_get_latency(context), (synthesis_size - reference_render_quantum_size));
+
+  pitchshifter_destroy(context);
+}
+
+// Voices (pitch and wet) of harmony
+static const float voice_pitches[] = { 1.25f, 1.5f, 0.75f, 1.0f };
+static const float voice_wets[]    = { 0.5f, 0.4f, 0.3f, 0.2f };
+
+static const size_t number_of_voices = sizeof(voice_pitches) / sizeof(voice_pitches[0]);
+
+// Multi-voice streaming API against sum of peak shifting per voice (`dry * inputs + sum(wet * shifted)`).
+// If `with_silence`, signal is muted for 2 frames in the middle (transforms of silent frames are skipped).
+static void check_stream_voices(const size_t fft_size, const size_t number_of_channels, const size_t frame_hop_size, const float dry, const bool with_silence, const char *const name) {
+  void *context = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(context, number_of_channels);
+  pitchshifter_set_hop_size(context, frame_hop_size);
+
+  for (size_t i = 0; i < number_of_voices; i++) {
+    pitchshifter_set_voice(context, i, voice_pitches[i], voice_wets[i]);
+  }
+
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  // Until the accumulators are filled and a little more
+  const size_t number_of_quanta = ((with_silence ? 4 : 2) * number_of_quanta_per_frame) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<double> expecteds(number_of_channels * length);
+  std::vector<double> window(fft_size);
+  std::vector<double> shifted(fft_size);
+
+  reference_hanning_window(window.data(), fft_size);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    generate_signal((inputs.data() + (channel_number * length)), length, (30 + channel_number));
+
+    if (with_silence) {
+      mute((inputs.data() + (channel_number * length)), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+    }
+
+    size_t time_cursor = 0;
+
+    reference_overlap_add((inputs.data() + (channel_number * length)), (expecteds.data() + (channel_number * length)), fft_size, frame_hop_size, number_of_quanta, [&](const float *frame, double *outputs) {
+      for (size_t n = 0; n < fft_size; n++) {
+        outputs[n] = dry * frame[n];
+      }
+
+      for (size_t i = 0; i < number_of_voices; i++) {
+        if (voice_pitches[i] == 1.0f) {
+          // Analysis and synthesis window
+          for (size_t n = 0; n < fft_size; n++) {
+            shifted[n] = window[n] * window[n] * frame[n];
+          }
+        } else {
+          reference_pitchshifter(frame, shifted.data(), fft_size, voice_pitches[i], 1.0, time_cursor);
+        }
+
+        for (size_t n = 0; n < fft_size; n++) {
+          outputs[n] += voice_wets[i] * shifted[n];
+        }
+      }
+
+      time_cursor += frame_hop_size;
+    });
+  }
+
+  stream(pitchshifter_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return pitchshifter_stream_process_by_voices(context, 1.0f, dry);
+  });
+
+  check(name, fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  if (with_silence) {
+    check_count(name, fft_size, pitchshifter_get_number_of_skipped_frames(context), reference_number_of_silent_frames(inputs.data(), number_of_channels, fft_size, frame_hop_size, number_of_quanta));
+  }
+
+  pitchshifter_destroy(context);
+}
+
+// Voices are appended in order, replaced by index, and removed from the end
+static void check_voices(void) {
+  void *context = pitchshifter_create(1024);
+
+  size_t number_of_set_voices = 0;
+
+  // Index must not skip voices
+  number_of_set_voices += pitchshifter_set_voice(context, 1, 1.5f, 1.0f) ? 1 : 0;
+
+  for (size_t i = 0; i < 10; i++) {
+    number_of_set_voices += pitchshifter_set_voice(context, i, 1.5f, 1.0f) ? 1 : 0;
+  }
+
+  check_count("pitchshifter (max voices)", 1024, number_of_set_voices, 8);
+  check_count("pitchshifter (remove voices)", 1024, pitchshifter_set_number_of_voices(context, 2), 2);
+  check_count("pitchshifter (remove voices)", 1024, pitchshifter_set_number_of_voices(context, 4), 2);
+
+  pitchshifter_destroy(context);
+}
+
+// Offline rendering against streaming API on any number of threads.
+// Signal is long enough to be split into jobs of render quanta (24 frames), and channel `0` is muted across the boundary of jobs.
+// Time cursor of job (peak shifting) and phases (phase vocoder, jobs of channels) must continue from the whole stream.
+static void check_render_pitchshifter(const size_t fft_size, const size_t number_of_channels, const bool phase_vocoder, const size_t frame_hop_size, const float pitch, const char *const name) {
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  const size_t number_of_quanta = (24 * number_of_quanta_per_frame) + 3;
+  const size_t length           = number_of_quanta * hop_size;
+  const size_t render_length    = length - render_tail_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> expecteds(number_of_channels * length);
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    float *signal = inputs.data() + (channel_number * length);
+
+    generate_signal(signal, length, (40 + channel_number));
+
+    memset((signal + render_length), 0, (render_tail_size * sizeof(float)));
+
+    if (channel_number == 0) {
+      mute(signal, (10 * number_of_quanta_per_frame), (14 * number_of_quanta_per_frame));
+    }
+  }
+
+  void *context = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(context, number_of_channels);
+  pitchshifter_set_hop_size(context, frame_hop_size);
+
+  stream(pitchshifter_stream_inputs(context), inputs.data(), expecteds.data(), number_of_channels, number_of_quanta, [&]() {
+    if (phase_vocoder) {
+      return pitchshifter_stream_process_by_phase_vocoder(context, pitch, 1.0f, 0.0f, 1.0f);
+    }
+
+    return pitchshifter_stream_process(context, pitch, 1.0f, 0.0f, 1.0f);
+  });
+
+  const size_t number_of_skipped_frames = pitchshifter_get_number_of_skipped_frames(context);
+
+  pitchshifter_destroy(context);
+
+  for (const size_t number_of_threads : render_numbers_of_threads) {
+    char thread_name[64];
+
+    snprintf(thread_name, sizeof(thread_name), "%s x%zu", name, number_of_threads);
+
+    context = pitchshifter_create(fft_size);
+
+    pitchshifter_set_number_of_channels(context, number_of_channels);
+    pitchshifter_set_hop_size(context, frame_hop_size);
+
+    copy_render_signal(pitchshifter_render_inputs(context, render_length), inputs.data(), number_of_channels, number_of_quanta, render_length);
+
+    const float *actuals = phase_vocoder ? pitchshifter_render_by_phase_vocoder(context, render_length, pitch, 1.0f, 0.0f, 1.0f, number_of_threads)
+                                         : pitchshifter_render(context, render_length, pitch, 1.0f, 0.0f, 1.0f, number_of_threads);
+
+    check_render(thread_name, fft_size, actuals, expecteds.data(), number_of_channels, number_of_quanta, render_length);
+    check_count(thread_name, fft_size, pitchshifter_get_number_of_skipped_frames(context), number_of_skipped_frames);
+
+    pitchshifter_destroy(context);
+  }
+}
+
+// Streaming API and offline rendering are rejected (`nullptr`), and frame-based API still works
+static void check_mixed_radix_pitchshifter(const size_t fft_size) {
+  void *context = pitchshifter_create(fft_size);
+
+  pitchshifter_set_number_of_channels(context, 2);
+
+  pitchshifter_render_inputs(context, fft_size);
+
+  check_rejected_stream("pitchshifter (stream, mixed-radix)", fft_size, {
+    pitchshifter_stream_inputs(context),
+    pitchshifter_stream_outputs(context),
+    pitchshifter_stream_process(context, 1.0f, 1.0f, 0.0f, 1.0f),
+    pitchshifter_stream_process_by_phase_vocoder(context, 1.5f, 1.0f, 0.0f, 1.0f),
+    pitchshifter_stream_process_by_voices(context, 1.0f, 1.0f),
+    pitchshifter_render(context, fft_size, 1.5f, 1.0f, 0.0f, 1.0f, 2)
+  });
+
+  check_count("pitchshifter (latency, mixed-radix)", fft_size, pitchshifter_get_latency(context), 0);
+
+  pitchshifter_destroy(context);
+
+  check_pitchshifter(fft_size, 1.5f, "pitchshifter (mixed-radix)");
+}
+
+// Render quanta are fixed until the number of channels is changed
+static void check_stable_stream_buffers(void) {
+  void *context = pitchshifter_create(1024);
+
+  pitchshifter_set_number_of_channels(context, 2);
+
+  generate_signal(pitchshifter_stream_inputs(context), (2 * hop_size), 8);
+
+  check_stable_buffers("pitchshifter (stable buffers)", 1024, [&]() {
+    return pitchshifter_stream_outputs(context);
+  }, [&]() {
+    return pitchshifter_stream_process(context, 1.5f, 1.0f, 0.0f, 1.0f);
+  }, [&]() {
+    pitchshifter_set_number_of_channels(context, 1);
+  });
+
+  pitchshifter_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  for (const size_t fft_size : fft_sizes) {
+    check_pitchshifter(fft_size, 1.5f, "pitchshifter (pitch 1.5)");
+    check_pitchshifter(fft_size, 0.75f, "pitchshifter (pitch 0.75)");
+    check_pitchshifter(fft_size, 1.5f, "pitchshifter (10 hours)", long_session_time_cursor);
+    check_planar_pitchshifter(fft_size, 2);
+  }
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 1.5f, 0.0f, 1.0f, false, "pitchshifter (stream)");
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 0.75f, 0.25f, 0.75f, false, "pitchshifter (stream, dry / wet)");
+    check_stream_pitchshifter(fft_size, 1, false, hop_size, 1.0f, 0.0f, 1.0f, false, "pitchshifter (stream, bypass)");
+    check_stream_pitchshifter(fft_size, 1, false, (fft_size / 4), 1.5f, 0.0f, 1.0f, false, "pitchshifter (stream, 4x overlap)");
+    check_stream_pitchshifter(fft_size, 2, true, (fft_size / 4), 1.5f, 0.0f, 1.0f, false, "vocoder (stream, 4x overlap)");
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 1.5f, 0.0f, 1.0f, true, "pitchshifter (stream, silence)");
+
+    // Hop size is render quantum size at least
+    if ((fft_size / 8) >= hop_size) {
+      check_stream_pitchshifter(fft_size, 1, true, (fft_size / 8), 0.75f, 0.0f, 1.0f, false, "vocoder (stream, 8x overlap)");
+    }
+  }
+
+  for (const size_t fft_size : low_latency_fft_sizes) {
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 1.5f, 0.0f, 1.0f, false, "pitchshifter (stream, low latency)", true);
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 0.75f, 0.25f, 0.75f, false, "pitchshifter (stream, low latency, dry / wet)", true);
+    check_stream_pitchshifter(fft_size, 1, false, hop_size, 1.0f, 0.0f, 1.0f, false, "pitchshifter (stream, low latency, bypass)", true);
+    check_stream_pitchshifter(fft_size, 2, true, hop_size, 1.5f, 0.0f, 1.0f, false, "vocoder (stream, low latency)", true);
+    check_stream_pitchshifter(fft_size, 2, false, hop_size, 1.5f, 0.0f, 1.0f, true, "pitchshifter (stream, low latency, silence)", true);
+  }
+
+  // 2x overlap (hop size is a half of FFT size)
+  check_stream_pitchshifter(512, 1, false, 256, 1.5f, 0.0f, 1.0f, false, "pitchshifter (stream, low latency, 2x)", true);
+
+  for (const size_t fft_size : mixed_radix_fft_sizes) {
+    check_mixed_radix_pitchshifter(fft_size);
+  }
+
+  check_stream_pitchshifter(1920, 1, false, hop_size, 1.0f, 0.0f, 1.0f, false, "pitchshifter (stream, bypass, mixed-radix)");
+
+  check_voices();
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_stream_voices(fft_size, 2, hop_size, 0.0f, false, "pitchshifter (stream, 4 voices)");
+    check_stream_voices(fft_size, 1, (fft_size / 4), 0.5f, false, "pitchshifter (stream, 4 voices, dry, 4x)");
+    check_stream_voices(fft_size, 2, hop_size, 0.5f, true, "pitchshifter (stream, 4 voices, silence)");
+  }
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_render_pitchshifter(fft_size, 2, false, hop_size, 1.5f, "pitchshifter (render)");
+    check_render_pitchshifter(fft_size, 1, false, (fft_size / 4), 1.5f, "pitchshifter (render, 4x)");
+    check_render_pitchshifter(fft_size, 1, false, hop_size, 1.0f, "pitchshifter (render, bypass)");
+    check_render_pitchshifter(fft_size, 2, true, (fft_size / 4), 1.5f, "vocoder (render, 4x)");
+  }
+
+  check_stable_stream_buffers();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  for (const size_t fft_size : fft_sizes) {
+    void *context = pitchshifter_create(fft_size);
+
+    generate_signal(pitchshifter_inputs(context), fft_size, 8);
+
+    size_t time_cursor = 0;
+
+    benchmark("pitchshifter", fft_size, fft_size, [&]() {
+      pitchshifter_process(context, 1.5f, 1.0f, time_cursor);
+
+      time_cursor += hop_size;
+    });
+
+    pitchshifter_set_number_of_channels(context, 2);
+
+    generate_signal(pitchshifter_inputs(context), (2 * fft_size), 8);
+
+    benchmark("pitchshifter (2 channels)", fft_size, (2 * fft_size), [&]() {
+      pitchshifter_process(context, 1.5f, 1.0f, time_cursor);
+
+      time_cursor += hop_size;
+    });
+
+    float *stream_inputs = pitchshifter_stream_inputs(context);
+
+    generate_signal(stream_inputs, (2 * hop_size), 8);
+
+    benchmark("pitchshifter (stream, 2 channels)", fft_size, (2 * hop_size), [&]() {
+      pitchshifter_stream_process(context, 1.5f, 1.0f, 0.0f, 1.0f);
+    });
+
+    // Transforms of silent frames are skipped
+    memset(stream_inputs, 0, (2 * hop_size * sizeof(float)));
+
+    benchmark("pitchshifter (stream, silence)", fft_size, (2 * hop_size), [&]() {
+      pitchshifter_stream_process(context, 1.5f, 1.0f, 0.0f, 1.0f);
+    });
+
+    generate_signal(stream_inputs, (2 * hop_size), 8);
+
+    // Cost per render quantum is averaged over hops
+    pitchshifter_set_hop_size(context, (fft_size / 4));
+
+    benchmark("pitchshifter (stream, 4x overlap)", fft_size, (2 * hop_size), [&]() {
+      pitchshifter_stream_process(context, 1.5f, 1.0f, 0.0f, 1.0f);
+    });
+
+    benchmark("vocoder (stream, 4x overlap)", fft_size, (2 * hop_size), [&]() {
+      pitchshifter_stream_process_by_phase_vocoder(context, 1.5f, 1.0f, 0.0f, 1.0f);
+    });
+
+    pitchshifter_set_hop_size(context, hop_size);
+
+    // Voices of harmony by separate instances (one analysis per voice) and by voices of one instance (one analysis per frame)
+    void *instances[number_of_voices];
+
+    for (size_t i = 0; i < number_of_voices; i++) {
+      instances[i] = pitchshifter_create(fft_size);
+
+      pitchshifter_set_number_of_channels(instances[i], 2);
+
+      generate_signal(pitchshifter_stream_inputs(instances[i]), (2 * hop_size), 8);
+
+      pitchshifter_set_voice(context, i, voice_pitches[i], voice_wets[i]);
+    }
+
+    benchmark("pitchshifter (stream, 4 instances)", fft_size, (2 * hop_size), [&]() {
+      for (size_t i = 0; i < number_of_voices; i++) {
+        pitchshifter_stream_process(instances[i], voice_pitches[i], 1.0f, 0.0f, voice_wets[i]);
+      }
+    });
+
+    for (size_t i = 0; i < number_of_voices; i++) {
+      pitchshifter_destroy(instances[i]);
+    }
+
+    benchmark("pitchshifter (stream, 4 voices)", fft_size, (2 * hop_size), [&]() {
+      pitchshifter_stream_process_by_voices(context, 1.0f, 0.0f);
+    });
+
+    // 1 second of stereo at 48 kHz (jobs are split by channels, then by render quanta except phase vocoder)
+    const size_t render_length = 48000;
+
+    generate_signal(pitchshifter_render_inputs(context, render_length), (2 * render_length), 8);
+
+    for (const size_t number_of_threads : benchmark_render_numbers_of_threads) {
+      char name[64];
+
+      snprintf(name, sizeof(name), "pitchshifter (render, %zu threads)", number_of_threads);
+
+      benchmark(name, fft_size, (2 * render_length), [&]() {
+        pitchshifter_render(context, render_length, 1.5f, 1.0f, 0.0f, 1.0f, number_of_threads);
+      });
+    }
+
+    for (const size_t number_of_threads : benchmark_render_numbers_of_threads) {
+      char name[64];
+
+      snprintf(name, sizeof(name), "vocoder (render, %zu threads)", number_of_threads);
+
+      benchmark(name, fft_size, (2 * render_length), [&]() {
+        pitchshifter_render_by_phase_vocoder(context, render_length, 1.5f, 1.0f, 0.0f, 1.0f, number_of_threads);
+      });
+    }
+
+    pitchshifter_destroy(context);
+  }
+
+  return number_of_failures;
+}
@@ -0,0 +1,645 @@
+#include "benchmark.hpp"
+
+extern "C" {
+void *spectralchain_create(const size_t fft_size);
+void spectralchain_destroy(void *const context);
+void spectralchain_set_number_of_channels(void *const context, const size_t number_of_channels);
+size_t spectralchain_set_number_of_stages(void *const context, const size_t number_of_stages);
+bool spectralchain_set_noise_suppressor(void *const context, const size_t index, const float threshold);
+bool spectralchain_set_vocal_canceler(void *const context, const size_t index, const bool on_spectrum, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold);
+bool spectralchain_set_pitch_shifter(void *const context, const size_t index, const float pitch, const float speed, const float dry, const float wet);
+float *spectralchain_stream_inputs(void *const context);
+float *spectralchain_stream_outputs(void *const context);
+float *spectralchain_stream_process(void *const context);
+size_t spectralchain_set_hop_size(void *const context, const size_t hop_size);
+size_t spectralchain_get_number_of_skipped_frames(void *const context);
+bool spectralchain_set_low_latency(void *const context, const bool low_latency);
+size_t spectralchain_get_latency(void *const context);
+}
+
+static const size_t fft_sizes[] = { 512, 1024, 2048, 4096 };
+
+// Naive DFT per hop is expensive, so golden checks of streaming API are limited to these sizes
+static const size_t stream_fft_sizes[] = { 512, 1024 };
+
+static const size_t hop_size = 128;
+
+// Small FFT sizes of low-latency mode (streaming API)
+static const size_t low_latency_fft_sizes[] = { 256, 512 };
+
+static const double tolerance = 1e-4;
+
+static const float sample_rate   = 48000.0f;
+static const float min_frequency = 200.0f;
+static const float max_frequency = 8000.0f;
+
+typedef enum {
+  NOISE_SUPPRESSOR,
+  VOCAL_CANCELER,
+  PITCH_SHIFTER
+} ReferenceStageType;
+
+// Stage of golden output (fields are used by its type, as `SpectralStage`)
+typedef struct {
+  ReferenceStageType type;
+  bool on_spectrum;
+  double threshold;
+  double depth;
+  double pitch;
+  double speed;
+  double dry;
+  double wet;
+  size_t time_cursor;
+} ReferenceStage;
+
+static ReferenceStage noise_suppressor_stage(const double threshold) {
+  return { NOISE_SUPPRESSOR, false, threshold, 0.0, 1.0, 1.0, 0.0, 1.0, 0 };
+}
+
+static ReferenceStage vocal_canceler_stage(const bool on_spectrum, const double depth, const double threshold) {
+  return { VOCAL_CANCELER, on_spectrum, threshold, depth, 1.0, 1.0, 0.0, 1.0, 0 };
+}
+
+static ReferenceStage pitch_shifter_stage(const double pitch, const double dry, const double wet) {
+  return { PITCH_SHIFTER, false, 0.0, 0.0, pitch, 1.0, dry, wet, 0 };
+}
+
+static bool is_reference_bypass(const ReferenceStage &stage) {
+  switch (stage.type) {
+    case NOISE_SUPPRESSOR:
+      return stage.threshold == 0.0;
+    case VOCAL_CANCELER:
+      return stage.depth == 0.0;
+    case PITCH_SHIFTER:
+      return (stage.pitch == 1.0) && (stage.speed == 1.0);
+  }
+
+  return true;
+}
+
+// Stages are set into spectral chain in order
+static void set_stages(void *const context, const std::vector<ReferenceStage> &stages) {
+  for (size_t i = 0; i < stages.size(); i++) {
+    const ReferenceStage &stage = stages[i];
+
+    switch (stage.type) {
+      case NOISE_SUPPRESSOR:
+        spectralchain_set_noise_suppressor(context, i, (float)stage.threshold);
+        break;
+      case VOCAL_CANCELER:
+        spectralchain_set_vocal_canceler(context, i, stage.on_spectrum, (float)stage.depth, sample_rate, min_frequency, max_frequency, (float)stage.threshold);
+        break;
+      case PITCH_SHIFTER:
+        spectralchain_set_pitch_shifter(context, i, (float)stage.pitch, (float)stage.speed, (float)stage.dry, (float)stage.wet);
+        break;
+    }
+  }
+}
+
+// Spectral subtraction (phase is kept)
+static void reference_subtract(double *const reals, double *const imags, const size_t buffer_size, const double threshold) {
+  for (size_t k = 0; k < buffer_size; k++) {
+    const double amplitude = sqrt((reals[k] * reals[k]) + (imags[k] * imags[k]));
+    const double gain      = (amplitude == 0.0) ? 0.0 : fmax((1.0 - (threshold / amplitude)), 0.0);
+
+    reals[k] *= gain;
+    imags[k] *= gain;
+  }
+}
+
+// Cancellation of center components (masked bins are replaced by minimum amplitude, and mixed with input spectra by depth in `reference_spectral_chain`)
+static void reference_cancel(double *const realLs, double *const imagLs, double *const realRs, double *const imagRs, const size_t fft_size, const ReferenceStage &stage) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const int min = (int)fmax((int)(min_frequency * (fft_size / sample_rate)), 0);
+  const int max = (int)fmin((int)(max_frequency * (fft_size / sample_rate)), buffer_size);
+
+  for (int k = min; k < max; k++) {
+    const double absL = sqrt((realLs[k] * realLs[k]) + (imagLs[k] * imagLs[k]));
+    const double absR = sqrt((realRs[k] * realRs[k]) + (imagRs[k] * imagRs[k]));
+
+    const double denominator = (absL + absR) * (absL + absR);
+
+    if ((denominator == 0.0) || ((((absL - absR) * (absL - absR)) / denominator) >= stage.threshold)) {
+      continue;
+    }
+
+    const double argL = atan2(imagLs[k], realLs[k]);
+    const double argR = atan2(imagRs[k], realRs[k]);
+
+    realLs[k] = 0.000001 * cos(argL);
+    imagLs[k] = 0.000001 * sin(argL);
+    realRs[k] = 0.000001 * cos(argR);
+    imagRs[k] = 0.000001 * sin(argR);
+  }
+}
+
+// Peak shifting (mixed with input spectrum by dry / wet in `reference_spectral_chain`)
+static void reference_shift(double *const reals, double *const imags, const size_t fft_size, const ReferenceStage &stage) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  std::vector<double> magnitudes(buffer_size);
+  std::vector<int> peak_indexes;
+  std::vector<double> shifted_reals(buffer_size);
+  std::vector<double> shifted_imags(buffer_size);
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    magnitudes[k] = (reals[k] * reals[k]) + (imags[k] * imags[k]);
+  }
+
+  for (int index = 2; index < (int)(buffer_size - 2);) {
+    const double magnitude = magnitudes[index];
+
+    if ((magnitudes[index - 1] >= magnitude) || (magnitudes[index - 2] >= magnitude) || (magnitudes[index + 1] >= magnitude) || (magnitudes[index + 2] >= magnitude)) {
+      ++index;
+      continue;
+    }
+
+    peak_indexes.push_back(index);
+
+    index += 2;
+  }
+
+  const int number_of_peaks = (int)peak_indexes.size();
+
+  for (int k = 0; k < number_of_peaks; k++) {
+    const int peak_index         = peak_indexes[k];
+    const int shifted_peak_index = (int)round(peak_index * stage.pitch * (1 / stage.speed));
+
+    if (shifted_peak_index > (int)buffer_size) {
+      break;
+    }
+
+    int start_index = 0;
+    int end_index   = (int)fft_size;
+
+    if (k > 0) {
+      start_index = peak_index - (int)floor((peak_index - peak_indexes[k - 1]) / 2.0);
+    }
+
+    if (k < (number_of_peaks - 1)) {
+      end_index = peak_index + (int)ceil((peak_indexes[k + 1] - peak_index) / 2.0);
+    }
+
+    for (int m = (start_index - peak_index); m < (end_index - peak_index); m++) {
+      const int bin_count_index         = peak_index + m;
+      const int shifted_bin_count_index = shifted_peak_index + m;
+
+      if (shifted_bin_count_index >= (int)buffer_size) {
+        break;
+      }
+
+      if (shifted_bin_count_index < 0) {
+        continue;
+      }
+
+      // Bins above Nyquist are the complex conjugate of the mirrored bins
+      const bool mirrored = bin_count_index >= (int)buffer_size;
+
+      const double real = mirrored ? reals[fft_size - bin_count_index] : reals[bin_count_index];
+      const double imag = mirrored ? (0.0 - imags[fft_size - bin_count_index]) : imags[bin_count_index];
+
+      const double omega = (2.0 * M_PI * (shifted_bin_count_index - bin_count_index)) / fft_size;
+
+      shifted_reals[shifted_bin_count_index] += (real * cos(omega * stage.time_cursor)) - (imag * sin(omega * stage.time_cursor));
+      shifted_imags[shifted_bin_count_index] += (real * sin(omega * stage.time_cursor)) + (imag * cos(omega * stage.time_cursor));
+    }
+  }
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    reals[k] = shifted_reals[k];
+    imags[k] = shifted_imags[k];
+  }
+}
+
+// Spectral chain on `double` with naive DFT (golden output of streaming API, as `reference_overlap_add` for all channels at once).
+// Frames are windowed and transformed once, processed by every stage, then transformed back, windowed and overlap-added once.
+// Dry components of stages are mixed on time domain (frames are not windowed), as effectors in series.
+// If `low_latency`, frames are windowed by asymmetric windows, and only the latest 2 hops of them are overlap-added.
+// Return value is the number of skipped (silent) frames.
+static size_t reference_spectral_chain(const float *const inputs, double *const outputs, const size_t number_of_channels, const size_t fft_size, const size_t frame_hop_size, const size_t number_of_quanta, std::vector<ReferenceStage> stages, const bool low_latency = false) {
+  const size_t quantum_size   = reference_render_quantum_size;
+  const size_t length         = number_of_quanta * quantum_size;
+  const size_t buffer_size    = (fft_size / 2) + 1;
+  const size_t synthesis_size = low_latency ? (2 * frame_hop_size) : fft_size;
+
+  const double number_of_overlaps = (double)synthesis_size / frame_hop_size;
+
+  bool stereo = false;
+
+  for (const ReferenceStage &stage : stages) {
+    stereo = stereo || ((stage.type == VOCAL_CANCELER) && !is_reference_bypass(stage) && (number_of_channels == 2));
+  }
+
+  std::vector<double> analysis_window(fft_size);
+  std::vector<double> synthesis_window(fft_size);
+
+  if (low_latency) {
+    reference_low_latency_windows(analysis_window.data(), synthesis_window.data(), fft_size, frame_hop_size);
+  } else {
+    reference_hanning_window(analysis_window.data(), fft_size);
+    reference_hanning_window(synthesis_window.data(), fft_size);
+  }
+
+  // Frames are taken from signals that are preceded by silence (as initial ring buffers)
+  std::vector<std::vector<float>> paddeds(number_of_channels, std::vector<float>(fft_size + length));
+  std::vector<std::vector<double>> output_buffers(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> reals(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> imags(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> spectral_reals(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> spectral_imags(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> stage_reals(number_of_channels, std::vector<double>(fft_size));
+  std::vector<std::vector<double>> stage_imags(number_of_channels, std::vector<double>(fft_size));
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    memcpy((paddeds[channel_number].data() + fft_size), (inputs + (channel_number * length)), (length * sizeof(float)));
+  }
+
+  std::vector<double> frame(fft_size);
+  std::vector<double> frame_outputs(fft_size);
+  std::vector<bool> silents(number_of_channels);
+
+  size_t number_of_skipped_frames = 0;
+
+  for (size_t quantum = 0; quantum < number_of_quanta; quantum++) {
+    const size_t end = (quantum + 1) * quantum_size;
+
+    if ((end % frame_hop_size) == 0) {
+      bool silent = true;
+
+      for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+        const float *samples = paddeds[channel_number].data() + end;
+
+        silents[channel_number] = true;
+
+        for (size_t n = 0; n < fft_size; n++) {
+          silents[channel_number] = silents[channel_number] && (fabsf(samples[n]) <= reference_silence_floor);
+        }
+
+        silent = silent && silents[channel_number];
+      }
+
+      if (stereo) {
+        for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+          silents[channel_number] = silent;
+        }
+      }
+
+      for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+        const float *samples = paddeds[channel_number].data() + end;
+
+        for (size_t n = 0; n < fft_size; n++) {
+          frame[n] = analysis_window[n] * samples[n];
+        }
+
+        reference_dft(frame.data(), nullptr, reals[channel_number].data(), imags[channel_number].data(), fft_size, -1);
+
+        spectral_reals[channel_number].assign(fft_size, 0.0);
+        spectral_imags[channel_number].assign(fft_size, 0.0);
+      }
+
+      // Output frame is `direct * frame + cross * frame of the other channel + synthesis of processed spectrum` (as effectors in series)
+      double direct = 1.0;
+      double cross  = 0.0;
+
+      // Input spectra of stage (processed spectra are overlap-added at 3 / 8)
+      const auto mix_inputs = [&]() {
+        for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+          const size_t other = (number_of_channels == 2) ? (1 - channel_number) : channel_number;
+
+          for (size_t k = 0; k < buffer_size; k++) {
+            stage_reals[channel_number][k] = (direct * reals[channel_number][k]) + (cross * reals[other][k]) + (0.375 * spectral_reals[channel_number][k]);
+            stage_imags[channel_number][k] = (direct * imags[channel_number][k]) + (cross * imags[other][k]) + (0.375 * spectral_imags[channel_number][k]);
+          }
+        }
+      };
+
+      // Processed spectra are mixed with outputs of the previous stages (`keep * previous + gain * processed`), and `keep` is applied to frames too
+      const auto mix_outputs = [&](const double keep, const double gain) {
+        for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+          for (size_t k = 0; k < buffer_size; k++) {
+            spectral_reals[channel_number][k] = (keep * spectral_reals[channel_number][k]) + (gain * stage_reals[channel_number][k]);
+            spectral_imags[channel_number][k] = (keep * spectral_imags[channel_number][k]) + (gain * stage_imags[channel_number][k]);
+          }
+        }
+
+        direct *= keep;
+        cross  *= keep;
+      };
+
+      for (ReferenceStage &stage : stages) {
+        if (is_reference_bypass(stage)) {
+          continue;
+        }
+
+        switch (stage.type) {
+          case NOISE_SUPPRESSOR:
+            mix_inputs();
+
+            for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+              reference_subtract(stage_reals[channel_number].data(), stage_imags[channel_number].data(), buffer_size, stage.threshold);
+            }
+
+            mix_outputs(0.0, 1.0);
+            break;
+          case VOCAL_CANCELER:
+            if (!stereo) {
+              break;
+            }
+
+            if (stage.on_spectrum) {
+              mix_inputs();
+
+              reference_cancel(stage_reals[0].data(), stage_imags[0].data(), stage_reals[1].data(), stage_imags[1].data(), fft_size, stage);
+
+              mix_outputs((1.0 - stage.depth), stage.depth);
+            } else {
+              // Cancellation on time domain is linear (L - depth * R)
+              for (size_t k = 0; k < buffer_size; k++) {
+                const double realL = spectral_reals[0][k];
+                const double imagL = spectral_imags[0][k];
+
+                spectral_reals[0][k] -= stage.depth * spectral_reals[1][k];
+                spectral_imags[0][k] -= stage.depth * spectral_imags[1][k];
+                spectral_reals[1][k] -= stage.depth * realL;
+                spectral_imags[1][k] -= stage.depth * imagL;
+              }
+
+              const double previous_direct = direct;
+
+              direct -= stage.depth * cross;
+              cross  -= stage.depth * previous_direct;
+            }
+
+            break;
+          case PITCH_SHIFTER:
+            mix_inputs();
+
+            for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+              reference_shift(stage_reals[channel_number].data(), stage_imags[channel_number].data(), fft_size, stage);
+            }
+
+            if (stage.dry == 0.0) {
+              mix_outputs(0.0, 1.0);
+            } else {
+              mix_outputs(stage.dry, stage.wet);
+            }
+
+            stage.time_cursor += frame_hop_size;
+            break;
+        }
+      }
+
+      for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+        if (silents[channel_number]) {
+          ++number_of_skipped_frames;
+          continue;
+        }
+
+        const size_t other = (number_of_channels == 2) ? (1 - channel_number) : channel_number;
+
+        reference_inverse_real_dft(spectral_reals[channel_number].data(), spectral_imags[channel_number].data(), frame_outputs.data(), fft_size);
+
+        for (size_t n = 0; n < synthesis_size; n++) {
+          const size_t index = (fft_size - synthesis_size) + n;
+
+          const double sample = (direct * paddeds[channel_number][end + index]) + (cross * paddeds[other][end + index]);
+
+          output_buffers[channel_number][n] += ((synthesis_window[index] * frame_outputs[index]) + sample) / number_of_overlaps;
+        }
+      }
+    }
+
+    for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+      std::vector<double> &output_buffer = output_buffers[channel_number];
+
+      memcpy((outputs + (channel_number * length) + (quantum * quantum_size)), output_buffer.data(), (quantum_size * sizeof(double)));
+      memmove(output_buffer.data(), (output_buffer.data() + quantum_size), ((fft_size - quantum_size) * sizeof(double)));
+      memset((output_buffer.data() + (fft_size - quantum_size)), 0, (quantum_size * sizeof(double)));
+    }
+  }
+
+  return number_of_skipped_frames;
+}
+
+// Stereo test signal (center component is common to both channels)
+static void generate_stereo_signal(float *const inputLs, float *const inputRs, const size_t size) {
+  std::vector<float> center(size);
+
+  generate_signal(center.data(), size, 11);
+  generate_signal(inputLs, size, 12);
+  generate_signal(inputRs, size, 13);
+
+  for (size_t n = 0; n < size; n++) {
+    inputLs[n] = center[n] + (0.5f * inputLs[n]);
+    inputRs[n] = center[n] + (0.3f * inputRs[n]);
+  }
+}
+
+// Streaming API against `reference_spectral_chain`.
+// If `with_silence`, both channels are muted for 2 frames, then the first channel is muted for 2 frames more (transforms of silent frames are skipped).
+static void check_spectral_chain(const size_t fft_size, const size_t number_of_channels, const size_t frame_hop_size, const std::vector<ReferenceStage> &stages, const bool with_silence, const char *const name, const bool low_latency = false) {
+  void *context = spectralchain_create(fft_size);
+
+  spectralchain_set_number_of_channels(context, number_of_channels);
+  spectralchain_set_low_latency(context, low_latency);
+
+  if (spectralchain_set_hop_size(context, frame_hop_size) != frame_hop_size) {
+    printf("FAIL %-40s %8zu hop size %zu is not set\n", name, fft_size, frame_hop_size);
+    ++number_of_failures;
+  }
+
+  set_stages(context, stages);
+
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  // Until the accumulators are filled and a little more (or the second silence has passed)
+  const size_t number_of_quanta = ((with_silence ? 7 : 2) * number_of_quanta_per_frame) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<float> inputs(number_of_channels * length);
+  std::vector<float> actuals(number_of_channels * length);
+  std::vector<double> expecteds(number_of_channels * length);
+
+  if (number_of_channels == 2) {
+    generate_stereo_signal(inputs.data(), (inputs.data() + length), length);
+  } else {
+    generate_signal(inputs.data(), length, 21);
+  }
+
+  if (with_silence) {
+    for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+      mute((inputs.data() + (channel_number * length)), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+    }
+
+    mute(inputs.data(), (4 * number_of_quanta_per_frame), (6 * number_of_quanta_per_frame));
+  }
+
+  const size_t number_of_skipped_frames = reference_spectral_chain(inputs.data(), expecteds.data(), number_of_channels, fft_size, frame_hop_size, number_of_quanta, stages, low_latency);
+
+  stream(spectralchain_stream_inputs(context), inputs.data(), actuals.data(), number_of_channels, number_of_quanta, [&]() {
+    return spectralchain_stream_process(context);
+  });
+
+  check(name, fft_size, actuals.data(), expecteds.data(), (number_of_channels * length), tolerance);
+
+  if (with_silence) {
+    check_count(name, fft_size, spectralchain_get_number_of_skipped_frames(context), number_of_skipped_frames);
+  }
+
+  // Golden output is delayed by `synthesis_size - 128` samples
+  check_count(name, fft_size, spectralchain_get_latency(context), ((low_latency ? (2 * frame_hop_size) : fft_size) - reference_render_quantum_size));
+
+  spectralchain_destroy(context);
+}
+
+// Stages are appended in order, replaced by index, and removed from the end
+static void check_stages(void) {
+  void *context = spectralchain_create(1024);
+
+  size_t number_of_stages = 0;
+
+  // Index must not skip stages
+  number_of_stages += spectralchain_set_noise_suppressor(context, 1, 0.5f) ? 1 : 0;
+
+  for (size_t i = 0; i < 10; i++) {
+    number_of_stages += spectralchain_set_pitch_shifter(context, i, 1.5f, 1.0f, 0.0f, 1.0f) ? 1 : 0;
+  }
+
+  check_count("spectralchain (max stages)", 1024, number_of_stages, 8);
+  check_count("spectralchain (replace stage)", 1024, spectralchain_set_noise_suppressor(context, 7, 0.5f), 1);
+  check_count("spectralchain (remove stages)", 1024, spectralchain_set_number_of_stages(context, 3), 3);
+  check_count("spectralchain (append stage)", 1024, spectralchain_set_vocal_canceler(context, 3, true, 0.5f, sample_rate, min_frequency, max_frequency, 0.05f), 1);
+  check_count("spectralchain (append stage)", 1024, spectralchain_set_number_of_stages(context, 8), 4);
+
+  spectralchain_destroy(context);
+}
+
+// Streaming API is rejected (`nullptr`) for mixed-radix sizes that are not multiple of render quantum size
+static void check_rejected_stream_spectral_chain(const size_t fft_size) {
+  void *context = spectralchain_create(fft_size);
+
+  spectralchain_set_number_of_channels(context, 2);
+  spectralchain_set_noise_suppressor(context, 0, 0.5f);
+  spectralchain_set_number_of_stages(context, 1);
+
+  check_rejected_stream("spectralchain (stream, mixed-radix)", fft_size, {
+    spectralchain_stream_inputs(context),
+    spectralchain_stream_outputs(context),
+    spectralchain_stream_process(context)
+  });
+
+  check_count("spectralchain (latency, mixed-radix)", fft_size, spectralchain_get_latency(context), 0);
+
+  spectralchain_destroy(context);
+}
+
+// Render quanta are fixed until the number of channels is changed
+static void check_stable_stream_buffers(void) {
+  void *context = spectralchain_create(1024);
+
+  spectralchain_set_number_of_channels(context, 2);
+
+  generate_signal(spectralchain_stream_inputs(context), (2 * hop_size), 8);
+
+  check_stable_buffers("spectralchain (stable buffers)", 1024, [&]() {
+    return spectralchain_stream_outputs(context);
+  }, [&]() {
+    return spectralchain_stream_process(context);
+  }, [&]() {
+    spectralchain_set_number_of_channels(context, 1);
+  });
+
+  spectralchain_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  const std::vector<ReferenceStage> noise_suppressor = { noise_suppressor_stage(0.5) };
+  const std::vector<ReferenceStage> vocal_canceler   = { vocal_canceler_stage(true, 0.75, 0.05) };
+  const std::vector<ReferenceStage> pitch_shifter    = { pitch_shifter_stage(1.5, 0.0, 1.0) };
+
+  const std::vector<ReferenceStage> three_stages = {
+    noise_suppressor_stage(0.5),
+    vocal_canceler_stage(true, 0.75, 0.05),
+    pitch_shifter_stage(1.5, 0.0, 1.0)
+  };
+
+  const std::vector<ReferenceStage> dry_wet_stages = {
+    vocal_canceler_stage(false, 0.5, 0.0),
+    pitch_shifter_stage(0.75, 0.25, 0.75),
+    noise_suppressor_stage(1.0)
+  };
+
+  check_stages();
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_spectral_chain(fft_size, 2, hop_size, noise_suppressor, false, "spectralchain (noise suppressor)");
+    check_spectral_chain(fft_size, 2, hop_size, vocal_canceler, false, "spectralchain (vocal canceler)");
+    check_spectral_chain(fft_size, 1, hop_size, vocal_canceler, false, "spectralchain (vocal canceler, mono)");
+    check_spectral_chain(fft_size, 1, hop_size, pitch_shifter, false, "spectralchain (pitch shifter)");
+    check_spectral_chain(fft_size, 2, hop_size, three_stages, false, "spectralchain (3 stages)");
+    check_spectral_chain(fft_size, 2, (fft_size / 4), dry_wet_stages, false, "spectralchain (3 stages, dry / wet, 4x)");
+    check_spectral_chain(fft_size, 2, hop_size, three_stages, true, "spectralchain (3 stages, silence)");
+    check_spectral_chain(fft_size, 2, hop_size, pitch_shifter, true, "spectralchain (pitch shifter, silence)");
+  }
+
+  for (const size_t fft_size : low_latency_fft_sizes) {
+    check_spectral_chain(fft_size, 2, hop_size, three_stages, false, "spectralchain (3 stages, low latency)", true);
+    check_spectral_chain(fft_size, 2, hop_size, dry_wet_stages, true, "spectralchain (3 stages, dry / wet, low latency)", true);
+  }
+
+  // 2x overlap (hop size is a half of FFT size)
+  check_spectral_chain(512, 2, 256, three_stages, false, "spectralchain (3 stages, low latency, 2x)", true);
+
+  check_rejected_stream_spectral_chain(480);
+  check_rejected_stream_spectral_chain(960);
+
+  check_stable_stream_buffers();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  for (const size_t fft_size : fft_sizes) {
+    // Separate effectors (one stage per chain, so one analysis / synthesis pass per effector)
+    void *contexts[3] = { spectralchain_create(fft_size), spectralchain_create(fft_size), spectralchain_create(fft_size) };
+
+    for (size_t i = 0; i < 3; i++) {
+      spectralchain_set_number_of_channels(contexts[i], 2);
+
+      set_stages(contexts[i], std::vector<ReferenceStage>(1, three_stages[i]));
+
+      generate_stereo_signal(spectralchain_stream_inputs(contexts[i]), (spectralchain_stream_inputs(contexts[i]) + hop_size), hop_size);
+    }
+
+    benchmark("3 effectors (separate passes)", fft_size, (2 * hop_size), [&]() {
+      for (size_t i = 0; i < 3; i++) {
+        spectralchain_stream_process(contexts[i]);
+      }
+    });
+
+    for (size_t i = 0; i < 3; i++) {
+      spectralchain_destroy(contexts[i]);
+    }
+
+    void *context = spectralchain_create(fft_size);
+
+    spectralchain_set_number_of_channels(context, 2);
+
+    set_stages(context, three_stages);
+
+    float *stream_inputs = spectralchain_stream_inputs(context);
+
+    generate_stereo_signal(stream_inputs, (stream_inputs + hop_size), hop_size);
+
+    benchmark("spectralchain (3 stages, one pass)", fft_size, (2 * hop_size), [&]() {
+      spectralchain_stream_process(context);
+    });
+
+    spectralchain_destroy(context);
+  }
+
+  return number_of_failures;
+}
@@ -0,0 +1,500 @@
+#include "benchmark.hpp"
+
+// Exports (`get_memory_generation`) are defined by module
+#define ARENA_WITHOUT_EXPORTS
+
+// For comparison path (two real FFTs)
+#include "../src/SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/FFT.hpp"
+
+extern "C" {
+void *vocalcanceler_create(const size_t fft_size);
+void vocalcanceler_destroy(void *const context);
+float *vocalcanceler_inputLs(void *const context);
+float *vocalcanceler_inputRs(void *const context);
+float *vocalcanceler_process(void *const context, const float depth);
+float *vocalcanceler_process_on_spectrum(void *const context, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold);
+void vocalcanceler_set_number_of_channels(void *const context, const size_t number_of_channels);
+float *vocalcanceler_stream_inputs(void *const context);
+float *vocalcanceler_stream_outputs(void *const context);
+float *vocalcanceler_stream_process(void *const context, const float depth);
+size_t vocalcanceler_get_number_of_skipped_frames(void *const context);
+bool vocalcanceler_set_low_latency(void *const context, const bool low_latency);
+size_t vocalcanceler_get_latency(void *const context);
+float *vocalcanceler_stream_process_on_spectrum(void *const context, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold);
+float *vocalcanceler_render_inputs(void *const context, const size_t length);
+float *vocalcanceler_render(void *const context, const size_t length, const float depth, const size_t number_of_threads);
+float *vocalcanceler_render_on_spectrum(void *const context, const size_t length, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold, const size_t number_of_threads);
+}
+
+static const size_t fft_sizes[] = { 512, 1024, 2048, 4096 };
+
+static const double sample_rate   = 48000.0;
+static const double min_frequency = 200.0;
+static const double max_frequency = 8000.0;
+static const double threshold     = 0.05;
+
+// Naive DFT per hop is expensive, so golden checks of streaming API are limited to these sizes
+static const size_t stream_fft_sizes[] = { 512, 1024 };
+
+static const size_t hop_size = 128;
+
+// Mixed-radix sizes (10 ms, 20 ms and 40 ms at 48 kHz). 1920 is multiple of render quantum size, so it is checked by streaming API too.
+static const size_t mixed_radix_fft_sizes[] = { 480, 960, 1920 };
+
+// Small FFT sizes of low-latency mode (streaming API)
+static const size_t low_latency_fft_sizes[] = { 256, 512 };
+
+static const double tolerance = 1e-4;
+
+// Stereo test signal (center component is common to both channels)
+static void generate_stereo_signal(float *const inputLs, float *const inputRs, const size_t size) {
+  std::vector<float> center(size);
+
+  generate_signal(center.data(), size, 11);
+  generate_signal(inputLs, size, 12);
+  generate_signal(inputRs, size, 13);
+
+  for (size_t n = 0; n < size; n++) {
+    inputLs[n] = center[n] + (0.5f * inputLs[n]);
+    inputRs[n] = center[n] + (0.3f * inputRs[n]);
+  }
+}
+
+// Spectral masking of center components on `double` with naive DFT (golden output).
+// Windows are Hanning window unless they are given (low-latency mode).
+static void reference_vocalcanceler_on_spectrum(const float *const inputLs, const float *const inputRs, double *const outputs, const size_t fft_size, const double *const analysis_window = nullptr, const double *const synthesis_window = nullptr) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  std::vector<double> window(fft_size);
+  std::vector<double> frameLs(fft_size);
+  std::vector<double> frameRs(fft_size);
+  std::vector<double> realLs(fft_size);
+  std::vector<double> imagLs(fft_size);
+  std::vector<double> realRs(fft_size);
+  std::vector<double> imagRs(fft_size);
+
+  reference_hanning_window(window.data(), fft_size);
+
+  const double *analysis  = (analysis_window == nullptr) ? window.data() : analysis_window;
+  const double *synthesis = (synthesis_window == nullptr) ? window.data() : synthesis_window;
+
+  for (size_t n = 0; n < fft_size; n++) {
+    frameLs[n] = analysis[n] * inputLs[n];
+    frameRs[n] = analysis[n] * inputRs[n];
+  }
+
+  reference_dft(frameLs.data(), nullptr, realLs.data(), imagLs.data(), fft_size, -1);
+  reference_dft(frameRs.data(), nullptr, realRs.data(), imagRs.data(), fft_size, -1);
+
+  const int min = (int)fmax((int)(min_frequency * (fft_size / sample_rate)), 0);
+  const int max = (int)fmin((int)(max_frequency * (fft_size / sample_rate)), buffer_size);
+
+  for (int k = min; k < max; k++) {
+    const double absL = sqrt((realLs[k] * realLs[k]) + (imagLs[k] * imagLs[k]));
+    const double absR = sqrt((realRs[k] * realRs[k]) + (imagRs[k] * imagRs[k]));
+
+    const double denominator = (absL + absR) * (absL + absR);
+
+    if ((denominator == 0.0) || ((((absL - absR) * (absL - absR)) / denominator) >= threshold)) {
+      continue;
+    }
+
+    // Amplitude is replaced with safe positive minimum (phase is kept)
+    const double argL = atan2(imagLs[k], realLs[k]);
+    const double argR = atan2(imagRs[k], realRs[k]);
+
+    realLs[k] = 0.000001 * cos(argL);
+    imagLs[k] = 0.000001 * sin(argL);
+    realRs[k] = 0.000001 * cos(argR);
+    imagRs[k] = 0.000001 * sin(argR);
+  }
+
+  reference_inverse_real_dft(realLs.data(), imagLs.data(), outputs, fft_size);
+  reference_inverse_real_dft(realRs.data(), imagRs.data(), (outputs + fft_size), fft_size);
+
+  for (size_t n = 0; n < fft_size; n++) {
+    outputs[n]            *= synthesis[n];
+    outputs[fft_size + n] *= synthesis[n];
+  }
+}
+
+// Previous path of `vocalcanceler_on_spectrum` (one real FFT and one real IFFT per channel, masking in polar form) for comparison with two-for-one complex FFT and gain mask
+typedef struct {
+  std::vector<float> window;
+  std::vector<float> realLs;
+  std::vector<float> realRs;
+  std::vector<float> imagLs;
+  std::vector<float> imagRs;
+  std::vector<float> absLs;
+  std::vector<float> absRs;
+  std::vector<float> argLs;
+  std::vector<float> argRs;
+  std::vector<float> outputs;
+} RFFTVocalCanceler;
+
+static void rfft_vocalcanceler_on_spectrum(RFFTVocalCanceler *const canceler, const float *const inputLs, const float *const inputRs, const size_t fft_size) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  float *window = canceler->window.data();
+  float *realLs = canceler->realLs.data();
+  float *realRs = canceler->realRs.data();
+  float *imagLs = canceler->imagLs.data();
+  float *imagRs = canceler->imagRs.data();
+  float *absLs  = canceler->absLs.data();
+  float *absRs  = canceler->absRs.data();
+  float *argLs  = canceler->argLs.data();
+  float *argRs  = canceler->argRs.data();
+
+  multiply_window(realLs, inputLs, window, fft_size);
+  multiply_window(realRs, inputRs, window, fft_size);
+
+  RFFT(realLs, imagLs, fft_size);
+  RFFT(realRs, imagRs, fft_size);
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    absLs[k] = sqrtf(powf(realLs[k], 2.0f) + powf(imagLs[k], 2.0f));
+    absRs[k] = sqrtf(powf(realRs[k], 2.0f) + powf(imagRs[k], 2.0f));
+    argLs[k] = atan2f(imagLs[k], realLs[k]);
+    argRs[k] = atan2f(imagRs[k], realRs[k]);
+  }
+
+  const int min = (int)fmax((int)(min_frequency * (fft_size / sample_rate)), 0);
+  const int max = (int)fmin((int)(max_frequency * (fft_size / sample_rate)), buffer_size);
+
+  for (int k = min; k < max; k++) {
+    const float numerator   = powf((absLs[k] - absRs[k]), 2.0f);
+    const float denominator = powf((absLs[k] + absRs[k]), 2.0f);
+
+    if ((denominator != 0.0f) && ((numerator / denominator) < threshold)) {
+      absLs[k] = 0.000001f;
+      absRs[k] = 0.000001f;
+    }
+  }
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    realLs[k] = absLs[k] * cosf(argLs[k]);
+    realRs[k] = absRs[k] * cosf(argRs[k]);
+    imagLs[k] = absLs[k] * sinf(argLs[k]);
+    imagRs[k] = absRs[k] * sinf(argRs[k]);
+  }
+
+  IRFFT(realLs, imagLs, fft_size);
+  IRFFT(realRs, imagRs, fft_size);
+
+  multiply_window(canceler->outputs.data(), realLs, window, fft_size);
+  multiply_window((canceler->outputs.data() + fft_size), realRs, window, fft_size);
+}
+
+static void check_vocalcanceler(const size_t fft_size) {
+  void *context = vocalcanceler_create(fft_size);
+
+  float *inputLs = vocalcanceler_inputLs(context);
+  float *inputRs = vocalcanceler_inputRs(context);
+
+  std::vector<double> expecteds(2 * fft_size);
+
+  generate_stereo_signal(inputLs, inputRs, fft_size);
+
+  for (size_t n = 0; n < fft_size; n++) {
+    expecteds[n]            = inputLs[n] - (0.5 * inputRs[n]);
+    expecteds[fft_size + n] = inputRs[n] - (0.5 * inputLs[n]);
+  }
+
+  check("vocalcanceler (time)", fft_size, vocalcanceler_process(context, 0.5f), expecteds.data(), (2 * fft_size), tolerance);
+
+  reference_vocalcanceler_on_spectrum(inputLs, inputRs, expecteds.data(), fft_size);
+
+  check("vocalcanceler (spectrum)", fft_size, vocalcanceler_process_on_spectrum(context, sample_rate, min_frequency, max_frequency, threshold), expecteds.data(), (2 * fft_size), tolerance);
+
+  vocalcanceler_destroy(context);
+}
+
+// Streaming API against `reference_overlap_add`.
+// If `with_silence`, signal is muted for 2 frames in the middle (transforms of silent frames are skipped).
+// If `low_latency`, frames are windowed by asymmetric windows, and only the latest 2 hops of them are overlap-added.
+static void check_stream_vocalcanceler(const size_t fft_size, const bool on_spectrum, const float depth, const bool with_silence, const bool low_latency = false) {
+  void *context = vocalcanceler_create(fft_size);
+
+  vocalcanceler_set_low_latency(context, low_latency);
+
+  std::vector<double> analysis_window(fft_size);
+  std::vector<double> synthesis_window(fft_size);
+
+  reference_low_latency_windows(analysis_window.data(), synthesis_window.data(), fft_size, hop_size);
+
+  const size_t synthesis_size = low_latency ? (2 * hop_size) : fft_size;
+
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  // Until the accumulators are filled and a little more
+  const size_t number_of_quanta = ((with_silence ? 4 : 2) * number_of_quanta_per_frame) + 2;
+  const size_t length           = number_of_quanta * hop_size;
+
+  std::vector<float> inputs(2 * length);
+  std::vector<float> actuals(2 * length);
+  std::vector<double> expecteds(2 * length);
+
+  generate_stereo_signal(inputs.data(), (inputs.data() + length), length);
+
+  if (with_silence) {
+    mute(inputs.data(), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+    mute((inputs.data() + length), number_of_quanta_per_frame, (3 * number_of_quanta_per_frame));
+  }
+
+  // Frames of both channels are required per hop, so they are taken from signals that are preceded by silence (as initial ring buffers)
+  std::vector<float> paddedLs(fft_size + length);
+  std::vector<float> paddedRs(fft_size + length);
+
+  memcpy((paddedLs.data() + fft_size), inputs.data(), (length * sizeof(float)));
+  memcpy((paddedRs.data() + fft_size), (inputs.data() + length), (length * sizeof(float)));
+
+  std::vector<double> frame_outputs(2 * fft_size);
+
+  for (size_t channel_number = 0; channel_number < 2; channel_number++) {
+    size_t quantum = 0;
+
+    reference_overlap_add((inputs.data() + (channel_number * length)), (expecteds.data() + (channel_number * length)), fft_size, hop_size, synthesis_size, number_of_quanta, [&](const float *, double *outputs) {
+      ++quantum;
+
+      const float *frameLs = paddedLs.data() + (quantum * hop_size);
+      const float *frameRs = paddedRs.data() + (quantum * hop_size);
+
+      const float *frames[2] = { frameLs, frameRs };
+
+      if (on_spectrum) {
+        reference_vocalcanceler_on_spectrum(frameLs, frameRs, frame_outputs.data(), fft_size, (low_latency ? analysis_window.data() : nullptr), (low_latency ? synthesis_window.data() : nullptr));
+      }
+
+      for (size_t n = 0; n < fft_size; n++) {
+        const double input = frames[channel_number][n];
+
+        if (on_spectrum) {
+          outputs[n] = ((1.0 - depth) * input) + (depth * frame_outputs[(channel_number * fft_size) + n]);
+        } else {
+          outputs[n] = input - (depth * frames[1 - channel_number][n]);
+        }
+      }
+    });
+  }
+
+  stream(vocalcanceler_stream_inputs(context), inputs.data(), actuals.data(), 2, number_of_quanta, [&]() {
+    if (on_spectrum) {
+      return vocalcanceler_stream_process_on_spectrum(context, depth, sample_rate, min_frequency, max_frequency, threshold);
+    }
+
+    return vocalcanceler_stream_process(context, depth);
+  });
+
+  char name[64];
+
+  snprintf(name, sizeof(name), "vocalcanceler (stream, %s%s)", (with_silence ? "silence" : (on_spectrum ? "spectrum" : "time")), (low_latency ? ", low latency" : ""));
+
+  check(name, fft_size, actuals.data(), expecteds.data(), (2 * length), tolerance);
+
+  if (with_silence) {
+    check_count(name, fft_size, vocalcanceler_get_number_of_skipped_frames(context), reference_number_of_silent_frames(inputs.data(), 2, fft_size, hop_size, number_of_quanta));
+  }
+
+  // Golden output is delayed by `synthesis_size - 128` samples
+  check_count(name, fft_size, vocalcanceler_get_latency(context), (synthesis_size - reference_render_quantum_size));
+
+  vocalcanceler_destroy(context);
+}
+
+// Offline rendering against streaming API on any number of threads.
+// Signal is long enough to be split into jobs of render quanta (24 frames), and both channels are muted across the boundary of jobs.
+static void check_render_vocalcanceler(const size_t fft_size, const bool on_spectrum) {
+  const size_t number_of_quanta_per_frame = fft_size / hop_size;
+
+  const size_t number_of_quanta = (24 * number_of_quanta_per_frame) + 3;
+  const size_t length           = number_of_quanta * hop_size;
+  const size_t render_length    = length - render_tail_size;
+
+  std::vector<float> inputs(2 * length);
+  std::vector<float> expecteds(2 * length);
+
+  generate_stereo_signal(inputs.data(), (inputs.data() + length), length);
+
+  for (size_t channel_number = 0; channel_number < 2; channel_number++) {
+    float *signal = inputs.data() + (channel_number * length);
+
+    memset((signal + render_length), 0, (render_tail_size * sizeof(float)));
+
+    mute(signal, (10 * number_of_quanta_per_frame), (14 * number_of_quanta_per_frame));
+  }
+
+  void *context = vocalcanceler_create(fft_size);
+
+  stream(vocalcanceler_stream_inputs(context), inputs.data(), expecteds.data(), 2, number_of_quanta, [&]() {
+    if (on_spectrum) {
+      return vocalcanceler_stream_process_on_spectrum(context, 0.75f, sample_rate, min_frequency, max_frequency, threshold);
+    }
+
+    return vocalcanceler_stream_process(context, 0.5f);
+  });
+
+  const size_t number_of_skipped_frames = vocalcanceler_get_number_of_skipped_frames(context);
+
+  vocalcanceler_destroy(context);
+
+  for (const size_t number_of_threads : render_numbers_of_threads) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "vocalcanceler (render, %s) x%zu", (on_spectrum ? "spectrum" : "time"), number_of_threads);
+
+    context = vocalcanceler_create(fft_size);
+
+    copy_render_signal(vocalcanceler_render_inputs(context, render_length), inputs.data(), 2, number_of_quanta, render_length);
+
+    const float *actuals = on_spectrum ? vocalcanceler_render_on_spectrum(context, render_length, 0.75f, sample_rate, min_frequency, max_frequency, threshold, number_of_threads)
+                                       : vocalcanceler_render(context, render_length, 0.5f, number_of_threads);
+
+    check_render(name, fft_size, actuals, expecteds.data(), 2, number_of_quanta, render_length);
+    check_count(name, fft_size, vocalcanceler_get_number_of_skipped_frames(context), number_of_skipped_frames);
+
+    vocalcanceler_destroy(context);
+  }
+}
+
+// Streaming API and offline rendering are rejected (`nullptr`) for mixed-radix sizes that are not multiple of render quantum size
+static void check_rejected_stream_vocalcanceler(const size_t fft_size) {
+  void *context = vocalcanceler_create(fft_size);
+
+  vocalcanceler_render_inputs(context, fft_size);
+
+  check_rejected_stream("vocalcanceler (stream, mixed-radix)", fft_size, {
+    vocalcanceler_stream_inputs(context),
+    vocalcanceler_stream_outputs(context),
+    vocalcanceler_stream_process(context, 0.5f),
+    vocalcanceler_stream_process_on_spectrum(context, 0.75f, (float)sample_rate, (float)min_frequency, (float)max_frequency, (float)threshold),
+    vocalcanceler_render(context, fft_size, 0.5f, 2)
+  });
+
+  check_count("vocalcanceler (latency, mixed-radix)", fft_size, vocalcanceler_get_latency(context), 0);
+
+  vocalcanceler_destroy(context);
+}
+
+// Render quanta are fixed until the number of channels is changed
+static void check_stable_stream_buffers(void) {
+  void *context = vocalcanceler_create(1024);
+
+  vocalcanceler_set_number_of_channels(context, 2);
+
+  generate_signal(vocalcanceler_stream_inputs(context), (2 * hop_size), 8);
+
+  check_stable_buffers("vocalcanceler (stable buffers)", 1024, [&]() {
+    return vocalcanceler_stream_outputs(context);
+  }, [&]() {
+    return vocalcanceler_stream_process(context, 1.0f);
+  }, [&]() {
+    vocalcanceler_set_number_of_channels(context, 1);
+  });
+
+  vocalcanceler_destroy(context);
+}
+
+int main(int argc, char **argv) {
+  for (const size_t fft_size : fft_sizes) {
+    check_vocalcanceler(fft_size);
+  }
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_stream_vocalcanceler(fft_size, false, 0.5f, false);
+    check_stream_vocalcanceler(fft_size, true, 0.75f, false);
+    check_stream_vocalcanceler(fft_size, true, 0.75f, true);
+  }
+
+  for (const size_t fft_size : low_latency_fft_sizes) {
+    check_stream_vocalcanceler(fft_size, false, 0.5f, false, true);
+    check_stream_vocalcanceler(fft_size, true, 0.75f, false, true);
+    check_stream_vocalcanceler(fft_size, true, 0.75f, true, true);
+  }
+
+  for (const size_t fft_size : stream_fft_sizes) {
+    check_render_vocalcanceler(fft_size, false);
+    check_render_vocalcanceler(fft_size, true);
+  }
+
+  for (const size_t fft_size : mixed_radix_fft_sizes) {
+    check_vocalcanceler(fft_size);
+
+    if ((fft_size % hop_size) != 0) {
+      check_rejected_stream_vocalcanceler(fft_size);
+    }
+  }
+
+  check_stream_vocalcanceler(1920, true, 0.75f, false);
+
+  check_stable_stream_buffers();
+
+  if (is_check_only(argc, argv)) {
+    return number_of_failures;
+  }
+
+  print_benchmark_header();
+
+  for (const size_t fft_size : fft_sizes) {
+    void *context = vocalcanceler_create(fft_size);
+
+    generate_stereo_signal(vocalcanceler_inputLs(context), vocalcanceler_inputRs(context), fft_size);
+
+    benchmark("vocalcanceler (time)", fft_size, (2 * fft_size), [&]() {
+      vocalcanceler_process(context, 0.5f);
+    });
+
+    benchmark("vocalcanceler_on_spectrum", fft_size, (2 * fft_size), [&]() {
+      vocalcanceler_process_on_spectrum(context, sample_rate, min_frequency, max_frequency, threshold);
+    });
+
+    const size_t buffer_size = (fft_size / 2) + 1;
+
+    RFFTVocalCanceler canceler = {
+      std::vector<float>(fft_size),
+      std::vector<float>(fft_size),
+      std::vector<float>(fft_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(buffer_size),
+      std::vector<float>(2 * fft_size)
+    };
+
+    window_function(canceler.window.data(), fft_size, HANNING);
+
+    benchmark("  (comparison: 2 x RFFT)", fft_size, (2 * fft_size), [&]() {
+      rfft_vocalcanceler_on_spectrum(&canceler, vocalcanceler_inputLs(context), vocalcanceler_inputRs(context), fft_size);
+    });
+
+    float *stream_inputs = vocalcanceler_stream_inputs(context);
+
+    generate_stereo_signal(stream_inputs, (stream_inputs + hop_size), hop_size);
+
+    benchmark("vocalcanceler_on_spectrum (stream)", fft_size, (2 * hop_size), [&]() {
+      vocalcanceler_stream_process_on_spectrum(context, 0.5f, sample_rate, min_frequency, max_frequency, threshold);
+    });
+
+    // 1 second of stereo at 48 kHz on spectrum (both channels are canceled together, so jobs are split by render quanta)
+    const size_t render_length = 48000;
+
+    float *render_inputs = vocalcanceler_render_inputs(context, render_length);
+
+    generate_stereo_signal(render_inputs, (render_inputs + render_length), render_length);
+
+    for (const size_t number_of_threads : benchmark_render_numbers_of_threads) {
+      char name[64];
+
+      snprintf(name, sizeof(name), "vocalcanceler (render, %zu threads)", number_of_threads);
+
+      benchmark(name, fft_size, (2 * render_length), [&]() {
+        vocalcanceler_render_on_spectrum(context, render_length, 0.5f, sample_rate, min_frequency, max_frequency, threshold, number_of_threads);
+      });
+    }
+
+    vocalcanceler_destroy(context);
+  }
+
+  return number_of_failures;
+}
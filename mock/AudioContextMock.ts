@@ -1,4 +1,5 @@
 import '/mock/AudioWorkletNodeMock';
+import '/mock/compileStreamingMock';
 import '/mock/fetchMock';
 import '/mock/instantiateStreamingMock';
 import { AnalyserNodeMock } from '/mock/AnalyserNodeMock';
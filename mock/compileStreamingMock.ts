@@ -0,0 +1,7 @@
+Object.defineProperty(WebAssembly, 'compileStreaming', {
+  configurable: true,
+  writable    : false,
+  value       : () => {
+    return Promise.resolve({});
+  }
+});
@@ -1,13 +1,28 @@
 import type { Inputs, Outputs } from '../worklet';
 import type { NoiseType, NoiseModuleParams } from './';
+import type { DSPProfile, DSPProfileMessageEventData } from '../XSound';
 
-import { AudioWorkletProcessor } from '../worklet';
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../worklet';
 
 interface NoiseModuleProcessorWebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  whitenoise: (frame: number) => number;
-  pinknoise: (frame: number) => number;
-  browniannoise: (frame: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  noisegenerator_profile: (context: number) => number;
+  noisegenerator_create: (seed: number) => number;
+  noisegenerator_destroy: (context: number) => void;
+  noisegenerator_whitenoise: (context: number) => number;
+  noisegenerator_pinknoise: (context: number) => number;
+  noisegenerator_browniannoise: (context: number) => number;
+  noisegenerator_render_whitenoise: (context: number, length: number) => number;
+  noisegenerator_render_pinknoise: (context: number, length: number) => number;
+  noisegenerator_render_browniannoise: (context: number, length: number) => number;
 };
 
 export type NoiseProcessingMessageEventData = {
@@ -17,22 +32,46 @@ export type NoiseProcessingMessageEventData = {
 /**
  * This class extends `AudioWorkletProcessor`.
  * Overrides `process` method for generating noise.
+ * Noise is rendered by `batchSize` samples per call of WebAssembly Module, and render quanta are read from the batches.
  */
 export class NoiseModuleProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
   private instance: WebAssembly.Instance | null = null;
 
+  // Pointers to `NoiseGeneratorContext` (per channel) in linear memory
+  private contexts: number[] = [];
+
+  // Rendered samples (per channel) that are not output yet (from `batchOffset` to `batchLength`)
+  private batches: Float32Array[] = [];
+  private batchSize = 128;
+  private batchOffset = 0;
+  private batchLength = 0;
+
   private processing = false;
 
+  // Instrumentation of WebAssembly Module is opt-in (set to contexts when they are created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
   private type: NoiseType = 'whitenoise';
 
-  constructor() {
-    super();
+  constructor(options?: AudioWorkletNodeOptions) {
+    super(options);
 
-    this.port.onmessage = (event: MessageEvent<ArrayBuffer | (NoiseModuleParams & NoiseProcessingMessageEventData)>) => {
-      if (event.data instanceof ArrayBuffer) {
-        WebAssembly.instantiate(event.data)
-          .then(({ instance }) => {
-            this.instance = instance;
+    if (options?.processorOptions) {
+      this.batchSize = options.processorOptions.batchSize ?? NoiseModuleProcessor.RENDER_QUANTUM_SIZE;
+    }
+
+    this.port.onmessage = (event: MessageEvent<WebAssembly.Module | (NoiseModuleParams & NoiseProcessingMessageEventData & DSPProfileMessageEventData)>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.contexts           = [];
+            this.batchLength        = 0;
+            this.profilingInContext = false;
           })
           .catch((error: Error) => {
             throw error;
@@ -44,6 +83,19 @@ export class NoiseModuleProcessor extends AudioWorkletProcessor {
 
         if (event.data.type) {
           this.type = event.data.type;
+
+          // Discard samples of previous type
+          this.batchLength = 0;
+        }
+
+        if (typeof event.data.profile === 'boolean') {
+          this.profiling          = event.data.profile;
+          this.profilingInContext = false;
+        }
+
+        // Reply is posted to transferred port (`queryDSPProfile`)
+        if ((event.data.query === 'profile') && (event.ports.length > 0)) {
+          event.ports[0].postMessage(this.getProfile());
         }
       }
     };
@@ -52,7 +104,8 @@ export class NoiseModuleProcessor extends AudioWorkletProcessor {
   /** @override */
   protected override process(_inputs: Inputs, outputs: Outputs): boolean {
     if (this.instance === null) {
-      return false;
+      // Output silence until combined DSP module is instantiated (keep processor alive)
+      return true;
     }
 
     if (!this.processing) {
@@ -62,38 +115,125 @@ export class NoiseModuleProcessor extends AudioWorkletProcessor {
 
     const output = outputs[0];
 
+    const bufferSize = (output.length > 0) ? output[0].length : NoiseModuleProcessor.RENDER_QUANTUM_SIZE;
+
+    if ((output.length !== this.batches.length) || ((this.batchOffset + bufferSize) > this.batchLength)) {
+      this.render(output.length, Math.max(this.batchSize, bufferSize));
+    }
+
+    for (let channelNumber = 0, numberOfChannels = output.length; channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(this.batches[channelNumber].subarray(this.batchOffset, (this.batchOffset + bufferSize)));
+    }
+
+    this.batchOffset += bufferSize;
+
+    return true;
+  }
+
+  private render(numberOfChannels: number, length: number): void {
+    if (this.instance === null) {
+      return;
+    }
+
     // HACK:
     const wasm = this.instance.exports as NoiseModuleProcessorWebAssemblyInstance;
 
-    const linearMemory = wasm.memory.buffer;
+    if (!this.profilingInContext) {
+      for (const context of this.contexts) {
+        const profile = wasm.noisegenerator_profile(context);
 
-    for (let channelNumber = 0, numberOfChannels = output.length; channelNumber < numberOfChannels; channelNumber++) {
-      const bufferSize = output[channelNumber].length;
+        // Counters are reset whenever instrumentation is started
+        if (this.profiling) {
+          wasm.profile_reset(profile);
+        }
+
+        wasm.profile_set_enabled(profile, this.profiling);
+      }
+
+      this.profilingInContext = true;
+    }
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (this.contexts[channelNumber] === undefined) {
+        // Random number generator is seeded per channel, so that channels are not correlated
+        this.contexts[channelNumber] = wasm.noisegenerator_create(Math.trunc(Math.random() * 0xFFFFFFFF) >>> 0);
+
+        wasm.profile_set_enabled(wasm.noisegenerator_profile(this.contexts[channelNumber]), this.profiling);
+      }
+
+      if ((this.batches[channelNumber] === undefined) || (this.batches[channelNumber].length !== length)) {
+        this.batches[channelNumber] = new Float32Array(length);
+      }
+
+      const context = this.contexts[channelNumber];
+
+      let offsetOutput = 0;
+
+      // Time is measured by processor (imported clock is only used to measure FFT plans)
+      const begin = this.profiling ? getTimestamp() : 0;
 
       switch (this.type) {
         case 'whitenoise': {
-          const offsetOutput = wasm.whitenoise(currentFrame);
-
-          output[channelNumber].set(new Float32Array(linearMemory, offsetOutput, bufferSize));
+          offsetOutput = wasm.noisegenerator_render_whitenoise(context, length);
           break;
         }
 
         case 'pinknoise': {
-          const offsetOutput = wasm.pinknoise(currentFrame);
-
-          output[channelNumber].set(new Float32Array(linearMemory, offsetOutput, bufferSize));
+          offsetOutput = wasm.noisegenerator_render_pinknoise(context, length);
           break;
         }
 
         case 'browniannoise': {
-          const offsetOutput = wasm.browniannoise(currentFrame);
-
-          output[channelNumber].set(new Float32Array(linearMemory, offsetOutput, bufferSize));
+          offsetOutput = wasm.noisegenerator_render_browniannoise(context, length);
           break;
         }
       }
+
+      if (this.profiling) {
+        wasm.profile_add_time(wasm.noisegenerator_profile(context), (getTimestamp() - begin));
+      }
+
+      // Linear memory may be grown by rendering
+      this.batches[channelNumber].set(new Float32Array(wasm.memory.buffer, offsetOutput, length));
     }
 
-    return true;
+    this.batches.length = numberOfChannels;
+
+    this.batchOffset = 0;
+    this.batchLength = length;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * Channels are rendered by their own contexts, so a call is rendering of one batch for all channels (total time is sum of channels, and max time is the maximum of channels as the other processors).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If contexts are not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.contexts.length === 0)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as NoiseModuleProcessorWebAssemblyInstance;
+
+    const stats: DSPProfile = {
+      calls        : 0,
+      totalTime    : 0,
+      maxTime      : 0,
+      allocations  : 0,
+      skippedFrames: 0
+    };
+
+    for (const context of this.contexts) {
+      const profile = wasm.noisegenerator_profile(context);
+
+      stats.calls          = Math.max(stats.calls, wasm.profile_get_number_of_calls(profile));
+      stats.totalTime     += wasm.profile_get_total_time(profile);
+      stats.maxTime        = Math.max(stats.maxTime, wasm.profile_get_max_time(profile));
+      stats.allocations   += wasm.profile_get_number_of_allocations(profile);
+      stats.skippedFrames += wasm.profile_get_number_of_skipped_frames(profile);
+    }
+
+    return stats;
   }
 }
@@ -1,65 +1,210 @@
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "../../SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/arena.hpp"
+#include "../../SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/profile.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 static const size_t buffer_size = 128;
 
-static float *outputs = nullptr;
+// Number of interleaved generators (sample `n` is drawn from lane `n % 4`, so 1 SIMD step yields 4 samples)
+static const size_t number_of_lanes = 4;
 
-static float b0 = 0.0f;
-static float b1 = 0.0f;
-static float b2 = 0.0f;
-static float b3 = 0.0f;
-static float b4 = 0.0f;
-static float b5 = 0.0f;
-static float b6 = 0.0f;
+// xoshiro128+ (ref: https://prng.di.unimi.it/xoshiro128plus.c) on 4 independent lanes.
+// State is structure of arrays, so that each word of 4 lanes is 1 `v128_t`.
+// Lanes of the last step that are not written yet (`reserves`) are written first by the next fill,
+// so output does not depend on how a stream is split into calls.
+typedef struct {
+  uint32_t s0[number_of_lanes];
+  uint32_t s1[number_of_lanes];
+  uint32_t s2[number_of_lanes];
+  uint32_t s3[number_of_lanes];
+  float reserves[number_of_lanes];
+  size_t number_of_reserves;
+} Xoshiro128;
 
-static float last_out = 0.0f;
+// State of noise generator per instance (random number generator and filter states of pink noise and brownian noise are kept per instance).
+// `outputs` grows to the largest length that has been rendered (`capacity`).
+typedef struct {
+  float *outputs;
+  size_t capacity;
+  Xoshiro128 prng;
+  Profile profile;
+  float b0;
+  float b1;
+  float b2;
+  float b3;
+  float b4;
+  float b5;
+  float b6;
+  float last_out;
+} NoiseGeneratorContext;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// for `whitenoise`, `pinknoise` and `browniannoise` (API without context)
+static NoiseGeneratorContext *default_context = nullptr;
 
-static inline float generate_normalized_rand(void) {
-  return (float)rand() / ((float)RAND_MAX + 1.0f);
+// ref: https://prng.di.unimi.it/splitmix64.c
+static inline uint64_t splitmix64(uint64_t *const state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
 }
 
-#ifdef __EMSCRIPTEN__
-EMSCRIPTEN_KEEPALIVE
-#endif
-float *whitenoise(const unsigned int time) {
-  if (outputs) {
-    free(outputs);
-  }
+// State is expanded from `seed` by SplitMix64 (never all zero), so output is deterministic for the same seed
+static void seed_prng(Xoshiro128 *const prng, const uint32_t seed) {
+  uint64_t state = seed;
 
-  srand(time);
+  uint32_t *words[] = { prng->s0, prng->s1, prng->s2, prng->s3 };
 
-  outputs = (float *)calloc(buffer_size, sizeof(float));
+  for (size_t lane = 0; lane < number_of_lanes; lane++) {
+    const uint64_t lower = splitmix64(&state);
+    const uint64_t upper = splitmix64(&state);
 
-  for (int n = 0; n < buffer_size; n++) {
-    outputs[n] = (float)((2.0f * generate_normalized_rand()) - 1.0f);
+    words[0][lane] = (uint32_t)lower;
+    words[1][lane] = (uint32_t)(lower >> 32);
+    words[2][lane] = (uint32_t)upper;
+    words[3][lane] = (uint32_t)(upper >> 32);
   }
 
-  return outputs;
+  prng->number_of_reserves = 0;
 }
 
-#ifdef __EMSCRIPTEN__
-EMSCRIPTEN_KEEPALIVE
+// Upper 24 bits are exact on `float`, so the range is [-1, 1) with the step 2^-23
+static inline float to_white(const uint32_t x) {
+  return ((float)(int32_t)(x >> 8) * (1.0f / 8388608.0f)) - 1.0f;
+}
+
+// Fills `outputs` with uniform white noise in [-1, 1)
+static void fill_whitenoise(Xoshiro128 *const prng, float *const outputs, const size_t length) {
+  size_t n = 0;
+
+  for (; (prng->number_of_reserves > 0) && (n < length); n++) {
+    outputs[n] = prng->reserves[number_of_lanes - prng->number_of_reserves];
+
+    --prng->number_of_reserves;
+  }
+
+#ifdef __wasm_simd128__
+  v128_t s0 = wasm_v128_load(prng->s0);
+  v128_t s1 = wasm_v128_load(prng->s1);
+  v128_t s2 = wasm_v128_load(prng->s2);
+  v128_t s3 = wasm_v128_load(prng->s3);
+
+  const v128_t scales  = wasm_f32x4_splat(1.0f / 8388608.0f);
+  const v128_t offsets = wasm_f32x4_splat(1.0f);
+
+  for (; n < length; n += number_of_lanes) {
+    const v128_t result = wasm_i32x4_add(s0, s3);
+    const v128_t t      = wasm_i32x4_shl(s1, 9);
+
+    s2 = wasm_v128_xor(s2, s0);
+    s3 = wasm_v128_xor(s3, s1);
+    s1 = wasm_v128_xor(s1, s2);
+    s0 = wasm_v128_xor(s0, s3);
+    s2 = wasm_v128_xor(s2, t);
+    s3 = wasm_v128_or(wasm_i32x4_shl(s3, 11), wasm_u32x4_shr(s3, 21));
+
+    const v128_t whites = wasm_f32x4_sub(wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_shr(result, 8)), scales), offsets);
+
+    if ((n + number_of_lanes) <= length) {
+      wasm_v128_store(outputs + n, whites);
+    } else {
+      wasm_v128_store(prng->reserves, whites);
+
+      memcpy((outputs + n), prng->reserves, ((length - n) * sizeof(float)));
+
+      prng->number_of_reserves = number_of_lanes - (length - n);
+    }
+  }
+
+  wasm_v128_store(prng->s0, s0);
+  wasm_v128_store(prng->s1, s1);
+  wasm_v128_store(prng->s2, s2);
+  wasm_v128_store(prng->s3, s3);
+#else
+  uint32_t *s0 = prng->s0;
+  uint32_t *s1 = prng->s1;
+  uint32_t *s2 = prng->s2;
+  uint32_t *s3 = prng->s3;
+
+  for (; n < length; n += number_of_lanes) {
+    float *whites = prng->reserves;
+
+    // Independent lanes (auto-vectorizable)
+    for (size_t lane = 0; lane < number_of_lanes; lane++) {
+      const uint32_t result = s0[lane] + s3[lane];
+      const uint32_t t      = s1[lane] << 9;
+
+      s2[lane] ^= s0[lane];
+      s3[lane] ^= s1[lane];
+      s1[lane] ^= s2[lane];
+      s0[lane] ^= s3[lane];
+      s2[lane] ^= t;
+      s3[lane]  = (s3[lane] << 11) | (s3[lane] >> 21);
+
+      whites[lane] = to_white(result);
+    }
+
+    if ((n + number_of_lanes) <= length) {
+      memcpy((outputs + n), whites, (number_of_lanes * sizeof(float)));
+    } else {
+      memcpy((outputs + n), whites, ((length - n) * sizeof(float)));
+
+      prng->number_of_reserves = number_of_lanes - (length - n);
+    }
+  }
 #endif
-float *pinknoise(const unsigned int time) {
-  if (outputs) {
-    free(outputs);
+}
+
+// Allocates only if `length` exceeds any length so far (no allocation in steady state)
+static float *reserve_outputs(NoiseGeneratorContext *const context, const size_t length) {
+  if (length > context->capacity) {
+    free(context->outputs);
+
+    context->outputs  = (float *)calloc(length, sizeof(float));
+    context->capacity = length;
+
+    memory_layout_changed();
   }
 
-  srand(time);
+  return context->outputs;
+}
+
+static float *generate_whitenoise(NoiseGeneratorContext *const context, const size_t length) {
+  float *outputs = reserve_outputs(context, length);
 
-  outputs = (float *)calloc(buffer_size, sizeof(float));
+  fill_whitenoise(&context->prng, outputs, length);
+
+  return outputs;
+}
+
+static float *generate_pinknoise(NoiseGeneratorContext *const context, const size_t length) {
+  float *outputs = reserve_outputs(context, length);
+
+  float b0 = context->b0;
+  float b1 = context->b1;
+  float b2 = context->b2;
+  float b3 = context->b3;
+  float b4 = context->b4;
+  float b5 = context->b5;
+  float b6 = context->b6;
+
+  fill_whitenoise(&context->prng, outputs, length);
 
   // ref: https://noisehack.com/generate-noise-web-audio-api/#pink-noise
-  for (int n = 0; n < buffer_size; n++) {
-    float white = (float)((2.0f * generate_normalized_rand()) - 1.0f);
+  for (size_t n = 0; n < length; n++) {
+    float white = outputs[n];
 
     b0 = (0.99886f * b0) + (white * 0.0555179f);
     b1 = (0.99332f * b1) + (white * 0.0750759f);
@@ -74,24 +219,27 @@ float *pinknoise(const unsigned int time) {
     b6 = white * 0.115926f;
   }
 
+  context->b0 = b0;
+  context->b1 = b1;
+  context->b2 = b2;
+  context->b3 = b3;
+  context->b4 = b4;
+  context->b5 = b5;
+  context->b6 = b6;
+
   return outputs;
 }
 
-#ifdef __EMSCRIPTEN__
-EMSCRIPTEN_KEEPALIVE
-#endif
-float *browniannoise(const unsigned int time) {
-  if (outputs) {
-    free(outputs);
-  }
+static float *generate_browniannoise(NoiseGeneratorContext *const context, const size_t length) {
+  float *outputs = reserve_outputs(context, length);
 
-  srand(time);
+  float last_out = context->last_out;
 
-  outputs = (float *)calloc(buffer_size, sizeof(float));
+  fill_whitenoise(&context->prng, outputs, length);
 
   // ref: https://noisehack.com/generate-noise-web-audio-api/#brownian-noise
-  for (int n = 0; n < buffer_size; n++) {
-    float white = (float)((2.0f * generate_normalized_rand()) - 1.0f);
+  for (size_t n = 0; n < length; n++) {
+    float white = outputs[n];
 
     outputs[n] = (last_out + (0.02f * white)) / 1.02f;
 
@@ -100,9 +248,171 @@ float *browniannoise(const unsigned int time) {
     outputs[n] *= 3.5f;
   }
 
+  context->last_out = last_out;
+
   return outputs;
 }
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output of instances that are created by the same `seed` is the same
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+NoiseGeneratorContext *noisegenerator_create(const unsigned int seed) {
+  NoiseGeneratorContext *context = (NoiseGeneratorContext *)calloc(1, sizeof(NoiseGeneratorContext));
+
+  reserve_outputs(context, buffer_size);
+
+  seed_prng(&context->prng, seed);
+
+  return context;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void noisegenerator_destroy(NoiseGeneratorContext *const context) {
+  if (context == nullptr) {
+    return;
+  }
+
+  free(context->outputs);
+  profile_release(&context->profile);
+  free(context);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_whitenoise(NoiseGeneratorContext *const context) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_whitenoise(context, buffer_size);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_pinknoise(NoiseGeneratorContext *const context) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_pinknoise(context, buffer_size);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_browniannoise(NoiseGeneratorContext *const context) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_browniannoise(context, buffer_size);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+// Instrumentation of `noisegenerator_*noise` and `noisegenerator_render_*` (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *noisegenerator_profile(NoiseGeneratorContext *const context) {
+  return &context->profile;
+}
+
+// Renders `length` samples (from render quantum size up to many seconds) by one call.
+// Random number generator and filter states are carried over calls, so rendering by any lengths yields the same stream.
+// Return value may move if `length` exceeds any length so far.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_render_whitenoise(NoiseGeneratorContext *const context, const size_t length) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_whitenoise(context, length);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_render_pinknoise(NoiseGeneratorContext *const context, const size_t length) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_pinknoise(context, length);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegenerator_render_browniannoise(NoiseGeneratorContext *const context, const size_t length) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = generate_browniannoise(context, length);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+// API without context is seeded by `time` on every call (same `time`, same white noise) as ever
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *whitenoise(const unsigned int time) {
+  if (default_context == nullptr) {
+    default_context = noisegenerator_create(time);
+  }
+
+  seed_prng(&default_context->prng, time);
+
+  return generate_whitenoise(default_context, buffer_size);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pinknoise(const unsigned int time) {
+  if (default_context == nullptr) {
+    default_context = noisegenerator_create(time);
+  }
+
+  seed_prng(&default_context->prng, time);
+
+  return generate_pinknoise(default_context, buffer_size);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *browniannoise(const unsigned int time) {
+  if (default_context == nullptr) {
+    default_context = noisegenerator_create(time);
+  }
+
+  seed_prng(&default_context->prng, time);
+
+  return generate_browniannoise(default_context, buffer_size);
+}
+
 #ifdef __cplusplus
 }
 #endif
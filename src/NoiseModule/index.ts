@@ -1,5 +1,7 @@
 import type { SoundModuleParams, Module, ModuleName } from '../SoundModule';
 import type { NoiseProcessingMessageEventData } from './NoiseModuleProcessor';
+import type { Profilable } from '../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../XSound';
 import type { Analyser } from '../SoundModule/Analyser';
 import type { Recorder } from '../SoundModule/Recorder';
 import type { Autopanner } from '../SoundModule/Effectors/Autopanner';
@@ -31,9 +33,7 @@ import type { Wah } from '../SoundModule/Effectors/Wah';
 
 import { SoundModule } from '../SoundModule';
 import { NoiseModuleProcessor } from './NoiseModuleProcessor';
-
-// @ts-expect-error Because of import WebAssembly Module
-import wasm from './WebAssemblyModules/noisegenerator.wasm';
+import { compileDSPModule, queryDSPProfile } from '../XSound';
 
 export type NoiseType = 'whitenoise' | 'pinknoise' | 'browniannoise';
 
@@ -47,6 +47,11 @@ export { NoiseModuleProcessor };
  * This subclass is for generating noise.
  */
 export class NoiseModule extends SoundModule {
+  // Samples that are rendered per call of WebAssembly Module.
+  // Real-time rendering renders each render quantum (even load per quantum), offline rendering is not latency-bound.
+  private static readonly REALTIME_BATCH_SIZE = 128;
+  private static readonly OFFLINE_BATCH_SIZE = 16384;
+
   private type: NoiseType = 'whitenoise';
 
   /**
@@ -55,15 +60,20 @@ export class NoiseModule extends SoundModule {
   constructor(context: AudioContext) {
     super(context);
 
-    this.processor = new AudioWorkletNode(context, NoiseModuleProcessor.name);
+    const isOffline = (typeof OfflineAudioContext !== 'undefined') && ((context as BaseAudioContext) instanceof OfflineAudioContext);
 
-    this.envelopegenerator.setGenerator(0);
+    this.processor = new AudioWorkletNode(context, NoiseModuleProcessor.name, {
+      processorOptions: {
+        batchSize: isOffline ? NoiseModule.OFFLINE_BATCH_SIZE : NoiseModule.REALTIME_BATCH_SIZE
+      }
+    });
 
-    fetch(wasm)
-      .then(async (response) => {
-        const wasm = await response.arrayBuffer();
+    this.envelopegenerator.setGenerator(0);
 
-        this.processor.port.postMessage(wasm);
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
       })
       .catch((error: Error) => {
         throw error;
@@ -368,6 +378,28 @@ export class NoiseModule extends SoundModule {
     };
   }
 
+  /**
+   * This method gets noise generator and effectors that are processed by combined DSP module.
+   * @return {{ [name: string]: Profilable }}
+   * @override
+   */
+  protected override profilables(): { [name: string]: Profilable } {
+    const processor = this.processor;
+
+    const noisegenerator: Profilable = {
+      profile: (enabled: boolean) => {
+        const message: DSPProfileMessageEventData = { profile: enabled };
+
+        processor.port.postMessage(message);
+      },
+      stats: (): Promise<DSPProfile | null> => {
+        return queryDSPProfile(processor);
+      }
+    };
+
+    return { noisegenerator, ...super.profilables() };
+  }
+
   /** @override */
   public override get INPUT(): GainNode | null {
     const generator = this.envelopegenerator.getGenerator(0);
@@ -0,0 +1,336 @@
+import type { Inputs, Outputs } from '../../../worklet';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
+
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
+
+export type HarmonizerProcessorParams = {
+  pitches?: number[],
+  dry?: number,
+  wets?: number[]
+};
+
+interface HarmonizerProcessorWebAssemblyInstance extends WebAssembly.Exports {
+  memory: WebAssembly.Memory;
+  get_memory_generation: () => number;
+  fft_plan_measure: (size: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  pitchshifter_profile: (context: number) => number;
+  pitchshifter_create: (fftSize: number) => number;
+  pitchshifter_destroy: (context: number) => void;
+  pitchshifter_get_latency: (context: number) => number;
+  pitchshifter_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  pitchshifter_set_voice: (context: number, index: number, pitch: number, wet: number) => boolean;
+  pitchshifter_set_number_of_voices: (context: number, numberOfVoices: number) => number;
+  pitchshifter_stream_inputs: (context: number) => number;
+  pitchshifter_stream_outputs: (context: number) => number;
+  pitchshifter_stream_process_by_voices: (context: number, speed: number, dry: number) => number;
+};
+
+/**
+ * This class extends `AudioWorkletProcessor`.
+ * Voices of harmony are shifted by one pitch shifter of WebAssembly Module (pitch shifter's module), so that they share one analysis (FFT) per frame.
+ * Override `process` method for harmonizer and Update voices on message event.
+ */
+export class HarmonizerProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
+  private frameSize = 2048;
+
+  private instance: WebAssembly.Instance | null = null;
+
+  // Pointer to `PitchShifterContext` in linear memory (all channels and voices are processed by one call)
+  private context: number | null = null;
+  private numberOfChannels = 0;
+  private voicesInContext = false;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
+  private pitches: number[] = [];
+  private dry = 1;
+  private wets: number[] = [];
+
+  constructor(options: AudioWorkletNodeOptions) {
+    super(options);
+
+    if (options.processorOptions) {
+      const frameSize = options.processorOptions.frameSize ?? 2048;
+
+      // Streaming API of WebAssembly Module does not allocate render quanta if frame size is not multiple of render quantum size
+      this.frameSize = ((frameSize > 0) && ((frameSize % HarmonizerProcessor.RENDER_QUANTUM_SIZE) === 0)) ? frameSize : 2048;
+    }
+
+    this.port.onmessage = async (event: MessageEvent<WebAssembly.Module | HarmonizerProcessorParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.voicesInContext    = false;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
+
+            // HACK:
+            const wasm = instance.exports as HarmonizerProcessorWebAssemblyInstance;
+
+            // FFT algorithms are measured once before rendering by this module (real FFT of frame), not while `process` builds plans
+            wasm.fft_plan_measure(this.frameSize / 2);
+          })
+          .catch((error: Error) => {
+            throw error;
+          });
+      } else {
+        for (const [key, value] of Object.entries(event.data)) {
+          switch (key) {
+            case 'pitches': {
+              if (Array.isArray(value)) {
+                this.pitches         = value;
+                this.voicesInContext = false;
+              }
+
+              break;
+            }
+
+            case 'dry': {
+              if (typeof value === 'number') {
+                this.dry = value;
+              }
+
+              break;
+            }
+
+            case 'wets': {
+              if (Array.isArray(value)) {
+                this.wets            = value;
+                this.voicesInContext = false;
+              }
+
+              break;
+            }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile` or `queryDSPLatency`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              if ((value === 'latency') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getLatency());
+              }
+
+              break;
+            }
+          }
+        }
+      }
+    };
+  }
+
+  /** @override */
+  protected override process(inputs: Inputs, outputs: Outputs): boolean {
+    const input  = inputs[0];
+    const output = outputs[0];
+
+    if ((input.length === 0) || (output.length === 0)) {
+      return true;
+    }
+
+    if (this.instance === null) {
+      // Pass through until combined DSP module is instantiated
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as HarmonizerProcessorWebAssemblyInstance;
+
+    if (this.context === null) {
+      this.context = wasm.pitchshifter_create(this.frameSize);
+    }
+
+    const context = this.context;
+
+    const numberOfChannels = input.length;
+
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.pitchshifter_set_number_of_channels(context, numberOfChannels);
+
+      this.numberOfChannels = numberOfChannels;
+
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (!this.voicesInContext) {
+      const numberOfVoices = Math.min(this.pitches.length, this.wets.length);
+
+      for (let index = 0; index < numberOfVoices; index++) {
+        wasm.pitchshifter_set_voice(context, index, this.pitches[index], this.wets[index]);
+      }
+
+      wasm.pitchshifter_set_number_of_voices(context, numberOfVoices);
+
+      this.voicesInContext = true;
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.pitchshifter_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
+      }
+
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
+    }
+
+    const bufferSize = HarmonizerProcessor.RENDER_QUANTUM_SIZE;
+
+    const linearMemory = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
+
+    if (linearMemory === null) {
+      // Frame size is rejected by WebAssembly Module (e.g. FFT size has the other prime factor), so views at address `0` must not be created
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    const [inputLinearMemory] = linearMemory;
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (input[channelNumber].length === 0) {
+        inputLinearMemory.fill(0, (channelNumber * bufferSize), ((channelNumber + 1) * bufferSize));
+      } else {
+        inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+      }
+    }
+
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
+
+    wasm.pitchshifter_stream_process_by_voices(context, 1, this.dry);
+
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.pitchshifter_profile(context), (getTimestamp() - begin));
+    }
+
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize) ?? linearMemory;
+
+    for (let channelNumber = 0; channelNumber < Math.min(numberOfChannels, output.length); channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
+    }
+
+    return true;
+  }
+
+  /**
+   * This method copies input to output (until combined DSP module is instantiated, or if frame size is not valid).
+   * @param {Array<Float32Array>} input This argument is channels of input.
+   * @param {Array<Float32Array>} output This argument is channels of output.
+   */
+  private passThrough(input: Float32Array[], output: Float32Array[]): void {
+    for (let channelNumber = 0, numberOfChannels = Math.min(input.length, output.length); channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(input[channelNumber]);
+    }
+  }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {HarmonizerProcessorWebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>|null} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`). If render quanta are not allocated, return value is `null`.
+   */
+  private getLinearMemory(wasm: HarmonizerProcessorWebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] | null {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const inputs  = wasm.pitchshifter_stream_inputs(context);
+      const outputs = wasm.pitchshifter_stream_outputs(context);
+
+      if ((inputs === 0) || (outputs === 0)) {
+        return null;
+      }
+
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, inputs, (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, outputs, (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
+    }
+
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as HarmonizerProcessorWebAssemblyInstance;
+
+    const profile = wasm.pitchshifter_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (reply of query).
+   * @return {number|null} Return value is latency (samples). If context is not created yet, return value is `null`.
+   */
+  private getLatency(): number | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as HarmonizerProcessorWebAssemblyInstance;
+
+    return wasm.pitchshifter_get_latency(this.context);
+  }
+}
@@ -1,12 +1,27 @@
 import type { Inputs, Outputs } from '../../../worklet';
 import type { NoiseGateParams } from '../NoiseGate';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
 
-import { AudioWorkletProcessor } from '../../../worklet';
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
 
 interface NoiseGateProcessorWebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  noisegate: (level: number) => number;
-  alloc_memory_inputs: () => number;
+  get_memory_generation: () => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  noisegate_profile: (context: number) => number;
+  noisegate_create: () => number;
+  noisegate_destroy: (context: number) => void;
+  noisegate_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  noisegate_inputs: (context: number) => number;
+  noisegate_outputs: (context: number) => number;
+  noisegate_process: (context: number, level: number) => number;
 };
 
 /**
@@ -16,17 +31,37 @@ interface NoiseGateProcessorWebAssemblyInstance extends WebAssembly.Exports {
 export class NoiseGateProcessor extends AudioWorkletProcessor {
   private instance: WebAssembly.Instance | null = null;
 
+  // Pointer to `NoiseGateContext` in linear memory (all channels are processed by one call)
+  private context: number | null = null;
+  private numberOfChannels = 0;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
   private level = 0;
   private isActive = true;
 
   constructor() {
     super();
 
-    this.port.onmessage = (event: MessageEvent<ArrayBuffer | NoiseGateParams>) => {
-      if (event.data instanceof ArrayBuffer) {
-        WebAssembly.instantiate(event.data)
-          .then(({ instance }) => {
-            this.instance = instance;
+    this.port.onmessage = (event: MessageEvent<WebAssembly.Module | NoiseGateParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
           })
           .catch((error: Error) => {
             throw error;
@@ -49,6 +84,24 @@ export class NoiseGateProcessor extends AudioWorkletProcessor {
 
               break;
             }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              break;
+            }
           }
         }
       }
@@ -57,10 +110,6 @@ export class NoiseGateProcessor extends AudioWorkletProcessor {
 
   /** @override */
   protected override process(inputs: Inputs, outputs: Outputs): boolean {
-    if (this.instance === null) {
-      return false;
-    }
-
     const input  = inputs[0];
     const output = outputs[0];
 
@@ -68,7 +117,8 @@ export class NoiseGateProcessor extends AudioWorkletProcessor {
       return true;
     }
 
-    if (!this.isActive || (this.level === 0)) {
+    // Pass through until combined DSP module is instantiated
+    if ((this.instance === null) || !this.isActive || (this.level === 0)) {
       for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
         output[channelNumber].set(input[channelNumber]);
       }
@@ -79,22 +129,108 @@ export class NoiseGateProcessor extends AudioWorkletProcessor {
     // HACK:
     const wasm = this.instance.exports as NoiseGateProcessorWebAssemblyInstance;;
 
-    const linearMemory = wasm.memory.buffer;
+    if (this.context === null) {
+      this.context = wasm.noisegate_create();
+    }
+
+    const context = this.context;
+
+    const numberOfChannels = input.length;
+
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.noisegate_set_number_of_channels(context, numberOfChannels);
+
+      this.numberOfChannels = numberOfChannels;
+
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.noisegate_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
+      }
+
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
+    }
 
     const bufferSize = input[0].length;
 
-    for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
-      const offsetInput = wasm.alloc_memory_inputs();
+    const [inputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
 
-      const inputLinearMemory = new Float32Array(linearMemory, offsetInput, bufferSize);
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+    }
 
-      inputLinearMemory.set(input[channelNumber]);
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
 
-      const offsetOutput = wasm.noisegate(this.level);
+    wasm.noisegate_process(context, this.level);
 
-      output[channelNumber].set(new Float32Array(linearMemory, offsetOutput, bufferSize));
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.noisegate_profile(context), (getTimestamp() - begin));
+    }
+
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
     }
 
     return true;
   }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {NoiseGateProcessorWebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`).
+   */
+  private getLinearMemory(wasm: NoiseGateProcessorWebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, wasm.noisegate_inputs(context), (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, wasm.noisegate_outputs(context), (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
+    }
+
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as NoiseGateProcessorWebAssemblyInstance;
+
+    const profile = wasm.noisegate_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
 }
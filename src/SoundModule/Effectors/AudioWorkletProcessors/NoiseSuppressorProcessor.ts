@@ -1,32 +1,92 @@
 import type { Inputs, Outputs } from '../../../worklet';
 import type { NoiseSuppressorParams } from '../NoiseSuppressor';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
 
-import { OverlapAddProcessor } from '../../../worklet';
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
 
 interface NoiseSuppressorProcessorWebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  noisesuppressor: (threshold: number, fftSize: number) => number;
-  alloc_memory_inputs: (bufferSize: number) => number;
+  get_memory_generation: () => number;
+  fft_plan_measure: (size: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  noisesuppressor_profile: (context: number) => number;
+  noisesuppressor_create: (fftSize: number) => number;
+  noisesuppressor_destroy: (context: number) => void;
+  noisesuppressor_set_low_latency: (context: number, lowLatency: boolean) => boolean;
+  noisesuppressor_get_latency: (context: number) => number;
+  noisesuppressor_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  noisesuppressor_stream_inputs: (context: number) => number;
+  noisesuppressor_stream_outputs: (context: number) => number;
+  noisesuppressor_stream_process: (context: number, threshold: number) => number;
 };
 
 /**
- * This class extends `OverlapAddProcessor`.
- * Override `processOverlapAdd` method for noise suppressor and Update parameters on message event.
+ * This class extends `AudioWorkletProcessor`.
+ * Overlap-add (frames and hops) is processed by WebAssembly Module, so only render quantum is pushed and pulled.
+ * Override `process` method for noise suppressor and Update parameters on message event.
  */
-export class NoiseSuppressorProcessor extends OverlapAddProcessor {
+export class NoiseSuppressorProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
+  // Frame size of low-latency mode (asymmetric windows, latency is 128 samples)
+  private static readonly LOW_LATENCY_FRAME_SIZE = 512;
+
+  private frameSize = 2048;
+  private lowLatency = false;
+
   private instance: WebAssembly.Instance | null = null;
 
+  // Pointer to `NoiseSuppressorContext` in linear memory (all channels are processed by one call)
+  private context: number | null = null;
+  private numberOfChannels = 0;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
   private threshold = 0;
   private isActive = true;
 
   constructor(options: AudioWorkletNodeOptions) {
     super(options);
 
-    this.port.onmessage = async (event: MessageEvent<ArrayBuffer | NoiseSuppressorParams>) => {
-      if (event.data instanceof ArrayBuffer) {
-        WebAssembly.instantiate(event.data)
-          .then(({ instance }) => {
-            this.instance = instance;
+    if (options.processorOptions) {
+      const frameSize = options.processorOptions.frameSize ?? 2048;
+
+      // Streaming API of WebAssembly Module does not allocate render quanta if frame size is not multiple of render quantum size
+      this.frameSize = ((frameSize > 0) && ((frameSize % NoiseSuppressorProcessor.RENDER_QUANTUM_SIZE) === 0)) ? frameSize : 2048;
+    }
+
+    this.port.onmessage = async (event: MessageEvent<WebAssembly.Module | NoiseSuppressorParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
+
+            // HACK:
+            const wasm = instance.exports as NoiseSuppressorProcessorWebAssemblyInstance;
+
+            // FFT algorithms are measured once before rendering by this module (real FFT of frame), not while `process` builds plans
+            wasm.fft_plan_measure((this.lowLatency ? NoiseSuppressorProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize) / 2);
           })
           .catch((error: Error) => {
             throw error;
@@ -49,6 +109,38 @@ export class NoiseSuppressorProcessor extends OverlapAddProcessor {
 
               break;
             }
+
+            case 'lowLatency': {
+              // Frame size is changed, so context is created again by the next render quantum
+              if ((typeof value === 'boolean') && (value !== this.lowLatency)) {
+                this.lowLatency = value;
+                this.destroyContext();
+              }
+
+              break;
+            }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile` or `queryDSPLatency`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              if ((value === 'latency') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getLatency());
+              }
+
+              break;
+            }
           }
         }
       }
@@ -56,11 +148,7 @@ export class NoiseSuppressorProcessor extends OverlapAddProcessor {
   }
 
   /** @override */
-  protected override processOverlapAdd(inputs: Inputs, outputs: Outputs): boolean {
-    if (this.instance === null) {
-      return false;
-    }
-
+  protected override process(inputs: Inputs, outputs: Outputs): boolean {
     const input  = inputs[0];
     const output = outputs[0];
 
@@ -68,10 +156,9 @@ export class NoiseSuppressorProcessor extends OverlapAddProcessor {
       return true;
     }
 
-    if (!this.isActive || (this.threshold === 0)) {
-      for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
-        output[channelNumber].set(input[channelNumber]);
-      }
+    if (this.instance === null) {
+      // Pass through until combined DSP module is instantiated
+      this.passThrough(input, output);
 
       return true;
     }
@@ -79,20 +166,176 @@ export class NoiseSuppressorProcessor extends OverlapAddProcessor {
     // HACK:
     const wasm = this.instance.exports as NoiseSuppressorProcessorWebAssemblyInstance;
 
-    const linearMemory = wasm.memory.buffer;
+    if (this.context === null) {
+      this.context = wasm.noisesuppressor_create(this.lowLatency ? NoiseSuppressorProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize);
+
+      wasm.noisesuppressor_set_low_latency(this.context, this.lowLatency);
+    }
+
+    const context = this.context;
+
+    const numberOfChannels = input.length;
+
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.noisesuppressor_set_number_of_channels(context, numberOfChannels);
+
+      this.numberOfChannels = numberOfChannels;
+
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.noisesuppressor_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
+      }
+
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
+    }
+
+    const bufferSize = NoiseSuppressorProcessor.RENDER_QUANTUM_SIZE;
+
+    const linearMemory = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
+
+    if (linearMemory === null) {
+      // Frame size is rejected by WebAssembly Module (e.g. FFT size has the other prime factor), so views at address `0` must not be created
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    const [inputLinearMemory] = linearMemory;
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (input[channelNumber].length === 0) {
+        inputLinearMemory.fill(0, (channelNumber * bufferSize), ((channelNumber + 1) * bufferSize));
+      } else {
+        inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+      }
+    }
 
-    for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
-      const offsetInput = wasm.alloc_memory_inputs(this.frameSize);
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
 
-      const inputLinearMemory = new Float32Array(linearMemory, offsetInput, this.frameSize);
+    // If not active, threshold `0` (bypass) keeps the same latency as suppression
+    wasm.noisesuppressor_stream_process(context, (this.isActive ? this.threshold : 0));
 
-      inputLinearMemory.set(input[channelNumber]);
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.noisesuppressor_profile(context), (getTimestamp() - begin));
+    }
 
-      const offsetOutput = wasm.noisesuppressor(this.threshold, this.frameSize);
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize) ?? linearMemory;
 
-      output[channelNumber].set(new Float32Array(linearMemory, offsetOutput, this.frameSize));
+    for (let channelNumber = 0; channelNumber < Math.min(numberOfChannels, output.length); channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
     }
 
     return true;
   }
+
+  /**
+   * This method destroys context of WebAssembly Module (if it is created), so that it is created again by the next render quantum.
+   */
+  private destroyContext(): void {
+    if ((this.instance !== null) && (this.context !== null)) {
+      // HACK:
+      const wasm = this.instance.exports as NoiseSuppressorProcessorWebAssemblyInstance;
+
+      wasm.noisesuppressor_destroy(this.context);
+    }
+
+    this.context            = null;
+    this.numberOfChannels   = 0;
+    this.memoryGeneration   = -1;
+    this.inputLinearMemory  = null;
+    this.outputLinearMemory = null;
+    this.profilingInContext = false;
+  }
+
+  /**
+   * This method copies input to output (until combined DSP module is instantiated, or if frame size is not valid).
+   * @param {Array<Float32Array>} input This argument is channels of input.
+   * @param {Array<Float32Array>} output This argument is channels of output.
+   */
+  private passThrough(input: Float32Array[], output: Float32Array[]): void {
+    for (let channelNumber = 0, numberOfChannels = Math.min(input.length, output.length); channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(input[channelNumber]);
+    }
+  }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {NoiseSuppressorProcessorWebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>|null} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`). If render quanta are not allocated, return value is `null`.
+   */
+  private getLinearMemory(wasm: NoiseSuppressorProcessorWebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] | null {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const inputs  = wasm.noisesuppressor_stream_inputs(context);
+      const outputs = wasm.noisesuppressor_stream_outputs(context);
+
+      if ((inputs === 0) || (outputs === 0)) {
+        return null;
+      }
+
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, inputs, (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, outputs, (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
+    }
+
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as NoiseSuppressorProcessorWebAssemblyInstance;
+
+    const profile = wasm.noisesuppressor_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (reply of query).
+   * @return {number|null} Return value is latency (samples). If context is not created yet, return value is `null`.
+   */
+  private getLatency(): number | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as NoiseSuppressorProcessorWebAssemblyInstance;
+
+    return wasm.noisesuppressor_get_latency(this.context);
+  }
 }
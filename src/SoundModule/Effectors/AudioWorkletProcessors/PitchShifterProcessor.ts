@@ -1,38 +1,103 @@
 import type { Inputs, Outputs } from '../../../worklet';
-import type { PitchShifterParams } from '../PitchShifter';
+import type { PitchShifterParams, PitchShifterAlgorithm } from '../PitchShifter';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
 
-import { OverlapAddProcessor } from '../../../worklet';
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
 
 interface PitchShifterProcessorebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  pitchshifter: (pitch: number, speed: number, fftSize: number, timeCursor: number) => number;
-  alloc_memory_inputs: (bufferSize: number) => number;
+  get_memory_generation: () => number;
+  fft_plan_measure: (size: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  pitchshifter_profile: (context: number) => number;
+  pitchshifter_create: (fftSize: number) => number;
+  pitchshifter_destroy: (context: number) => void;
+  pitchshifter_set_low_latency: (context: number, lowLatency: boolean) => boolean;
+  pitchshifter_get_latency: (context: number) => number;
+  pitchshifter_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  pitchshifter_stream_inputs: (context: number) => number;
+  pitchshifter_stream_outputs: (context: number) => number;
+  pitchshifter_stream_process: (context: number, pitch: number, speed: number, dry: number, wet: number) => number;
+  pitchshifter_stream_process_by_phase_vocoder: (context: number, pitch: number, speed: number, dry: number, wet: number) => number;
+  pitchshifter_set_hop_size: (context: number, hopSize: number) => number;
 };
 
 /**
- * This class extends `OverlapAddProcessor`.
- * Override `processOverlapAdd` method for pitch shifter and Update parameters on message event.
+ * This class extends `AudioWorkletProcessor`.
+ * Overlap-add (frames and hops) is processed by WebAssembly Module, so only render quantum is pushed and pulled.
+ * Override `process` method for pitch shifter and Update parameters on message event.
  */
-export class PitchShifterProcessor extends OverlapAddProcessor {
+export class PitchShifterProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
+  // Frame size of low-latency mode (asymmetric windows, latency is 128 samples)
+  private static readonly LOW_LATENCY_FRAME_SIZE = 512;
+
+  private frameSize = 2048;
+  private lowLatency = false;
+
   private instance: WebAssembly.Instance | null = null;
 
-  private timeCursor = 0;
+  // Pointer to `PitchShifterContext` in linear memory (all channels are processed by one call)
+  private context: number | null = null;
+  private numberOfChannels = 0;
+  private hopSizeInContext = 0;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
 
   private isActive = true;
+  private algorithm: PitchShifterAlgorithm = 'peak';
   private pitch = 1;
   private speed = 1;
 
   private dry = 0;
   private wet = 1;
 
+  private hopSize = 128;
+
   constructor(options: AudioWorkletNodeOptions) {
     super(options);
 
-    this.port.onmessage = async (event: MessageEvent<ArrayBuffer | PitchShifterParams>) => {
-      if (event.data instanceof ArrayBuffer) {
-        WebAssembly.instantiate(event.data)
-          .then(({ instance }) => {
-            this.instance = instance;
+    if (options.processorOptions) {
+      const frameSize = options.processorOptions.frameSize ?? 2048;
+
+      // Streaming API of WebAssembly Module does not allocate render quanta if frame size is not multiple of render quantum size
+      this.frameSize = ((frameSize > 0) && ((frameSize % PitchShifterProcessor.RENDER_QUANTUM_SIZE) === 0)) ? frameSize : 2048;
+    }
+
+    this.port.onmessage = async (event: MessageEvent<WebAssembly.Module | PitchShifterParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.hopSizeInContext   = 0;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
+
+            // HACK:
+            const wasm = instance.exports as PitchShifterProcessorebAssemblyInstance;
+
+            // FFT algorithms are measured once before rendering by this module (real FFT of frame), not while `process` builds plans
+            wasm.fft_plan_measure((this.lowLatency ? PitchShifterProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize) / 2);
           })
           .catch((error: Error) => {
             throw error;
@@ -48,6 +113,14 @@ export class PitchShifterProcessor extends OverlapAddProcessor {
               break;
             }
 
+            case 'algorithm': {
+              if (typeof value === 'string') {
+                this.algorithm = value;
+              }
+
+              break;
+            }
+
             case 'pitch': {
               if (typeof value === 'number') {
                 this.pitch = value;
@@ -79,6 +152,46 @@ export class PitchShifterProcessor extends OverlapAddProcessor {
 
               break;
             }
+
+            case 'hopSize': {
+              if (typeof value === 'number') {
+                this.hopSize = value;
+              }
+
+              break;
+            }
+
+            case 'lowLatency': {
+              // Frame size is changed, so context is created again by the next render quantum
+              if ((typeof value === 'boolean') && (value !== this.lowLatency)) {
+                this.lowLatency = value;
+                this.destroyContext();
+              }
+
+              break;
+            }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile` or `queryDSPLatency`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              if ((value === 'latency') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getLatency());
+              }
+
+              break;
+            }
           }
         }
       }
@@ -86,47 +199,214 @@ export class PitchShifterProcessor extends OverlapAddProcessor {
   }
 
   /** @override */
-  protected override processOverlapAdd(inputs: Inputs, outputs: Outputs): void {
-    if (this.instance === null) {
-      return;
-    }
-
+  protected override process(inputs: Inputs, outputs: Outputs): boolean {
     const input  = inputs[0];
     const output = outputs[0];
 
-    if (!this.isActive || ((this.pitch === 1) && (this.speed === 1))) {
-      for (let channelNumber = 0; channelNumber < input.length; channelNumber++) {
-        output[channelNumber].set(input[channelNumber]);
-      }
+    if ((input.length === 0) || (output.length === 0)) {
+      return true;
+    }
 
-      return;
+    if (this.instance === null) {
+      // Pass through until combined DSP module is instantiated
+      this.passThrough(input, output);
+
+      return true;
     }
 
     // HACK:
     const wasm = this.instance.exports as PitchShifterProcessorebAssemblyInstance;
 
-    const linearMemory = wasm.memory.buffer;
+    if (this.context === null) {
+      this.context = wasm.pitchshifter_create(this.lowLatency ? PitchShifterProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize);
+
+      wasm.pitchshifter_set_low_latency(this.context, this.lowLatency);
+    }
 
-    for (let channelNumber = 0; channelNumber < input.length; channelNumber++) {
-      const offsetInput = wasm.alloc_memory_inputs(this.frameSize);
+    const context = this.context;
 
-      const inputLinearMemory = new Float32Array(linearMemory, offsetInput, this.frameSize);
+    const numberOfChannels = input.length;
 
-      inputLinearMemory.set(input[channelNumber]);
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.pitchshifter_set_number_of_channels(context, numberOfChannels);
 
-      const offsetOutput = wasm.pitchshifter(this.pitch, this.speed, this.frameSize, this.timeCursor);
+      this.numberOfChannels = numberOfChannels;
 
-      const shiftedOutput = new Float32Array(linearMemory, offsetOutput, this.frameSize);
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (this.hopSize !== this.hopSizeInContext) {
+      // Invalid hop size is ignored by WebAssembly Module (return value is hop size in use)
+      this.hopSizeInContext = wasm.pitchshifter_set_hop_size(context, this.hopSize);
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.pitchshifter_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
+      }
 
-      if (this.dry === 0) {
-        output[channelNumber].set(shiftedOutput);
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
+    }
+
+    const bufferSize = PitchShifterProcessor.RENDER_QUANTUM_SIZE;
+
+    const linearMemory = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
+
+    if (linearMemory === null) {
+      // Frame size is rejected by WebAssembly Module (e.g. FFT size has the other prime factor), so views at address `0` must not be created
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    const [inputLinearMemory] = linearMemory;
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (input[channelNumber].length === 0) {
+        inputLinearMemory.fill(0, (channelNumber * bufferSize), ((channelNumber + 1) * bufferSize));
       } else {
-        for (let n = 0; n < this.frameSize; n++) {
-          output[channelNumber][n] = (this.dry * input[channelNumber][n]) + (this.wet * shiftedOutput[n]);
+        inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+      }
+    }
+
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
+
+    if (!this.isActive) {
+      // Pitch `1` and speed `1` (bypass) keeps the same latency as shifting
+      wasm.pitchshifter_stream_process(context, 1, 1, 0, 1);
+    } else {
+      switch (this.algorithm) {
+        case 'peak': {
+          wasm.pitchshifter_stream_process(context, this.pitch, this.speed, this.dry, this.wet);
+          break;
         }
+
+        case 'vocoder': {
+          wasm.pitchshifter_stream_process_by_phase_vocoder(context, this.pitch, this.speed, this.dry, this.wet);
+          break;
+        }
+      }
+    }
+
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.pitchshifter_profile(context), (getTimestamp() - begin));
+    }
+
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize) ?? linearMemory;
+
+    for (let channelNumber = 0; channelNumber < Math.min(numberOfChannels, output.length); channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
+    }
+
+    return true;
+  }
+
+  /**
+   * This method destroys context of WebAssembly Module (if it is created), so that it is created again by the next render quantum.
+   */
+  private destroyContext(): void {
+    if ((this.instance !== null) && (this.context !== null)) {
+      // HACK:
+      const wasm = this.instance.exports as PitchShifterProcessorebAssemblyInstance;
+
+      wasm.pitchshifter_destroy(this.context);
+    }
+
+    this.context            = null;
+    this.numberOfChannels   = 0;
+    this.hopSizeInContext   = 0;
+    this.memoryGeneration   = -1;
+    this.inputLinearMemory  = null;
+    this.outputLinearMemory = null;
+    this.profilingInContext = false;
+  }
+
+  /**
+   * This method copies input to output (until combined DSP module is instantiated, or if frame size is not valid).
+   * @param {Array<Float32Array>} input This argument is channels of input.
+   * @param {Array<Float32Array>} output This argument is channels of output.
+   */
+  private passThrough(input: Float32Array[], output: Float32Array[]): void {
+    for (let channelNumber = 0, numberOfChannels = Math.min(input.length, output.length); channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(input[channelNumber]);
+    }
+  }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {PitchShifterProcessorebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>|null} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`). If render quanta are not allocated, return value is `null`.
+   */
+  private getLinearMemory(wasm: PitchShifterProcessorebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] | null {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const inputs  = wasm.pitchshifter_stream_inputs(context);
+      const outputs = wasm.pitchshifter_stream_outputs(context);
+
+      if ((inputs === 0) || (outputs === 0)) {
+        return null;
       }
+
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, inputs, (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, outputs, (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
     }
 
-    this.timeCursor += this.hopSize;
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as PitchShifterProcessorebAssemblyInstance;
+
+    const profile = wasm.pitchshifter_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (reply of query).
+   * @return {number|null} Return value is latency (samples). If context is not created yet, return value is `null`.
+   */
+  private getLatency(): number | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as PitchShifterProcessorebAssemblyInstance;
+
+    return wasm.pitchshifter_get_latency(this.context);
   }
 }
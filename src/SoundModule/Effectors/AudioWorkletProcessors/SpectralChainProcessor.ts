@@ -0,0 +1,346 @@
+import type { Inputs, Outputs } from '../../../worklet';
+import type { SpectralChainParams, SpectralStageParams } from '../SpectralChain';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
+
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
+
+interface SpectralChainProcessorWebAssemblyInstance extends WebAssembly.Exports {
+  memory: WebAssembly.Memory;
+  get_memory_generation: () => number;
+  fft_plan_measure: (size: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  spectralchain_profile: (context: number) => number;
+  spectralchain_create: (fftSize: number) => number;
+  spectralchain_destroy: (context: number) => void;
+  spectralchain_get_latency: (context: number) => number;
+  spectralchain_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  spectralchain_set_number_of_stages: (context: number, numberOfStages: number) => number;
+  spectralchain_set_noise_suppressor: (context: number, index: number, threshold: number) => boolean;
+  spectralchain_set_vocal_canceler: (context: number, index: number, onSpectrum: boolean, depth: number, sampleRate: number, minFrequency: number, maxFrequency: number, threshold: number) => boolean;
+  spectralchain_set_pitch_shifter: (context: number, index: number, pitch: number, speed: number, dry: number, wet: number) => boolean;
+  spectralchain_stream_inputs: (context: number) => number;
+  spectralchain_stream_outputs: (context: number) => number;
+  spectralchain_stream_process: (context: number) => number;
+  spectralchain_set_hop_size: (context: number, hopSize: number) => number;
+};
+
+/**
+ * This class extends `AudioWorkletProcessor`.
+ * Overlap-add (frames and hops) is processed by WebAssembly Module, so only render quantum is pushed and pulled.
+ * Override `process` method for fused spectral effectors and Update stages on message event.
+ */
+export class SpectralChainProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
+  private frameSize = 2048;
+
+  private instance: WebAssembly.Instance | null = null;
+
+  // Pointer to `SpectralChainContext` in linear memory (all channels are processed by one call)
+  private context: number | null = null;
+  private numberOfChannels = 0;
+  private hopSizeInContext = 0;
+  private stagesInContext = false;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
+  private hopSize = 128;
+  private stages: SpectralStageParams[] = [];
+
+  constructor(options: AudioWorkletNodeOptions) {
+    super(options);
+
+    if (options.processorOptions) {
+      const frameSize = options.processorOptions.frameSize ?? 2048;
+
+      // Streaming API of WebAssembly Module does not allocate render quanta if frame size is not multiple of render quantum size
+      this.frameSize = ((frameSize > 0) && ((frameSize % SpectralChainProcessor.RENDER_QUANTUM_SIZE) === 0)) ? frameSize : 2048;
+    }
+
+    this.port.onmessage = async (event: MessageEvent<WebAssembly.Module | SpectralChainParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.hopSizeInContext   = 0;
+            this.stagesInContext    = false;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
+
+            // HACK:
+            const wasm = instance.exports as SpectralChainProcessorWebAssemblyInstance;
+
+            // FFT algorithms are measured once before rendering by this module (real FFT of frame), not while `process` builds plans
+            wasm.fft_plan_measure(this.frameSize / 2);
+          })
+          .catch((error: Error) => {
+            throw error;
+          });
+      } else {
+        for (const [key, value] of Object.entries(event.data)) {
+          switch (key) {
+            case 'hopSize': {
+              if (typeof value === 'number') {
+                this.hopSize = value;
+              }
+
+              break;
+            }
+
+            case 'stages': {
+              if (Array.isArray(value)) {
+                this.stages          = value;
+                this.stagesInContext = false;
+              }
+
+              break;
+            }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile` or `queryDSPLatency`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              if ((value === 'latency') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getLatency());
+              }
+
+              break;
+            }
+          }
+        }
+      }
+    };
+  }
+
+  /** @override */
+  protected override process(inputs: Inputs, outputs: Outputs): boolean {
+    const input  = inputs[0];
+    const output = outputs[0];
+
+    if ((input.length === 0) || (output.length === 0)) {
+      return true;
+    }
+
+    if (this.instance === null) {
+      // Pass through until combined DSP module is instantiated
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as SpectralChainProcessorWebAssemblyInstance;
+
+    if (this.context === null) {
+      this.context = wasm.spectralchain_create(this.frameSize);
+    }
+
+    const context = this.context;
+
+    // Vocal canceler stage is bypassed by WebAssembly Module except stereo
+    const numberOfChannels = input.length;
+
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.spectralchain_set_number_of_channels(context, numberOfChannels);
+
+      this.numberOfChannels = numberOfChannels;
+
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (this.hopSize !== this.hopSizeInContext) {
+      // Invalid hop size is ignored by WebAssembly Module (return value is hop size in use)
+      this.hopSizeInContext = wasm.spectralchain_set_hop_size(context, this.hopSize);
+    }
+
+    if (!this.stagesInContext) {
+      // Stage of the same type keeps its state (time cursor of pitch shifter)
+      this.stages.forEach((stage: SpectralStageParams, index: number) => {
+        switch (stage.type) {
+          case 'noisesuppressor': {
+            wasm.spectralchain_set_noise_suppressor(context, index, stage.threshold);
+            break;
+          }
+
+          case 'vocalcanceler': {
+            wasm.spectralchain_set_vocal_canceler(context, index, (stage.algorithm === 'spectrum'), stage.depth, sampleRate, stage.minFrequency, stage.maxFrequency, stage.threshold);
+            break;
+          }
+
+          case 'pitchshifter': {
+            wasm.spectralchain_set_pitch_shifter(context, index, stage.pitch, stage.speed, stage.dry, stage.wet);
+            break;
+          }
+        }
+      });
+
+      wasm.spectralchain_set_number_of_stages(context, this.stages.length);
+
+      this.stagesInContext = true;
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.spectralchain_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
+      }
+
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
+    }
+
+    const bufferSize = SpectralChainProcessor.RENDER_QUANTUM_SIZE;
+
+    const linearMemory = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
+
+    if (linearMemory === null) {
+      // Frame size is rejected by WebAssembly Module (e.g. FFT size has the other prime factor), so views at address `0` must not be created
+      this.passThrough(input, output);
+
+      return true;
+    }
+
+    const [inputLinearMemory] = linearMemory;
+
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (input[channelNumber].length === 0) {
+        inputLinearMemory.fill(0, (channelNumber * bufferSize), ((channelNumber + 1) * bufferSize));
+      } else {
+        inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+      }
+    }
+
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
+
+    wasm.spectralchain_stream_process(context);
+
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.spectralchain_profile(context), (getTimestamp() - begin));
+    }
+
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize) ?? linearMemory;
+
+    for (let channelNumber = 0; channelNumber < Math.min(numberOfChannels, output.length); channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
+    }
+
+    return true;
+  }
+
+  /**
+   * This method copies input to output (until combined DSP module is instantiated, or if frame size is not valid).
+   * @param {Array<Float32Array>} input This argument is channels of input.
+   * @param {Array<Float32Array>} output This argument is channels of output.
+   */
+  private passThrough(input: Float32Array[], output: Float32Array[]): void {
+    for (let channelNumber = 0, numberOfChannels = Math.min(input.length, output.length); channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(input[channelNumber]);
+    }
+  }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {SpectralChainProcessorWebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>|null} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`). If render quanta are not allocated, return value is `null`.
+   */
+  private getLinearMemory(wasm: SpectralChainProcessorWebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] | null {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const inputs  = wasm.spectralchain_stream_inputs(context);
+      const outputs = wasm.spectralchain_stream_outputs(context);
+
+      if ((inputs === 0) || (outputs === 0)) {
+        return null;
+      }
+
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, inputs, (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, outputs, (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
+    }
+
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as SpectralChainProcessorWebAssemblyInstance;
+
+    const profile = wasm.spectralchain_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (reply of query).
+   * @return {number|null} Return value is latency (samples). If context is not created yet, return value is `null`.
+   */
+  private getLatency(): number | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as SpectralChainProcessorWebAssemblyInstance;
+
+    return wasm.spectralchain_get_latency(this.context);
+  }
+}
@@ -1,24 +1,62 @@
 import type { Inputs, Outputs } from '../../../worklet';
 import type { VocalCancelerParams, VocalCancelerAlgorithm } from '../VocalCanceler';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../../XSound';
 
-import { OverlapAddProcessor } from '../../../worklet';
+import { AudioWorkletProcessor, createDSPImports, getTimestamp } from '../../../worklet';
 
 interface VocalCancelerProcessorWebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  vocalcancelerL: (depth: number, bufferSize: number) => number;
-  vocalcancelerR: (depth: number, bufferSize: number) => number;
-  vocalcanceler_on_spectrum: (sampleRate: number, minFrequency: number, maxFrequency: number, threshold: number, fftSize: number) => number;
-  alloc_memory_inputLs: (bufferSize: number) => number;
-  alloc_memory_inputRs: (bufferSize: number) => number;
+  get_memory_generation: () => number;
+  fft_plan_measure: (size: number) => number;
+  profile_set_enabled: (profile: number, enabled: boolean) => void;
+  profile_reset: (profile: number) => void;
+  profile_add_time: (profile: number, time: number) => void;
+  profile_get_number_of_calls: (profile: number) => number;
+  profile_get_total_time: (profile: number) => number;
+  profile_get_max_time: (profile: number) => number;
+  profile_get_number_of_allocations: (profile: number) => number;
+  profile_get_number_of_skipped_frames: (profile: number) => number;
+  vocalcanceler_profile: (context: number) => number;
+  vocalcanceler_create: (fftSize: number) => number;
+  vocalcanceler_destroy: (context: number) => void;
+  vocalcanceler_set_low_latency: (context: number, lowLatency: boolean) => boolean;
+  vocalcanceler_get_latency: (context: number) => number;
+  vocalcanceler_set_number_of_channels: (context: number, numberOfChannels: number) => void;
+  vocalcanceler_stream_inputs: (context: number) => number;
+  vocalcanceler_stream_outputs: (context: number) => number;
+  vocalcanceler_stream_process: (context: number, depth: number) => number;
+  vocalcanceler_stream_process_on_spectrum: (context: number, depth: number, sampleRate: number, minFrequency: number, maxFrequency: number, threshold: number) => number;
 };
 
 /**
- * This class extends `OverlapAddProcessor`.
- * Override `processOverlapAdd` method for vocal canceler and Update parameters on message event.
+ * This class extends `AudioWorkletProcessor`.
+ * Overlap-add (frames and hops) is processed by WebAssembly Module, so only render quantum is pushed and pulled.
+ * Override `process` method for vocal canceler and Update parameters on message event.
  */
-export class VocalCancelerProcessor extends OverlapAddProcessor {
+export class VocalCancelerProcessor extends AudioWorkletProcessor {
+  private static readonly RENDER_QUANTUM_SIZE = 128;
+
+  // Frame size of low-latency mode (asymmetric windows, latency is 128 samples)
+  private static readonly LOW_LATENCY_FRAME_SIZE = 512;
+
+  private frameSize = 2048;
+  private lowLatency = false;
+
   private instance: WebAssembly.Instance | null = null;
 
+  // Pointer to `VocalCancelerContext` in linear memory
+  private context: number | null = null;
+  private numberOfChannels = 0;
+
+  // Views of render quanta in linear memory (created again only if generation of memory layout is changed)
+  private memoryGeneration = -1;
+  private inputLinearMemory: Float32Array | null = null;
+  private outputLinearMemory: Float32Array | null = null;
+
+  // Instrumentation of WebAssembly Module is opt-in (set to context when context is created, or instrumentation is started or stopped)
+  private profiling = false;
+  private profilingInContext = false;
+
   private algorithm: VocalCancelerAlgorithm = 'time';
   private depth = 0;
   private minFrequency = 200;
@@ -30,11 +68,31 @@ export class VocalCancelerProcessor extends OverlapAddProcessor {
   constructor(options: AudioWorkletNodeOptions) {
     super(options);
 
-    this.port.onmessage = (event: MessageEvent<ArrayBuffer | VocalCancelerParams>) => {
-      if (event.data instanceof ArrayBuffer) {
-        WebAssembly.instantiate(event.data)
-          .then(({ instance }) => {
-            this.instance = instance;
+    if (options.processorOptions) {
+      const frameSize = options.processorOptions.frameSize ?? 2048;
+
+      // Streaming API of WebAssembly Module does not allocate render quanta if frame size is not multiple of render quantum size
+      this.frameSize = ((frameSize > 0) && ((frameSize % VocalCancelerProcessor.RENDER_QUANTUM_SIZE) === 0)) ? frameSize : 2048;
+    }
+
+    this.port.onmessage = (event: MessageEvent<WebAssembly.Module | VocalCancelerParams | DSPProfileMessageEventData>) => {
+      if (event.data instanceof WebAssembly.Module) {
+        // Combined DSP module is compiled by main thread, so it is only instantiated
+        WebAssembly.instantiate(event.data, createDSPImports(() => ((this.instance === null) ? null : (this.instance.exports.memory as WebAssembly.Memory)), getTimestamp))
+          .then((instance: WebAssembly.Instance) => {
+            this.instance           = instance;
+            this.context            = null;
+            this.numberOfChannels   = 0;
+            this.memoryGeneration   = -1;
+            this.inputLinearMemory  = null;
+            this.outputLinearMemory = null;
+            this.profilingInContext = false;
+
+            // HACK:
+            const wasm = instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+
+            // FFT algorithms are measured once before rendering by this module (complex FFT of frame), not while `process` builds plans
+            wasm.fft_plan_measure(this.lowLatency ? VocalCancelerProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize);
           })
           .catch((error: Error) => {
             throw error;
@@ -89,6 +147,38 @@ export class VocalCancelerProcessor extends OverlapAddProcessor {
 
               break;
             }
+
+            case 'lowLatency': {
+              // Frame size is changed, so context is created again by the next render quantum
+              if ((typeof value === 'boolean') && (value !== this.lowLatency)) {
+                this.lowLatency = value;
+                this.destroyContext();
+              }
+
+              break;
+            }
+
+            case 'profile': {
+              if (typeof value === 'boolean') {
+                this.profiling          = value;
+                this.profilingInContext = false;
+              }
+
+              break;
+            }
+
+            case 'query': {
+              // Reply is posted to transferred port (`queryDSPProfile` or `queryDSPLatency`)
+              if ((value === 'profile') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getProfile());
+              }
+
+              if ((value === 'latency') && (event.ports.length > 0)) {
+                event.ports[0].postMessage(this.getLatency());
+              }
+
+              break;
+            }
           }
         }
       }
@@ -96,11 +186,7 @@ export class VocalCancelerProcessor extends OverlapAddProcessor {
   }
 
   /** @override */
-  protected override processOverlapAdd(inputs: Inputs, outputs: Outputs): boolean {
-    if (this.instance === null) {
-      return false;
-    }
-
+  protected override process(inputs: Inputs, outputs: Outputs): boolean {
     const input  = inputs[0];
     const output = outputs[0];
 
@@ -108,63 +194,199 @@ export class VocalCancelerProcessor extends OverlapAddProcessor {
       return true;
     }
 
-    if ((input.length !== 2) || (output.length !== 2)) {
-      for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
-        output[channelNumber].set(input[channelNumber]);
-      }
+    if (this.instance === null) {
+      // Pass through until combined DSP module is instantiated
+      this.passThrough(input, output);
 
       return true;
     }
 
-    if (!this.isActive || (this.depth === 0)) {
-      for (let channelNumber = 0, numberOfChannels = input.length; channelNumber < numberOfChannels; channelNumber++) {
-        output[channelNumber].set(input[channelNumber]);
+    // HACK:
+    const wasm = this.instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+
+    if (this.context === null) {
+      this.context = wasm.vocalcanceler_create(this.lowLatency ? VocalCancelerProcessor.LOW_LATENCY_FRAME_SIZE : this.frameSize);
+
+      wasm.vocalcanceler_set_low_latency(this.context, this.lowLatency);
+    }
+
+    const context = this.context;
+
+    // Channels except stereo are bypassed by WebAssembly Module
+    const numberOfChannels = input.length;
+
+    if (numberOfChannels !== this.numberOfChannels) {
+      wasm.vocalcanceler_set_number_of_channels(context, numberOfChannels);
+
+      this.numberOfChannels = numberOfChannels;
+
+      // Length of views is changed
+      this.inputLinearMemory  = null;
+      this.outputLinearMemory = null;
+    }
+
+    if (!this.profilingInContext) {
+      const profile = wasm.vocalcanceler_profile(context);
+
+      // Counters are reset whenever instrumentation is started
+      if (this.profiling) {
+        wasm.profile_reset(profile);
       }
 
-      return true;
+      wasm.profile_set_enabled(profile, this.profiling);
+
+      this.profilingInContext = true;
     }
 
-    // HACK:
-    const wasm = this.instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+    const bufferSize = VocalCancelerProcessor.RENDER_QUANTUM_SIZE;
 
-    const linearMemory = wasm.memory.buffer;
+    const linearMemory = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize);
 
-    const offsetInputL = wasm.alloc_memory_inputLs(this.frameSize);
-    const offsetInputR = wasm.alloc_memory_inputRs(this.frameSize);
+    if (linearMemory === null) {
+      // Frame size is rejected by WebAssembly Module (e.g. FFT size has the other prime factor), so views at address `0` must not be created
+      this.passThrough(input, output);
 
-    const inputLinearMemoryL = new Float32Array(linearMemory, offsetInputL, this.frameSize);
-    const inputLinearMemoryR = new Float32Array(linearMemory, offsetInputR, this.frameSize);
+      return true;
+    }
 
-    inputLinearMemoryL.set(input[0]);
-    inputLinearMemoryR.set(input[1]);
+    const [inputLinearMemory] = linearMemory;
 
-    switch (this.algorithm) {
-      case 'time': {
-        const offsetOutputL = wasm.vocalcancelerL(this.depth, this.frameSize);
-        const offsetOutputR = wasm.vocalcancelerR(this.depth, this.frameSize);
+    for (let channelNumber = 0; channelNumber < numberOfChannels; channelNumber++) {
+      if (input[channelNumber].length === 0) {
+        inputLinearMemory.fill(0, (channelNumber * bufferSize), ((channelNumber + 1) * bufferSize));
+      } else {
+        inputLinearMemory.set(input[channelNumber], (channelNumber * bufferSize));
+      }
+    }
 
-        output[0].set(new Float32Array(linearMemory, offsetOutputL, this.frameSize));
-        output[1].set(new Float32Array(linearMemory, offsetOutputR, this.frameSize));
+    // Time is measured by processor (imported clock is only used to measure FFT plans)
+    const begin = this.profiling ? getTimestamp() : 0;
 
+    // If not active, depth `0` (bypass) keeps the same latency as cancellation
+    const depth = this.isActive ? this.depth : 0;
+
+    switch (this.algorithm) {
+      case 'time': {
+        wasm.vocalcanceler_stream_process(context, depth);
         break;
       }
 
       case 'spectrum': {
-        const offsetOutputL = wasm.vocalcanceler_on_spectrum(sampleRate, this.minFrequency, this.maxFrequency, this.threshold, this.frameSize);
-        const offsetOutputR = offsetOutputL + (this.frameSize * Float32Array.BYTES_PER_ELEMENT);
+        wasm.vocalcanceler_stream_process_on_spectrum(context, depth, sampleRate, this.minFrequency, this.maxFrequency, this.threshold);
+        break;
+      }
+    }
 
-        const canceledInputLs = new Float32Array(linearMemory, offsetOutputL, this.frameSize);
-        const canceledInputRs = new Float32Array(linearMemory, offsetOutputR, this.frameSize);
+    if (this.profiling) {
+      wasm.profile_add_time(wasm.vocalcanceler_profile(context), (getTimestamp() - begin));
+    }
 
-        for (let n = 0; n < this.frameSize; n++) {
-          output[0][n] = ((1 - this.depth) * input[0][n]) + (this.depth * canceledInputLs[n]);
-          output[1][n] = ((1 - this.depth) * input[1][n]) + (this.depth * canceledInputRs[n]);
-        }
+    // Linear memory may grow while processing (FFT plans and work buffers are allocated by the first frame)
+    const [, outputLinearMemory] = this.getLinearMemory(wasm, context, numberOfChannels, bufferSize) ?? linearMemory;
 
-        break;
-      }
+    for (let channelNumber = 0; channelNumber < Math.min(numberOfChannels, output.length); channelNumber++) {
+      output[channelNumber].set(outputLinearMemory.subarray((channelNumber * bufferSize), ((channelNumber + 1) * bufferSize)));
     }
 
     return true;
   }
+
+  /**
+   * This method destroys context of WebAssembly Module (if it is created), so that it is created again by the next render quantum.
+   */
+  private destroyContext(): void {
+    if ((this.instance !== null) && (this.context !== null)) {
+      // HACK:
+      const wasm = this.instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+
+      wasm.vocalcanceler_destroy(this.context);
+    }
+
+    this.context            = null;
+    this.numberOfChannels   = 0;
+    this.memoryGeneration   = -1;
+    this.inputLinearMemory  = null;
+    this.outputLinearMemory = null;
+    this.profilingInContext = false;
+  }
+
+  /**
+   * This method copies input to output (until combined DSP module is instantiated, or if frame size is not valid).
+   * @param {Array<Float32Array>} input This argument is channels of input.
+   * @param {Array<Float32Array>} output This argument is channels of output.
+   */
+  private passThrough(input: Float32Array[], output: Float32Array[]): void {
+    for (let channelNumber = 0, numberOfChannels = Math.min(input.length, output.length); channelNumber < numberOfChannels; channelNumber++) {
+      output[channelNumber].set(input[channelNumber]);
+    }
+  }
+
+  /**
+   * This method gets views of render quanta in linear memory.
+   * Buffers are allocated once (fixed offsets), so views are created again only if buffers are reallocated or linear memory grows (generation of memory layout is changed).
+   * @param {VocalCancelerProcessorWebAssemblyInstance} wasm This argument is exports of WebAssembly Module.
+   * @param {number} context This argument is pointer to context.
+   * @param {number} numberOfChannels This argument is the number of channels.
+   * @param {number} bufferSize This argument is buffer size per channel.
+   * @return {Array<Float32Array>|null} Return value is views of inputs and outputs (planar, channel `c` starts at `c * bufferSize`). If render quanta are not allocated, return value is `null`.
+   */
+  private getLinearMemory(wasm: VocalCancelerProcessorWebAssemblyInstance, context: number, numberOfChannels: number, bufferSize: number): [Float32Array, Float32Array] | null {
+    const memoryGeneration = wasm.get_memory_generation();
+
+    if ((memoryGeneration !== this.memoryGeneration) || (this.inputLinearMemory === null) || (this.outputLinearMemory === null)) {
+      const inputs  = wasm.vocalcanceler_stream_inputs(context);
+      const outputs = wasm.vocalcanceler_stream_outputs(context);
+
+      if ((inputs === 0) || (outputs === 0)) {
+        return null;
+      }
+
+      const linearMemory = wasm.memory.buffer;
+
+      this.inputLinearMemory  = new Float32Array(linearMemory, inputs, (numberOfChannels * bufferSize));
+      this.outputLinearMemory = new Float32Array(linearMemory, outputs, (numberOfChannels * bufferSize));
+
+      this.memoryGeneration = memoryGeneration;
+    }
+
+    return [this.inputLinearMemory, this.outputLinearMemory];
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module (reply of query).
+   * @return {DSPProfile|null} Return value is counters since instrumentation is started. If context is not created yet, return value is `null`.
+   */
+  private getProfile(): DSPProfile | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+
+    const profile = wasm.vocalcanceler_profile(this.context);
+
+    return {
+      calls        : wasm.profile_get_number_of_calls(profile),
+      totalTime    : wasm.profile_get_total_time(profile),
+      maxTime      : wasm.profile_get_max_time(profile),
+      allocations  : wasm.profile_get_number_of_allocations(profile),
+      skippedFrames: wasm.profile_get_number_of_skipped_frames(profile)
+    };
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (reply of query).
+   * @return {number|null} Return value is latency (samples). If context is not created yet, return value is `null`.
+   */
+  private getLatency(): number | null {
+    if ((this.instance === null) || (this.context === null)) {
+      return null;
+    }
+
+    // HACK:
+    const wasm = this.instance.exports as VocalCancelerProcessorWebAssemblyInstance;
+
+    return wasm.vocalcanceler_get_latency(this.context);
+  }
 }
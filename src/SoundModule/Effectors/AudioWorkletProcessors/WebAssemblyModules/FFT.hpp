@@ -1,13 +1,29 @@
+#ifndef XSOUND_FFT_HPP
+#define XSOUND_FFT_HPP
+
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#include "arena.hpp"
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 typedef enum {
   RECTANGULAR,
   HANNING,
   HAMMING
 } WINDOW_FUNCTION;
 
-static void window_function(float *const window, const size_t size, const WINDOW_FUNCTION function) {
+static inline void window_function(float *const window, const size_t size, const WINDOW_FUNCTION function) {
   switch (function) {
     case HANNING: {
       for (int n = 0; n < size; n++) {
@@ -43,12 +59,112 @@ static void window_function(float *const window, const size_t size, const WINDOW
   }
 }
 
-static inline int pow2(const int n) {
-  if (n == 0) {
-    return 1;
+// outputs[n] = window[n] * inputs[n] (`outputs` may be the same as `inputs`)
+static inline void multiply_window(float *const outputs, const float *const inputs, const float *const window, const size_t size) {
+  size_t n = 0;
+
+#ifdef __wasm_simd128__
+  for (; (n + 4) <= size; n += 4) {
+    wasm_v128_store(outputs + n, wasm_f32x4_mul(wasm_v128_load(window + n), wasm_v128_load(inputs + n)));
   }
+#endif
 
-  return 2 << (n - 1);
+  for (; n < size; n++) {
+    outputs[n] = window[n] * inputs[n];
+  }
+}
+
+typedef enum {
+  FORWARD,
+  INVERSE
+} FFT_DIRECTION;
+
+// `FFT_AUTO` selects the fastest of the others once per (size, direction).
+// `FFT_RADIX_2` is power of two sizes only, and `FFT_CODELET` is multiple of 8 sizes only (the other sizes fall back to `FFT_MIXED_RADIX`).
+typedef enum {
+  FFT_AUTO,
+  FFT_RADIX_2,
+  FFT_MIXED_RADIX,
+  FFT_CODELET
+} FFT_ALGORITHM;
+
+// Algorithm of plans that are built by later `get_fft_plan` (tests and benchmarks force each algorithm by `set_fft_algorithm`)
+static FFT_ALGORITHM fft_algorithm = FFT_AUTO;
+
+// Radices of mixed-radix FFT (size is 2^a * 3^b * 5^c)
+static const size_t fft_radices[] = { 4, 2, 3, 5 };
+
+// Enough for any `size_t` size (every factor is 2 or more)
+static const int max_number_of_factors = 64;
+
+// Planner (`measure_fft_plans`) transforms about this number of samples per trial, and takes the best of trials (noise of timer and the other processes)
+static const size_t fft_planner_samples = 16384;
+static const int fft_planner_trials     = 5;
+
+// Twiddle factors and bit-reversal permutation are built once per (size, direction, algorithm) and reused by every later transform.
+// `FFT_RADIX_2` plan is transformed in-place and permuted by `indexes`. The other plans are transformed by mixed-radix (Stockham autosort)
+// that holds `factors` (work buffers are per thread). `FFT_CODELET` plan transforms the last `codelet_size` points by one unrolled pass.
+// In every plan, `twiddle_reals[k]` and `twiddle_imags[k]` hold exp(-+j * (2 * pi * k) / size) for 0 <= k < size / 2 (real FFT uses them).
+typedef struct FFTPlan {
+  size_t size;
+  FFT_DIRECTION direction;
+  FFT_ALGORITHM requested_algorithm;
+  FFT_ALGORITHM algorithm;
+  int number_of_stages;
+  float *twiddle_reals;
+  float *twiddle_imags;
+  size_t *indexes;
+  int number_of_factors;
+  size_t factors[max_number_of_factors];
+  size_t codelet_size;
+  bool measured;
+  struct FFTPlan *next;
+} FFTPlan;
+
+// Plans are shared by threads (offline rendering transforms on worker threads), and they are never freed.
+// Readers walk the list without lock (plan is built, then it is published by release store at the head),
+// and writers (plan of new size, or plan selected by `measure_fft_plans`) are serialized by spin lock.
+static FFTPlan *fft_plans = nullptr;
+
+static bool fft_plans_lock = false;
+
+static inline void lock_fft_plans(void) {
+  while (__atomic_test_and_set(&fft_plans_lock, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+static inline void unlock_fft_plans(void) {
+  __atomic_clear(&fft_plans_lock, __ATOMIC_RELEASE);
+}
+
+// Work buffers of mixed-radix stages per thread (offline rendering transforms on worker threads by the shared plans).
+// They grow to the largest size that the thread has transformed, and they are freed when the thread exits.
+typedef struct FFTWorkBuffers {
+  float *reals;
+  float *imags;
+  size_t capacity;
+
+  ~FFTWorkBuffers() {
+    free(reals);
+    free(imags);
+  }
+} FFTWorkBuffers;
+
+static thread_local FFTWorkBuffers fft_work_buffers = { nullptr, nullptr, 0 };
+
+static inline FFTWorkBuffers *reserve_fft_work_buffers(const size_t size) {
+  FFTWorkBuffers *buffers = &fft_work_buffers;
+
+  if (size > buffers->capacity) {
+    free(buffers->reals);
+    free(buffers->imags);
+
+    buffers->reals    = (float *)calloc(size, sizeof(float));
+    buffers->imags    = (float *)calloc(size, sizeof(float));
+    buffers->capacity = size;
+  }
+
+  return buffers;
 }
 
 static inline void swap(float *const reals, float *const imags, const size_t i, const size_t k) {
@@ -65,83 +181,918 @@ static inline void swap(float *const reals, float *const imags, const size_t i,
   imags[k] = tmp_imag;
 }
 
-static void FFT(float *const reals, float *const imags, const size_t size) {
-  int number_of_stages = (int)log2f((float)size);
+static inline bool is_power_of_two(const size_t size) {
+  return (size > 0) && ((size & (size - 1)) == 0);
+}
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      int rest = number_of_stages - stage;
+// FFT size must be 2^a * 3^b * 5^c (any other size is not transformed instead of wrong output)
+static inline bool fft_is_valid_size(const size_t size) {
+  if (size == 0) {
+    return false;
+  }
 
-      for (int j = 0; j < pow2(rest); j++) {
-        int n = i * pow2(rest + 1) + j;
-        int m = pow2(rest) + n;
+  size_t rest = size;
 
-        float w = 2.0f * M_PI * j * pow2(stage - 1);
+  for (const size_t radix : fft_radices) {
+    while ((rest % radix) == 0) {
+      rest /= radix;
+    }
+  }
 
-        float e_real = reals[n];
-        float e_imag = imags[n];
-        float o_real = reals[m];
-        float o_imag = imags[m];
-        float w_real = cosf(w / size);
-        float w_imag = 0.0f - sinf(w / size);
+  return rest == 1;
+}
 
-        if (stage < number_of_stages) {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = (w_real * (e_real - o_real)) - (w_imag * (e_imag - o_imag));
-          imags[m] = (w_real * (e_imag - o_imag)) + (w_imag * (e_real - o_real));
-        } else {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = e_real - o_real;
-          imags[m] = e_imag - o_imag;
-        }
-      }
+// Real FFT packs `size` real samples into `size / 2` complex samples
+static inline bool rfft_is_valid_size(const size_t size) {
+  return ((size % 2) == 0) && fft_is_valid_size(size / 2);
+}
+
+// Unrolled codelet is 16 points (or 8 points), so that its values fit in registers
+static inline size_t fft_codelet_size(const size_t size) {
+  if ((size % 16) == 0) {
+    return 16;
+  }
+
+  if ((size % 8) == 0) {
+    return 8;
+  }
+
+  return 0;
+}
+
+static inline bool fft_is_valid_algorithm(const size_t size, const FFT_ALGORITHM algorithm) {
+  switch (algorithm) {
+    case FFT_RADIX_2: {
+      return is_power_of_two(size);
+    }
+
+    case FFT_CODELET: {
+      return fft_codelet_size(size) > 0;
+    }
+
+    default: {
+      return true;
     }
   }
+}
 
-  size_t *index = (size_t *)calloc(size, sizeof(size_t));
+static FFTPlan *create_mixed_radix_fft_plan(const size_t size, const FFT_DIRECTION direction, const size_t codelet_size) {
+  FFTPlan *plan = (FFTPlan *)calloc(1, sizeof(FFTPlan));
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    int rest = number_of_stages - stage;
+  plan->size         = size;
+  plan->direction    = direction;
+  plan->algorithm    = (codelet_size > 0) ? FFT_CODELET : FFT_MIXED_RADIX;
+  plan->codelet_size = codelet_size;
+
+  // Radix-4 first (fewer stages), then 2, 3 and 5 (codelet is the last stage)
+  size_t rest = (codelet_size > 0) ? (size / codelet_size) : size;
 
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      index[(size_t)(pow2(stage - 1) + i)] = index[i] + (size_t)pow2(rest);
+  for (const size_t radix : fft_radices) {
+    while ((rest % radix) == 0) {
+      plan->factors[plan->number_of_factors++] = radix;
+
+      rest /= radix;
     }
   }
 
+  // Full table (stage of radix `p` with stride `s` uses exp(-+j * (2 * pi * j * t * s) / size), and `j * t * s` < size)
+  plan->twiddle_reals = (float *)calloc(size, sizeof(float));
+  plan->twiddle_imags = (float *)calloc(size, sizeof(float));
+
   for (size_t k = 0; k < size; k++) {
-    if (index[k] <= k) {
+    const double w = (2.0 * M_PI * k) / size;
+
+    plan->twiddle_reals[k] = cos(w);
+    plan->twiddle_imags[k] = (direction == FORWARD) ? (0.0 - sin(w)) : sin(w);
+  }
+
+  // for the thread that builds plan (transforms on this thread do not allocate)
+  reserve_fft_work_buffers(size);
+
+  return plan;
+}
+
+static FFTPlan *create_radix2_fft_plan(const size_t size, const FFT_DIRECTION direction) {
+  FFTPlan *plan = (FFTPlan *)calloc(1, sizeof(FFTPlan));
+
+  plan->size             = size;
+  plan->direction        = direction;
+  plan->algorithm        = FFT_RADIX_2;
+  plan->number_of_stages = (int)log2f((float)size);
+
+  plan->twiddle_reals = (float *)calloc(size, sizeof(float));
+  plan->twiddle_imags = (float *)calloc(size, sizeof(float));
+
+  // Butterfly `j` on stage `s` uses exp(-+j * (2 * pi * j * 2^(s - 1)) / size).
+  // Twiddle factors are laid out contiguously per stage (stage `s` starts at `size - 2 * span`), so that butterflies can load them as vectors.
+  // The first stage holds exp(-+j * (2 * pi * k) / size) for 0 <= k < size / 2.
+  for (int stage = 1; stage <= plan->number_of_stages; stage++) {
+    const size_t span   = size >> stage;
+    const size_t stride = (size_t)1 << (stage - 1);
+
+    float *twiddle_reals = plan->twiddle_reals + (size - (2 * span));
+    float *twiddle_imags = plan->twiddle_imags + (size - (2 * span));
+
+    for (size_t j = 0; j < span; j++) {
+      float w = 2.0f * M_PI * j * stride;
+
+      twiddle_reals[j] = cosf(w / size);
+      twiddle_imags[j] = (direction == FORWARD) ? (0.0f - sinf(w / size)) : sinf(w / size);
+    }
+  }
+
+  plan->indexes = (size_t *)calloc(size, sizeof(size_t));
+
+  for (int stage = 1; stage <= plan->number_of_stages; stage++) {
+    const size_t span   = size >> stage;
+    const size_t stride = (size_t)1 << (stage - 1);
+
+    for (size_t i = 0; i < stride; i++) {
+      plan->indexes[stride + i] = plan->indexes[i] + span;
+    }
+  }
+
+  return plan;
+}
+
+static void destroy_fft_plan(FFTPlan *const plan) {
+  free(plan->twiddle_reals);
+  free(plan->twiddle_imags);
+  free(plan->indexes);
+  free(plan);
+}
+
+static void execute_fft_plan(const FFTPlan *const plan, float *const reals, float *const imags);
+
+// Seconds of monotonic clock.
+// WebAssembly Modules import clock from JavaScript (`emscripten_get_now` is milliseconds), so hosts pass it on instantiation.
+static double fft_planner_now(void) {
+#ifdef __EMSCRIPTEN__
+  return emscripten_get_now() * 1e-3;
+#else
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+#endif
+}
+
+// Best time of trials that transform zeros (arithmetic costs the same as any other normal value)
+static double measure_fft_plan(const FFTPlan *const plan) {
+  const size_t size = plan->size;
+
+  const size_t number_of_transforms = (size < fft_planner_samples) ? (fft_planner_samples / size) : 1;
+
+  float *reals = (float *)calloc(size, sizeof(float));
+  float *imags = (float *)calloc(size, sizeof(float));
+
+  // Warm up caches
+  execute_fft_plan(plan, reals, imags);
+
+  double best = 0.0;
+
+  for (int trial = 0; trial < fft_planner_trials; trial++) {
+    const double start = fft_planner_now();
+
+    for (size_t i = 0; i < number_of_transforms; i++) {
+      execute_fft_plan(plan, reals, imags);
+    }
+
+    const double elapsed = fft_planner_now() - start;
+
+    if ((trial == 0) || (elapsed < best)) {
+      best = elapsed;
+    }
+  }
+
+  free(reals);
+  free(imags);
+
+  return best;
+}
+
+static FFTPlan *create_fft_plan(const size_t size, const FFT_DIRECTION direction, const FFT_ALGORITHM algorithm);
+
+// Candidates in order of fewer memory passes (unrolled codelet, then radix-4 Stockham without bit-reversal pass, then in-place radix-2)
+static const FFT_ALGORITHM fft_candidates[] = { FFT_CODELET, FFT_MIXED_RADIX, FFT_RADIX_2 };
+
+// Plans are built while `*_create` (or the first frame after frame size is changed) on the audio rendering thread,
+// so `FFT_AUTO` selects the first valid candidate without measuring (`measure_fft_plans` selects the fastest in advance).
+static FFTPlan *plan_fft(const size_t size, const FFT_DIRECTION direction) {
+  for (const FFT_ALGORITHM candidate : fft_candidates) {
+    if (fft_is_valid_algorithm(size, candidate)) {
+      return create_fft_plan(size, direction, candidate);
+    }
+  }
+
+  return create_fft_plan(size, direction, FFT_MIXED_RADIX);
+}
+
+// Every valid candidate is measured, and the fastest is returned (if clock is too coarse to tell candidates apart, the earlier candidate is kept)
+static FFTPlan *plan_fastest_fft(const size_t size, const FFT_DIRECTION direction) {
+  FFTPlan *best_plan = nullptr;
+
+  double best_time = 0.0;
+
+  for (const FFT_ALGORITHM candidate : fft_candidates) {
+    if (!fft_is_valid_algorithm(size, candidate)) {
       continue;
     }
 
-    swap(reals, imags, index[k], k);
+    FFTPlan *plan = create_fft_plan(size, direction, candidate);
+
+    const double time = measure_fft_plan(plan);
+
+    if ((best_plan == nullptr) || (time < best_time)) {
+      if (best_plan != nullptr) {
+        destroy_fft_plan(best_plan);
+      }
+
+      best_plan = plan;
+      best_time = time;
+    } else {
+      destroy_fft_plan(plan);
+    }
+  }
+
+  return best_plan;
+}
+
+static FFTPlan *create_fft_plan(const size_t size, const FFT_DIRECTION direction, const FFT_ALGORITHM algorithm) {
+  if (algorithm == FFT_AUTO) {
+    return plan_fft(size, direction);
+  }
+
+  if (!fft_is_valid_algorithm(size, algorithm)) {
+    return create_mixed_radix_fft_plan(size, direction, 0);
+  }
+
+  switch (algorithm) {
+    case FFT_RADIX_2: {
+      return create_radix2_fft_plan(size, direction);
+    }
+
+    case FFT_CODELET: {
+      return create_mixed_radix_fft_plan(size, direction, fft_codelet_size(size));
+    }
+
+    default: {
+      return create_mixed_radix_fft_plan(size, direction, 0);
+    }
+  }
+}
+
+// The latest plan is at the head, so measured plan hides plan that was built before it
+static FFTPlan *lookup_fft_plan(const size_t size, const FFT_DIRECTION direction, const FFT_ALGORITHM algorithm) {
+  for (FFTPlan *plan = __atomic_load_n(&fft_plans, __ATOMIC_ACQUIRE); plan != nullptr; plan = plan->next) {
+    if ((plan->size == size) && (plan->direction == direction) && (plan->requested_algorithm == algorithm)) {
+      return plan;
+    }
+  }
+
+  return nullptr;
+}
+
+// Lock must be held
+static void publish_fft_plan(FFTPlan *const plan, const FFT_ALGORITHM algorithm) {
+  plan->requested_algorithm = algorithm;
+  plan->next                = fft_plans;
+
+  __atomic_store_n(&fft_plans, plan, __ATOMIC_RELEASE);
+}
+
+// Return value is `nullptr` if size is not valid
+static FFTPlan *find_fft_plan(const size_t size, const FFT_DIRECTION direction, const FFT_ALGORITHM algorithm) {
+  if (!fft_is_valid_size(size)) {
+    return nullptr;
+  }
+
+  FFTPlan *plan = lookup_fft_plan(size, direction, algorithm);
+
+  if (plan != nullptr) {
+    return plan;
+  }
+
+  lock_fft_plans();
+
+  // The other thread may have built it while waiting
+  plan = lookup_fft_plan(size, direction, algorithm);
+
+  if (plan == nullptr) {
+    plan = create_fft_plan(size, direction, algorithm);
+
+    publish_fft_plan(plan, algorithm);
+  }
+
+  unlock_fft_plans();
+
+  return plan;
+}
+
+// Measures every valid candidate of complex FFT of `size` (forward and inverse), and publishes the fastest as plan of `FFT_AUTO`.
+// It takes milliseconds, so hosts call it off the audio rendering thread (or before rendering starts), once per size (a later call only returns the result).
+// Plan that was built before is not freed (the other threads may be transforming by it), but later transforms find the measured plan first.
+// Return value is algorithm of forward transform (`FFT_AUTO` if size is not valid).
+static inline FFT_ALGORITHM measure_fft_plans(const size_t size) {
+  if (!fft_is_valid_size(size)) {
+    return FFT_AUTO;
+  }
+
+  static const FFT_DIRECTION directions[] = { FORWARD, INVERSE };
+
+  for (const FFT_DIRECTION direction : directions) {
+    const FFTPlan *plan = lookup_fft_plan(size, direction, FFT_AUTO);
+
+    if ((plan != nullptr) && plan->measured) {
+      continue;
+    }
+
+    FFTPlan *fastest_plan = plan_fastest_fft(size, direction);
+
+    fastest_plan->measured = true;
+
+    lock_fft_plans();
+
+    plan = lookup_fft_plan(size, direction, FFT_AUTO);
+
+    if ((plan != nullptr) && plan->measured) {
+      destroy_fft_plan(fastest_plan);
+    } else {
+      publish_fft_plan(fastest_plan, FFT_AUTO);
+    }
+
+    unlock_fft_plans();
+  }
+
+  return lookup_fft_plan(size, FORWARD, FFT_AUTO)->algorithm;
+}
+
+// Return value is `nullptr` if size is not valid
+static FFTPlan *get_fft_plan(const size_t size, const FFT_DIRECTION direction) {
+  return find_fft_plan(size, direction, fft_algorithm);
+}
+
+// Real FFT of `size` uses twiddle factors of `size` only (the transform itself is `size / 2`), so this plan is not measured.
+// Return value is `nullptr` if size is not valid.
+static FFTPlan *get_rfft_plan(const size_t size) {
+  return find_fft_plan(size, FORWARD, FFT_MIXED_RADIX);
+}
+
+static inline void set_fft_algorithm(const FFT_ALGORITHM algorithm) {
+  fft_algorithm = algorithm;
+}
+
+// Stages of mixed-radix FFT (Stockham autosort, decimation in frequency).
+// Stage of radix `p` on sub-transforms of length `n = p * m` (`s` interleaved sub-transforms) reads x[q + s * (j + r * m)],
+// and writes y[q + s * (p * j + t)] = exp(-+j * (2 * pi * j * t * s) / size) * sum_r x[q + s * (j + r * m)] * exp(-+j * (2 * pi * r * t) / p).
+// `sign` is `-1` for forward and `1` for inverse. The inner loop on `q` is contiguous.
+// The last stage (`m` is `1`) reads and writes the same indexes per `q` (every value is loaded before stores), so it may run in-place.
+
+static inline void twiddle(float *const real, float *const imag, const float w_real, const float w_imag) {
+  const float r = *real;
+  const float i = *imag;
+
+  *real = (r * w_real) - (i * w_imag);
+  *imag = (r * w_imag) + (i * w_real);
+}
+
+static void radix2_stage(const FFTPlan *const plan, const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t m, const size_t s) {
+  for (size_t j = 0; j < m; j++) {
+    const float w_real = plan->twiddle_reals[j * s];
+    const float w_imag = plan->twiddle_imags[j * s];
+
+    const float *x0_reals = x_reals + (s * j);
+    const float *x0_imags = x_imags + (s * j);
+    const float *x1_reals = x0_reals + (s * m);
+    const float *x1_imags = x0_imags + (s * m);
+
+    float *y0_reals = y_reals + (s * 2 * j);
+    float *y0_imags = y_imags + (s * 2 * j);
+    float *y1_reals = y0_reals + s;
+    float *y1_imags = y0_imags + s;
+
+    for (size_t q = 0; q < s; q++) {
+      const float a0_real = x0_reals[q];
+      const float a0_imag = x0_imags[q];
+      const float a1_real = x1_reals[q];
+      const float a1_imag = x1_imags[q];
+
+      float b1_real = a0_real - a1_real;
+      float b1_imag = a0_imag - a1_imag;
+
+      twiddle(&b1_real, &b1_imag, w_real, w_imag);
+
+      y0_reals[q] = a0_real + a1_real;
+      y0_imags[q] = a0_imag + a1_imag;
+      y1_reals[q] = b1_real;
+      y1_imags[q] = b1_imag;
+    }
+  }
+}
+
+static void radix3_stage(const FFTPlan *const plan, const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t m, const size_t s, const float sign) {
+  // sin(2 * pi / 3) (multiplied by `sign`)
+  const float c = sign * 0.86602540378443864676f;
+
+  for (size_t j = 0; j < m; j++) {
+    const float w1_real = plan->twiddle_reals[j * s];
+    const float w1_imag = plan->twiddle_imags[j * s];
+    const float w2_real = plan->twiddle_reals[2 * j * s];
+    const float w2_imag = plan->twiddle_imags[2 * j * s];
+
+    for (size_t q = 0; q < s; q++) {
+      const size_t n0 = q + (s * j);
+      const size_t n1 = n0 + (s * m);
+      const size_t n2 = n1 + (s * m);
+
+      const float a0_real = x_reals[n0];
+      const float a0_imag = x_imags[n0];
+
+      const float sum_real  = x_reals[n1] + x_reals[n2];
+      const float sum_imag  = x_imags[n1] + x_imags[n2];
+      const float diff_real = x_reals[n1] - x_reals[n2];
+      const float diff_imag = x_imags[n1] - x_imags[n2];
+
+      const float m_real = a0_real - (0.5f * sum_real);
+      const float m_imag = a0_imag - (0.5f * sum_imag);
+
+      // j * c * diff
+      const float n_real = 0.0f - (c * diff_imag);
+      const float n_imag = c * diff_real;
+
+      float b1_real = m_real + n_real;
+      float b1_imag = m_imag + n_imag;
+      float b2_real = m_real - n_real;
+      float b2_imag = m_imag - n_imag;
+
+      twiddle(&b1_real, &b1_imag, w1_real, w1_imag);
+      twiddle(&b2_real, &b2_imag, w2_real, w2_imag);
+
+      const size_t k = q + (s * 3 * j);
+
+      y_reals[k]           = a0_real + sum_real;
+      y_imags[k]           = a0_imag + sum_imag;
+      y_reals[k + s]       = b1_real;
+      y_imags[k + s]       = b1_imag;
+      y_reals[k + (2 * s)] = b2_real;
+      y_imags[k + (2 * s)] = b2_imag;
+    }
+  }
+}
+
+// 4-point DFT of (reals[0 .. 3], imags[0 .. 3]) in place
+static inline void dft4(float *const reals, float *const imags, const float sign) {
+  const float t0_real = reals[0] + reals[2];
+  const float t0_imag = imags[0] + imags[2];
+  const float t1_real = reals[0] - reals[2];
+  const float t1_imag = imags[0] - imags[2];
+  const float t2_real = reals[1] + reals[3];
+  const float t2_imag = imags[1] + imags[3];
+
+  // (x1 - x3) * exp(-+j * pi / 2) = (x1 - x3) * (j * sign)
+  const float t3_real = 0.0f - (sign * (imags[1] - imags[3]));
+  const float t3_imag = sign * (reals[1] - reals[3]);
+
+  reals[0] = t0_real + t2_real;
+  imags[0] = t0_imag + t2_imag;
+  reals[1] = t1_real + t3_real;
+  imags[1] = t1_imag + t3_imag;
+  reals[2] = t0_real - t2_real;
+  imags[2] = t0_imag - t2_imag;
+  reals[3] = t1_real - t3_real;
+  imags[3] = t1_imag - t3_imag;
+}
+
+#ifdef __wasm_simd128__
+static inline void twiddle_v128(v128_t *const real, v128_t *const imag, const v128_t w_real, const v128_t w_imag) {
+  const v128_t r = *real;
+  const v128_t i = *imag;
+
+  *real = wasm_f32x4_sub(wasm_f32x4_mul(r, w_real), wasm_f32x4_mul(i, w_imag));
+  *imag = wasm_f32x4_add(wasm_f32x4_mul(r, w_imag), wasm_f32x4_mul(i, w_real));
+}
+
+// 4 lanes of `dft4`
+static inline void dft4_v128(v128_t *const reals, v128_t *const imags, const v128_t sign) {
+  const v128_t t0_real = wasm_f32x4_add(reals[0], reals[2]);
+  const v128_t t0_imag = wasm_f32x4_add(imags[0], imags[2]);
+  const v128_t t1_real = wasm_f32x4_sub(reals[0], reals[2]);
+  const v128_t t1_imag = wasm_f32x4_sub(imags[0], imags[2]);
+  const v128_t t2_real = wasm_f32x4_add(reals[1], reals[3]);
+  const v128_t t2_imag = wasm_f32x4_add(imags[1], imags[3]);
+  const v128_t t3_real = wasm_f32x4_mul(sign, wasm_f32x4_sub(imags[3], imags[1]));
+  const v128_t t3_imag = wasm_f32x4_mul(sign, wasm_f32x4_sub(reals[1], reals[3]));
+
+  reals[0] = wasm_f32x4_add(t0_real, t2_real);
+  imags[0] = wasm_f32x4_add(t0_imag, t2_imag);
+  reals[1] = wasm_f32x4_add(t1_real, t3_real);
+  imags[1] = wasm_f32x4_add(t1_imag, t3_imag);
+  reals[2] = wasm_f32x4_sub(t0_real, t2_real);
+  imags[2] = wasm_f32x4_sub(t0_imag, t2_imag);
+  reals[3] = wasm_f32x4_sub(t1_real, t3_real);
+  imags[3] = wasm_f32x4_sub(t1_imag, t3_imag);
+}
+#endif
+
+static void radix4_stage(const FFTPlan *const plan, const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t m, const size_t s, const float sign) {
+  for (size_t j = 0; j < m; j++) {
+    float w_reals[4];
+    float w_imags[4];
+
+    for (size_t t = 1; t < 4; t++) {
+      w_reals[t] = plan->twiddle_reals[t * j * s];
+      w_imags[t] = plan->twiddle_imags[t * j * s];
+    }
+
+    size_t q = 0;
+
+#ifdef __wasm_simd128__
+    const v128_t v_sign = wasm_f32x4_splat(sign);
+
+    for (; (q + 4) <= s; q += 4) {
+      v128_t a_reals[4];
+      v128_t a_imags[4];
+
+      for (size_t r = 0; r < 4; r++) {
+        a_reals[r] = wasm_v128_load(x_reals + q + (s * (j + (r * m))));
+        a_imags[r] = wasm_v128_load(x_imags + q + (s * (j + (r * m))));
+      }
+
+      dft4_v128(a_reals, a_imags, v_sign);
+
+      for (size_t t = 1; t < 4; t++) {
+        twiddle_v128(&a_reals[t], &a_imags[t], wasm_f32x4_splat(w_reals[t]), wasm_f32x4_splat(w_imags[t]));
+      }
+
+      for (size_t t = 0; t < 4; t++) {
+        wasm_v128_store(y_reals + q + (s * ((4 * j) + t)), a_reals[t]);
+        wasm_v128_store(y_imags + q + (s * ((4 * j) + t)), a_imags[t]);
+      }
+    }
+#endif
+
+    for (; q < s; q++) {
+      float a_reals[4];
+      float a_imags[4];
+
+      for (size_t r = 0; r < 4; r++) {
+        a_reals[r] = x_reals[q + (s * (j + (r * m)))];
+        a_imags[r] = x_imags[q + (s * (j + (r * m)))];
+      }
+
+      dft4(a_reals, a_imags, sign);
+
+      for (size_t t = 1; t < 4; t++) {
+        twiddle(&a_reals[t], &a_imags[t], w_reals[t], w_imags[t]);
+      }
+
+      for (size_t t = 0; t < 4; t++) {
+        y_reals[q + (s * ((4 * j) + t))] = a_reals[t];
+        y_imags[q + (s * ((4 * j) + t))] = a_imags[t];
+      }
+    }
+  }
+}
+
+static void radix5_stage(const FFTPlan *const plan, const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t m, const size_t s, const float sign) {
+  // cos(2 * pi / 5), cos(4 * pi / 5), sin(2 * pi / 5) and sin(4 * pi / 5) (sines are multiplied by `sign`)
+  const float c1 = 0.30901699437494742410f;
+  const float c2 = -0.80901699437494742410f;
+  const float s1 = sign * 0.95105651629515357212f;
+  const float s2 = sign * 0.58778525229247312917f;
+
+  for (size_t j = 0; j < m; j++) {
+    float w_reals[4];
+    float w_imags[4];
+
+    for (size_t t = 1; t < 5; t++) {
+      w_reals[t - 1] = plan->twiddle_reals[t * j * s];
+      w_imags[t - 1] = plan->twiddle_imags[t * j * s];
+    }
+
+    for (size_t q = 0; q < s; q++) {
+      const size_t n0 = q + (s * j);
+      const size_t n1 = n0 + (s * m);
+      const size_t n2 = n1 + (s * m);
+      const size_t n3 = n2 + (s * m);
+      const size_t n4 = n3 + (s * m);
+
+      const float a0_real = x_reals[n0];
+      const float a0_imag = x_imags[n0];
+
+      const float s14_real = x_reals[n1] + x_reals[n4];
+      const float s14_imag = x_imags[n1] + x_imags[n4];
+      const float d14_real = x_reals[n1] - x_reals[n4];
+      const float d14_imag = x_imags[n1] - x_imags[n4];
+      const float s23_real = x_reals[n2] + x_reals[n3];
+      const float s23_imag = x_imags[n2] + x_imags[n3];
+      const float d23_real = x_reals[n2] - x_reals[n3];
+      const float d23_imag = x_imags[n2] - x_imags[n3];
+
+      const float m1_real = a0_real + (c1 * s14_real) + (c2 * s23_real);
+      const float m1_imag = a0_imag + (c1 * s14_imag) + (c2 * s23_imag);
+      const float m2_real = a0_real + (c2 * s14_real) + (c1 * s23_real);
+      const float m2_imag = a0_imag + (c2 * s14_imag) + (c1 * s23_imag);
+
+      // j * (s1 * d14 + s2 * d23) and j * (s2 * d14 - s1 * d23)
+      const float n1_real = 0.0f - ((s1 * d14_imag) + (s2 * d23_imag));
+      const float n1_imag = (s1 * d14_real) + (s2 * d23_real);
+      const float n2_real = 0.0f - ((s2 * d14_imag) - (s1 * d23_imag));
+      const float n2_imag = (s2 * d14_real) - (s1 * d23_real);
+
+      float b_reals[4] = { (m1_real + n1_real), (m2_real + n2_real), (m2_real - n2_real), (m1_real - n1_real) };
+      float b_imags[4] = { (m1_imag + n1_imag), (m2_imag + n2_imag), (m2_imag - n2_imag), (m1_imag - n1_imag) };
+
+      const size_t k = q + (s * 5 * j);
+
+      y_reals[k] = a0_real + s14_real + s23_real;
+      y_imags[k] = a0_imag + s14_imag + s23_imag;
+
+      for (size_t t = 0; t < 4; t++) {
+        twiddle(&b_reals[t], &b_imags[t], w_reals[t], w_imags[t]);
+
+        y_reals[k + ((t + 1) * s)] = b_reals[t];
+        y_imags[k + ((t + 1) * s)] = b_imags[t];
+      }
+    }
   }
+}
+
+// cos(2 * pi * k / 16) and sin(2 * pi * k / 16) (twiddle factors inside codelets are constants)
+static const float codelet_cosines[16] = {
+  1.0f, 0.92387953251128675613f, 0.70710678118654752440f, 0.38268343236508977173f,
+  0.0f, -0.38268343236508977173f, -0.70710678118654752440f, -0.92387953251128675613f,
+  -1.0f, -0.92387953251128675613f, -0.70710678118654752440f, -0.38268343236508977173f,
+  0.0f, 0.38268343236508977173f, 0.70710678118654752440f, 0.92387953251128675613f
+};
+
+static const float codelet_sines[16] = {
+  0.0f, 0.38268343236508977173f, 0.70710678118654752440f, 0.92387953251128675613f,
+  1.0f, 0.92387953251128675613f, 0.70710678118654752440f, 0.38268343236508977173f,
+  0.0f, -0.38268343236508977173f, -0.70710678118654752440f, -0.92387953251128675613f,
+  -1.0f, -0.92387953251128675613f, -0.70710678118654752440f, -0.38268343236508977173f
+};
+
+// Last 2 stages (radix-4 and radix-4) of 16 points as one pass. Both stages are unrolled on values in registers.
+// Stage 1 reads a[j + 4 * r] and writes b[4 * j + t] (twiddle factor is exp(-+j * (2 * pi * j * t) / 16)),
+// stage 2 reads b[u + 4 * r] and writes y[q + s * (u + 4 * t)] (same as 2 `radix4_stage` with `m` = 4 and 1).
+static void codelet16_stage(const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t s, const float sign) {
+  size_t q = 0;
+
+#ifdef __wasm_simd128__
+  const v128_t v_sign = wasm_f32x4_splat(sign);
+
+  for (; (q + 4) <= s; q += 4) {
+    v128_t b_reals[16];
+    v128_t b_imags[16];
+
+    for (size_t j = 0; j < 4; j++) {
+      v128_t a_reals[4];
+      v128_t a_imags[4];
+
+      for (size_t r = 0; r < 4; r++) {
+        a_reals[r] = wasm_v128_load(x_reals + q + (s * (j + (4 * r))));
+        a_imags[r] = wasm_v128_load(x_imags + q + (s * (j + (4 * r))));
+      }
+
+      dft4_v128(a_reals, a_imags, v_sign);
+
+      for (size_t t = 0; t < 4; t++) {
+        if ((j * t) > 0) {
+          twiddle_v128(&a_reals[t], &a_imags[t], wasm_f32x4_splat(codelet_cosines[j * t]), wasm_f32x4_splat(sign * codelet_sines[j * t]));
+        }
+
+        b_reals[(4 * j) + t] = a_reals[t];
+        b_imags[(4 * j) + t] = a_imags[t];
+      }
+    }
+
+    for (size_t u = 0; u < 4; u++) {
+      v128_t a_reals[4] = { b_reals[u], b_reals[u + 4], b_reals[u + 8], b_reals[u + 12] };
+      v128_t a_imags[4] = { b_imags[u], b_imags[u + 4], b_imags[u + 8], b_imags[u + 12] };
+
+      dft4_v128(a_reals, a_imags, v_sign);
+
+      for (size_t t = 0; t < 4; t++) {
+        wasm_v128_store(y_reals + q + (s * (u + (4 * t))), a_reals[t]);
+        wasm_v128_store(y_imags + q + (s * (u + (4 * t))), a_imags[t]);
+      }
+    }
+  }
+#endif
+
+  for (; q < s; q++) {
+    float b_reals[16];
+    float b_imags[16];
 
-  free(index);
+    for (size_t j = 0; j < 4; j++) {
+      float a_reals[4];
+      float a_imags[4];
+
+      for (size_t r = 0; r < 4; r++) {
+        a_reals[r] = x_reals[q + (s * (j + (4 * r)))];
+        a_imags[r] = x_imags[q + (s * (j + (4 * r)))];
+      }
+
+      dft4(a_reals, a_imags, sign);
+
+      for (size_t t = 0; t < 4; t++) {
+        if ((j * t) > 0) {
+          twiddle(&a_reals[t], &a_imags[t], codelet_cosines[j * t], (sign * codelet_sines[j * t]));
+        }
+
+        b_reals[(4 * j) + t] = a_reals[t];
+        b_imags[(4 * j) + t] = a_imags[t];
+      }
+    }
+
+    for (size_t u = 0; u < 4; u++) {
+      float a_reals[4] = { b_reals[u], b_reals[u + 4], b_reals[u + 8], b_reals[u + 12] };
+      float a_imags[4] = { b_imags[u], b_imags[u + 4], b_imags[u + 8], b_imags[u + 12] };
+
+      dft4(a_reals, a_imags, sign);
+
+      for (size_t t = 0; t < 4; t++) {
+        y_reals[q + (s * (u + (4 * t)))] = a_reals[t];
+        y_imags[q + (s * (u + (4 * t)))] = a_imags[t];
+      }
+    }
+  }
 }
 
-static void IFFT(float *const reals, float *const imags, const size_t size) {
-  int number_of_stages = (int)log2f((float)size);
+// Last 2 stages (radix-4 and radix-2) of 8 points as one pass (twiddle factor of stage 1 is exp(-+j * (2 * pi * j * t) / 8))
+static void codelet8_stage(const float *const x_reals, const float *const x_imags, float *const y_reals, float *const y_imags, const size_t s, const float sign) {
+  for (size_t q = 0; q < s; q++) {
+    float b_reals[8];
+    float b_imags[8];
+
+    for (size_t j = 0; j < 2; j++) {
+      float a_reals[4];
+      float a_imags[4];
+
+      for (size_t r = 0; r < 4; r++) {
+        a_reals[r] = x_reals[q + (s * (j + (2 * r)))];
+        a_imags[r] = x_imags[q + (s * (j + (2 * r)))];
+      }
+
+      dft4(a_reals, a_imags, sign);
+
+      for (size_t t = 0; t < 4; t++) {
+        if ((j * t) > 0) {
+          twiddle(&a_reals[t], &a_imags[t], codelet_cosines[2 * j * t], (sign * codelet_sines[2 * j * t]));
+        }
+
+        b_reals[(4 * j) + t] = a_reals[t];
+        b_imags[(4 * j) + t] = a_imags[t];
+      }
+    }
+
+    for (size_t u = 0; u < 4; u++) {
+      y_reals[q + (s * u)]       = b_reals[u] + b_reals[u + 4];
+      y_imags[q + (s * u)]       = b_imags[u] + b_imags[u + 4];
+      y_reals[q + (s * (u + 4))] = b_reals[u] - b_reals[u + 4];
+      y_imags[q + (s * (u + 4))] = b_imags[u] - b_imags[u + 4];
+    }
+  }
+}
+
+static void execute_mixed_radix_fft_plan(const FFTPlan *const plan, float *const reals, float *const imags) {
+  const size_t size = plan->size;
+
+  const float sign = (plan->direction == FORWARD) ? -1.0f : 1.0f;
+
+  const int number_of_passes = plan->number_of_factors + ((plan->codelet_size > 0) ? 1 : 0);
+
+  // Stages ping-pong between the input arrays and the work buffers.
+  // The last stage writes the input arrays (in-place if it reads them), so that no copy pass is required.
+  float *x_reals = reals;
+  float *x_imags = imags;
+  FFTWorkBuffers *buffers = reserve_fft_work_buffers(size);
+
+  float *y_reals = buffers->reals;
+  float *y_imags = buffers->imags;
+
+  size_t n = size;
+  size_t s = 1;
+
+  for (int f = 0; f < plan->number_of_factors; f++) {
+    const size_t radix = plan->factors[f];
+    const size_t m     = n / radix;
+
+    if ((f + 1) == number_of_passes) {
+      y_reals = reals;
+      y_imags = imags;
+    }
+
+    switch (radix) {
+      case 2: {
+        radix2_stage(plan, x_reals, x_imags, y_reals, y_imags, m, s);
+        break;
+      }
+
+      case 3: {
+        radix3_stage(plan, x_reals, x_imags, y_reals, y_imags, m, s, sign);
+        break;
+      }
+
+      case 4: {
+        radix4_stage(plan, x_reals, x_imags, y_reals, y_imags, m, s, sign);
+        break;
+      }
+
+      case 5: {
+        radix5_stage(plan, x_reals, x_imags, y_reals, y_imags, m, s, sign);
+        break;
+      }
+    }
+
+    float *tmp_reals = x_reals;
+    float *tmp_imags = x_imags;
+
+    x_reals = y_reals;
+    x_imags = y_imags;
+    y_reals = tmp_reals;
+    y_imags = tmp_imags;
+
+    n = m;
+    s *= radix;
+  }
+
+  switch (plan->codelet_size) {
+    case 16: {
+      codelet16_stage(x_reals, x_imags, reals, imags, s, sign);
+      break;
+    }
+
+    case 8: {
+      codelet8_stage(x_reals, x_imags, reals, imags, s, sign);
+      break;
+    }
+  }
+}
+
+static void execute_fft_plan(const FFTPlan *const plan, float *const reals, float *const imags) {
+  if (plan->algorithm != FFT_RADIX_2) {
+    execute_mixed_radix_fft_plan(plan, reals, imags);
+    return;
+  }
+
+  const int number_of_stages = plan->number_of_stages;
+
+  const size_t size = plan->size;
 
   for (int stage = 1; stage <= number_of_stages; stage++) {
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      int rest = number_of_stages - stage;
+    const size_t span   = size >> stage;
+    const size_t stride = (size_t)1 << (stage - 1);
+
+    const float *twiddle_reals = plan->twiddle_reals + (size - (2 * span));
+    const float *twiddle_imags = plan->twiddle_imags + (size - (2 * span));
+
+#ifdef __wasm_simd128__
+    if (span >= 4) {
+      for (size_t i = 0; i < stride; i++) {
+        float *e_reals = reals + (i * (2 * span));
+        float *e_imags = imags + (i * (2 * span));
+        float *o_reals = e_reals + span;
+        float *o_imags = e_imags + span;
+
+        for (size_t j = 0; j < span; j += 4) {
+          v128_t e_real = wasm_v128_load(e_reals + j);
+          v128_t e_imag = wasm_v128_load(e_imags + j);
+          v128_t o_real = wasm_v128_load(o_reals + j);
+          v128_t o_imag = wasm_v128_load(o_imags + j);
+          v128_t w_real = wasm_v128_load(twiddle_reals + j);
+          v128_t w_imag = wasm_v128_load(twiddle_imags + j);
+
+          v128_t d_real = wasm_f32x4_sub(e_real, o_real);
+          v128_t d_imag = wasm_f32x4_sub(e_imag, o_imag);
+
+          wasm_v128_store(e_reals + j, wasm_f32x4_add(e_real, o_real));
+          wasm_v128_store(e_imags + j, wasm_f32x4_add(e_imag, o_imag));
+          wasm_v128_store(o_reals + j, wasm_f32x4_sub(wasm_f32x4_mul(w_real, d_real), wasm_f32x4_mul(w_imag, d_imag)));
+          wasm_v128_store(o_imags + j, wasm_f32x4_add(wasm_f32x4_mul(w_real, d_imag), wasm_f32x4_mul(w_imag, d_real)));
+        }
+      }
 
-      for (int j = 0; j < pow2(rest); j++) {
-        int n = i * pow2(rest + 1) + j;
-        int m = pow2(rest) + n;
+      continue;
+    }
+#endif
 
-        float w = 2.0f * M_PI * j * pow2(stage - 1);
+    for (size_t i = 0; i < stride; i++) {
+      for (size_t j = 0; j < span; j++) {
+        size_t n = i * (2 * span) + j;
+        size_t m = span + n;
 
         float e_real = reals[n];
         float e_imag = imags[n];
         float o_real = reals[m];
         float o_imag = imags[m];
-        float w_real = cosf(w / size);
-        float w_imag = sinf(w / size);
 
         if (stage < number_of_stages) {
+          float w_real = twiddle_reals[j];
+          float w_imag = twiddle_imags[j];
+
           reals[n] = e_real + o_real;
           imags[n] = e_imag + o_imag;
           reals[m] = (w_real * (e_real - o_real)) - (w_imag * (e_imag - o_imag));
@@ -156,15 +1107,7 @@ static void IFFT(float *const reals, float *const imags, const size_t size) {
     }
   }
 
-  size_t *index = (size_t *)calloc(size, sizeof(size_t));
-
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    int rest = number_of_stages - stage;
-
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      index[(size_t)(pow2(stage - 1) + i)] = index[i] + (size_t)pow2(rest);
-    }
-  }
+  const size_t *index = plan->indexes;
 
   for (size_t k = 0; k < size; k++) {
     if (index[k] <= k) {
@@ -173,11 +1116,161 @@ static void IFFT(float *const reals, float *const imags, const size_t size) {
 
     swap(reals, imags, index[k], k);
   }
+}
+
+// Return value is `false` (and `reals` and `imags` are not changed) if size is not valid
+static bool FFT(float *const reals, float *const imags, const size_t size) {
+  const FFTPlan *plan = get_fft_plan(size, FORWARD);
+
+  if (plan == nullptr) {
+    return false;
+  }
+
+  execute_fft_plan(plan, reals, imags);
+
+  return true;
+}
+
+// Return value is `false` (and `reals` and `imags` are not changed) if size is not valid
+static bool IFFT(float *const reals, float *const imags, const size_t size) {
+  const FFTPlan *plan = get_fft_plan(size, INVERSE);
+
+  if (plan == nullptr) {
+    return false;
+  }
+
+  execute_fft_plan(plan, reals, imags);
 
   for (size_t k = 0; k < size; k++) {
     reals[k] /= size;
     imags[k] /= size;
   }
 
-  free(index);
+  return true;
+}
+
+// Real-to-complex FFT
+// `reals` holds `size` real samples on input. On output, `reals[0 .. size / 2]` and `imags[0 .. size / 2]` hold the non-redundant bins.
+// The real signal is packed into `size / 2` complex samples (even -> real, odd -> imaginary), so the transform runs on half size.
+// Return value is `false` (and `reals` and `imags` are not changed) if size is not valid.
+static inline bool RFFT(float *const reals, float *const imags, const size_t size) {
+  if (!rfft_is_valid_size(size)) {
+    return false;
+  }
+
+  const size_t half_size = size / 2;
+
+  for (size_t n = 0; n < half_size; n++) {
+    imags[n] = reals[(2 * n) + 1];
+    reals[n] = reals[2 * n];
+  }
+
+  FFT(reals, imags, half_size);
+
+  const FFTPlan *plan = get_rfft_plan(size);
+
+  const float z_real = reals[0];
+  const float z_imag = imags[0];
+
+  reals[0] = z_real + z_imag;
+  imags[0] = 0.0f;
+
+  reals[half_size] = z_real - z_imag;
+  imags[half_size] = 0.0f;
+
+  for (size_t k = 1; k < ((half_size + 1) / 2); k++) {
+    const size_t mirror = half_size - k;
+
+    const float a = reals[k];
+    const float b = imags[k];
+    const float c = reals[mirror];
+    const float d = imags[mirror];
+
+    // Even part and odd part of bin `k`
+    const float e_real = 0.5f * (a + c);
+    const float e_imag = 0.5f * (b - d);
+    const float o_real = 0.5f * (b + d);
+    const float o_imag = 0.5f * (c - a);
+
+    const float w_real = plan->twiddle_reals[k];
+    const float w_imag = plan->twiddle_imags[k];
+
+    const float t_real = (w_real * o_real) - (w_imag * o_imag);
+    const float t_imag = (w_real * o_imag) + (w_imag * o_real);
+
+    reals[k] = e_real + t_real;
+    imags[k] = e_imag + t_imag;
+
+    reals[mirror] = e_real - t_real;
+    imags[mirror] = t_imag - e_imag;
+  }
+
+  if ((half_size > 1) && ((half_size % 2) == 0)) {
+    imags[half_size / 2] = 0.0f - imags[half_size / 2];
+  }
+
+  return true;
+}
+
+// Complex-to-real IFFT (inverse of `RFFT`)
+// `reals[0 .. size / 2]` and `imags[0 .. size / 2]` hold the non-redundant bins on input (imaginary parts of DC and Nyquist are ignored).
+// On output, `reals` holds `size` real samples.
+// Return value is `false` (and `reals` and `imags` are not changed) if size is not valid.
+static inline bool IRFFT(float *const reals, float *const imags, const size_t size) {
+  if (!rfft_is_valid_size(size)) {
+    return false;
+  }
+
+  const size_t half_size = size / 2;
+
+  const FFTPlan *plan = get_rfft_plan(size);
+
+  const float dc      = reals[0];
+  const float nyquist = reals[half_size];
+
+  reals[0] = 0.5f * (dc + nyquist);
+  imags[0] = 0.5f * (dc - nyquist);
+
+  for (size_t k = 1; k < ((half_size + 1) / 2); k++) {
+    const size_t mirror = half_size - k;
+
+    const float a = reals[k];
+    const float b = imags[k];
+    const float c = reals[mirror];
+    const float d = imags[mirror];
+
+    const float e_real = 0.5f * (a + c);
+    const float e_imag = 0.5f * (b - d);
+    const float d_real = 0.5f * (a - c);
+    const float d_imag = 0.5f * (b + d);
+
+    // Multiply by conjugate of twiddle factor
+    const float w_real = plan->twiddle_reals[k];
+    const float w_imag = 0.0f - plan->twiddle_imags[k];
+
+    const float o_real = (w_real * d_real) - (w_imag * d_imag);
+    const float o_imag = (w_real * d_imag) + (w_imag * d_real);
+
+    // Z[k] = E[k] + j * O[k], Z[N / 2 - k] = conj(E[k]) + j * conj(O[k])
+    reals[k] = e_real - o_imag;
+    imags[k] = e_imag + o_real;
+
+    reals[mirror] = e_real + o_imag;
+    imags[mirror] = o_real - e_imag;
+  }
+
+  if ((half_size > 1) && ((half_size % 2) == 0)) {
+    imags[half_size / 2] = 0.0f - imags[half_size / 2];
+  }
+
+  IFFT(reals, imags, half_size);
+
+  for (size_t n = half_size; n-- > 0;) {
+    reals[(2 * n) + 1] = imags[n];
+    reals[2 * n]       = reals[n];
+  }
+
+  return true;
 }
+
+#endif
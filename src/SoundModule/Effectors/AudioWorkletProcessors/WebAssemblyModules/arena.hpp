@@ -0,0 +1,142 @@
+#ifndef XSOUND_ARENA_HPP
+#define XSOUND_ARENA_HPP
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+// Every `calloc` / `malloc` in kernels is counted, so that it is verifiable that the steady-state `process` path does not allocate
+// (benchmarks, and allocations per call of instrumentation by `profile.hpp`).
+// Kernels allocate only when buffers are (re)sized, so counting costs nothing on steady state.
+static size_t number_of_allocations = 0;
+
+// Worker threads of offline rendering allocate too, so counting is atomic
+static inline void *counted_calloc(const size_t count, const size_t size) {
+  __atomic_fetch_add(&number_of_allocations, 1, __ATOMIC_RELAXED);
+
+  return calloc(count, size);
+}
+
+static inline void *counted_malloc(const size_t size) {
+  __atomic_fetch_add(&number_of_allocations, 1, __ATOMIC_RELAXED);
+
+  return malloc(size);
+}
+
+#define calloc(count, size) counted_calloc((count), (size))
+#define malloc(size) counted_malloc((size))
+
+static inline size_t count_allocations(void) {
+  return __atomic_load_n(&number_of_allocations, __ATOMIC_RELAXED);
+}
+
+// Generation of memory layout. It is incremented whenever buffers are (re)allocated (`memory_layout_changed`) or linear memory grows,
+// so that JavaScript creates typed array views of buffers once and creates them again only if `get_memory_generation` is changed.
+// Buffers are reallocated only if their sizes are changed, so generation does not change on steady state.
+static size_t memory_generation = 0;
+
+#ifdef __wasm__
+// Linear memory size (in pages of 64 KiB) when generation was got last
+static size_t memory_pages = 0;
+#endif
+
+// Worker threads of offline rendering allocate too, so increment is atomic
+static inline void memory_layout_changed(void) {
+  __atomic_fetch_add(&memory_generation, 1, __ATOMIC_RELAXED);
+}
+
+// Exported once per module (code that only borrows helpers of this header, such as benchmark, defines `ARENA_WITHOUT_EXPORTS`)
+#ifndef ARENA_WITHOUT_EXPORTS
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t get_number_of_allocations(void) {
+  return count_allocations();
+}
+
+// Views of linear memory are detached when linear memory grows (`memory.buffer` is replaced), so growth changes generation too
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t get_memory_generation(void) {
+#ifdef __wasm__
+  const size_t pages = __builtin_wasm_memory_size(0);
+
+  if (pages != memory_pages) {
+    memory_pages = pages;
+
+    memory_layout_changed();
+  }
+#endif
+
+  return __atomic_load_n(&memory_generation, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+// Alignment for SIMD loads and stores
+static const size_t arena_alignment = 16;
+
+// Scratch memory that is allocated once (per FFT size) and handed out by bumping `offset`
+typedef struct {
+  unsigned char *memory;
+  size_t capacity;
+  size_t offset;
+} Arena;
+
+static inline size_t arena_align(const size_t bytes) {
+  return (bytes + (arena_alignment - 1)) & ~(arena_alignment - 1);
+}
+
+// Bytes that `arena_alloc` consumes for `count` elements of `size` bytes
+static inline size_t arena_size_of(const size_t count, const size_t size) {
+  return arena_align(count * size);
+}
+
+static inline void arena_reserve(Arena *const arena, const size_t capacity) {
+  if (arena->capacity != capacity) {
+    free(arena->memory);
+
+    arena->memory   = (unsigned char *)calloc(capacity + arena_alignment, sizeof(unsigned char));
+    arena->capacity = capacity;
+
+    memory_layout_changed();
+  }
+
+  arena->offset = 0;
+}
+
+static inline void arena_release(Arena *const arena) {
+  free(arena->memory);
+
+  arena->memory   = nullptr;
+  arena->capacity = 0;
+  arena->offset   = 0;
+}
+
+static inline void *arena_alloc(Arena *const arena, const size_t count, const size_t size) {
+  const size_t base  = arena_align((size_t)arena->memory) - (size_t)arena->memory;
+  const size_t bytes = arena_size_of(count, size);
+
+  if ((arena->memory == nullptr) || ((arena->offset + bytes) > arena->capacity)) {
+    return nullptr;
+  }
+
+  void *pointer = arena->memory + base + arena->offset;
+
+  arena->offset += bytes;
+
+  return memset(pointer, 0, bytes);
+}
+
+#endif
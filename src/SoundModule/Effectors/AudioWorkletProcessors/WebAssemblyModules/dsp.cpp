@@ -0,0 +1,89 @@
+// Combined DSP module.
+// Modules of effectors (and noise generator of `NoiseModule`) are compiled into one WebAssembly Module,
+// so that the main thread compiles it once (`WebAssembly.Module`) and posts it to every AudioWorkletProcessor (instantiation only).
+// Shared headers (FFT, STFT, spectral kernels, arenas, offline rendering and instrumentation) are compiled once too, and FFT plans are cached per module (not per effector).
+//
+// Modules are included in namespaces, because their static helpers have the same names (e.g. `prepare`, `process`).
+// Exported functions have C linkage and prefixed names, so namespaces don't change them.
+// Headers that modules include must be included here first (they are skipped in namespaces by include guards).
+#define XSOUND_DSP_MODULE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+#include "arena.hpp"
+#include "FFT.hpp"
+#include "stft.hpp"
+#include "spectral.hpp"
+#include "render.hpp"
+#include "profile.hpp"
+
+namespace noisegate {
+#include "noisegate.cpp"
+}
+
+namespace noisesuppressor {
+#include "noisesuppressor.cpp"
+}
+
+namespace pitchshifter {
+#include "pitchshifter.cpp"
+}
+
+namespace vocalcanceler {
+#include "vocalcanceler.cpp"
+}
+
+namespace spectralchain {
+#include "spectralchain.cpp"
+}
+
+namespace noisegenerator {
+#include "../../../../NoiseModule/WebAssemblyModules/noisegenerator.cpp"
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Plan of complex FFT that effectors have built (`nullptr` if no effector has built it yet).
+// Effectors of every namespace look up the same list, so effectors whose transforms have the same size share the plan.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+const void *dsp_find_fft_plan(const size_t size, const bool inverse) {
+  const FFT_DIRECTION direction = inverse ? INVERSE : FORWARD;
+
+  for (const FFTPlan *plan = fft_plans; plan != nullptr; plan = plan->next) {
+    if ((plan->size == size) && (plan->direction == direction) && (plan->requested_algorithm == fft_algorithm)) {
+      return plan;
+    }
+  }
+
+  return nullptr;
+}
+
+// Measures FFT algorithms of complex FFT of `size` points (`frame_size / 2` for real FFT of effectors, `frame_size` for vocal canceler),
+// so that later transforms of the size run the fastest (effectors select algorithm without measuring on the audio rendering thread).
+// Return value is selected algorithm of forward transform (`FFT_ALGORITHM`).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+FFT_ALGORITHM fft_plan_measure(const size_t size) {
+  return measure_fft_plans(size);
+}
+
+#ifdef __cplusplus
+}
+#endif
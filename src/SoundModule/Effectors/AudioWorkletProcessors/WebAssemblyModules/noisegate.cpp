@@ -1,5 +1,12 @@
 #include <stdlib.h>
 
+#include "arena.hpp"
+#include "profile.hpp"
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
@@ -8,24 +15,55 @@
 
 static const size_t buffer_size = 128;
 
-static float *inputs  = nullptr;
-static float *outputs = nullptr;
+// State of noise gate per instance.
+// `inputs` and `outputs` are planar (channel `c` starts at `c * buffer_size`).
+typedef struct {
+  size_t number_of_channels;
+  Arena arena;
+  Profile profile;
+  float *inputs;
+  float *outputs;
+} NoiseGateContext;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// for `noisegate` and `alloc_memory_inputs` (API without context)
+static NoiseGateContext *default_context = nullptr;
 
-#ifdef __EMSCRIPTEN__
-EMSCRIPTEN_KEEPALIVE
-#endif
-float *noisegate(const float level) {
-  if (outputs) {
-    free(outputs);
+static void prepare(NoiseGateContext *const context, const size_t number_of_channels) {
+  if ((context->arena.memory != nullptr) && (context->number_of_channels == number_of_channels)) {
+    return;
   }
 
-  outputs = (float *)calloc(buffer_size, sizeof(float));
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, (2 * arena_size_of((number_of_channels * buffer_size), sizeof(float))));
+
+  context->inputs  = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+  context->outputs = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+
+  context->number_of_channels = number_of_channels;
+}
+
+// Gate is applied to every sample independently, so planar channels are processed as one buffer
+static float *process(NoiseGateContext *const context, const float level) {
+  const float *inputs = context->inputs;
+  float *outputs      = context->outputs;
+
+  const size_t length = context->number_of_channels * buffer_size;
+
+  int n = 0;
+
+#ifdef __wasm_simd128__
+  const v128_t levels = wasm_f32x4_splat(level);
+
+  for (; (n + 4) <= length; n += 4) {
+    v128_t samples = wasm_v128_load(inputs + n);
+
+    // Lanes whose amplitude is not greater than `level` are masked to `0`
+    wasm_v128_store(outputs + n, wasm_v128_and(samples, wasm_f32x4_gt(wasm_f32x4_abs(samples), levels)));
+  }
+#endif
 
-  for (int n = 0; n < buffer_size; n++) {
+  for (; n < length; n++) {
     // input[n]: If amplitude is greater than `level`.
     //        0: Otherwise, signal is detected as background noise (amplitude is `0`).
     if (absf(inputs[n]) > level) {
@@ -38,18 +76,103 @@ float *noisegate(const float level) {
   return outputs;
 }
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
-float *alloc_memory_inputs(void) {
-  if (inputs) {
-    free(inputs);
+NoiseGateContext *noisegate_create(void) {
+  NoiseGateContext *context = (NoiseGateContext *)calloc(1, sizeof(NoiseGateContext));
+
+  prepare(context, 1);
+
+  return context;
+}
+
+// Inputs and outputs are reallocated (so, pointers by `noisegate_inputs` must be got again)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void noisegate_set_number_of_channels(NoiseGateContext *const context, const size_t number_of_channels) {
+  prepare(context, number_of_channels);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void noisegate_destroy(NoiseGateContext *const context) {
+  if (context == nullptr) {
+    return;
+  }
+
+  arena_release(&context->arena);
+  profile_release(&context->profile);
+
+  free(context);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegate_inputs(NoiseGateContext *const context) {
+  return context->inputs;
+}
+
+// The same pointer that `noisegate_process` returns (fixed until the number of channels is changed, as `noisegate_inputs`)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegate_outputs(NoiseGateContext *const context) {
+  return context->outputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegate_process(NoiseGateContext *const context, const float level) {
+  const ProfileScope scope = profile_begin(&context->profile, 0);
+
+  float *outputs = process(context, level);
+
+  profile_end(&context->profile, scope, 0);
+
+  return outputs;
+}
+
+// Instrumentation of `noisegate_process` (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *noisegate_profile(NoiseGateContext *const context) {
+  return &context->profile;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisegate(const float level) {
+  if (default_context == nullptr) {
+    default_context = noisegate_create();
   }
 
-  inputs = (float *)calloc(buffer_size, sizeof(float));
+  return process(default_context, level);
+}
+
+// Every module has this name, so combined DSP module (`dsp.cpp`) doesn't export it (API with context is used)
+#ifndef XSOUND_DSP_MODULE
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *alloc_memory_inputs(void) {
+  if (default_context == nullptr) {
+    default_context = noisegate_create();
+  }
 
-  return inputs;
+  return default_context->inputs;
 }
+#endif
 
 #ifdef __cplusplus
 }
@@ -1,11 +1,174 @@
 #include "FFT.hpp"
+#include "stft.hpp"
+#include "spectral.hpp"
+#include "render.hpp"
+#include "profile.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-static float *inputs  = nullptr;
-static float *outputs = nullptr;
+// State of noise suppressor per instance.
+// Scratch buffers (and Hanning window) are carved from the arena that is allocated once per FFT size and number of channels, so processing does not allocate on steady state.
+// `inputs` and `outputs` are planar (channel `c` starts at `c * fft_size`). Scratch buffers are shared by channels.
+// `stft` is used by streaming API (`noisesuppressor_stream_*`), and `render` is used by offline rendering (`noisesuppressor_render*`).
+typedef struct {
+  size_t fft_size;
+  size_t number_of_channels;
+  Arena arena;
+  STFT stft;
+  RenderBuffers render;
+  Profile profile;
+  float *inputs;
+  float *window;
+  float *reals;
+  float *imags;
+  float *outputs;
+} NoiseSuppressorContext;
+
+// for `noisesuppressor` and `alloc_memory_inputs` (API without context)
+static NoiseSuppressorContext *default_context = nullptr;
+
+static void prepare(NoiseSuppressorContext *const context, const size_t fft_size, const size_t number_of_channels) {
+  if ((context->fft_size == fft_size) && (context->number_of_channels == number_of_channels)) {
+    return;
+  }
+
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const size_t capacity = (2 * arena_size_of((number_of_channels * fft_size), sizeof(float)))
+                        + (2 * arena_size_of(fft_size, sizeof(float)))
+                        + arena_size_of(buffer_size, sizeof(float));
+
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, capacity);
+
+  context->inputs       = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->window       = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->reals        = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->imags        = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->outputs      = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+
+  stft_prepare(&context->stft, fft_size, number_of_channels);
+
+  window_function(context->window, fft_size, HANNING);
+
+  // Build FFT plans in advance
+  get_rfft_plan(fft_size);
+  get_fft_plan((fft_size / 2), FORWARD);
+  get_fft_plan((fft_size / 2), INVERSE);
+
+  context->fft_size           = fft_size;
+  context->number_of_channels = number_of_channels;
+}
+
+// Spectral subtraction (`spectral_subtract`).
+// Windows are Hanning window of context, except streaming API in low-latency mode (`stft_analysis_window` and `stft_synthesis_window`).
+static void process_channel(NoiseSuppressorContext *const context, const float *const inputs, float *const outputs, const float *const analysis_window, const float *const synthesis_window, const float threshold) {
+  const size_t fft_size = context->fft_size;
+
+  float *reals = context->reals;
+  float *imags = context->imags;
+
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  multiply_window(reals, inputs, analysis_window, fft_size);
+
+  RFFT(reals, imags, fft_size);
+
+  spectral_subtract(reals, imags, buffer_size, threshold);
+
+  IRFFT(reals, imags, fft_size);
+
+  multiply_window(outputs, reals, synthesis_window, fft_size);
+}
+
+static float *process(NoiseSuppressorContext *const context, const float threshold) {
+  const size_t fft_size = context->fft_size;
+
+  for (size_t channel_number = 0; channel_number < context->number_of_channels; channel_number++) {
+    const size_t offset = channel_number * fft_size;
+
+    process_channel(context, (context->inputs + offset), (context->outputs + offset), context->window, context->window, threshold);
+  }
+
+  return context->outputs;
+}
+
+// One render quantum is pushed and pulled per call, and frames are suppressed every hop.
+// If `threshold` is `0`, input frames are overlap-added as they are (bypass).
+static float *process_stream(NoiseSuppressorContext *const context, const float threshold) {
+  STFT *stft = &context->stft;
+
+  // Frame size is not valid for streaming API (`stft_prepare`)
+  if (!stft_is_prepared(stft)) {
+    return nullptr;
+  }
+
+  if (!stft_push(stft)) {
+    return stft_pull(stft);
+  }
+
+  const size_t fft_size = context->fft_size;
+
+  const float *analysis_window  = stft_analysis_window(stft, context->window);
+  const float *synthesis_window = stft_synthesis_window(stft, context->window);
+
+  for (size_t channel_number = 0; channel_number < context->number_of_channels; channel_number++) {
+    const float *frame = stft_frame(stft, channel_number);
+
+    if (stft_is_silent(stft, channel_number)) {
+      ++stft->number_of_skipped_frames;
+      continue;
+    }
+
+    if (threshold == 0.0f) {
+      stft_overlap_add(stft, channel_number, frame);
+      continue;
+    }
+
+    float *outputs = context->outputs + (channel_number * fft_size);
+
+    process_channel(context, frame, outputs, analysis_window, synthesis_window, threshold);
+
+    stft_overlap_add(stft, channel_number, outputs);
+  }
+
+  return stft_pull(stft);
+}
+
+// Offline rendering (shared by jobs, read only)
+typedef struct {
+  const NoiseSuppressorContext *context;
+  const float *inputs;
+  float *outputs;
+  size_t length;
+  float threshold;
+} NoiseSuppressorRenderArgument;
+
+static float *render_process(void *const worker, const void *const parameters) {
+  return process_stream((NoiseSuppressorContext *)worker, *(const float *)parameters);
+}
+
+// Each job streams channels of job through private context (FFT plans have been built by `context`)
+static void render_job(const void *const argument_pointer, RenderJob *const job) {
+  const NoiseSuppressorRenderArgument *argument = (const NoiseSuppressorRenderArgument *)argument_pointer;
+
+  NoiseSuppressorContext *worker = (NoiseSuppressorContext *)calloc(1, sizeof(NoiseSuppressorContext));
+
+  prepare(worker, argument->context->fft_size, job->number_of_channels);
+
+  stft_set_low_latency(&worker->stft, argument->context->stft.low_latency);
+  stft_set_hop_size(&worker->stft, argument->context->stft.hop_size);
+
+  render_stream(job, &worker->stft, worker, render_process, &argument->threshold, argument->inputs, argument->outputs, argument->length);
+
+  arena_release(&worker->arena);
+  stft_release(&worker->stft);
+
+  free(worker);
+}
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,82 +177,171 @@ extern "C" {
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
-float *noisesuppressor(const float threshold, const size_t fft_size) {
-  if (outputs) {
-    free(outputs);
+NoiseSuppressorContext *noisesuppressor_create(const size_t fft_size) {
+  NoiseSuppressorContext *context = (NoiseSuppressorContext *)calloc(1, sizeof(NoiseSuppressorContext));
+
+  prepare(context, fft_size, 1);
+
+  return context;
+}
+
+// Inputs and outputs are reallocated (so, pointers by `noisesuppressor_inputs` and `noisesuppressor_stream_inputs` must be got again)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void noisesuppressor_set_number_of_channels(NoiseSuppressorContext *const context, const size_t number_of_channels) {
+  prepare(context, context->fft_size, number_of_channels);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void noisesuppressor_destroy(NoiseSuppressorContext *const context) {
+  if (context == nullptr) {
+    return;
   }
 
-  outputs = (float *)calloc(fft_size, sizeof(float));
+  arena_release(&context->arena);
+  stft_release(&context->stft);
+  render_release(&context->render);
+  profile_release(&context->profile);
 
-  float *input_reals  = (float *)calloc(fft_size, sizeof(float));
-  float *input_imags  = (float *)calloc(fft_size, sizeof(float));
-  float *output_reals = (float *)calloc(fft_size, sizeof(float));
-  float *output_imags = (float *)calloc(fft_size, sizeof(float));
+  free(context);
+}
 
-  float *amplitudes = (float *)calloc(fft_size, sizeof(float));
-  float *phases     = (float *)calloc(fft_size, sizeof(float));
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_inputs(NoiseSuppressorContext *const context) {
+  return context->inputs;
+}
 
-  float *window = (float *)calloc(fft_size, sizeof(float));
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_process(NoiseSuppressorContext *const context, const float threshold) {
+  return process(context, threshold);
+}
 
-  window_function(window, fft_size, HANNING);
+// Planar render quantum (channel `c` starts at `c * 128`).
+// Streaming API needs FFT size that is multiple of 128, otherwise this and `noisesuppressor_stream_process*` return `nullptr`.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_stream_inputs(NoiseSuppressorContext *const context) {
+  return context->stft.quantum_inputs;
+}
 
-  for (int n = 0; n < fft_size; n++) {
-    input_reals[n] = window[n] * inputs[n];
-    input_imags[n] = 0.0f;
-  }
+// Planar render quantum of outputs (the same pointer that `noisesuppressor_stream_process*` returns).
+// Pointers of render quanta are fixed until the number of channels is changed (`get_memory_generation`).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_stream_outputs(NoiseSuppressorContext *const context) {
+  return context->stft.quantum_outputs;
+}
 
-  FFT(input_reals, input_imags, fft_size);
+// Output is delayed by `noisesuppressor_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_stream_process(NoiseSuppressorContext *const context, const float threshold) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
 
-  for (int k = 0; k < fft_size; k++) {
-    amplitudes[k] = sqrtf((input_reals[k] * input_reals[k]) + (input_imags[k] * input_imags[k]));
+  float *outputs = process_stream(context, threshold);
 
-    if ((input_imags[k] != 0.0f) && (input_reals[k] != 0.0f)) {
-      phases[k] = atan2f(input_imags[k], input_reals[k]);
-    }
-  }
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
 
-  for (int k = 0; k < fft_size; k++) {
-    amplitudes[k] -= threshold;
+  return outputs;
+}
 
-    if (amplitudes[k] < 0.0f) {
-      amplitudes[k] = 0.0f;
-    }
-  }
+// Planar signal of `length` samples per channel for offline rendering (channel `c` starts at `c * length`)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_render_inputs(NoiseSuppressorContext *const context, const size_t length) {
+  return render_reserve(&context->render, (context->number_of_channels * length));
+}
 
-  for (int k = 0; k < fft_size; k++) {
-    output_reals[k] = amplitudes[k] * cosf(phases[k]);
-    output_imags[k] = amplitudes[k] * sinf(phases[k]);
+// Renders the whole signal by `noisesuppressor_render_inputs` on `number_of_threads` threads (`0` is the number of logical cores).
+// Output is planar, and it is bit-identical to streaming API on new context (delayed by `noisesuppressor_get_latency` samples).
+// Skipped frames are counted as streaming API.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor_render(NoiseSuppressorContext *const context, const size_t length, const float threshold, const size_t number_of_threads) {
+  if (!stft_is_prepared(&context->stft) || ((context->number_of_channels * length) > context->render.capacity)) {
+    return nullptr;
   }
 
-  IFFT(output_reals, output_imags, fft_size);
+  const NoiseSuppressorRenderArgument argument = { context, context->render.inputs, context->render.outputs, length, threshold };
+
+  context->stft.number_of_skipped_frames += render(render_job, &argument, context->number_of_channels, 1, length, context->fft_size, number_of_threads, true);
+
+  return context->render.outputs;
+}
+
+// Low-latency mode of streaming API (asymmetric windows for small FFT size such as 256 or 512, `stft.hpp`).
+// Return value is whether mode is set (FFT size must be 256 at least for low-latency mode).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool noisesuppressor_set_low_latency(NoiseSuppressorContext *const context, const bool low_latency) {
+  return stft_set_low_latency(&context->stft, low_latency);
+}
+
+// Algorithmic latency of streaming API (samples). It is `fft_size - 128` by default, and `2 * hop_size - 128` in low-latency mode.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t noisesuppressor_get_latency(NoiseSuppressorContext *const context) {
+  return stft_get_latency(&context->stft);
+}
 
-  for (int n = 0; n < fft_size; n++) {
-    outputs[n] = window[n] * output_reals[n];
+// Number of frames (per channel) whose transforms have been skipped because of silence (streaming API)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t noisesuppressor_get_number_of_skipped_frames(NoiseSuppressorContext *const context) {
+  return context->stft.number_of_skipped_frames;
+}
+
+// Instrumentation of streaming API (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *noisesuppressor_profile(NoiseSuppressorContext *const context) {
+  return &context->profile;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *noisesuppressor(const float threshold, const size_t fft_size) {
+  if (default_context == nullptr) {
+    default_context = noisesuppressor_create(fft_size);
   }
 
-  free(input_reals);
-  free(input_imags);
-  free(output_reals);
-  free(output_imags);
-  free(amplitudes);
-  free(phases);
-  free(window);
+  prepare(default_context, fft_size, 1);
 
-  return outputs;
+  return process(default_context, threshold);
 }
 
+// Every module has this name, so combined DSP module (`dsp.cpp`) doesn't export it (API with context is used)
+#ifndef XSOUND_DSP_MODULE
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_inputs(const size_t buffer_size) {
-  if (inputs) {
-    free(inputs);
+  if (default_context == nullptr) {
+    default_context = noisesuppressor_create(buffer_size);
   }
 
-  inputs = (float *)calloc(buffer_size, sizeof(float));
+  prepare(default_context, buffer_size, 1);
 
-  return inputs;
+  return default_context->inputs;
 }
+#endif
 
 #ifdef __cplusplus
 }
@@ -1,160 +1,675 @@
 #include "FFT.hpp"
+#include "stft.hpp"
+#include "spectral.hpp"
+#include "render.hpp"
+#include "profile.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-static float *inputs  = nullptr;
-static float *outputs = nullptr;
+// Voices of multi-voice peak shifting (harmonizer) share peak detection and forward transform of frame
+static const size_t pitchshifter_max_voices = 8;
+
+typedef struct {
+  float pitch;
+  float wet;
+} PitchShifterVoice;
+
+// State of pitch shifter per instance.
+// Scratch buffers (and Hanning window) are carved from the arena that is allocated once per FFT size and number of channels, so processing does not allocate on steady state.
+// `inputs` and `outputs` are planar (channel `c` starts at `c * fft_size`). Scratch buffers are shared by channels.
+// `stft` is used by streaming API (`pitchshifter_stream_*`), and `time_cursor` advances by hop size per shifted frame (modulo FFT size, because phase rotation is periodic in FFT size).
+// `render` is used by offline rendering (`pitchshifter_render*`).
+// Phase vocoder keeps phase per bin and channel between frames (`analysis_phases` and `synthesis_phases`, channel `c` starts at `c * (fft_size / 2 + 1)`).
+// Shifted spectra of voices are mixed by their wets into `voice_reals` and `voice_imags`, so that one inverse transform synthesizes all voices.
+typedef struct {
+  size_t fft_size;
+  size_t number_of_channels;
+  size_t time_cursor;
+  size_t number_of_voices;
+  PitchShifterVoice voices[pitchshifter_max_voices];
+  Arena arena;
+  STFT stft;
+  RenderBuffers render;
+  Profile profile;
+  float *inputs;
+  float *window;
+  float *reals;
+  float *imags;
+  float *magnitudes;
+  int *peak_indexes;
+  float *shifted_reals;
+  float *shifted_imags;
+  float *frequencies;
+  float *analysis_phases;
+  float *synthesis_phases;
+  float *voice_reals;
+  float *voice_imags;
+  float *outputs;
+} PitchShifterContext;
+
+// for `pitchshifter` and `alloc_memory_inputs` (API without context)
+static PitchShifterContext *default_context = nullptr;
+
+static void prepare(PitchShifterContext *const context, const size_t fft_size, const size_t number_of_channels) {
+  if ((context->fft_size == fft_size) && (context->number_of_channels == number_of_channels)) {
+    return;
+  }
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+  const size_t buffer_size = (fft_size / 2) + 1;
 
-#ifdef __EMSCRIPTEN__
-EMSCRIPTEN_KEEPALIVE
-#endif
-float *pitchshifter(const float pitch, const float speed, const size_t fft_size, const size_t time_cursor) {
-  if (outputs) {
-    free(outputs);
-  }
+  const size_t capacity = (2 * arena_size_of((number_of_channels * fft_size), sizeof(float)))
+                        + (4 * arena_size_of(fft_size, sizeof(float)))
+                        + (5 * arena_size_of(buffer_size, sizeof(float)))
+                        + arena_size_of(buffer_size, sizeof(int))
+                        + (2 * arena_size_of((number_of_channels * buffer_size), sizeof(float)));
+
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, capacity);
+
+  context->inputs        = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->window        = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->reals         = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->imags         = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->magnitudes    = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->peak_indexes  = (int *)arena_alloc(arena, buffer_size, sizeof(int));
+  context->shifted_reals = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->shifted_imags = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->frequencies   = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+
+  context->analysis_phases  = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+  context->synthesis_phases = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+
+  context->voice_reals   = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->voice_imags   = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+
+  context->outputs       = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+
+  stft_prepare(&context->stft, fft_size, number_of_channels);
+
+  window_function(context->window, fft_size, HANNING);
+
+  // Build FFT plans in advance
+  get_rfft_plan(fft_size);
+  get_fft_plan((fft_size / 2), FORWARD);
+  get_fft_plan((fft_size / 2), INVERSE);
+
+  context->fft_size           = fft_size;
+  context->number_of_channels = number_of_channels;
+}
+
+// Peak shifting (`spectral_shift_peaks`).
+// Windows are Hanning window of context, except streaming API in low-latency mode (`stft_analysis_window` and `stft_synthesis_window`).
+static void process_channel(PitchShifterContext *const context, const float *const inputs, float *const outputs, const float *const analysis_window, const float *const synthesis_window, const float pitch, const float speed, const size_t time_cursor) {
+  const size_t fft_size = context->fft_size;
+
+  float *reals         = context->reals;
+  float *imags         = context->imags;
+  float *shifted_reals = context->shifted_reals;
+  float *shifted_imags = context->shifted_imags;
+
+  multiply_window(reals, inputs, analysis_window, fft_size);
+
+  RFFT(reals, imags, fft_size);
+
+  spectral_shift_peaks(reals, imags, context->magnitudes, context->peak_indexes, shifted_reals, shifted_imags, fft_size, pitch, speed, time_cursor);
+
+  IRFFT(shifted_reals, shifted_imags, fft_size);
+
+  multiply_window(outputs, shifted_reals, synthesis_window, fft_size);
+}
+
+// Multi-voice peak shifting. Frame is analyzed and its peaks are detected once, then peaks are shifted per voice (`spectral_shift_regions`).
+// Shifted spectra are mixed by wets of voices before inverse transform (it is linear), so N voices cost one FFT / IFFT pair.
+// Voice of pitch `1` (and speed `1`) is the spectrum of frame as it is.
+static void process_channel_by_voices(PitchShifterContext *const context, const float *const inputs, float *const outputs, const float *const analysis_window, const float *const synthesis_window, const float speed, const size_t time_cursor) {
+  const size_t fft_size = context->fft_size;
+
+  float *reals         = context->reals;
+  float *imags         = context->imags;
+  float *shifted_reals = context->shifted_reals;
+  float *shifted_imags = context->shifted_imags;
+  float *voice_reals   = context->voice_reals;
+  float *voice_imags   = context->voice_imags;
+
+  const size_t buffer_size = (fft_size / 2) + 1;
 
-  outputs = (float*)calloc(fft_size, sizeof(float));
+  multiply_window(reals, inputs, analysis_window, fft_size);
 
-  float *reals = (float*)calloc(fft_size, sizeof(float));
-  float *imags = (float*)calloc(fft_size, sizeof(float));
+  RFFT(reals, imags, fft_size);
 
-  float *window = (float*)calloc(fft_size, sizeof(float));
+  const int number_of_peaks = spectral_find_peaks(reals, imags, context->magnitudes, context->peak_indexes, fft_size);
 
-  window_function(window, fft_size, HANNING);
+  memset(voice_reals, 0, (buffer_size * sizeof(float)));
+  memset(voice_imags, 0, (buffer_size * sizeof(float)));
 
-  for (int n = 0; n < fft_size; n++) {
-    reals[n] = window[n] * inputs[n];
-    imags[n] = 0.0f;
+  for (size_t i = 0; i < context->number_of_voices; i++) {
+    const PitchShifterVoice *voice = context->voices + i;
+
+    const float wet = voice->wet;
+
+    if (wet == 0.0f) {
+      continue;
+    }
+
+    if ((voice->pitch == 1.0f) && (speed == 1.0f)) {
+      for (size_t k = 0; k < buffer_size; k++) {
+        voice_reals[k] += wet * reals[k];
+        voice_imags[k] += wet * imags[k];
+      }
+
+      continue;
+    }
+
+    spectral_shift_regions(reals, imags, context->peak_indexes, number_of_peaks, shifted_reals, shifted_imags, fft_size, voice->pitch, speed, time_cursor);
+
+    for (size_t k = 0; k < buffer_size; k++) {
+      voice_reals[k] += wet * shifted_reals[k];
+      voice_imags[k] += wet * shifted_imags[k];
+    }
   }
 
-  FFT(reals, imags, fft_size);
+  IRFFT(voice_reals, voice_imags, fft_size);
+
+  multiply_window(outputs, voice_reals, synthesis_window, fft_size);
+}
+
+static inline float wrap_phase(const float phase) {
+  return phase - ((2.0f * M_PI) * roundf(phase / (2.0f * M_PI)));
+}
 
-  const size_t half_fft_size = fft_size / 2;
-  const size_t buffer_size   = half_fft_size + 1;
+// Phase vocoder. Bin `k` is moved to bin `round(k * pitch / speed)`, and its frequency is estimated from phase difference between frames.
+// Synthesis phase is accumulated per bin, so that phase is coherent between frames at lower overlap (4x or 8x) too.
+static void process_channel_by_phase_vocoder(PitchShifterContext *const context, const float *const inputs, float *const outputs, float *const analysis_phases, float *const synthesis_phases, const float *const analysis_window, const float *const synthesis_window, const float pitch, const float speed, const size_t hop_size) {
+  const size_t fft_size = context->fft_size;
 
-  float *magnitudes = (float *)calloc(buffer_size, sizeof(float));
-  int *peak_indexes = (int *)calloc(buffer_size, sizeof(int));
+  float *reals       = context->reals;
+  float *imags       = context->imags;
+  float *magnitudes  = context->magnitudes;
+  float *frequencies = context->frequencies;
+
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const float ratio = pitch * (1 / speed);
+
+  // Phase advance of bin `1` per hop
+  const float expected_phase = (2.0f * M_PI * hop_size) / fft_size;
+
+  multiply_window(reals, inputs, analysis_window, fft_size);
+
+  RFFT(reals, imags, fft_size);
+
+  memset(magnitudes, 0, (buffer_size * sizeof(float)));
+  memset(frequencies, 0, (buffer_size * sizeof(float)));
 
   for (int k = 0; k < buffer_size; k++) {
-    magnitudes[k] = (reals[k] * reals[k]) + (imags[k] * imags[k]);
+    const int shifted_k = roundf(k * ratio);
+
+    const float phase = atan2f(imags[k], reals[k]);
+
+    // Deviation from the phase advance of bin center (wrapped into -pi .. pi)
+    const float deviation = wrap_phase(phase - analysis_phases[k] - (k * expected_phase));
+
+    analysis_phases[k] = phase;
+
+    if (shifted_k >= buffer_size) {
+      continue;
+    }
+
+    magnitudes[shifted_k] += sqrtf((reals[k] * reals[k]) + (imags[k] * imags[k]));
+    frequencies[shifted_k] = ((k * expected_phase) + deviation) * ratio;
   }
 
-  int number_of_peaks = 0;
+  for (int k = 0; k < buffer_size; k++) {
+    // Wrapped, so that precision of `float` does not degrade as time goes on
+    synthesis_phases[k] = wrap_phase(synthesis_phases[k] + frequencies[k]);
 
-  // Find peaks
-  int index = 2;
+    reals[k] = magnitudes[k] * cosf(synthesis_phases[k]);
+    imags[k] = magnitudes[k] * sinf(synthesis_phases[k]);
+  }
 
-  const size_t end = half_fft_size + 1 - 2;
+  IRFFT(reals, imags, fft_size);
 
-  while (index < end) {
-    float magnitude = magnitudes[index];
+  multiply_window(outputs, reals, synthesis_window, fft_size);
+}
+
+static float *process(PitchShifterContext *const context, const float pitch, const float speed, const size_t time_cursor) {
+  const size_t fft_size = context->fft_size;
+
+  for (size_t channel_number = 0; channel_number < context->number_of_channels; channel_number++) {
+    const size_t offset = channel_number * fft_size;
+
+    process_channel(context, (context->inputs + offset), (context->outputs + offset), context->window, context->window, pitch, speed, time_cursor);
+  }
+
+  return context->outputs;
+}
+
+// One render quantum is pushed and pulled per call, and frames are shifted every hop (by peak shifting or phase vocoder).
+// Shifted frame is mixed with input frame (`dry * inputs + wet * shifted`) unless `dry` is `0`.
+// If both `pitch` and `speed` are `1`, input frames are overlap-added as they are (bypass).
+static float *process_stream(PitchShifterContext *const context, const bool phase_vocoder, const float pitch, const float speed, const float dry, const float wet) {
+  STFT *stft = &context->stft;
+
+  // Frame size is not valid for streaming API (`stft_prepare`)
+  if (!stft_is_prepared(stft)) {
+    return nullptr;
+  }
+
+  if (!stft_push(stft)) {
+    return stft_pull(stft);
+  }
+
+  const size_t fft_size = context->fft_size;
+
+  const bool bypass = (pitch == 1.0f) && (speed == 1.0f);
+
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const float *analysis_window  = stft_analysis_window(stft, context->window);
+  const float *synthesis_window = stft_synthesis_window(stft, context->window);
 
-    if ((magnitudes[index - 1] >= magnitude) || (magnitudes[index - 2] >= magnitude)) {
-      ++index;
+  for (size_t channel_number = 0; channel_number < context->number_of_channels; channel_number++) {
+    const float *frame = stft_frame(stft, channel_number);
+
+    if (stft_is_silent(stft, channel_number)) {
+      // Phase of silent frame is zero (as if it were analyzed)
+      if (phase_vocoder) {
+        memset((context->analysis_phases + (channel_number * buffer_size)), 0, (buffer_size * sizeof(float)));
+      }
+
+      ++stft->number_of_skipped_frames;
       continue;
     }
 
-    if ((magnitudes[index + 1] >= magnitude) || (magnitudes[index + 2] >= magnitude)) {
-      ++index;
+    if (bypass) {
+      stft_overlap_add(stft, channel_number, frame);
       continue;
     }
 
-    peak_indexes[number_of_peaks++] = index;
+    float *outputs = context->outputs + (channel_number * fft_size);
+
+    if (phase_vocoder) {
+      float *analysis_phases  = context->analysis_phases + (channel_number * buffer_size);
+      float *synthesis_phases = context->synthesis_phases + (channel_number * buffer_size);
 
-    index += 2;
+      process_channel_by_phase_vocoder(context, frame, outputs, analysis_phases, synthesis_phases, analysis_window, synthesis_window, pitch, speed, stft->hop_size);
+    } else {
+      process_channel(context, frame, outputs, analysis_window, synthesis_window, pitch, speed, context->time_cursor);
+    }
+
+    if (dry != 0.0f) {
+      for (size_t n = 0; n < fft_size; n++) {
+        outputs[n] = (dry * frame[n]) + (wet * outputs[n]);
+      }
+    }
+
+    stft_overlap_add(stft, channel_number, outputs);
   }
 
-  // Shift peaks
-  float *shifted_reals = (float*)calloc(fft_size, sizeof(float));
-  float *shifted_imags = (float*)calloc(fft_size, sizeof(float));
+  if (!bypass) {
+    context->time_cursor = (context->time_cursor + stft->hop_size) % context->fft_size;
+  }
 
-  for (int k = 0; k < number_of_peaks; k++) {
-    const int peak_index = peak_indexes[k];
+  return stft_pull(stft);
+}
 
-    const int shifted_peak_index = roundf(peak_index * pitch * (1 / speed));
+// Same as `process_stream`, but frames are shifted by voices (`dry * inputs + sum(wet * shifted)`).
+// Time cursor advances by hop size per frame, as peak shifting of one voice.
+static float *process_stream_by_voices(PitchShifterContext *const context, const float speed, const float dry) {
+  STFT *stft = &context->stft;
 
-    if (shifted_peak_index > buffer_size) {
-      break;
-    }
+  // Frame size is not valid for streaming API (`stft_prepare`)
+  if (!stft_is_prepared(stft)) {
+    return nullptr;
+  }
+
+  if (!stft_push(stft)) {
+    return stft_pull(stft);
+  }
 
-    int start_index = 0;
-    int end_index   = fft_size;
+  const size_t fft_size = context->fft_size;
 
-    if (k > 0) {
-      const int peak_index_before = peak_indexes[k - 1];
+  const float *analysis_window  = stft_analysis_window(stft, context->window);
+  const float *synthesis_window = stft_synthesis_window(stft, context->window);
 
-      start_index = peak_index - floorf((float)(peak_index - peak_index_before) / 2.0f);
+  for (size_t channel_number = 0; channel_number < context->number_of_channels; channel_number++) {
+    const float *frame = stft_frame(stft, channel_number);
+
+    if (stft_is_silent(stft, channel_number)) {
+      ++stft->number_of_skipped_frames;
+      continue;
     }
 
-    if (k < (number_of_peaks - 1)) {
-      const int peak_index_after = peak_indexes[k + 1];
+    float *outputs = context->outputs + (channel_number * fft_size);
 
-      end_index = peak_index + ceilf((float)(peak_index_after - peak_index) / 2.0f);
+    process_channel_by_voices(context, frame, outputs, analysis_window, synthesis_window, speed, context->time_cursor);
+
+    if (dry != 0.0f) {
+      for (size_t n = 0; n < fft_size; n++) {
+        outputs[n] += dry * frame[n];
+      }
     }
 
-    const int start_offset = start_index - peak_index;
-    const int end_offset   = end_index - peak_index;
+    stft_overlap_add(stft, channel_number, outputs);
+  }
 
-    for (int m = start_offset; m < end_offset; m++) {
-      const int bin_count_index = peak_index + m;
+  context->time_cursor = (context->time_cursor + stft->hop_size) % context->fft_size;
 
-      const int shifted_bin_count_index = shifted_peak_index + m;
+  return stft_pull(stft);
+}
 
-      if (shifted_bin_count_index >= buffer_size) {
-        break;
-      }
+// Offline rendering (shared by jobs, read only)
+typedef struct {
+  bool phase_vocoder;
+  float pitch;
+  float speed;
+  float dry;
+  float wet;
+} PitchShifterRenderParameters;
+
+typedef struct {
+  const PitchShifterContext *context;
+  const float *inputs;
+  float *outputs;
+  size_t length;
+  PitchShifterRenderParameters parameters;
+} PitchShifterRenderArgument;
+
+static float *render_process(void *const worker, const void *const parameters_pointer) {
+  const PitchShifterRenderParameters *parameters = (const PitchShifterRenderParameters *)parameters_pointer;
+
+  return process_stream((PitchShifterContext *)worker, parameters->phase_vocoder, parameters->pitch, parameters->speed, parameters->dry, parameters->wet);
+}
 
-      const float omega = (2.0f * M_PI * (shifted_bin_count_index - bin_count_index)) / fft_size;
+// Each job streams channels of job through private context (FFT plans have been built by `context`).
+// Time cursor of peak shifting advances by hop size per frame on the whole stream, so it starts at the first sample of job's stream
+// (hops divide frame size, and job's stream starts on multiple of frame size).
+static void render_job(const void *const argument_pointer, RenderJob *const job) {
+  const PitchShifterRenderArgument *argument = (const PitchShifterRenderArgument *)argument_pointer;
 
-      const float shifted_real = cosf(omega * time_cursor);
-      const float shifted_imag = sinf(omega * time_cursor);
+  const PitchShifterRenderParameters *parameters = &argument->parameters;
 
-      shifted_reals[shifted_bin_count_index] += (reals[bin_count_index] * shifted_real) - (imags[bin_count_index] * shifted_imag);
-      shifted_imags[shifted_bin_count_index] += (reals[bin_count_index] * shifted_imag) + (imags[bin_count_index] * shifted_real);
-    }
+  PitchShifterContext *worker = (PitchShifterContext *)calloc(1, sizeof(PitchShifterContext));
+
+  prepare(worker, argument->context->fft_size, job->number_of_channels);
+
+  stft_set_low_latency(&worker->stft, argument->context->stft.low_latency);
+  stft_set_hop_size(&worker->stft, argument->context->stft.hop_size);
+
+  const bool bypass = (parameters->pitch == 1.0f) && (parameters->speed == 1.0f);
+
+  worker->time_cursor = bypass ? 0 : (render_warm_up_begin(job->begin, worker->fft_size) * render_quantum_size);
+
+  render_stream(job, &worker->stft, worker, render_process, parameters, argument->inputs, argument->outputs, argument->length);
+
+  arena_release(&worker->arena);
+  stft_release(&worker->stft);
+
+  free(worker);
+}
+
+// Phase vocoder carries phases over every frame, so its jobs are split by channels only
+static float *render_channels(PitchShifterContext *const context, const size_t length, const PitchShifterRenderParameters *const parameters, const size_t number_of_threads) {
+  if (!stft_is_prepared(&context->stft) || ((context->number_of_channels * length) > context->render.capacity)) {
+    return nullptr;
   }
 
-  free(reals);
-  free(imags);
-  free(magnitudes);
-  free(peak_indexes);
+  const PitchShifterRenderArgument argument = { context, context->render.inputs, context->render.outputs, length, *parameters };
+
+  context->stft.number_of_skipped_frames += render(render_job, &argument, context->number_of_channels, 1, length, context->fft_size, number_of_threads, !parameters->phase_vocoder);
+
+  return context->render.outputs;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+PitchShifterContext *pitchshifter_create(const size_t fft_size) {
+  PitchShifterContext *context = (PitchShifterContext *)calloc(1, sizeof(PitchShifterContext));
+
+  prepare(context, fft_size, 1);
 
-  for (int k = 1; k < half_fft_size; k++) {
-    shifted_reals[fft_size - k] = 0.0f + shifted_reals[k];
-    shifted_imags[fft_size - k] = 0.0f - shifted_imags[k];
+  return context;
+}
+
+// Inputs and outputs are reallocated (so, pointers by `pitchshifter_inputs` and `pitchshifter_stream_inputs` must be got again)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void pitchshifter_set_number_of_channels(PitchShifterContext *const context, const size_t number_of_channels) {
+  prepare(context, context->fft_size, number_of_channels);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void pitchshifter_destroy(PitchShifterContext *const context) {
+  if (context == nullptr) {
+    return;
   }
 
-  IFFT(shifted_reals, shifted_imags, fft_size);
+  arena_release(&context->arena);
+  stft_release(&context->stft);
+  render_release(&context->render);
+  profile_release(&context->profile);
+
+  free(context);
+}
 
-  for (int n = 0; n < fft_size; n++) {
-    outputs[n] = window[n] * shifted_reals[n];
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_inputs(PitchShifterContext *const context) {
+  return context->inputs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_process(PitchShifterContext *const context, const float pitch, const float speed, const size_t time_cursor) {
+  return process(context, pitch, speed, time_cursor);
+}
+
+// Planar render quantum (channel `c` starts at `c * 128`).
+// Streaming API needs FFT size that is multiple of 128, otherwise this and `pitchshifter_stream_process*` return `nullptr`.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_stream_inputs(PitchShifterContext *const context) {
+  return context->stft.quantum_inputs;
+}
+
+// Planar render quantum of outputs (the same pointer that `pitchshifter_stream_process*` returns).
+// Pointers of render quanta are fixed until the number of channels is changed (`get_memory_generation`).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_stream_outputs(PitchShifterContext *const context) {
+  return context->stft.quantum_outputs;
+}
+
+// Output is delayed by `pitchshifter_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_stream_process(PitchShifterContext *const context, const float pitch, const float speed, const float dry, const float wet) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
+
+  float *outputs = process_stream(context, false, pitch, speed, dry, wet);
+
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
+
+  return outputs;
+}
+
+// Output is delayed by `pitchshifter_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_stream_process_by_phase_vocoder(PitchShifterContext *const context, const float pitch, const float speed, const float dry, const float wet) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
+
+  float *outputs = process_stream(context, true, pitch, speed, dry, wet);
+
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
+
+  return outputs;
+}
+
+// Voice `index` of multi-voice streaming API (`pitchshifter_stream_process_by_voices`).
+// Voice is appended if `index` is the number of voices. Return value is whether voice is set (up to 8 voices).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool pitchshifter_set_voice(PitchShifterContext *const context, const size_t index, const float pitch, const float wet) {
+  if ((index > context->number_of_voices) || (index >= pitchshifter_max_voices)) {
+    return false;
+  }
+
+  context->voices[index].pitch = pitch;
+  context->voices[index].wet   = wet;
+
+  if (index == context->number_of_voices) {
+    ++context->number_of_voices;
+  }
+
+  return true;
+}
+
+// Voices are removed from the end (the number of voices is not increased). Return value is the number of voices after this call.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t pitchshifter_set_number_of_voices(PitchShifterContext *const context, const size_t number_of_voices) {
+  if (number_of_voices < context->number_of_voices) {
+    context->number_of_voices = number_of_voices;
   }
 
-  free(shifted_reals);
-  free(shifted_imags);
-  free(window);
+  return context->number_of_voices;
+}
+
+// Output is delayed by `pitchshifter_get_latency` samples (planar render quantum).
+// Voices share analysis of frame (forward transform and peak detection) and synthesis (inverse transform).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_stream_process_by_voices(PitchShifterContext *const context, const float speed, const float dry) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
+
+  float *outputs = process_stream_by_voices(context, speed, dry);
+
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
 
   return outputs;
 }
 
+// Planar signal of `length` samples per channel for offline rendering (channel `c` starts at `c * length`)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_render_inputs(PitchShifterContext *const context, const size_t length) {
+  return render_reserve(&context->render, (context->number_of_channels * length));
+}
+
+// Renders the whole signal by `pitchshifter_render_inputs` on `number_of_threads` threads (`0` is the number of logical cores).
+// Output is planar, and it is bit-identical to streaming API on new context (delayed by `pitchshifter_get_latency` samples).
+// Skipped frames are counted as streaming API.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_render(PitchShifterContext *const context, const size_t length, const float pitch, const float speed, const float dry, const float wet, const size_t number_of_threads) {
+  const PitchShifterRenderParameters parameters = { false, pitch, speed, dry, wet };
+
+  return render_channels(context, length, &parameters, number_of_threads);
+}
+
+// Same as `pitchshifter_render`, but channels are not split into shorter jobs (at most one thread per channel)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter_render_by_phase_vocoder(PitchShifterContext *const context, const size_t length, const float pitch, const float speed, const float dry, const float wet, const size_t number_of_threads) {
+  const PitchShifterRenderParameters parameters = { true, pitch, speed, dry, wet };
+
+  return render_channels(context, length, &parameters, number_of_threads);
+}
+
+// Hop size of streaming API (power of two, from 128 to `fft_size / 4`, or `fft_size / 2` in low-latency mode). Invalid hop size is ignored.
+// Return value is hop size after this call.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t pitchshifter_set_hop_size(PitchShifterContext *const context, const size_t hop_size) {
+  return stft_set_hop_size(&context->stft, hop_size);
+}
+
+// Low-latency mode of streaming API (asymmetric windows for small FFT size such as 256 or 512, `stft.hpp`).
+// Return value is whether mode is set (FFT size must be 256 at least for low-latency mode).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool pitchshifter_set_low_latency(PitchShifterContext *const context, const bool low_latency) {
+  return stft_set_low_latency(&context->stft, low_latency);
+}
+
+// Algorithmic latency of streaming API (samples). It is `fft_size - 128` by default, and `2 * hop_size - 128` in low-latency mode.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t pitchshifter_get_latency(PitchShifterContext *const context) {
+  return stft_get_latency(&context->stft);
+}
+
+// Number of frames (per channel) whose transforms have been skipped because of silence (streaming API)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t pitchshifter_get_number_of_skipped_frames(PitchShifterContext *const context) {
+  return context->stft.number_of_skipped_frames;
+}
+
+// Instrumentation of streaming API (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *pitchshifter_profile(PitchShifterContext *const context) {
+  return &context->profile;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *pitchshifter(const float pitch, const float speed, const size_t fft_size, const size_t time_cursor) {
+  if (default_context == nullptr) {
+    default_context = pitchshifter_create(fft_size);
+  }
+
+  prepare(default_context, fft_size, 1);
+
+  return process(default_context, pitch, speed, time_cursor);
+}
+
+// Every module has this name, so combined DSP module (`dsp.cpp`) doesn't export it (API with context is used)
+#ifndef XSOUND_DSP_MODULE
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_inputs(const size_t buffer_size) {
-  if (inputs) {
-    free(inputs);
+  if (default_context == nullptr) {
+    default_context = pitchshifter_create(buffer_size);
   }
 
-  inputs = (float *)calloc(buffer_size, sizeof(float));
+  prepare(default_context, buffer_size, 1);
 
-  return inputs;
+  return default_context->inputs;
 }
+#endif
 
 #ifdef __cplusplus
 }
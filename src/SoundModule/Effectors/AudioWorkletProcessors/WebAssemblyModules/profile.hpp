@@ -0,0 +1,288 @@
+#ifndef XSOUND_PROFILE_HPP
+#define XSOUND_PROFILE_HPP
+
+#include <stdlib.h>
+
+#include "arena.hpp"
+
+#ifndef __EMSCRIPTEN__
+#include <stdio.h>
+#include <chrono>
+#endif
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+// Opt-in instrumentation of kernels (per context, `<module>_profile` returns it).
+// Profiling is disabled by default, so instrumented calls only test `enabled` (no clock and no counters).
+// If it is enabled (`profile_set_enabled`), kernels count calls, allocations while calls (`calloc` / `malloc`) and frames skipped because of silence.
+//
+// WebAssembly Modules import clock only to measure FFT plans, so the host measures time of each call and adds it (`profile_add_time`).
+// Native builds measure time by steady clock, and keep the latest calls as events for trace (`profile_write_trace`).
+#ifndef __EMSCRIPTEN__
+// The number of the latest calls that are kept per profile (ring buffer)
+static const size_t profile_event_capacity = 65536;
+
+typedef struct {
+  double begin;
+  double duration;
+  size_t number_of_allocations;
+  size_t number_of_skipped_frames;
+} ProfileEvent;
+#endif
+
+// Time is milliseconds
+typedef struct {
+  bool enabled;
+  size_t number_of_calls;
+  double total_time;
+  double max_time;
+  size_t number_of_allocations;
+  size_t number_of_skipped_frames;
+#ifndef __EMSCRIPTEN__
+  ProfileEvent *events;
+  size_t number_of_events;
+#endif
+} Profile;
+
+// Counters when call begins
+typedef struct {
+  double begin;
+  size_t number_of_allocations;
+  size_t number_of_skipped_frames;
+} ProfileScope;
+
+#ifndef __EMSCRIPTEN__
+static inline double profile_now(void) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static inline void profile_add_time_of_call(Profile *const profile, const double time) {
+  profile->total_time += time;
+
+  if (time > profile->max_time) {
+    profile->max_time = time;
+  }
+}
+
+// `number_of_skipped_frames` is the counter of context (so, frames that are skipped while call are counted)
+static inline ProfileScope profile_begin(const Profile *const profile, const size_t number_of_skipped_frames) {
+  ProfileScope scope = { 0.0, 0, 0 };
+
+  if (!profile->enabled) {
+    return scope;
+  }
+
+  scope.number_of_allocations    = count_allocations();
+  scope.number_of_skipped_frames = number_of_skipped_frames;
+
+#ifndef __EMSCRIPTEN__
+  scope.begin = profile_now();
+#endif
+
+  return scope;
+}
+
+static inline void profile_end(Profile *const profile, const ProfileScope scope, const size_t number_of_skipped_frames) {
+  if (!profile->enabled) {
+    return;
+  }
+
+  const size_t allocations    = count_allocations() - scope.number_of_allocations;
+  const size_t skipped_frames = number_of_skipped_frames - scope.number_of_skipped_frames;
+
+  ++profile->number_of_calls;
+
+  profile->number_of_allocations    += allocations;
+  profile->number_of_skipped_frames += skipped_frames;
+
+#ifndef __EMSCRIPTEN__
+  const double duration = profile_now() - scope.begin;
+
+  profile_add_time_of_call(profile, duration);
+
+  if (profile->events != nullptr) {
+    ProfileEvent *event = profile->events + (profile->number_of_events % profile_event_capacity);
+
+    event->begin                    = scope.begin;
+    event->duration                 = duration;
+    event->number_of_allocations    = allocations;
+    event->number_of_skipped_frames = skipped_frames;
+
+    ++profile->number_of_events;
+  }
+#endif
+}
+
+static inline void profile_release(Profile *const profile) {
+#ifndef __EMSCRIPTEN__
+  free(profile->events);
+
+  profile->events           = nullptr;
+  profile->number_of_events = 0;
+#endif
+
+  profile->enabled = false;
+}
+
+// Exported once per module (as `arena.hpp`)
+#ifndef ARENA_WITHOUT_EXPORTS
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Events of native builds are allocated when profiling is enabled (not while calls)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void profile_set_enabled(Profile *const profile, const bool enabled) {
+#ifndef __EMSCRIPTEN__
+  if (enabled && (profile->events == nullptr)) {
+    profile->events = (ProfileEvent *)calloc(profile_event_capacity, sizeof(ProfileEvent));
+  }
+#endif
+
+  profile->enabled = enabled;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void profile_reset(Profile *const profile) {
+  profile->number_of_calls          = 0;
+  profile->total_time               = 0.0;
+  profile->max_time                 = 0.0;
+  profile->number_of_allocations    = 0;
+  profile->number_of_skipped_frames = 0;
+
+#ifndef __EMSCRIPTEN__
+  profile->number_of_events = 0;
+#endif
+}
+
+// Time of one call that is measured by the host (milliseconds)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void profile_add_time(Profile *const profile, const double time) {
+  if (profile->enabled) {
+    profile_add_time_of_call(profile, time);
+  }
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t profile_get_number_of_calls(const Profile *const profile) {
+  return profile->number_of_calls;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+double profile_get_total_time(const Profile *const profile) {
+  return profile->total_time;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+double profile_get_max_time(const Profile *const profile) {
+  return profile->max_time;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t profile_get_number_of_allocations(const Profile *const profile) {
+  return profile->number_of_allocations;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t profile_get_number_of_skipped_frames(const Profile *const profile) {
+  return profile->number_of_skipped_frames;
+}
+
+#ifndef __EMSCRIPTEN__
+// Writes events of profiles as Chrome trace event format (JSON Object Format, for `chrome://tracing` and Perfetto).
+// Each profile is one track (`tid`) that is named by `names` (names are written as they are, so they must not need escape).
+// Calls are complete events ("X"), and counters of the whole profile are one counter event ("C") at the end of the track.
+bool profile_write_trace(const char *const path, const char *const *const names, const Profile *const *const profiles, const size_t number_of_profiles) {
+  FILE *file = fopen(path, "w");
+
+  if (file == nullptr) {
+    return false;
+  }
+
+  // Timestamps are microseconds from the first kept event
+  double origin = -1.0;
+
+  for (size_t n = 0; n < number_of_profiles; n++) {
+    const Profile *profile = profiles[n];
+
+    if ((profile->events == nullptr) || (profile->number_of_events == 0)) {
+      continue;
+    }
+
+    const size_t first = (profile->number_of_events > profile_event_capacity) ? (profile->number_of_events - profile_event_capacity) : 0;
+    const double begin = profile->events[first % profile_event_capacity].begin;
+
+    if ((origin < 0.0) || (begin < origin)) {
+      origin = begin;
+    }
+  }
+
+  if (origin < 0.0) {
+    origin = 0.0;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"xsound\"}}");
+
+  for (size_t n = 0; n < number_of_profiles; n++) {
+    const Profile *profile = profiles[n];
+
+    const size_t tid = n + 1;
+
+    fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", tid, names[n]);
+
+    double end = 0.0;
+
+    if (profile->events != nullptr) {
+      const size_t first = (profile->number_of_events > profile_event_capacity) ? (profile->number_of_events - profile_event_capacity) : 0;
+
+      for (size_t index = first; index < profile->number_of_events; index++) {
+        const ProfileEvent *event = profile->events + (index % profile_event_capacity);
+
+        const double ts  = 1000.0 * (event->begin - origin);
+        const double dur = 1000.0 * event->duration;
+
+        fprintf(file,
+                ",\n{\"name\":\"%s\",\"cat\":\"dsp\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"allocations\":%zu,\"skipped_frames\":%zu}}",
+                names[n], tid, ts, dur, event->number_of_allocations, event->number_of_skipped_frames);
+
+        end = ts + dur;
+      }
+    }
+
+    fprintf(file,
+            ",\n{\"name\":\"%s\",\"cat\":\"dsp\",\"ph\":\"C\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{\"calls\":%zu,\"total_ms\":%.6f,\"max_ms\":%.6f,\"allocations\":%zu,\"skipped_frames\":%zu}}",
+            names[n], tid, end, profile->number_of_calls, profile->total_time, profile->max_time, profile->number_of_allocations, profile->number_of_skipped_frames);
+  }
+
+  fprintf(file, "\n]}\n");
+
+  return fclose(file) == 0;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#endif
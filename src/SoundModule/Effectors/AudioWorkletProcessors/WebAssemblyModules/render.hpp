@@ -0,0 +1,291 @@
+#ifndef XSOUND_RENDER_HPP
+#define XSOUND_RENDER_HPP
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stft.hpp"
+
+// Worker threads are `std::thread` natively, and pthreads on WebAssembly that is built with `-pthread` (SharedArrayBuffer).
+// WebAssembly without threads renders jobs in order on the calling thread (the output is the same).
+#ifdef __EMSCRIPTEN__
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+#include <emscripten/threading.h>
+#endif
+#else
+#include <system_error>
+#include <thread>
+#include <vector>
+#endif
+
+// Offline rendering of streaming kernels.
+// Signal is planar (channel `c` starts at `c * length`), and it is rendered as if it were pushed by render quanta into a new streaming context
+// (output is delayed by `frame_size - 128` samples as streaming API, and the last render quantum is zero-padded).
+//
+// Work is split into jobs of channels and render quanta (`begin` .. `end`) that worker threads take in order.
+// Channels are independent. A job of render quanta starts streaming earlier from a frame boundary (`render_warm_up_begin`),
+// so that its ring buffers, accumulators and silence lengths hold the same samples as the whole stream, and its outputs are bit-identical.
+// Kernels whose state is carried over every frame (phase vocoder) are split by channels only.
+typedef struct {
+  size_t channel_number;
+  size_t number_of_channels;
+  size_t begin;
+  size_t end;
+  size_t number_of_skipped_frames;
+} RenderJob;
+
+// Planar signal of offline rendering (reallocated only if longer than before)
+typedef struct {
+  size_t capacity;
+  float *inputs;
+  float *outputs;
+} RenderBuffers;
+
+// `process(worker, parameters)` pushes `quantum_inputs` of worker's STFT and returns one planar render quantum (streaming API)
+typedef float *(*RenderProcess)(void *const worker, const void *const parameters);
+
+// `render_job(argument, job)` renders one job on a worker thread (`argument` is shared by jobs and read only)
+typedef void (*RenderKernel)(const void *const argument, RenderJob *const job);
+
+// Job of render quanta is 8 frames at least, so that warm-up (up to 3 frames) does not dominate
+static const size_t render_min_frames_per_job = 8;
+
+static inline float *render_reserve(RenderBuffers *const buffers, const size_t size) {
+  if (size > buffers->capacity) {
+    free(buffers->inputs);
+    free(buffers->outputs);
+
+    buffers->inputs   = (float *)calloc(size, sizeof(float));
+    buffers->outputs  = (float *)calloc(size, sizeof(float));
+    buffers->capacity = size;
+
+    memory_layout_changed();
+  }
+
+  return buffers->inputs;
+}
+
+static inline void render_release(RenderBuffers *const buffers) {
+  free(buffers->inputs);
+  free(buffers->outputs);
+
+  buffers->inputs   = nullptr;
+  buffers->outputs  = nullptr;
+  buffers->capacity = 0;
+}
+
+// `0` is the number of logical cores
+static inline size_t render_number_of_threads(const size_t number_of_threads) {
+  if (number_of_threads > 0) {
+    return number_of_threads;
+  }
+
+#ifdef __EMSCRIPTEN__
+#ifdef __EMSCRIPTEN_PTHREADS__
+  return (size_t)emscripten_num_logical_cores();
+#else
+  return 1;
+#endif
+#else
+  const size_t number_of_cores = std::thread::hardware_concurrency();
+
+  return (number_of_cores > 0) ? number_of_cores : 1;
+#endif
+}
+
+// Output render quantum `q` is overlap-added from frames that are due on render quanta `q - frames + 1 .. q`,
+// and frame that is due on render quantum `i` reads render quanta `i - frames + 1 .. i` (`frames` is `frame_size / 128`).
+// So, streaming from 2 * (frames - 1) render quanta before `begin` reproduces the whole stream.
+// Streaming starts on multiple of frame size, so that offsets of ring buffers and accumulators (and hop schedule) are the same too.
+static inline size_t render_warm_up_begin(const size_t begin, const size_t frame_size) {
+  const size_t frames = frame_size / render_quantum_size;
+
+  const size_t warm_up = 2 * (frames - 1);
+
+  if (begin <= warm_up) {
+    return 0;
+  }
+
+  return ((begin - warm_up) / frames) * frames;
+}
+
+// Jobs of `channels_per_job` channels. Render quanta are split into up to `number_of_threads` jobs per channels if `segmentable`.
+// Return value is jobs (freed by caller), and `number_of_jobs` is set.
+static RenderJob *render_plan_jobs(const size_t number_of_channels, const size_t channels_per_job, const size_t length, const size_t frame_size, const size_t number_of_threads, const bool segmentable, size_t *const number_of_jobs) {
+  const size_t number_of_quanta = (length + (render_quantum_size - 1)) / render_quantum_size;
+  const size_t number_of_units  = number_of_channels / channels_per_job;
+
+  const size_t max_number_of_segments = number_of_quanta / (render_min_frames_per_job * (frame_size / render_quantum_size));
+
+  size_t number_of_segments = 1;
+
+  if (segmentable) {
+    number_of_segments = (number_of_threads + (number_of_units - 1)) / number_of_units;
+
+    if (number_of_segments > max_number_of_segments) {
+      number_of_segments = max_number_of_segments;
+    }
+
+    if (number_of_segments == 0) {
+      number_of_segments = 1;
+    }
+  }
+
+  RenderJob *jobs = (RenderJob *)calloc((number_of_units * number_of_segments), sizeof(RenderJob));
+
+  for (size_t unit = 0; unit < number_of_units; unit++) {
+    for (size_t segment = 0; segment < number_of_segments; segment++) {
+      RenderJob *job = jobs + ((unit * number_of_segments) + segment);
+
+      job->channel_number     = unit * channels_per_job;
+      job->number_of_channels = channels_per_job;
+      job->begin              = (segment * number_of_quanta) / number_of_segments;
+      job->end                = ((segment + 1) * number_of_quanta) / number_of_segments;
+    }
+  }
+
+  *number_of_jobs = number_of_units * number_of_segments;
+
+  return jobs;
+}
+
+typedef struct {
+  RenderKernel kernel;
+  const void *argument;
+  RenderJob *jobs;
+  size_t number_of_jobs;
+  size_t next;
+} RenderQueue;
+
+static void *render_worker(void *const queue_pointer) {
+  RenderQueue *queue = (RenderQueue *)queue_pointer;
+
+  while (true) {
+    const size_t index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+
+    if (index >= queue->number_of_jobs) {
+      break;
+    }
+
+    queue->kernel(queue->argument, (queue->jobs + index));
+  }
+
+  return nullptr;
+}
+
+// Runs jobs on `number_of_threads` threads (the calling thread is one of them) and waits for all jobs.
+// FFT plans are built before threads start (contexts build them on create), and a thread that builds plan of new size locks the list (`find_fft_plan`).
+static void render_run(const RenderKernel kernel, const void *const argument, RenderJob *const jobs, const size_t number_of_jobs, const size_t number_of_threads) {
+  RenderQueue queue = { kernel, argument, jobs, number_of_jobs, 0 };
+
+  const size_t number_of_workers = (number_of_threads < number_of_jobs) ? number_of_threads : number_of_jobs;
+
+  // If thread can't be created (e.g. no worker is available on WebAssembly), the calling thread takes its jobs (the output is the same)
+#ifdef __EMSCRIPTEN__
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_t *threads = (pthread_t *)calloc(number_of_workers, sizeof(pthread_t));
+
+  size_t number_of_created_threads = 0;
+
+  for (size_t i = 1; (threads != nullptr) && (i < number_of_workers); i++) {
+    if (pthread_create(&threads[number_of_created_threads], nullptr, render_worker, &queue) != 0) {
+      break;
+    }
+
+    ++number_of_created_threads;
+  }
+
+  render_worker(&queue);
+
+  for (size_t i = 0; i < number_of_created_threads; i++) {
+    pthread_join(threads[i], nullptr);
+  }
+
+  free(threads);
+#else
+  (void)number_of_workers;
+
+  render_worker(&queue);
+#endif
+#else
+  std::vector<std::thread> threads;
+
+  for (size_t i = 1; i < number_of_workers; i++) {
+    try {
+      threads.push_back(std::thread(render_worker, &queue));
+    } catch (const std::system_error &) {
+      break;
+    }
+  }
+
+  render_worker(&queue);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+#endif
+}
+
+// Streams `inputs` of job through worker (its STFT is new), and writes render quanta from `job->begin` into `outputs`.
+// Frames that are skipped on render quanta of job are counted in `job->number_of_skipped_frames`.
+static void render_stream(RenderJob *const job, STFT *const stft, void *const worker, const RenderProcess process, const void *const parameters, const float *const inputs, float *const outputs, const size_t length) {
+  const size_t begin = render_warm_up_begin(job->begin, stft->frame_size);
+
+  size_t number_of_skipped_frames = 0;
+
+  for (size_t quantum = begin; quantum < job->end; quantum++) {
+    const size_t offset = quantum * render_quantum_size;
+    const size_t count  = ((offset + render_quantum_size) <= length) ? render_quantum_size : (length - offset);
+
+    for (size_t channel_number = 0; channel_number < job->number_of_channels; channel_number++) {
+      float *quantum_inputs = stft->quantum_inputs + (channel_number * render_quantum_size);
+
+      memcpy(quantum_inputs, (inputs + ((job->channel_number + channel_number) * length) + offset), (count * sizeof(float)));
+      memset((quantum_inputs + count), 0, ((render_quantum_size - count) * sizeof(float)));
+    }
+
+    if (quantum == job->begin) {
+      number_of_skipped_frames = stft->number_of_skipped_frames;
+    }
+
+    const float *quantum_outputs = process(worker, parameters);
+
+    if (quantum < job->begin) {
+      continue;
+    }
+
+    for (size_t channel_number = 0; channel_number < job->number_of_channels; channel_number++) {
+      memcpy((outputs + ((job->channel_number + channel_number) * length) + offset), (quantum_outputs + (channel_number * render_quantum_size)), (count * sizeof(float)));
+    }
+  }
+
+  job->number_of_skipped_frames = stft->number_of_skipped_frames - number_of_skipped_frames;
+}
+
+// Renders every job, and return value is the number of skipped frames of all jobs
+static size_t render(const RenderKernel kernel, const void *const argument, const size_t number_of_channels, const size_t channels_per_job, const size_t length, const size_t frame_size, const size_t number_of_threads, const bool segmentable) {
+  if ((length == 0) || (number_of_channels == 0)) {
+    return 0;
+  }
+
+  const size_t threads = render_number_of_threads(number_of_threads);
+
+  size_t number_of_jobs = 0;
+
+  RenderJob *jobs = render_plan_jobs(number_of_channels, channels_per_job, length, frame_size, threads, segmentable, &number_of_jobs);
+
+  render_run(kernel, argument, jobs, number_of_jobs, threads);
+
+  size_t number_of_skipped_frames = 0;
+
+  for (size_t i = 0; i < number_of_jobs; i++) {
+    number_of_skipped_frames += jobs[i].number_of_skipped_frames;
+  }
+
+  free(jobs);
+
+  return number_of_skipped_frames;
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef XSOUND_SPECTRAL_HPP
+#define XSOUND_SPECTRAL_HPP
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+// Spectral stages on half spectrum of real frame (bins `0` .. `fft_size / 2`, as `RFFT`).
+// They are shared by effector modules and spectral chain (`spectralchain.cpp`) that applies them in one analysis / synthesis pass.
+
+// Safe positive minimum on `float` (6 digits)
+static const float spectral_minimum_amplitude = 0.000001f;
+
+// Spectral subtraction as gain mask (phase is kept, so polar form is not required).
+// |X[k]| - threshold = gain * |X[k]| -> gain = max(1 - (threshold / |X[k]|), 0)
+// Bins whose squared magnitude is not greater than squared threshold are removed without square root.
+static inline void spectral_subtract(float *const reals, float *const imags, const size_t buffer_size, const float threshold) {
+  const float squared_threshold = threshold * threshold;
+
+  int k = 0;
+
+#ifdef __wasm_simd128__
+  const v128_t ones       = wasm_f32x4_splat(1.0f);
+  const v128_t zeros      = wasm_f32x4_splat(0.0f);
+  const v128_t thresholds = wasm_f32x4_splat(threshold);
+  const v128_t squared_thresholds = wasm_f32x4_splat(squared_threshold);
+
+  for (; (k + 4) <= buffer_size; k += 4) {
+    const v128_t real = wasm_v128_load(reals + k);
+    const v128_t imag = wasm_v128_load(imags + k);
+
+    const v128_t squared_magnitude = wasm_f32x4_add(wasm_f32x4_mul(real, real), wasm_f32x4_mul(imag, imag));
+
+    // Lanes that are not greater than threshold are masked (so, division by `0` is not selected)
+    const v128_t mask = wasm_f32x4_gt(squared_magnitude, squared_thresholds);
+    const v128_t gain = wasm_v128_and(wasm_f32x4_max(wasm_f32x4_sub(ones, wasm_f32x4_div(thresholds, wasm_f32x4_sqrt(squared_magnitude))), zeros), mask);
+
+    wasm_v128_store(reals + k, wasm_f32x4_mul(real, gain));
+    wasm_v128_store(imags + k, wasm_f32x4_mul(imag, gain));
+  }
+#endif
+
+  for (; k < buffer_size; k++) {
+    const float squared_magnitude = (reals[k] * reals[k]) + (imags[k] * imags[k]);
+
+    float gain = 0.0f;
+
+    if (squared_magnitude > squared_threshold) {
+      gain = 1.0f - (threshold / sqrtf(squared_magnitude));
+    }
+
+    reals[k] *= gain;
+    imags[k] *= gain;
+  }
+}
+
+// Peaks of power spectrum (`magnitudes`) are detected (greater than 2 bins on both sides).
+// `peak_indexes` holds `buffer_size` indexes, and return value is the number of peaks.
+// Bin next to peak is never peak (peak is greater than it), so every bin is tested without branch (index is always stored, and count is advanced by comparison).
+static inline int spectral_find_peaks(const float *const reals, const float *const imags, float *const magnitudes, int *const peak_indexes, const size_t fft_size) {
+  const size_t half_fft_size = fft_size / 2;
+  const size_t buffer_size   = half_fft_size + 1;
+
+  int k = 0;
+
+#ifdef __wasm_simd128__
+  for (; (k + 4) <= buffer_size; k += 4) {
+    const v128_t real = wasm_v128_load(reals + k);
+    const v128_t imag = wasm_v128_load(imags + k);
+
+    wasm_v128_store((magnitudes + k), wasm_f32x4_add(wasm_f32x4_mul(real, real), wasm_f32x4_mul(imag, imag)));
+  }
+#endif
+
+  for (; k < buffer_size; k++) {
+    magnitudes[k] = (reals[k] * reals[k]) + (imags[k] * imags[k]);
+  }
+
+  int number_of_peaks = 0;
+
+  int index = 2;
+
+  const size_t end = half_fft_size + 1 - 2;
+
+#ifdef __wasm_simd128__
+  // 4 bins per comparison, and indexes are stored only if either lane is peak
+  for (; (index + 4) <= end; index += 4) {
+    const v128_t magnitude = wasm_v128_load(magnitudes + index);
+
+    const v128_t neighbors = wasm_f32x4_max(wasm_f32x4_max(wasm_v128_load(magnitudes + index - 2), wasm_v128_load(magnitudes + index - 1)),
+                                            wasm_f32x4_max(wasm_v128_load(magnitudes + index + 1), wasm_v128_load(magnitudes + index + 2)));
+
+    const uint32_t mask = wasm_i32x4_bitmask(wasm_f32x4_gt(magnitude, neighbors));
+
+    if (mask == 0) {
+      continue;
+    }
+
+    for (int lane = 0; lane < 4; lane++) {
+      peak_indexes[number_of_peaks] = index + lane;
+
+      number_of_peaks += (mask >> lane) & 1;
+    }
+  }
+#endif
+
+  for (; index < end; index++) {
+    const float magnitude = magnitudes[index];
+
+    const float neighbor = fmaxf(fmaxf(magnitudes[index - 2], magnitudes[index - 1]), fmaxf(magnitudes[index + 1], magnitudes[index + 2]));
+
+    peak_indexes[number_of_peaks] = index;
+
+    number_of_peaks += (magnitude > neighbor);
+  }
+
+  return number_of_peaks;
+}
+
+// Peaks (`spectral_find_peaks`) are moved to `round(peak * pitch / speed)` with their regions,
+// and phases are rotated by `time_cursor` (the number of samples from the first frame).
+// Peaks are detected once per frame, so that they are shared by voices of different pitch.
+// `shifted_reals` and `shifted_imags` hold `buffer_size` bins at least.
+//
+// Every bin of region is moved by the same number of bins, so region is rotated by one phasor (`cosf` and `sinf` per peak, not per bin).
+// Rotation `2 * pi * shift * time_cursor / fft_size` is periodic in `fft_size`, so its phase is wrapped by integers
+// (exact for any `time_cursor`, so that precision does not degrade over long sessions).
+static inline void spectral_shift_regions(const float *const reals, const float *const imags, const int *const peak_indexes, const int number_of_peaks, float *const shifted_reals, float *const shifted_imags, const size_t fft_size, const float pitch, const float speed, const size_t time_cursor) {
+  const int buffer_size = (fft_size / 2) + 1;
+
+  const size_t wrapped_time_cursor = time_cursor % fft_size;
+
+  // Shift peaks
+  memset(shifted_reals, 0, (buffer_size * sizeof(float)));
+  memset(shifted_imags, 0, (buffer_size * sizeof(float)));
+
+  for (int k = 0; k < number_of_peaks; k++) {
+    const int peak_index = peak_indexes[k];
+
+    const int shifted_peak_index = roundf(peak_index * pitch * (1 / speed));
+
+    if (shifted_peak_index > buffer_size) {
+      break;
+    }
+
+    int start_index = 0;
+    int end_index   = fft_size;
+
+    if (k > 0) {
+      const int peak_index_before = peak_indexes[k - 1];
+
+      start_index = peak_index - floorf((float)(peak_index - peak_index_before) / 2.0f);
+    }
+
+    if (k < (number_of_peaks - 1)) {
+      const int peak_index_after = peak_indexes[k + 1];
+
+      end_index = peak_index + ceilf((float)(peak_index_after - peak_index) / 2.0f);
+    }
+
+    // Bins below DC are dropped (pitch < 1 may shift the lower edge of peak region below `0`), and bins above Nyquist are dropped
+    int start_offset = start_index - peak_index;
+    int end_offset   = end_index - peak_index;
+
+    if ((shifted_peak_index + start_offset) < 0) {
+      start_offset = 0 - shifted_peak_index;
+    }
+
+    if ((shifted_peak_index + end_offset) > buffer_size) {
+      end_offset = buffer_size - shifted_peak_index;
+    }
+
+    if (start_offset >= end_offset) {
+      continue;
+    }
+
+    // Phase index of rotation (`shift * time_cursor` modulo `fft_size`)
+    const int shift = shifted_peak_index - peak_index;
+
+    const size_t wrapped_shift = (shift >= 0) ? (shift % fft_size) : (fft_size - ((0 - shift) % fft_size));
+    const size_t phase_index   = ((uint64_t)wrapped_shift * wrapped_time_cursor) % fft_size;
+
+    const float omega = (2.0f * M_PI * phase_index) / fft_size;
+
+    const float rotation_real = cosf(omega);
+    const float rotation_imag = sinf(omega);
+
+    // Bins above Nyquist are the complex conjugate of the mirrored bins (real input)
+    const int mirror_offset = (buffer_size - peak_index) < end_offset ? (buffer_size - peak_index) : end_offset;
+
+    const float *const source_reals = reals + peak_index;
+    const float *const source_imags = imags + peak_index;
+
+    float *const destination_reals = shifted_reals + shifted_peak_index;
+    float *const destination_imags = shifted_imags + shifted_peak_index;
+
+    int m = start_offset;
+
+#ifdef __wasm_simd128__
+    const v128_t rotation_reals = wasm_f32x4_splat(rotation_real);
+    const v128_t rotation_imags = wasm_f32x4_splat(rotation_imag);
+
+    for (; (m + 4) <= mirror_offset; m += 4) {
+      const v128_t real = wasm_v128_load(source_reals + m);
+      const v128_t imag = wasm_v128_load(source_imags + m);
+
+      const v128_t rotated_real = wasm_f32x4_sub(wasm_f32x4_mul(real, rotation_reals), wasm_f32x4_mul(imag, rotation_imags));
+      const v128_t rotated_imag = wasm_f32x4_add(wasm_f32x4_mul(real, rotation_imags), wasm_f32x4_mul(imag, rotation_reals));
+
+      wasm_v128_store((destination_reals + m), wasm_f32x4_add(wasm_v128_load(destination_reals + m), rotated_real));
+      wasm_v128_store((destination_imags + m), wasm_f32x4_add(wasm_v128_load(destination_imags + m), rotated_imag));
+    }
+#endif
+
+    for (; m < mirror_offset; m++) {
+      const float real = source_reals[m];
+      const float imag = source_imags[m];
+
+      destination_reals[m] += (real * rotation_real) - (imag * rotation_imag);
+      destination_imags[m] += (real * rotation_imag) + (imag * rotation_real);
+    }
+
+    for (; m < end_offset; m++) {
+      const int mirrored_bin_count_index = fft_size - (peak_index + m);
+
+      const float real = 0.0f + reals[mirrored_bin_count_index];
+      const float imag = 0.0f - imags[mirrored_bin_count_index];
+
+      destination_reals[m] += (real * rotation_real) - (imag * rotation_imag);
+      destination_imags[m] += (real * rotation_imag) + (imag * rotation_real);
+    }
+  }
+}
+
+// Peak shifting (`spectral_find_peaks` and `spectral_shift_regions`).
+// `shifted_reals` and `shifted_imags` hold `buffer_size` bins at least, and `peak_indexes` holds `buffer_size` indexes.
+static inline void spectral_shift_peaks(const float *const reals, const float *const imags, float *const magnitudes, int *const peak_indexes, float *const shifted_reals, float *const shifted_imags, const size_t fft_size, const float pitch, const float speed, const size_t time_cursor) {
+  const int number_of_peaks = spectral_find_peaks(reals, imags, magnitudes, peak_indexes, fft_size);
+
+  spectral_shift_regions(reals, imags, peak_indexes, number_of_peaks, shifted_reals, shifted_imags, fft_size, pitch, speed, time_cursor);
+}
+
+// Bins of frequency band (`min` .. `max`, exclusive) on half spectrum
+static inline void spectral_band(const size_t fft_size, const float sample_rate, const float min_frequency, const float max_frequency, int *const min, int *const max) {
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  *min = (int)(min_frequency * (fft_size / sample_rate));
+  *max = (int)(max_frequency * (fft_size / sample_rate));
+
+  if (*min < 0) {
+    *min = 0;
+  }
+
+  if (*max > buffer_size) {
+    *max = buffer_size;
+  }
+}
+
+// Center component of bin `k` (left and right channels) is masked by real gain (phase is kept, so polar form is not required).
+// (|L| - |R|)^2 / (|L| + |R|)^2 < threshold <-> (1 - threshold) * (|L|^2 + |R|^2) < 2 * (1 + threshold) * |L| * |R|
+// Masked bins are scaled to safe positive minimum amplitude (gain = minimum / |X[k]|).
+// Return value is whether bin is masked (otherwise, bin is not changed).
+static inline bool spectral_mask_center(float *const realL, float *const imagL, float *const realR, float *const imagR, const float threshold) {
+  const float squared_absL = (*realL * *realL) + (*imagL * *imagL);
+  const float squared_absR = (*realR * *realR) + (*imagR * *imagR);
+
+  // (|L| + |R|)^2 is `0`
+  if ((squared_absL == 0.0f) && (squared_absR == 0.0f)) {
+    return false;
+  }
+
+  if (((1.0f - threshold) * (squared_absL + squared_absR)) >= (2.0f * (1.0f + threshold) * sqrtf(squared_absL * squared_absR))) {
+    return false;
+  }
+
+  // Either magnitude may be `0` (then phase is `0`, as `atan2f(0, 0)`)
+  if (squared_absL == 0.0f) {
+    *realL = spectral_minimum_amplitude;
+  } else {
+    const float gainL = spectral_minimum_amplitude / sqrtf(squared_absL);
+
+    *realL *= gainL;
+    *imagL *= gainL;
+  }
+
+  if (squared_absR == 0.0f) {
+    *realR = spectral_minimum_amplitude;
+  } else {
+    const float gainR = spectral_minimum_amplitude / sqrtf(squared_absR);
+
+    *realR *= gainR;
+    *imagR *= gainR;
+  }
+
+  return true;
+}
+
+#endif
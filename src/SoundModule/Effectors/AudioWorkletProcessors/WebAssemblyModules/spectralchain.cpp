@@ -0,0 +1,666 @@
+#include "FFT.hpp"
+#include "stft.hpp"
+#include "spectral.hpp"
+#include "profile.hpp"
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+// Spectral effects that are chained in one analysis / synthesis pass
+typedef enum {
+  SPECTRAL_NOISE_SUPPRESSOR,
+  SPECTRAL_VOCAL_CANCELER,
+  SPECTRAL_PITCH_SHIFTER
+} SPECTRAL_STAGE;
+
+// Parameters per stage (fields are used by its type).
+// Noise suppressor: `threshold` (`0` is bypass)
+// Vocal canceler  : `on_spectrum`, `depth` (`0` is bypass), `sample_rate`, `min_frequency`, `max_frequency` and `threshold`
+// Pitch shifter   : `pitch`, `speed` (both `1` is bypass), `dry`, `wet`, and `time_cursor` that advances by hop size per frame (modulo FFT size)
+typedef struct {
+  SPECTRAL_STAGE type;
+  bool on_spectrum;
+  float threshold;
+  float depth;
+  float sample_rate;
+  float min_frequency;
+  float max_frequency;
+  float pitch;
+  float speed;
+  float dry;
+  float wet;
+  size_t time_cursor;
+} SpectralStage;
+
+static const size_t spectral_chain_max_stages = 8;
+
+// Gain of Hanning analysis and synthesis windows after overlap-add (the same in low-latency mode, `stft.hpp`).
+// Processed spectra are overlap-added at this gain, while frames that are mixed on time domain are overlap-added at unity gain.
+static const float spectral_chain_overlap_add_gain = 0.375f;
+
+// State of spectral chain per instance.
+// Every frame is windowed and transformed once, then `stages` process its spectrum in order, and it is transformed back and overlap-added once
+// (so, latency is one frame for any number of stages, instead of one frame per effector).
+// Every stage is processed by hop size of `stft`, so non-linear stage (e.g. noise suppressor) in chain of larger hop size than its effector
+// doesn't have the same output as standalone effector (`check_shared_hop_size` of `benchmark/dsp.cpp`).
+// Scratch buffers (and Hanning window) are carved from the arena that is allocated once per FFT size and number of channels.
+// `reals` and `imags` hold analyzed spectra of all channels (channel `c` starts at `c * fft_size`), because vocal canceler mixes both channels.
+// `spectral_reals` and `spectral_imags` hold processed spectra of all channels (the same layout), and `stage_reals` and `stage_imags` hold inputs of stage
+// (channel `c` starts at `c * (fft_size / 2 + 1)`).
+typedef struct {
+  size_t fft_size;
+  size_t number_of_channels;
+  size_t number_of_stages;
+  SpectralStage stages[spectral_chain_max_stages];
+  Arena arena;
+  STFT stft;
+  Profile profile;
+  float *window;
+  float *reals;
+  float *imags;
+  float *spectral_reals;
+  float *spectral_imags;
+  float *stage_reals;
+  float *stage_imags;
+  float *magnitudes;
+  int *peak_indexes;
+  float *shifted_reals;
+  float *shifted_imags;
+  float *outputs;
+} SpectralChainContext;
+
+// Output of chain per frame (as if effectors were run in series).
+// Dry components (dry of pitch shifter, `1 - depth` of vocal canceler, and cancellation on time domain) are mixed on time domain as standalone effectors,
+// so frame of the same channel is mixed by `direct` and frame of the other channel (stereo) is mixed by `cross`.
+// Processed spectra (`spectral_reals` and `spectral_imags`) are mixed too, if `spectral`.
+typedef struct {
+  float direct;
+  float cross;
+  bool spectral;
+} SpectralChainMix;
+
+static void prepare(SpectralChainContext *const context, const size_t fft_size, const size_t number_of_channels) {
+  if ((context->fft_size == fft_size) && (context->number_of_channels == number_of_channels)) {
+    return;
+  }
+
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const size_t capacity = (2 * arena_size_of(fft_size, sizeof(float)))
+                        + (4 * arena_size_of((number_of_channels * fft_size), sizeof(float)))
+                        + (2 * arena_size_of((number_of_channels * buffer_size), sizeof(float)))
+                        + (3 * arena_size_of(buffer_size, sizeof(float)))
+                        + arena_size_of(buffer_size, sizeof(int));
+
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, capacity);
+
+  context->window         = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->reals          = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->imags          = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->spectral_reals = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->spectral_imags = (float *)arena_alloc(arena, (number_of_channels * fft_size), sizeof(float));
+  context->stage_reals    = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+  context->stage_imags    = (float *)arena_alloc(arena, (number_of_channels * buffer_size), sizeof(float));
+  context->magnitudes     = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->peak_indexes   = (int *)arena_alloc(arena, buffer_size, sizeof(int));
+  context->shifted_reals  = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->shifted_imags  = (float *)arena_alloc(arena, buffer_size, sizeof(float));
+  context->outputs        = (float *)arena_alloc(arena, fft_size, sizeof(float));
+
+  stft_prepare(&context->stft, fft_size, number_of_channels);
+
+  window_function(context->window, fft_size, HANNING);
+
+  // Build FFT plans in advance
+  get_rfft_plan(fft_size);
+  get_fft_plan((fft_size / 2), FORWARD);
+  get_fft_plan((fft_size / 2), INVERSE);
+
+  context->fft_size           = fft_size;
+  context->number_of_channels = number_of_channels;
+}
+
+static inline bool is_bypass(const SpectralStage *const stage) {
+  switch (stage->type) {
+    case SPECTRAL_NOISE_SUPPRESSOR:
+      return stage->threshold == 0.0f;
+    case SPECTRAL_VOCAL_CANCELER:
+      return stage->depth == 0.0f;
+    case SPECTRAL_PITCH_SHIFTER:
+      return (stage->pitch == 1.0f) && (stage->speed == 1.0f);
+  }
+
+  return true;
+}
+
+// Vocal canceler mixes left and right channels (only if they are stereo)
+static bool is_stereo_chain(const SpectralChainContext *const context) {
+  if (context->number_of_channels != 2) {
+    return false;
+  }
+
+  for (size_t i = 0; i < context->number_of_stages; i++) {
+    const SpectralStage *stage = context->stages + i;
+
+    if ((stage->type == SPECTRAL_VOCAL_CANCELER) && !is_bypass(stage)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Frames are analyzed only if a stage processes spectrum (cancellation on time domain and bypass mix frames as they are)
+static bool needs_analysis(const SpectralChainContext *const context, const bool stereo) {
+  for (size_t i = 0; i < context->number_of_stages; i++) {
+    const SpectralStage *stage = context->stages + i;
+
+    if (is_bypass(stage)) {
+      continue;
+    }
+
+    if ((stage->type != SPECTRAL_VOCAL_CANCELER) || (stereo && stage->on_spectrum)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Input spectrum of stage is the spectrum that standalone effector would analyze from output of the previous effector
+// (frames by `direct` and `cross`, and processed spectra at overlap-add gain).
+static void mix_stage_inputs(SpectralChainContext *const context, const size_t channel_number, const SpectralChainMix *const mix) {
+  const size_t fft_size    = context->fft_size;
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const float *reals          = context->reals + (channel_number * fft_size);
+  const float *imags          = context->imags + (channel_number * fft_size);
+  const float *spectral_reals = context->spectral_reals + (channel_number * fft_size);
+  const float *spectral_imags = context->spectral_imags + (channel_number * fft_size);
+
+  float *stage_reals = context->stage_reals + (channel_number * buffer_size);
+  float *stage_imags = context->stage_imags + (channel_number * buffer_size);
+
+  const float gain = mix->spectral ? spectral_chain_overlap_add_gain : 0.0f;
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    stage_reals[k] = (mix->direct * reals[k]) + (gain * spectral_reals[k]);
+    stage_imags[k] = (mix->direct * imags[k]) + (gain * spectral_imags[k]);
+  }
+
+  if (mix->cross == 0.0f) {
+    return;
+  }
+
+  // Cross term exists only in stereo chain
+  const float *cross_reals = context->reals + ((1 - channel_number) * fft_size);
+  const float *cross_imags = context->imags + ((1 - channel_number) * fft_size);
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    stage_reals[k] += mix->cross * cross_reals[k];
+    stage_imags[k] += mix->cross * cross_imags[k];
+  }
+}
+
+// Processed spectrum of stage is mixed with output of the previous stages (`keep * previous + gain * processed`).
+// `keep` is applied to frames on time domain too (`mix_stage_gains`).
+static void mix_stage_outputs(SpectralChainContext *const context, const size_t channel_number, const SpectralChainMix *const mix, const float *const reals, const float *const imags, const float keep, const float gain) {
+  const size_t fft_size    = context->fft_size;
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  float *spectral_reals = context->spectral_reals + (channel_number * fft_size);
+  float *spectral_imags = context->spectral_imags + (channel_number * fft_size);
+
+  if (!mix->spectral || (keep == 0.0f)) {
+    for (size_t k = 0; k < buffer_size; k++) {
+      spectral_reals[k] = gain * reals[k];
+      spectral_imags[k] = gain * imags[k];
+    }
+
+    return;
+  }
+
+  for (size_t k = 0; k < buffer_size; k++) {
+    spectral_reals[k] = (keep * spectral_reals[k]) + (gain * reals[k]);
+    spectral_imags[k] = (keep * spectral_imags[k]) + (gain * imags[k]);
+  }
+}
+
+static inline void mix_stage_gains(SpectralChainMix *const mix, const float keep) {
+  mix->direct   *= keep;
+  mix->cross    *= keep;
+  mix->spectral  = true;
+}
+
+// Cancellation on time domain is linear (L - depth * R), so it is applied to frames (gains) and processed spectra as they are
+static void cancel_on_time(SpectralChainContext *const context, const SpectralStage *const stage, SpectralChainMix *const mix) {
+  const size_t fft_size    = context->fft_size;
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  const float depth = stage->depth;
+
+  if (mix->spectral) {
+    float *realLs = context->spectral_reals;
+    float *imagLs = context->spectral_imags;
+    float *realRs = context->spectral_reals + fft_size;
+    float *imagRs = context->spectral_imags + fft_size;
+
+    for (size_t k = 0; k < buffer_size; k++) {
+      const float realL = realLs[k];
+      const float imagL = imagLs[k];
+      const float realR = realRs[k];
+      const float imagR = imagRs[k];
+
+      realLs[k] = realL - (depth * realR);
+      imagLs[k] = imagL - (depth * imagR);
+      realRs[k] = realR - (depth * realL);
+      imagRs[k] = imagR - (depth * imagL);
+    }
+  }
+
+  const float direct = mix->direct;
+  const float cross  = mix->cross;
+
+  mix->direct = direct - (depth * cross);
+  mix->cross  = cross - (depth * direct);
+}
+
+// Canceled spectrum is mixed with input (`(1 - depth) * input + depth * canceled`), and input is mixed on time domain as standalone vocal canceler
+static void cancel_on_spectrum(SpectralChainContext *const context, const SpectralStage *const stage, SpectralChainMix *const mix) {
+  const size_t fft_size    = context->fft_size;
+  const size_t buffer_size = (fft_size / 2) + 1;
+
+  mix_stage_inputs(context, 0, mix);
+  mix_stage_inputs(context, 1, mix);
+
+  float *realLs = context->stage_reals;
+  float *imagLs = context->stage_imags;
+  float *realRs = context->stage_reals + buffer_size;
+  float *imagRs = context->stage_imags + buffer_size;
+
+  int min = 0;
+  int max = 0;
+
+  spectral_band(fft_size, stage->sample_rate, stage->min_frequency, stage->max_frequency, &min, &max);
+
+  for (int k = min; k < max; k++) {
+    spectral_mask_center((realLs + k), (imagLs + k), (realRs + k), (imagRs + k), stage->threshold);
+  }
+
+  const float depth = stage->depth;
+
+  mix_stage_outputs(context, 0, mix, realLs, imagLs, (1.0f - depth), depth);
+  mix_stage_outputs(context, 1, mix, realRs, imagRs, (1.0f - depth), depth);
+
+  mix_stage_gains(mix, (1.0f - depth));
+}
+
+// Shifted spectrum is mixed with input (`dry * input + wet * shifted`) unless `dry` is `0`, and input is mixed on time domain as standalone pitch shifter
+static void shift_on_spectrum(SpectralChainContext *const context, const SpectralStage *const stage, const size_t channel_number, const SpectralChainMix *const mix) {
+  const size_t buffer_size = (context->fft_size / 2) + 1;
+
+  float *stage_reals = context->stage_reals + (channel_number * buffer_size);
+  float *stage_imags = context->stage_imags + (channel_number * buffer_size);
+
+  mix_stage_inputs(context, channel_number, mix);
+
+  spectral_shift_peaks(stage_reals, stage_imags, context->magnitudes, context->peak_indexes, context->shifted_reals, context->shifted_imags, context->fft_size, stage->pitch, stage->speed, stage->time_cursor);
+
+  if (stage->dry == 0.0f) {
+    mix_stage_outputs(context, channel_number, mix, context->shifted_reals, context->shifted_imags, 0.0f, 1.0f);
+  } else {
+    mix_stage_outputs(context, channel_number, mix, context->shifted_reals, context->shifted_imags, stage->dry, stage->wet);
+  }
+}
+
+// Spectral subtraction replaces input (no dry component)
+static void subtract_on_spectrum(SpectralChainContext *const context, const SpectralStage *const stage, const size_t channel_number, const SpectralChainMix *const mix) {
+  const size_t buffer_size = (context->fft_size / 2) + 1;
+
+  float *stage_reals = context->stage_reals + (channel_number * buffer_size);
+  float *stage_imags = context->stage_imags + (channel_number * buffer_size);
+
+  mix_stage_inputs(context, channel_number, mix);
+
+  spectral_subtract(stage_reals, stage_imags, buffer_size, stage->threshold);
+
+  mix_stage_outputs(context, channel_number, mix, stage_reals, stage_imags, 0.0f, 1.0f);
+}
+
+// One render quantum is pushed and pulled per call, and frames are processed by every stage every hop.
+// Silent frames are skipped per channel (or only if all channels are silent, if vocal canceler mixes channels).
+// Output frame is `direct * frame + cross * frame of the other channel + synthesis of processed spectrum` (`SpectralChainMix`),
+// so that chain has the same level as effectors in series (frames that are not processed on spectrum are not scaled by overlap-add gain of windows).
+static float *process_stream(SpectralChainContext *const context) {
+  STFT *stft = &context->stft;
+
+  // Frame size is not valid for streaming API (`stft_prepare`)
+  if (!stft_is_prepared(stft)) {
+    return nullptr;
+  }
+
+  if (!stft_push(stft)) {
+    return stft_pull(stft);
+  }
+
+  const size_t fft_size           = context->fft_size;
+  const size_t number_of_channels = context->number_of_channels;
+
+  const bool stereo   = is_stereo_chain(context);
+  const bool analysis = needs_analysis(context, stereo);
+
+  const float *analysis_window  = stft_analysis_window(stft, context->window);
+  const float *synthesis_window = stft_synthesis_window(stft, context->window);
+
+  // Only the latest `synthesis_size` samples of frame are overlap-added (the whole frame by default)
+  const size_t synthesis_offset = fft_size - stft->synthesis_size;
+
+  bool silent = true;
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    silent = silent && stft_is_silent(stft, channel_number);
+  }
+
+  // Analysis
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    if (!analysis || (stereo ? silent : stft_is_silent(stft, channel_number))) {
+      continue;
+    }
+
+    float *reals = context->reals + (channel_number * fft_size);
+    float *imags = context->imags + (channel_number * fft_size);
+
+    multiply_window(reals, stft_frame(stft, channel_number), analysis_window, fft_size);
+
+    RFFT(reals, imags, fft_size);
+  }
+
+  SpectralChainMix mix = { 1.0f, 0.0f, false };
+
+  // Stages
+  for (size_t i = 0; i < context->number_of_stages; i++) {
+    SpectralStage *stage = context->stages + i;
+
+    if (is_bypass(stage)) {
+      continue;
+    }
+
+    if (stage->type == SPECTRAL_VOCAL_CANCELER) {
+      if (stereo && !silent) {
+        if (stage->on_spectrum) {
+          cancel_on_spectrum(context, stage, &mix);
+        } else {
+          cancel_on_time(context, stage, &mix);
+        }
+      }
+
+      continue;
+    }
+
+    for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+      if (stereo ? silent : stft_is_silent(stft, channel_number)) {
+        continue;
+      }
+
+      if (stage->type == SPECTRAL_NOISE_SUPPRESSOR) {
+        subtract_on_spectrum(context, stage, channel_number, &mix);
+      } else {
+        shift_on_spectrum(context, stage, channel_number, &mix);
+      }
+    }
+
+    if (stage->type == SPECTRAL_NOISE_SUPPRESSOR) {
+      mix_stage_gains(&mix, 0.0f);
+    } else {
+      mix_stage_gains(&mix, stage->dry);
+
+      stage->time_cursor = (stage->time_cursor + stft->hop_size) % context->fft_size;
+    }
+  }
+
+  // Synthesis
+  float *outputs = context->outputs + synthesis_offset;
+
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    if (stereo ? silent : stft_is_silent(stft, channel_number)) {
+      ++stft->number_of_skipped_frames;
+      continue;
+    }
+
+    if (mix.spectral) {
+      float *reals = context->spectral_reals + (channel_number * fft_size);
+      float *imags = context->spectral_imags + (channel_number * fft_size);
+
+      IRFFT(reals, imags, fft_size);
+
+      multiply_window(outputs, (reals + synthesis_offset), (synthesis_window + synthesis_offset), stft->synthesis_size);
+    } else {
+      memset(outputs, 0, (stft->synthesis_size * sizeof(float)));
+    }
+
+    const float *frame = stft_frame(stft, channel_number) + synthesis_offset;
+
+    for (size_t n = 0; n < stft->synthesis_size; n++) {
+      outputs[n] += mix.direct * frame[n];
+    }
+
+    if (mix.cross != 0.0f) {
+      const float *cross_frame = stft_frame(stft, (1 - channel_number)) + synthesis_offset;
+
+      for (size_t n = 0; n < stft->synthesis_size; n++) {
+        outputs[n] += mix.cross * cross_frame[n];
+      }
+    }
+
+    stft_overlap_add(stft, channel_number, context->outputs);
+  }
+
+  return stft_pull(stft);
+}
+
+// Stage `index` is replaced (or appended if `index` is the number of stages).
+// Time cursor is kept if stage type is not changed, so that parameters can be updated while streaming.
+static SpectralStage *set_stage(SpectralChainContext *const context, const size_t index, const SPECTRAL_STAGE type) {
+  if ((index > context->number_of_stages) || (index >= spectral_chain_max_stages)) {
+    return nullptr;
+  }
+
+  SpectralStage *stage = context->stages + index;
+
+  if ((index == context->number_of_stages) || (stage->type != type)) {
+    memset(stage, 0, sizeof(SpectralStage));
+
+    stage->type = type;
+  }
+
+  if (index == context->number_of_stages) {
+    ++context->number_of_stages;
+  }
+
+  return stage;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+SpectralChainContext *spectralchain_create(const size_t fft_size) {
+  SpectralChainContext *context = (SpectralChainContext *)calloc(1, sizeof(SpectralChainContext));
+
+  prepare(context, fft_size, 1);
+
+  return context;
+}
+
+// Render quanta are reallocated (so, pointer by `spectralchain_stream_inputs` must be got again)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void spectralchain_set_number_of_channels(SpectralChainContext *const context, const size_t number_of_channels) {
+  prepare(context, context->fft_size, number_of_channels);
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void spectralchain_destroy(SpectralChainContext *const context) {
+  if (context == nullptr) {
+    return;
+  }
+
+  arena_release(&context->arena);
+  stft_release(&context->stft);
+  profile_release(&context->profile);
+
+  free(context);
+}
+
+// Stages after `number_of_stages` are removed. Return value is the number of stages after this call.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t spectralchain_set_number_of_stages(SpectralChainContext *const context, const size_t number_of_stages) {
+  if (number_of_stages < context->number_of_stages) {
+    context->number_of_stages = number_of_stages;
+  }
+
+  return context->number_of_stages;
+}
+
+// Return value is `false` if `index` is out of stages (or more than the maximum number of stages)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool spectralchain_set_noise_suppressor(SpectralChainContext *const context, const size_t index, const float threshold) {
+  SpectralStage *stage = set_stage(context, index, SPECTRAL_NOISE_SUPPRESSOR);
+
+  if (stage == nullptr) {
+    return false;
+  }
+
+  stage->threshold = threshold;
+
+  return true;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool spectralchain_set_vocal_canceler(SpectralChainContext *const context, const size_t index, const bool on_spectrum, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold) {
+  SpectralStage *stage = set_stage(context, index, SPECTRAL_VOCAL_CANCELER);
+
+  if (stage == nullptr) {
+    return false;
+  }
+
+  stage->on_spectrum   = on_spectrum;
+  stage->depth         = depth;
+  stage->sample_rate   = sample_rate;
+  stage->min_frequency = min_frequency;
+  stage->max_frequency = max_frequency;
+  stage->threshold     = threshold;
+
+  return true;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool spectralchain_set_pitch_shifter(SpectralChainContext *const context, const size_t index, const float pitch, const float speed, const float dry, const float wet) {
+  SpectralStage *stage = set_stage(context, index, SPECTRAL_PITCH_SHIFTER);
+
+  if (stage == nullptr) {
+    return false;
+  }
+
+  stage->pitch = pitch;
+  stage->speed = speed;
+  stage->dry   = dry;
+  stage->wet   = wet;
+
+  return true;
+}
+
+// Planar render quantum (channel `c` starts at `c * 128`).
+// Streaming API needs FFT size that is multiple of 128, otherwise this and `spectralchain_stream_process*` return `nullptr`.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *spectralchain_stream_inputs(SpectralChainContext *const context) {
+  return context->stft.quantum_inputs;
+}
+
+// Planar render quantum of outputs (the same pointer that `spectralchain_stream_process*` returns).
+// Pointers of render quanta are fixed until the number of channels is changed (`get_memory_generation`).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *spectralchain_stream_outputs(SpectralChainContext *const context) {
+  return context->stft.quantum_outputs;
+}
+
+// Output is delayed by `spectralchain_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *spectralchain_stream_process(SpectralChainContext *const context) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
+
+  float *outputs = process_stream(context);
+
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
+
+  return outputs;
+}
+
+// Hop size of streaming API (power of two, from 128 to `fft_size / 4`, or `fft_size / 2` in low-latency mode). Invalid hop size is ignored.
+// Return value is hop size after this call.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t spectralchain_set_hop_size(SpectralChainContext *const context, const size_t hop_size) {
+  return stft_set_hop_size(&context->stft, hop_size);
+}
+
+// Low-latency mode of streaming API (asymmetric windows for small FFT size such as 256 or 512, `stft.hpp`).
+// Return value is whether mode is set (FFT size must be 256 at least for low-latency mode).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool spectralchain_set_low_latency(SpectralChainContext *const context, const bool low_latency) {
+  return stft_set_low_latency(&context->stft, low_latency);
+}
+
+// Algorithmic latency of streaming API (samples). It is `fft_size - 128` by default, and `2 * hop_size - 128` in low-latency mode.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t spectralchain_get_latency(SpectralChainContext *const context) {
+  return stft_get_latency(&context->stft);
+}
+
+// Number of frames (per channel) whose transforms have been skipped because of silence (streaming API)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t spectralchain_get_number_of_skipped_frames(SpectralChainContext *const context) {
+  return context->stft.number_of_skipped_frames;
+}
+
+// Instrumentation of streaming API (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *spectralchain_profile(SpectralChainContext *const context) {
+  return &context->profile;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,354 @@
+#ifndef XSOUND_STFT_HPP
+#define XSOUND_STFT_HPP
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.hpp"
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+// Render quantum size of Web Audio API
+static const size_t render_quantum_size = 128;
+
+// Samples whose magnitude is not more than this floor (-120 dB) are regarded as silence
+static const float stft_silence_floor = 1e-6f;
+
+// Streaming STFT engine (analysis ring buffer, hop scheduling and synthesis by overlap-add).
+// Processor pushes one render quantum into `quantum_inputs` and pulls one render quantum from `quantum_outputs`,
+// so frames are neither copied into nor out of linear memory by JavaScript.
+// `quantum_inputs` and `quantum_outputs` are planar (channel `c` starts at `c * render_quantum_size`).
+//
+// `rings` holds 2 * `frame_size` per channel and every quantum is written twice (`write_offset` and `write_offset + frame_size`),
+// so the latest frame is always contiguous (no shifting).
+// `accumulators` holds `frame_size` per channel as circular buffer that starts at `read_offset`.
+//
+// `silent_lengths` is the number of the latest samples per channel that are silence (up to `frame_size`).
+// Kernels skip transforms of silent frames (the accumulators drain the tail of previous frames as it is)
+// and count them in `number_of_skipped_frames` (per channel).
+//
+// Low-latency mode (`stft_set_low_latency`, for small frames such as 256 or 512) replaces the Hanning window of kernels by asymmetric windows.
+// Synthesis window is not zero only on the latest 2 * `hop_size` samples of frame, so only them are overlap-added (`synthesis_size`),
+// and output is delayed by `2 * hop_size - 128` samples instead of `frame_size - 128` samples (`stft_get_latency`).
+typedef struct {
+  size_t frame_size;
+  size_t hop_size;
+  size_t synthesis_size;
+  size_t number_of_channels;
+  size_t write_offset;
+  size_t read_offset;
+  bool low_latency;
+  Arena arena;
+  float *quantum_inputs;
+  float *quantum_outputs;
+  float *rings;
+  float *accumulators;
+  float *analysis_window;
+  float *synthesis_window;
+  size_t *silent_lengths;
+  size_t number_of_skipped_frames;
+} STFT;
+
+// Ring buffers and accumulators are written and read by whole render quanta, so frame size must be multiple of render quantum size
+// (e.g. 1920 for mixed-radix FFT, but not 480 or 960). Otherwise, streaming API is not available (`stft_prepare` returns `false`).
+static inline bool stft_is_valid_frame_size(const size_t frame_size) {
+  return (frame_size > 0) && ((frame_size % render_quantum_size) == 0);
+}
+
+// Hop size is a power of two from render quantum size up to a quarter of frame size, and divides frame size.
+// Overlap-add of Hanning window (analysis and synthesis) has constant gain at 4x overlap or more.
+// Synthesis window of low-latency mode has constant gain at 2x overlap, so hop size is up to a half of frame size.
+static inline bool stft_is_valid_hop_size(const size_t frame_size, const size_t hop_size, const bool low_latency) {
+  const size_t overlap = low_latency ? 2 : 4;
+
+  if ((hop_size < render_quantum_size) || ((overlap * hop_size) > frame_size) || ((frame_size % hop_size) != 0)) {
+    return false;
+  }
+
+  return (hop_size & (hop_size - 1)) == 0;
+}
+
+// Periodic Hanning window of `size` samples at `n`
+static inline double stft_hanning(const size_t n, const size_t size) {
+  return 0.5 - (0.5 * cos((2.0 * M_PI * n) / size));
+}
+
+// Asymmetric windows of low-latency mode (N is `frame_size`, M is `hop_size`).
+// Analysis window rises by square root of Hanning window of 2 * (N - M) samples, and falls by square root of Hanning window of 2 * M samples on the latest M samples.
+// Product of analysis and synthesis window is Hanning window of 2 * M samples on the latest 2 * M samples (constant gain at 2x overlap),
+// and it is scaled by 3 / 4, so that frames have the same gain as Hanning analysis and synthesis (3 / 8 after overlap-add) and switching modes doesn't change level.
+static inline void stft_build_windows(STFT *const stft) {
+  const size_t frame_size = stft->frame_size;
+  const size_t hop_size   = stft->hop_size;
+
+  const size_t rise_size = frame_size - hop_size;
+  const size_t tail_size = 2 * hop_size;
+
+  for (size_t n = 0; n < frame_size; n++) {
+    const double analysis = (n < rise_size) ? sqrt(stft_hanning(n, (2 * rise_size))) : sqrt(stft_hanning((n + tail_size - frame_size), tail_size));
+
+    double synthesis = 0.0;
+
+    if (((n + tail_size) >= frame_size) && (analysis > 0.0)) {
+      synthesis = (0.75 * stft_hanning((n + tail_size - frame_size), tail_size)) / analysis;
+    }
+
+    stft->analysis_window[n]  = (float)analysis;
+    stft->synthesis_window[n] = (float)synthesis;
+  }
+}
+
+// Overlap-added samples per frame, windows of low-latency mode, and accumulators are updated by mode and hop size
+static inline void stft_update_mode(STFT *const stft) {
+  if (stft->arena.memory == nullptr) {
+    return;
+  }
+
+  stft->synthesis_size = stft->low_latency ? (2 * stft->hop_size) : stft->frame_size;
+
+  if (stft->low_latency) {
+    stft_build_windows(stft);
+  }
+
+  // Samples that are overlap-added by the previous mode are not aligned to this mode
+  memset(stft->accumulators, 0, (stft->number_of_channels * stft->frame_size * sizeof(float)));
+}
+
+static inline void stft_release(STFT *const stft);
+
+// Return value is whether streaming API is available (frame size is valid). If not, buffers are released (`nullptr`).
+static inline bool stft_prepare(STFT *const stft, const size_t frame_size, const size_t number_of_channels) {
+  if (!stft_is_valid_frame_size(frame_size)) {
+    stft_release(stft);
+    return false;
+  }
+
+  if ((stft->arena.memory != nullptr) && (stft->frame_size == frame_size) && (stft->number_of_channels == number_of_channels)) {
+    return true;
+  }
+
+  const size_t capacity = (2 * arena_size_of((number_of_channels * render_quantum_size), sizeof(float)))
+                        + arena_size_of((number_of_channels * 2 * frame_size), sizeof(float))
+                        + arena_size_of((number_of_channels * frame_size), sizeof(float))
+                        + (2 * arena_size_of(frame_size, sizeof(float)))
+                        + arena_size_of(number_of_channels, sizeof(size_t));
+
+  Arena *arena = &stft->arena;
+
+  arena_reserve(arena, capacity);
+
+  stft->quantum_inputs   = (float *)arena_alloc(arena, (number_of_channels * render_quantum_size), sizeof(float));
+  stft->quantum_outputs  = (float *)arena_alloc(arena, (number_of_channels * render_quantum_size), sizeof(float));
+  stft->rings            = (float *)arena_alloc(arena, (number_of_channels * 2 * frame_size), sizeof(float));
+  stft->accumulators     = (float *)arena_alloc(arena, (number_of_channels * frame_size), sizeof(float));
+  stft->analysis_window  = (float *)arena_alloc(arena, frame_size, sizeof(float));
+  stft->synthesis_window = (float *)arena_alloc(arena, frame_size, sizeof(float));
+  stft->silent_lengths   = (size_t *)arena_alloc(arena, number_of_channels, sizeof(size_t));
+
+  // Ring buffers are filled with zeros
+  for (size_t channel_number = 0; channel_number < number_of_channels; channel_number++) {
+    stft->silent_lengths[channel_number] = frame_size;
+  }
+
+  stft->frame_size         = frame_size;
+  stft->hop_size           = stft_is_valid_hop_size(frame_size, stft->hop_size, stft->low_latency) ? stft->hop_size : render_quantum_size;
+  stft->number_of_channels = number_of_channels;
+  stft->write_offset       = 0;
+  stft->read_offset        = 0;
+
+  stft_update_mode(stft);
+
+  return true;
+}
+
+static inline bool stft_is_prepared(const STFT *const stft) {
+  return stft->arena.memory != nullptr;
+}
+
+// Invalid hop size is ignored. Return value is hop size after this call.
+static inline size_t stft_set_hop_size(STFT *const stft, const size_t hop_size) {
+  if ((hop_size != stft->hop_size) && stft_is_valid_hop_size(stft->frame_size, hop_size, stft->low_latency)) {
+    stft->hop_size = hop_size;
+
+    // Windows of low-latency mode depend on hop size
+    if (stft->low_latency) {
+      stft_update_mode(stft);
+    }
+  }
+
+  return stft->hop_size;
+}
+
+// Hop size that is not valid for the mode falls back to render quantum size.
+// Return value is whether mode is set (frame of low-latency mode must hold 2 render quanta at least).
+static inline bool stft_set_low_latency(STFT *const stft, const bool low_latency) {
+  if (low_latency && !stft_is_valid_hop_size(stft->frame_size, render_quantum_size, true)) {
+    return false;
+  }
+
+  if (low_latency == stft->low_latency) {
+    return true;
+  }
+
+  stft->low_latency = low_latency;
+
+  if (!stft_is_valid_hop_size(stft->frame_size, stft->hop_size, low_latency)) {
+    stft->hop_size = render_quantum_size;
+  }
+
+  stft_update_mode(stft);
+
+  return true;
+}
+
+// Window that kernels multiply frame by before transform (`window` is Hanning window of kernel, that is used by default mode)
+static inline const float *stft_analysis_window(const STFT *const stft, const float *const window) {
+  return stft->low_latency ? stft->analysis_window : window;
+}
+
+// Window that kernels multiply frame by after inverse transform
+static inline const float *stft_synthesis_window(const STFT *const stft, const float *const window) {
+  return stft->low_latency ? stft->synthesis_window : window;
+}
+
+// Algorithmic latency of streaming API (samples). Output of render quantum is the input of `stft_get_latency` samples before.
+static inline size_t stft_get_latency(const STFT *const stft) {
+  return stft_is_prepared(stft) ? (stft->synthesis_size - render_quantum_size) : 0;
+}
+
+// Mode and hop size are kept (so, they are applied to buffers that are prepared again)
+static inline void stft_release(STFT *const stft) {
+  arena_release(&stft->arena);
+
+  stft->frame_size         = 0;
+  stft->synthesis_size     = 0;
+  stft->number_of_channels = 0;
+  stft->write_offset       = 0;
+  stft->read_offset        = 0;
+  stft->quantum_inputs     = nullptr;
+  stft->quantum_outputs    = nullptr;
+  stft->rings              = nullptr;
+  stft->accumulators       = nullptr;
+  stft->analysis_window    = nullptr;
+  stft->synthesis_window   = nullptr;
+  stft->silent_lengths     = nullptr;
+}
+
+// Appends `quantum_inputs` to the analysis ring buffers.
+// Return value is whether a frame is due (every `hop_size` samples).
+static inline bool stft_push(STFT *const stft) {
+  const size_t frame_size = stft->frame_size;
+
+  for (size_t channel_number = 0; channel_number < stft->number_of_channels; channel_number++) {
+    const float *quantum = stft->quantum_inputs + (channel_number * render_quantum_size);
+
+    float *ring = stft->rings + (channel_number * 2 * frame_size);
+
+    memcpy((ring + stft->write_offset), quantum, (render_quantum_size * sizeof(float)));
+    memcpy((ring + stft->write_offset + frame_size), quantum, (render_quantum_size * sizeof(float)));
+
+    // Render quantum is silent only if every sample is silent (much cheaper than transforms)
+    float peak = 0.0f;
+
+    size_t n = 0;
+
+#ifdef __wasm_simd128__
+    v128_t peaks = wasm_f32x4_splat(0.0f);
+
+    for (; (n + 4) <= render_quantum_size; n += 4) {
+      peaks = wasm_f32x4_max(peaks, wasm_f32x4_abs(wasm_v128_load(quantum + n)));
+    }
+
+    peak = fmaxf(fmaxf(wasm_f32x4_extract_lane(peaks, 0), wasm_f32x4_extract_lane(peaks, 1)), fmaxf(wasm_f32x4_extract_lane(peaks, 2), wasm_f32x4_extract_lane(peaks, 3)));
+#endif
+
+    for (; n < render_quantum_size; n++) {
+      peak = fmaxf(peak, fabsf(quantum[n]));
+    }
+
+    size_t *silent_length = stft->silent_lengths + channel_number;
+
+    if (peak > stft_silence_floor) {
+      *silent_length = 0;
+    } else if (*silent_length < frame_size) {
+      *silent_length += render_quantum_size;
+    }
+  }
+
+  stft->write_offset = (stft->write_offset + render_quantum_size) % frame_size;
+
+  return ((stft->write_offset % stft->hop_size) == 0);
+}
+
+// Latest `frame_size` samples of channel (contiguous, read only)
+static inline const float *stft_frame(const STFT *const stft, const size_t channel_number) {
+  return stft->rings + (channel_number * 2 * stft->frame_size) + stft->write_offset;
+}
+
+// Whether the latest frame of channel is silent (transforms are skipped).
+// Output of silent frame is regarded as silence, so nothing is accumulated.
+static inline bool stft_is_silent(const STFT *const stft, const size_t channel_number) {
+  return stft->silent_lengths[channel_number] >= stft->frame_size;
+}
+
+// accumulators[read_offset + n] += frame[frame_size - synthesis_size + n] / (synthesis_size / hop_size)
+// (the whole frame by default, and the latest 2 hops of frame in low-latency mode)
+static inline void stft_overlap_add(STFT *const stft, const size_t channel_number, const float *const frame) {
+  const size_t frame_size     = stft->frame_size;
+  const size_t synthesis_size = stft->synthesis_size;
+
+  const float scale = (float)stft->hop_size / (float)synthesis_size;
+
+  float *accumulator = stft->accumulators + (channel_number * frame_size);
+
+  // Circular buffer is accumulated by 2 contiguous segments (no modulo per sample)
+  const size_t head = (synthesis_size < (frame_size - stft->read_offset)) ? synthesis_size : (frame_size - stft->read_offset);
+
+  const size_t offsets[2] = { stft->read_offset, 0 };
+  const size_t lengths[2] = { head, (synthesis_size - head) };
+
+  const float *samples = frame + (frame_size - synthesis_size);
+
+  for (int segment = 0; segment < 2; segment++) {
+    float *destinations = accumulator + offsets[segment];
+
+    const size_t length = lengths[segment];
+
+    size_t n = 0;
+
+#ifdef __wasm_simd128__
+    const v128_t scales = wasm_f32x4_splat(scale);
+
+    for (; (n + 4) <= length; n += 4) {
+      wasm_v128_store(destinations + n, wasm_f32x4_add(wasm_v128_load(destinations + n), wasm_f32x4_mul(wasm_v128_load(samples + n), scales)));
+    }
+#endif
+
+    for (; n < length; n++) {
+      destinations[n] += samples[n] * scale;
+    }
+
+    samples += length;
+  }
+}
+
+// Moves the oldest render quantum of the accumulators into `quantum_outputs`
+static inline float *stft_pull(STFT *const stft) {
+  const size_t frame_size = stft->frame_size;
+
+  for (size_t channel_number = 0; channel_number < stft->number_of_channels; channel_number++) {
+    float *accumulator = stft->accumulators + (channel_number * frame_size) + stft->read_offset;
+
+    memcpy((stft->quantum_outputs + (channel_number * render_quantum_size)), accumulator, (render_quantum_size * sizeof(float)));
+    memset(accumulator, 0, (render_quantum_size * sizeof(float)));
+  }
+
+  stft->read_offset = (stft->read_offset + render_quantum_size) % frame_size;
+
+  return stft->quantum_outputs;
+}
+
+#endif
@@ -1,184 +1,510 @@
 #include "FFT.hpp"
+#include "stft.hpp"
+#include "spectral.hpp"
+#include "render.hpp"
+#include "profile.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-// Safe positive minimum on `float` (6 digits)
-static const float minimum_amplitude = 0.000001f;
+// State of vocal canceler per instance.
+// Scratch buffers (and Hanning window) are carved from the arena that is allocated once per FFT size, so processing does not allocate on steady state.
+// `outputs` is left channel data (`fft_size`) followed by right channel data (`fft_size`).
+// `stft` is used by streaming API (`vocalcanceler_stream_*`). Its channels are processed only if they are stereo.
+// `render` is used by offline rendering (`vocalcanceler_render*`), and its channels are the same as `stft`.
+typedef struct {
+  size_t fft_size;
+  Arena arena;
+  STFT stft;
+  RenderBuffers render;
+  Profile profile;
+  float *inputLs;
+  float *inputRs;
+  float *window;
+  float *reals;
+  float *imags;
+  float *outputs;
+} VocalCancelerContext;
+
+// for `vocalcancelerL`, `vocalcancelerR`, `vocalcanceler_on_spectrum`, `alloc_memory_inputLs` and `alloc_memory_inputRs` (API without context)
+static VocalCancelerContext *default_context = nullptr;
+
+static void prepare(VocalCancelerContext *const context, const size_t fft_size) {
+  if (context->fft_size == fft_size) {
+    return;
+  }
+
+  const size_t capacity = (5 * arena_size_of(fft_size, sizeof(float)))
+                        + arena_size_of((2 * fft_size), sizeof(float));
+
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, capacity);
+
+  context->inputLs = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->inputRs = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->window  = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->reals   = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->imags   = (float *)arena_alloc(arena, fft_size, sizeof(float));
+  context->outputs = (float *)arena_alloc(arena, (2 * fft_size), sizeof(float));
+
+  // Stereo unless number of channels has been set
+  stft_prepare(&context->stft, fft_size, ((context->stft.number_of_channels == 0) ? 2 : context->stft.number_of_channels));
+
+  window_function(context->window, fft_size, HANNING);
+
+  // Build FFT plans in advance
+  get_fft_plan(fft_size, FORWARD);
+  get_fft_plan(fft_size, INVERSE);
+
+  context->fft_size = fft_size;
+}
+
+// outputs[n] = inputs[n] - (depth * subtrahends[n])
+static void cancel(float *const outputs, const float *const inputs, const float *const subtrahends, const float depth, const size_t buffer_size) {
+  int n = 0;
+
+#ifdef __wasm_simd128__
+  const v128_t depths = wasm_f32x4_splat(depth);
+
+  for (; (n + 4) <= buffer_size; n += 4) {
+    wasm_v128_store(outputs + n, wasm_f32x4_sub(wasm_v128_load(inputs + n), wasm_f32x4_mul(depths, wasm_v128_load(subtrahends + n))));
+  }
+#endif
+
+  for (; n < buffer_size; n++) {
+    outputs[n] = inputs[n] - (depth * subtrahends[n]);
+  }
+}
+
+// Both channels are transformed by one complex FFT (two-for-one).
+// Left channel is packed into real part and right channel is packed into imaginary part, then spectra are separated by conjugate symmetry.
+// Z[k] = L[k] + j * R[k] -> L[k] = (Z[k] + conj(Z[N - k])) / 2, R[k] = (Z[k] - conj(Z[N - k])) / 2j
+//
+// Center components are masked by real gain per bin (`spectral_mask_center`).
+// Windows are Hanning window of context, except streaming API in low-latency mode (`stft_analysis_window` and `stft_synthesis_window`).
+static float *process_on_spectrum(VocalCancelerContext *const context, const float *const inputLs, const float *const inputRs, const float *const analysis_window, const float *const synthesis_window, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold) {
+  const size_t fft_size = context->fft_size;
+
+  float *reals   = context->reals;
+  float *imags   = context->imags;
+  float *outputs = context->outputs;
+
+  const size_t half_fft_size = fft_size / 2;
+
+  multiply_window(reals, inputLs, analysis_window, fft_size);
+  multiply_window(imags, inputRs, analysis_window, fft_size);
+
+  FFT(reals, imags, fft_size);
+
+  int min = 0;
+  int max = 0;
+
+  spectral_band(fft_size, sample_rate, min_frequency, max_frequency, &min, &max);
+
+  // Bins out of range are not changed (Z[k] and Z[N - k] are kept as they are)
+  for (int k = min; k < max; k++) {
+    // Index of Z[N - k] (mixed-radix FFT size is not a power of two, so it is not masked)
+    const size_t mirror = (k == 0) ? 0 : (fft_size - k);
+
+    const float a = reals[k];
+    const float b = imags[k];
+    const float c = reals[mirror];
+    const float d = imags[mirror];
+
+    float realL = 0.5f * (a + c);
+    float imagL = 0.5f * (b - d);
+    float realR = 0.5f * (b + d);
+    float imagR = 0.5f * (c - a);
+
+    if (!spectral_mask_center(&realL, &imagL, &realR, &imagR, threshold)) {
+      continue;
+    }
+
+    // Z[k] = L[k] + j * R[k], Z[N - k] = conj(L[k]) + j * conj(R[k])
+    // Imaginary parts of DC and Nyquist are ignored (as `IRFFT`)
+    if ((k == 0) || (k == half_fft_size)) {
+      reals[k] = realL;
+      imags[k] = realR;
+      continue;
+    }
+
+    reals[k] = realL - imagR;
+    imags[k] = imagL + realR;
+
+    reals[mirror] = realL + imagR;
+    imags[mirror] = realR - imagL;
+  }
+
+  IFFT(reals, imags, fft_size);
+
+  // Unify left channel data (real part) and right channel data (imaginary part)
+  multiply_window(outputs, reals, synthesis_window, fft_size);
+  multiply_window((outputs + fft_size), imags, synthesis_window, fft_size);
+
+  return outputs;
+}
+
+// One render quantum is pushed and pulled per call, and frames are canceled every hop.
+// Canceled frames on spectrum are mixed with input frames (`(1 - depth) * inputs + depth * canceled`).
+// If channels are not stereo or `depth` is `0`, input frames are overlap-added as they are (bypass).
+static float *process_stream(VocalCancelerContext *const context, const bool on_spectrum, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold) {
+  STFT *stft = &context->stft;
+
+  // Frame size is not valid for streaming API (`stft_prepare`)
+  if (!stft_is_prepared(stft)) {
+    return nullptr;
+  }
+
+  if (!stft_push(stft)) {
+    return stft_pull(stft);
+  }
+
+  if ((stft->number_of_channels != 2) || (depth == 0.0f)) {
+    for (size_t channel_number = 0; channel_number < stft->number_of_channels; channel_number++) {
+      if (stft_is_silent(stft, channel_number)) {
+        ++stft->number_of_skipped_frames;
+        continue;
+      }
 
-static float *inputLs  = nullptr;
-static float *inputRs  = nullptr;
-static float *outputLs = nullptr;
-static float *outputRs = nullptr;
-static float *outputs  = nullptr;
+      stft_overlap_add(stft, channel_number, stft_frame(stft, channel_number));
+    }
+
+    return stft_pull(stft);
+  }
+
+  // Both channels are transformed by one FFT, so frames are skipped only if both channels are silent
+  if (stft_is_silent(stft, 0) && stft_is_silent(stft, 1)) {
+    stft->number_of_skipped_frames += 2;
+
+    return stft_pull(stft);
+  }
+
+  const size_t fft_size = context->fft_size;
+
+  const float *frameLs = stft_frame(stft, 0);
+  const float *frameRs = stft_frame(stft, 1);
+
+  float *outputLs = context->outputs;
+  float *outputRs = context->outputs + fft_size;
+
+  if (on_spectrum) {
+    process_on_spectrum(context, frameLs, frameRs, stft_analysis_window(stft, context->window), stft_synthesis_window(stft, context->window), sample_rate, min_frequency, max_frequency, threshold);
+
+    for (size_t n = 0; n < fft_size; n++) {
+      outputLs[n] = ((1.0f - depth) * frameLs[n]) + (depth * outputLs[n]);
+      outputRs[n] = ((1.0f - depth) * frameRs[n]) + (depth * outputRs[n]);
+    }
+  } else {
+    cancel(outputLs, frameLs, frameRs, depth, fft_size);
+    cancel(outputRs, frameRs, frameLs, depth, fft_size);
+  }
+
+  stft_overlap_add(stft, 0, outputLs);
+  stft_overlap_add(stft, 1, outputRs);
+
+  return stft_pull(stft);
+}
+
+// Offline rendering (shared by jobs, read only)
+typedef struct {
+  bool on_spectrum;
+  float depth;
+  float sample_rate;
+  float min_frequency;
+  float max_frequency;
+  float threshold;
+} VocalCancelerRenderParameters;
+
+typedef struct {
+  const VocalCancelerContext *context;
+  const float *inputs;
+  float *outputs;
+  size_t length;
+  VocalCancelerRenderParameters parameters;
+} VocalCancelerRenderArgument;
+
+static float *render_process(void *const worker, const void *const parameters_pointer) {
+  const VocalCancelerRenderParameters *parameters = (const VocalCancelerRenderParameters *)parameters_pointer;
+
+  return process_stream((VocalCancelerContext *)worker, parameters->on_spectrum, parameters->depth, parameters->sample_rate, parameters->min_frequency, parameters->max_frequency, parameters->threshold);
+}
+
+// Each job streams all channels (left and right are canceled together) through private context (FFT plans have been built by `context`)
+static void render_job(const void *const argument_pointer, RenderJob *const job) {
+  const VocalCancelerRenderArgument *argument = (const VocalCancelerRenderArgument *)argument_pointer;
+
+  VocalCancelerContext *worker = (VocalCancelerContext *)calloc(1, sizeof(VocalCancelerContext));
+
+  stft_prepare(&worker->stft, argument->context->fft_size, job->number_of_channels);
+
+  prepare(worker, argument->context->fft_size);
+
+  stft_set_low_latency(&worker->stft, argument->context->stft.low_latency);
+  stft_set_hop_size(&worker->stft, argument->context->stft.hop_size);
+
+  render_stream(job, &worker->stft, worker, render_process, &argument->parameters, argument->inputs, argument->outputs, argument->length);
+
+  arena_release(&worker->arena);
+  stft_release(&worker->stft);
+
+  free(worker);
+}
+
+static float *render_channels(VocalCancelerContext *const context, const size_t length, const VocalCancelerRenderParameters *const parameters, const size_t number_of_threads) {
+  const size_t number_of_channels = context->stft.number_of_channels;
+
+  if (!stft_is_prepared(&context->stft) || ((number_of_channels * length) > context->render.capacity)) {
+    return nullptr;
+  }
+
+  const VocalCancelerRenderArgument argument = { context, context->render.inputs, context->render.outputs, length, *parameters };
+
+  context->stft.number_of_skipped_frames += render(render_job, &argument, number_of_channels, number_of_channels, length, context->fft_size, number_of_threads, true);
+
+  return context->render.outputs;
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-static inline float complex_abs(const float real, const float imag) {
-  return sqrtf(powf(real, 2.0f) + powf(imag, 2.0f));
-}
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+VocalCancelerContext *vocalcanceler_create(const size_t fft_size) {
+  VocalCancelerContext *context = (VocalCancelerContext *)calloc(1, sizeof(VocalCancelerContext));
+
+  prepare(context, fft_size);
 
-static inline float complex_arg(const float real, const float imag) {
-  return atan2f(imag, real);
+  return context;
 }
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
-float *vocalcancelerL(const float depth, const size_t buffer_size) {
-  if (outputLs) {
-    free(outputLs);
+#endif
+void vocalcanceler_destroy(VocalCancelerContext *const context) {
+  if (context == nullptr) {
+    return;
   }
 
-  outputLs = (float *)calloc(buffer_size, sizeof(float));
+  arena_release(&context->arena);
+  stft_release(&context->stft);
+  render_release(&context->render);
+  profile_release(&context->profile);
 
-  for (int n = 0; n < buffer_size; n++) {
-    outputLs[n] = inputLs[n] - (depth * inputRs[n]);
-  }
+  free(context);
+}
 
-  return outputLs;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_inputLs(VocalCancelerContext *const context) {
+  return context->inputLs;
 }
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
 #endif
+float *vocalcanceler_inputRs(VocalCancelerContext *const context) {
+  return context->inputRs;
+}
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
-float *vocalcancelerR(const float depth, const size_t buffer_size) {
-  if (outputRs) {
-    free(outputRs);
-  }
+#endif
+float *vocalcanceler_process(VocalCancelerContext *const context, const float depth) {
+  const size_t fft_size = context->fft_size;
 
-  outputRs = (float *)calloc(buffer_size, sizeof(float));
+  cancel(context->outputs, context->inputLs, context->inputRs, depth, fft_size);
+  cancel((context->outputs + fft_size), context->inputRs, context->inputLs, depth, fft_size);
 
-  for (int n = 0; n < buffer_size; n++) {
-    outputRs[n] = inputRs[n] - (depth * inputLs[n]);
-  }
+  return context->outputs;
+}
 
-  return outputRs;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_process_on_spectrum(VocalCancelerContext *const context, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold) {
+  return process_on_spectrum(context, context->inputLs, context->inputRs, context->window, context->window, sample_rate, min_frequency, max_frequency, threshold);
 }
+
+// Number of channels of streaming API (render quanta are reallocated, so pointer by `vocalcanceler_stream_inputs` must be got again)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
 #endif
+void vocalcanceler_set_number_of_channels(VocalCancelerContext *const context, const size_t number_of_channels) {
+  stft_prepare(&context->stft, context->fft_size, number_of_channels);
+}
 
+// Planar render quantum (channel `c` starts at `c * 128`).
+// Streaming API needs FFT size that is multiple of 128, otherwise this and `vocalcanceler_stream_process*` return `nullptr`.
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
-float *vocalcanceler_on_spectrum(const float sample_rate, const float min_frequency, const float max_frequency, const float threshold, const size_t fft_size) {
-  if (outputs) {
-    free(outputs);
-  }
+#endif
+float *vocalcanceler_stream_inputs(VocalCancelerContext *const context) {
+  return context->stft.quantum_inputs;
+}
 
-  float *realLs = (float *)calloc(fft_size, sizeof(float));
-  float *realRs = (float *)calloc(fft_size, sizeof(float));
-  float *imagLs = (float *)calloc(fft_size, sizeof(float));
-  float *imagRs = (float *)calloc(fft_size, sizeof(float));
+// Planar render quantum of outputs (the same pointer that `vocalcanceler_stream_process*` returns).
+// Pointers of render quanta are fixed until the number of channels is changed (`get_memory_generation`).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_stream_outputs(VocalCancelerContext *const context) {
+  return context->stft.quantum_outputs;
+}
 
-  float *window = (float *)calloc(fft_size, sizeof(float));
+// Output is delayed by `vocalcanceler_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_stream_process(VocalCancelerContext *const context, const float depth) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
 
-  window_function(window, fft_size, HANNING);
+  float *outputs = process_stream(context, false, depth, 0.0f, 0.0f, 0.0f, 0.0f);
 
-  for (int n = 0; n < fft_size; n++) {
-    realLs[n] = window[n] * inputLs[n];
-    realRs[n] = window[n] * inputRs[n];
-    imagLs[n] = 0.0f;
-    imagRs[n] = 0.0f;
-  }
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
 
-  FFT(realLs, imagLs, fft_size);
-  FFT(realRs, imagRs, fft_size);
+  return outputs;
+}
 
-  float *absLs = (float *)calloc(fft_size, sizeof(float));
-  float *absRs = (float *)calloc(fft_size, sizeof(float));
-  float *argLs = (float *)calloc(fft_size, sizeof(float));
-  float *argRs = (float *)calloc(fft_size, sizeof(float));
+// Output is delayed by `vocalcanceler_get_latency` samples (planar render quantum)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_stream_process_on_spectrum(VocalCancelerContext *const context, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold) {
+  const ProfileScope scope = profile_begin(&context->profile, context->stft.number_of_skipped_frames);
 
-  for (int k = 0; k < fft_size; k++) {
-    absLs[k] = complex_abs(realLs[k], imagLs[k]);
-    absRs[k] = complex_abs(realRs[k], imagRs[k]);
-    argLs[k] = complex_arg(realLs[k], imagLs[k]);
-    argRs[k] = complex_arg(realRs[k], imagRs[k]);
-  }
+  float *outputs = process_stream(context, true, depth, sample_rate, min_frequency, max_frequency, threshold);
 
-  int min = (int)(min_frequency * (fft_size / sample_rate));
-  int max = (int)(max_frequency * (fft_size / sample_rate));
+  profile_end(&context->profile, scope, context->stft.number_of_skipped_frames);
 
-  for (int k = min; k < max; k++) {
-    float numerator   = powf((absLs[k] - absRs[k]), 2.0f);
-    float denominator = powf((absLs[k] + absRs[k]), 2.0f);
+  return outputs;
+}
 
-    if (denominator != 0.0f) {
-      float diff = numerator / denominator;
+// Planar signal of `length` samples per channel for offline rendering (channel `c` starts at `c * length`)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_render_inputs(VocalCancelerContext *const context, const size_t length) {
+  return render_reserve(&context->render, (context->stft.number_of_channels * length));
+}
 
-      if (diff < threshold) {
-        absLs[k] = minimum_amplitude;
-        absRs[k] = minimum_amplitude;
+// Renders the whole signal by `vocalcanceler_render_inputs` on `number_of_threads` threads (`0` is the number of logical cores).
+// Output is planar, and it is bit-identical to streaming API on new context (delayed by `vocalcanceler_get_latency` samples).
+// Skipped frames are counted as streaming API.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_render(VocalCancelerContext *const context, const size_t length, const float depth, const size_t number_of_threads) {
+  const VocalCancelerRenderParameters parameters = { false, depth, 0.0f, 0.0f, 0.0f, 0.0f };
 
-        absLs[fft_size - k] = absLs[k];
-        absRs[fft_size - k] = absRs[k];
-      }
-    }
-  }
+  return render_channels(context, length, &parameters, number_of_threads);
+}
 
-  // Euler's formula
-  // abs * exp(j * arg) = abs * (cos(arg) + j * sin(arg))
-  for (int k = 0; k < fft_size; k++) {
-    realLs[k] = absLs[k] * cosf(argLs[k]);
-    realRs[k] = absRs[k] * cosf(argRs[k]);
-    imagLs[k] = absLs[k] * sinf(argLs[k]);
-    imagRs[k] = absRs[k] * sinf(argRs[k]);
-  }
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_render_on_spectrum(VocalCancelerContext *const context, const size_t length, const float depth, const float sample_rate, const float min_frequency, const float max_frequency, const float threshold, const size_t number_of_threads) {
+  const VocalCancelerRenderParameters parameters = { true, depth, sample_rate, min_frequency, max_frequency, threshold };
 
-  free(absLs);
-  free(absRs);
-  free(argLs);
-  free(argRs);
+  return render_channels(context, length, &parameters, number_of_threads);
+}
 
-  IFFT(realLs, imagLs, fft_size);
-  IFFT(realRs, imagRs, fft_size);
+// Low-latency mode of streaming API (asymmetric windows for small FFT size such as 256 or 512, `stft.hpp`).
+// Return value is whether mode is set (FFT size must be 256 at least for low-latency mode).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool vocalcanceler_set_low_latency(VocalCancelerContext *const context, const bool low_latency) {
+  return stft_set_low_latency(&context->stft, low_latency);
+}
 
-  // Unify left channel data and right channel data
-  outputs = (float *)calloc((2 * fft_size), sizeof(float));
+// Algorithmic latency of streaming API (samples). It is `fft_size - 128` by default, and `2 * hop_size - 128` in low-latency mode.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t vocalcanceler_get_latency(VocalCancelerContext *const context) {
+  return stft_get_latency(&context->stft);
+}
 
-  for (int n = 0; n < fft_size; n++) {
-    outputs[n] = window[n] * realLs[n];
-  }
+// Number of frames (per channel) whose transforms have been skipped because of silence (streaming API)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t vocalcanceler_get_number_of_skipped_frames(VocalCancelerContext *const context) {
+  return context->stft.number_of_skipped_frames;
+}
 
-  for (int n = 0; n < fft_size; n++) {
-    outputs[fft_size + n] = window[n] * realRs[n];
-  }
+// Instrumentation of streaming API (`profile.hpp`). Pointer is valid until context is destroyed.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+Profile *vocalcanceler_profile(VocalCancelerContext *const context) {
+  return &context->profile;
+}
 
-  free(realLs);
-  free(realRs);
-  free(imagLs);
-  free(imagRs);
-  free(window);
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcancelerL(const float depth, const size_t buffer_size) {
+  float *outputLs = default_context->outputs;
 
-  return outputs;
+  cancel(outputLs, default_context->inputLs, default_context->inputRs, depth, buffer_size);
+
+  return outputLs;
 }
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
 #endif
+float *vocalcancelerR(const float depth, const size_t buffer_size) {
+  float *outputRs = default_context->outputs + default_context->fft_size;
+
+  cancel(outputRs, default_context->inputRs, default_context->inputLs, depth, buffer_size);
+
+  return outputRs;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *vocalcanceler_on_spectrum(const float sample_rate, const float min_frequency, const float max_frequency, const float threshold, const size_t fft_size) {
+  if (default_context == nullptr) {
+    default_context = vocalcanceler_create(fft_size);
+  }
+
+  prepare(default_context, fft_size);
+
+  return process_on_spectrum(default_context, default_context->inputLs, default_context->inputRs, default_context->window, default_context->window, sample_rate, min_frequency, max_frequency, threshold);
+}
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_inputLs(const size_t buffer_size) {
-  if (inputLs) {
-    free(inputLs);
+  if (default_context == nullptr) {
+    default_context = vocalcanceler_create(buffer_size);
   }
 
-  inputLs = (float *)calloc(buffer_size, sizeof(float));
+  prepare(default_context, buffer_size);
 
-  return inputLs;
+  return default_context->inputLs;
 }
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_inputRs(const size_t buffer_size) {
-  if (inputRs) {
-    free(inputRs);
+  if (default_context == nullptr) {
+    default_context = vocalcanceler_create(buffer_size);
   }
 
-  inputRs = (float *)calloc(buffer_size, sizeof(float));
+  prepare(default_context, buffer_size);
 
-  return inputRs;
+  return default_context->inputRs;
 }
 
 #ifdef __cplusplus
@@ -1,5 +1,10 @@
+import type { HarmonizerProcessorParams } from './AudioWorkletProcessors/HarmonizerProcessor';
+import type { Compensable, Profilable } from '../../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
 import { Effector } from './Effector';
-import { PitchShifter } from './PitchShifter';
+import { HarmonizerProcessor } from './AudioWorkletProcessors/HarmonizerProcessor';
+import { compileDSPModule, queryDSPLatency, queryDSPProfile } from '../../XSound';
 
 export type HarmonizerType = 'harmony' | 'octave' | 'detune';
 export type HarmonizerMode = 'major' | 'minor';
@@ -15,14 +20,19 @@ export type HarmonizerParams = {
 
 /**
  * Effector's subclass for Harmonizer.
+ * Voices are shifted by one `AudioWorkletNode` (pitch shifter's WebAssembly Module), so that they share one analysis (FFT) per frame.
  */
-export class Harmonizer extends Effector {
+export class Harmonizer extends Effector implements Profilable, Compensable {
+  private static readonly FRAME_SIZE = 2048;
+
   private static readonly indexes: [0, 1] = [0, 1];
 
+  private processor: AudioWorkletNode;
+
   private type: HarmonizerType = 'harmony';
   private mode: HarmonizerMode = 'major';
   private shifts: [number, number] = [1, 1];
-  private pitchShifters: [PitchShifter, PitchShifter];
+  private pitches: [number, number] = [1, 1];
   private dry = 1;
   private wets: [number, number] = [0, 0];
 
@@ -32,12 +42,25 @@ export class Harmonizer extends Effector {
   constructor(context: AudioContext) {
     super(context);
 
-    this.pitchShifters = [new PitchShifter(context), new PitchShifter(context)];
-
-    Harmonizer.indexes.forEach((index: 0 | 1) => {
-      this.pitchShifters[index].param({ pitch: this.shifts[index], dry: this.dry, wet: this.wets[index] });
+    this.processor = new AudioWorkletNode(this.context, HarmonizerProcessor.name, {
+      processorOptions: {
+        frameSize: Harmonizer.FRAME_SIZE
+      }
     });
 
+    const message: HarmonizerProcessorParams = { pitches: this.pitches, dry: this.dry, wets: this.wets };
+
+    this.processor.port.postMessage(message);
+
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
+      })
+      .catch((error: Error) => {
+        throw error;
+      });
+
     // `Harmonizer` is not connected by default
     this.deactivate();
   }
@@ -54,17 +77,12 @@ export class Harmonizer extends Effector {
   public override connect(): GainNode {
     // Clear connection
     this.input.disconnect(0);
-
-    Harmonizer.indexes.forEach((index: 0 | 1) => {
-      this.pitchShifters[index].OUTPUT.disconnect(0);
-    });
+    this.processor.disconnect(0);
 
     if (this.isActive) {
-      // GainNode (Input) -> Pitch Shifter -> GainNode (Output);
-      Harmonizer.indexes.forEach((index: 0 | 1) => {
-        this.input.connect(this.pitchShifters[index].INPUT);
-        this.pitchShifters[index].OUTPUT.connect(this.output);
-      });
+      // GainNode (Input) -> AudioWorkletNode (Pitch Shifter of voices) -> GainNode (Output);
+      this.input.connect(this.processor);
+      this.processor.connect(this.output);
     } else {
       // GainNode (Input) -> GainNode (Output)
       this.input.connect(this.output);
@@ -162,9 +180,9 @@ export class Harmonizer extends Effector {
           if (typeof value === 'number') {
             this.dry = value;
 
-            Harmonizer.indexes.forEach((index: 0 | 1) => {
-              this.pitchShifters[index].param({ dry: this.dry });
-            });
+            const message: HarmonizerProcessorParams = { dry: this.dry };
+
+            this.processor.port.postMessage(message);
           }
 
           break;
@@ -174,9 +192,9 @@ export class Harmonizer extends Effector {
           if (Array.isArray(value) && (value.length === 2)) {
             this.wets = value;
 
-            Harmonizer.indexes.forEach((index: 0 | 1) => {
-              this.pitchShifters[index].param({ wet: this.wets[index] });
-            });
+            const message: HarmonizerProcessorParams = { wets: this.wets };
+
+            this.processor.port.postMessage(message);
           }
 
           break;
@@ -211,8 +229,7 @@ export class Harmonizer extends Effector {
             const pitch3 = 1 + (400 / 1200);
             const pitch5 = 1 + (700 / 1200);
 
-            this.pitchShifters[0].param({ pitch: pitch3 });
-            this.pitchShifters[1].param({ pitch: pitch5 });
+            this.pitches = [pitch3, pitch5];
 
             break;
           }
@@ -221,8 +238,7 @@ export class Harmonizer extends Effector {
             const pitch3 = 1 + (300 / 1200);
             const pitch5 = 1 + (700 / 1200);
 
-            this.pitchShifters[0].param({ pitch: pitch3 });
-            this.pitchShifters[1].param({ pitch: pitch5 });
+            this.pitches = [pitch3, pitch5];
 
             break;
           }
@@ -236,7 +252,7 @@ export class Harmonizer extends Effector {
           const octave = Math.abs(Math.trunc(this.shifts[index]));
           const pitch  = (this.shifts[index] >= 0) ? (1 + octave) : (1 / (2 ** octave));
 
-          this.pitchShifters[index].param({ pitch });
+          this.pitches[index] = pitch;
         });
 
         break;
@@ -247,13 +263,52 @@ export class Harmonizer extends Effector {
           const detune = Math.abs(this.shifts[index] / 1200);
           const pitch  = (this.shifts[index] >= 0) ? (1 + detune) : (1 / (2 ** detune));
 
-          this.pitchShifters[index].param({ pitch });
+          this.pitches[index] = pitch;
         });
 
         break;
       }
     }
 
+    const message: HarmonizerProcessorParams = { pitches: this.pitches };
+
+    this.processor.port.postMessage(message);
+
     return this;
   }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {Harmonizer} Return value is for method chain.
+   */
+  public profile(enabled: boolean): Harmonizer {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (in order to compensate delay of parallel paths).
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds, `0` until processor is ready).
+   */
+  public latency(): Promise<number> {
+    // If not active, processor is not connected
+    if (!this.isActive) {
+      return Promise.resolve(0);
+    }
+
+    return queryDSPLatency(this.processor)
+      .then((latency: number | null) => (latency ?? 0) / this.context.sampleRate);
+  }
 }
@@ -1,8 +1,9 @@
+import type { Profilable } from '../../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
 import { Effector } from './Effector';
 import { NoiseGateProcessor } from './AudioWorkletProcessors/NoiseGateProcessor';
-
-// @ts-expect-error Because of import WebAssembly Module
-import wasm from './AudioWorkletProcessors/WebAssemblyModules/noisegate.wasm';
+import { compileDSPModule, queryDSPProfile } from '../../XSound';
 
 export type NoiseGateParams = {
   state?: boolean,
@@ -12,7 +13,7 @@ export type NoiseGateParams = {
 /**
  * This private class is for Noise Gate.
  */
-export class NoiseGate extends Effector {
+export class NoiseGate extends Effector implements Profilable {
   private processor: AudioWorkletNode;
 
   private level = 0;
@@ -25,11 +26,10 @@ export class NoiseGate extends Effector {
 
     this.processor = new AudioWorkletNode(this.context, NoiseGateProcessor.name);
 
-    fetch(wasm)
-      .then(async (response) => {
-        const wasm = await response.arrayBuffer();
-
-        this.processor.port.postMessage(wasm);
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
         this.activate();
       })
       .catch((error: Error) => {
@@ -123,4 +123,25 @@ export class NoiseGate extends Effector {
       level: this.level
     };
   }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {NoiseGate} Return value is for method chain.
+   */
+  public profile(enabled: boolean): NoiseGate {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
 }
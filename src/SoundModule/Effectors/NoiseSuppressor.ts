@@ -1,20 +1,29 @@
+import type { SpectralChain, SpectralEffector, SpectralStageParams } from './SpectralChain';
+import type { Compensable, Profilable } from '../../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
 import { Effector } from './Effector';
 import { NoiseSuppressorProcessor } from './AudioWorkletProcessors/NoiseSuppressorProcessor';
-
-// @ts-expect-error Because of import WebAssembly Module
-import wasm from './AudioWorkletProcessors/WebAssemblyModules/noisesuppressor.wasm';
+import { compileDSPModule, queryDSPLatency, queryDSPProfile } from '../../XSound';
 
 export type NoiseSuppressorParams = {
   state?: boolean,
-  threshold?: number
+  threshold?: number,
+  lowLatency?: boolean
 };
 
 /**
  * This private class is for Noise Suppressor.
  */
-export class NoiseSuppressor extends Effector {
+export class NoiseSuppressor extends Effector implements SpectralEffector, Profilable, Compensable {
   private processor: AudioWorkletNode;
 
+  // Spectral chain that this effector is fused into (then, `processor` is not connected)
+  private chain: SpectralChain | null = null;
+
+  // Small frame (512 samples) and asymmetric windows (algorithmic latency is 128 samples). Then, this effector is not fused
+  private lowLatency = false;
+
   private threshold = 0;
 
   /**
@@ -29,11 +38,10 @@ export class NoiseSuppressor extends Effector {
       }
     });
 
-    fetch(wasm)
-      .then(async (response) => {
-        const wasm = await response.arrayBuffer();
-
-        this.processor.port.postMessage(wasm);
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
         this.activate();
       })
       .catch((error: Error) => {
@@ -64,6 +72,11 @@ export class NoiseSuppressor extends Effector {
       this.input.connect(this.output);
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this.output;
   }
 
@@ -75,6 +88,7 @@ export class NoiseSuppressor extends Effector {
    */
   public param(params: 'state'): boolean;
   public param(params: 'threshold'): number;
+  public param(params: 'lowLatency'): boolean;
   public param(params: NoiseSuppressorParams): NoiseSuppressor;
   public param(params: keyof NoiseSuppressorParams | NoiseSuppressorParams): NoiseSuppressorParams[keyof NoiseSuppressorParams] | NoiseSuppressor {
     if (typeof params === 'string') {
@@ -86,6 +100,10 @@ export class NoiseSuppressor extends Effector {
         case 'threshold': {
           return this.threshold;
         }
+
+        case 'lowLatency': {
+          return this.lowLatency;
+        }
       }
     }
 
@@ -116,17 +134,88 @@ export class NoiseSuppressor extends Effector {
 
           break;
         }
+
+        case 'lowLatency': {
+          if (typeof value === 'boolean') {
+            this.lowLatency = value;
+
+            const message: NoiseSuppressorParams = { lowLatency: value };
+
+            this.processor.port.postMessage(message);
+          }
+
+          break;
+        }
       }
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this;
   }
 
   /** @override */
   public override params(): Required<NoiseSuppressorParams> {
     return {
-      state    : this.isActive,
-      threshold: this.threshold
+      state     : this.isActive,
+      threshold : this.threshold,
+      lowLatency: this.lowLatency
     };
   }
+
+  /** @override */
+  public stage(): SpectralStageParams | null {
+    // Low-latency mode has its own frame, so it is not fused
+    if (this.lowLatency) {
+      return null;
+    }
+
+    return {
+      type     : 'noisesuppressor',
+      threshold: this.isActive ? this.threshold : 0
+    };
+  }
+
+  /** @override */
+  public fuse(chain: SpectralChain | null): void {
+    this.chain = chain;
+  }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {NoiseSuppressor} Return value is for method chain.
+   */
+  public profile(enabled: boolean): NoiseSuppressor {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (in order to compensate delay of parallel paths).
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds, `0` until processor is ready).
+   */
+  public latency(): Promise<number> {
+    // If not active, processor is not connected. If fused, latency is reported by spectral chain
+    if (!this.isActive || ((this.chain !== null) && this.chain.isFused())) {
+      return Promise.resolve(0);
+    }
+
+    return queryDSPLatency(this.processor)
+      .then((latency: number | null) => (latency ?? 0) / this.context.sampleRate);
+  }
 }
@@ -1,42 +1,65 @@
+import type { SpectralChain, SpectralEffector, SpectralStageParams } from './SpectralChain';
+import type { Compensable, Profilable } from '../../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
 import { Effector } from './Effector';
 import { PitchShifterProcessor } from './AudioWorkletProcessors/PitchShifterProcessor';
+import { compileDSPModule, queryDSPLatency, queryDSPProfile } from '../../XSound';
 
-// @ts-expect-error Because of import WebAssembly Module
-import wasm from './AudioWorkletProcessors/WebAssemblyModules/pitchshifter.wasm';
+export type PitchShifterAlgorithm = 'peak' | 'vocoder';
 
 export type PitchShifterParams = {
   state?: boolean,
+  algorithm?: PitchShifterAlgorithm,
   pitch?: number,
   speed?: number,
   dry?: number,
-  wet?: number
+  wet?: number,
+  hopSize?: number,
+  lowLatency?: boolean
 };
 
 /**
  * Effector's subclass for Pitch Shifter.
  */
-export class PitchShifter extends Effector {
+export class PitchShifter extends Effector implements SpectralEffector, Profilable, Compensable {
+  private static readonly FRAME_SIZE = 2048;
+  private static readonly LOW_LATENCY_FRAME_SIZE = 512;
+
   private processor: AudioWorkletNode;
 
+  // Spectral chain that this effector is fused into (then, `processor` is not connected)
+  private chain: SpectralChain | null = null;
+
+  // Small frame (512 samples) and asymmetric windows (algorithmic latency is 128 samples). Then, this effector is not fused
+  private lowLatency = false;
+
+  private algorithm: PitchShifterAlgorithm = 'peak';
   private pitch = 1;
   private speed = 1;
 
   private dry = 0;
   private wet = 1;
 
+  // Overlap is `FRAME_SIZE / hopSize` (16x by default, `LOW_LATENCY_FRAME_SIZE / hopSize` in low-latency mode)
+  private hopSize = 128;
+
   /**
    * @param {AudioContext} context This argument is in order to use Web Audio API.
    */
   constructor(context: AudioContext) {
     super(context);
 
-    this.processor = new AudioWorkletNode(this.context, PitchShifterProcessor.name);
-
-    fetch(wasm)
-      .then(async (response) => {
-        const wasm = await response.arrayBuffer();
+    this.processor = new AudioWorkletNode(this.context, PitchShifterProcessor.name, {
+      processorOptions: {
+        frameSize: PitchShifter.FRAME_SIZE
+      }
+    });
 
-        this.processor.port.postMessage(wasm);
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
         this.activate();
       })
       .catch((error: Error) => {
@@ -67,6 +90,11 @@ export class PitchShifter extends Effector {
       this.input.connect(this.output);
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this.output;
   }
 
@@ -78,10 +106,13 @@ export class PitchShifter extends Effector {
    *     Otherwise, return value is for method chain.
    */
   public param(params: 'state'): boolean;
+  public param(params: 'algorithm'): PitchShifterAlgorithm;
   public param(params: 'pitch'): number;
   public param(params: 'speed'): number;
   public param(params: 'dry'): number;
   public param(params: 'wet'): number;
+  public param(params: 'hopSize'): number;
+  public param(params: 'lowLatency'): boolean;
   public param(params: PitchShifterParams): PitchShifter;
   public param(params: keyof PitchShifterParams | PitchShifterParams): PitchShifterParams[keyof PitchShifterParams] | PitchShifter {
     if (typeof params === 'string') {
@@ -90,6 +121,10 @@ export class PitchShifter extends Effector {
           return this.isActive;
         }
 
+        case 'algorithm': {
+          return this.algorithm;
+        }
+
         case 'pitch': {
           return this.pitch;
         }
@@ -105,6 +140,14 @@ export class PitchShifter extends Effector {
         case 'wet': {
           return this.wet;
         }
+
+        case 'hopSize': {
+          return this.hopSize;
+        }
+
+        case 'lowLatency': {
+          return this.lowLatency;
+        }
       }
     }
 
@@ -122,6 +165,18 @@ export class PitchShifter extends Effector {
           break;
         }
 
+        case 'algorithm': {
+          if (typeof value === 'string') {
+            this.algorithm = value;
+
+            const message: PitchShifterParams = { algorithm: value };
+
+            this.processor.port.postMessage(message);
+          }
+
+          break;
+        }
+
         case 'pitch': {
           if (typeof value === 'number') {
             if (value > 0) {
@@ -177,20 +232,124 @@ export class PitchShifter extends Effector {
 
           break;
         }
+
+        case 'hopSize': {
+          if (typeof value === 'number') {
+            // Power of two from render quantum size (128) to a quarter of frame size (4x overlap, or 2x overlap of low-latency mode)
+            const maxHopSize = this.lowLatency ? (PitchShifter.LOW_LATENCY_FRAME_SIZE / 2) : (PitchShifter.FRAME_SIZE / 4);
+
+            if ((value >= 128) && (value <= maxHopSize) && ((value & (value - 1)) === 0)) {
+              this.hopSize = value;
+
+              const message: PitchShifterParams = { hopSize: value };
+
+              this.processor.port.postMessage(message);
+            }
+          }
+
+          break;
+        }
+
+        case 'lowLatency': {
+          if (typeof value === 'boolean') {
+            this.lowLatency = value;
+
+            // Hop size must be valid for frame of low-latency mode
+            if (this.lowLatency && (this.hopSize > (PitchShifter.LOW_LATENCY_FRAME_SIZE / 2))) {
+              this.hopSize = 128;
+            }
+
+            const message: PitchShifterParams = { lowLatency: value, hopSize: this.hopSize };
+
+            this.processor.port.postMessage(message);
+          }
+
+          break;
+        }
       }
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this;
   }
 
   /** @override */
   public override params(): Required<PitchShifterParams> {
     return {
-      state: this.isActive,
-      pitch: this.pitch,
-      speed: this.speed,
-      dry  : this.dry,
-      wet  : this.wet
+      state     : this.isActive,
+      algorithm : this.algorithm,
+      pitch     : this.pitch,
+      speed     : this.speed,
+      dry       : this.dry,
+      wet       : this.wet,
+      hopSize   : this.hopSize,
+      lowLatency: this.lowLatency
     };
   }
+
+  /** @override */
+  public stage(): SpectralStageParams | null {
+    // Low-latency mode has its own frame, so it is not fused
+    if (this.lowLatency) {
+      return null;
+    }
+
+    // Phase vocoder carries phases over frames, so it is not fused
+    if (this.algorithm !== 'peak') {
+      return null;
+    }
+
+    return {
+      type   : 'pitchshifter',
+      pitch  : this.isActive ? this.pitch : 1,
+      speed  : this.isActive ? this.speed : 1,
+      dry    : this.dry,
+      wet    : this.wet,
+      hopSize: this.hopSize
+    };
+  }
+
+  /** @override */
+  public fuse(chain: SpectralChain | null): void {
+    this.chain = chain;
+  }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {PitchShifter} Return value is for method chain.
+   */
+  public profile(enabled: boolean): PitchShifter {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (in order to compensate delay of parallel paths).
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds, `0` until processor is ready).
+   */
+  public latency(): Promise<number> {
+    // If not active, processor is not connected. If fused, latency is reported by spectral chain
+    if (!this.isActive || ((this.chain !== null) && this.chain.isFused())) {
+      return Promise.resolve(0);
+    }
+
+    return queryDSPLatency(this.processor)
+      .then((latency: number | null) => (latency ?? 0) / this.context.sampleRate);
+  }
 }
@@ -0,0 +1,279 @@
+import type { Compensable, Connectable, Profilable } from '../../interfaces';
+import type { VocalCancelerAlgorithm } from './VocalCanceler';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
+import { Effector } from './Effector';
+import { SpectralChainProcessor } from './AudioWorkletProcessors/SpectralChainProcessor';
+import { compileDSPModule, queryDSPLatency, queryDSPProfile } from '../../XSound';
+
+export type SpectralStageParams = {
+  type: 'noisesuppressor',
+  threshold: number
+} | {
+  type: 'vocalcanceler',
+  algorithm: VocalCancelerAlgorithm,
+  depth: number,
+  minFrequency: number,
+  maxFrequency: number,
+  threshold: number
+} | {
+  type: 'pitchshifter',
+  pitch: number,
+  speed: number,
+  dry: number,
+  wet: number,
+  hopSize: number
+};
+
+export type SpectralChainParams = {
+  hopSize?: number,
+  stages?: SpectralStageParams[]
+};
+
+/**
+ * This interface is implemented by effector that is processed on spectrum (such as `NoiseSuppressor` class).
+ * Adjacent spectral effectors are fused into `SpectralChain` by `SoundModule`.
+ * @interface
+ */
+export interface SpectralEffector extends Connectable {
+  /**
+   * This method gets stage for spectral chain (bypass if not active). If returns `null`, effector can't be fused (then, effectors are connected in series).
+   * @return {SpectralStageParams|null}
+   */
+  stage(): SpectralStageParams | null;
+
+  /**
+   * This method sets spectral chain that effector is fused into (`null` if not fused).
+   * @param {SpectralChain|null} chain This argument is instance of `SpectralChain` or `null`.
+   */
+  fuse(chain: SpectralChain | null): void;
+}
+
+/**
+ * This function determines whether module is spectral effector.
+ * @param {Connectable} module This argument is module in connection.
+ * @return {boolean}
+ */
+export const isSpectralEffector = (module: Connectable): module is SpectralEffector => {
+  return ('stage' in module) && ('fuse' in module);
+};
+
+/**
+ * Effector's subclass for fused spectral effectors.
+ * Stages of adjacent spectral effectors (noise suppressor, vocal canceler, pitch shifter) are processed by one analysis (FFT) and one synthesis (IFFT) per hop.
+ * Spectra of stages are mixed on spectrum, while dry components (depth of vocal canceler on time domain, dry of pitch shifter) are mixed on time domain at synthesis.
+ * Frame size is the largest of fused effectors, and every stage is processed by hop size of chain (hop size of pitch shifter, otherwise 128).
+ * So, noise suppressor or vocal canceler that is fused with pitch shifter of larger hop size doesn't have the same output as standalone effector (that is processed every 128 samples).
+ * Until WebAssembly Module is instantiated (or if either effector can't be fused), effectors are connected in series.
+ */
+export class SpectralChain extends Effector implements Profilable, Compensable {
+  private static readonly FRAME_SIZE = 2048;
+
+  private processor: AudioWorkletNode;
+
+  private effectors: SpectralEffector[] = [];
+
+  private loaded = false;
+  private fused = false;
+
+  private hopSize = 128;
+  private stages: SpectralStageParams[] = [];
+
+  /**
+   * @param {AudioContext} context This argument is in order to use Web Audio API.
+   */
+  constructor(context: AudioContext) {
+    super(context);
+
+    this.processor = new AudioWorkletNode(this.context, SpectralChainProcessor.name, {
+      processorOptions: {
+        frameSize: SpectralChain.FRAME_SIZE
+      }
+    });
+
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
+
+        this.loaded = true;
+
+        this.update();
+      })
+      .catch((error: Error) => {
+        throw error;
+      });
+  }
+
+  /** @override */
+  public override start(): void {
+  }
+
+  /** @override */
+  public override stop(): void {
+  }
+
+  /** @override */
+  public override connect(): GainNode {
+    // Clear connection
+    this.input.disconnect(0);
+    this.processor.disconnect(0);
+
+    for (const effector of this.effectors) {
+      if (effector.OUTPUT) {
+        effector.OUTPUT.disconnect(0);
+      }
+    }
+
+    if (this.fused) {
+      // GainNode (Input) -> AudioWorkletNode (Spectral Chain) -> GainNode (Output);
+      this.input.connect(this.processor);
+      this.processor.connect(this.output);
+    } else {
+      // GainNode (Input) -> Effector -> ... -> Effector -> GainNode (Output)
+      let output: AudioNode = this.input;
+
+      for (const effector of this.effectors) {
+        if ((effector.INPUT === null) || (effector.OUTPUT === null)) {
+          continue;
+        }
+
+        output.connect(effector.INPUT);
+
+        output = effector.OUTPUT;
+      }
+
+      output.connect(this.output);
+    }
+
+    return this.output;
+  }
+
+  /**
+   * This method fuses spectral effectors (in connection order) into this chain.
+   * @param {Array<SpectralEffector>} effectors This argument is adjacent spectral effectors. If empty array, this chain is not used.
+   * @return {SpectralChain} Return value is for method chain.
+   */
+  public fuse(effectors: SpectralEffector[]): SpectralChain {
+    for (const effector of this.effectors) {
+      if (!effectors.includes(effector)) {
+        effector.fuse(null);
+      }
+    }
+
+    // Clear connection of effectors that have been fused
+    this.input.disconnect(0);
+
+    for (const effector of this.effectors) {
+      if (effector.OUTPUT) {
+        effector.OUTPUT.disconnect(0);
+      }
+    }
+
+    this.effectors = effectors;
+
+    for (const effector of this.effectors) {
+      effector.fuse(this);
+    }
+
+    this.fused = false;
+
+    this.update();
+    this.connect();
+
+    return this;
+  }
+
+  /**
+   * This method sends stages of fused effectors to processor. Fused effectors call this method whenever their parameters are changed.
+   * If either effector can't be fused, effectors are connected in series.
+   */
+  public update(): void {
+    const stages: SpectralStageParams[] = [];
+
+    for (const effector of this.effectors) {
+      const stage = effector.stage();
+
+      if (stage === null) {
+        break;
+      }
+
+      stages.push(stage);
+    }
+
+    const fused = this.loaded && (stages.length > 0) && (stages.length === this.effectors.length);
+
+    if (fused) {
+      this.stages  = stages;
+      this.hopSize = 128;
+
+      // Overlap is determined by pitch shifter (the others are 16x), and stages of the others are processed by the same hop size
+      for (const stage of stages) {
+        if (stage.type === 'pitchshifter') {
+          this.hopSize = Math.max(this.hopSize, stage.hopSize);
+        }
+      }
+
+      const message: SpectralChainParams = { hopSize: this.hopSize, stages: this.stages };
+
+      this.processor.port.postMessage(message);
+    }
+
+    if (fused !== this.fused) {
+      this.fused = fused;
+
+      this.connect();
+    }
+  }
+
+  /**
+   * This method determines whether effectors are fused (processed by this chain).
+   * @return {boolean}
+   */
+  public isFused(): boolean {
+    return this.fused;
+  }
+
+  /** @override */
+  public override params(): Required<SpectralChainParams> {
+    return {
+      hopSize: this.hopSize,
+      stages : this.stages
+    };
+  }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {SpectralChain} Return value is for method chain.
+   */
+  public profile(enabled: boolean): SpectralChain {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (in order to compensate delay of parallel paths).
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds, `0` until processor is ready).
+   */
+  public latency(): Promise<number> {
+    // If not fused, latency is reported by effectors that are connected in series
+    if (!this.fused) {
+      return Promise.resolve(0);
+    }
+
+    return queryDSPLatency(this.processor)
+      .then((latency: number | null) => (latency ?? 0) / this.context.sampleRate);
+  }
+}
@@ -1,8 +1,10 @@
+import type { SpectralChain, SpectralEffector, SpectralStageParams } from './SpectralChain';
+import type { Compensable, Profilable } from '../../interfaces';
+import type { DSPProfile, DSPProfileMessageEventData } from '../../XSound';
+
 import { Effector } from './Effector';
 import { VocalCancelerProcessor } from './AudioWorkletProcessors/VocalCancelerProcessor';
-
-// @ts-expect-error Because of import WebAssembly Module
-import wasm from './AudioWorkletProcessors/WebAssemblyModules/vocalcanceler.wasm';
+import { compileDSPModule, queryDSPLatency, queryDSPProfile } from '../../XSound';
 
 export type VocalCancelerAlgorithm = 'time' | 'spectrum';
 
@@ -12,15 +14,22 @@ export type VocalCancelerParams = {
   depth?: number,
   minFrequency?: number,
   maxFrequency?: number,
-  threshold?: number
+  threshold?: number,
+  lowLatency?: boolean
 };
 
 /**
  * This private class is for Vocal Canceler.
  */
-export class VocalCanceler extends Effector {
+export class VocalCanceler extends Effector implements SpectralEffector, Profilable, Compensable {
   private processor: AudioWorkletNode;
 
+  // Spectral chain that this effector is fused into (then, `processor` is not connected)
+  private chain: SpectralChain | null = null;
+
+  // Small frame (512 samples) and asymmetric windows (algorithmic latency is 128 samples). Then, this effector is not fused
+  private lowLatency = false;
+
   private algorithm: VocalCancelerAlgorithm = 'time';
   private minFrequency = 200;
   private maxFrequency = 8000;
@@ -36,11 +45,10 @@ export class VocalCanceler extends Effector {
 
     this.processor = new AudioWorkletNode(this.context, VocalCancelerProcessor.name);
 
-    fetch(wasm)
-      .then(async (response) => {
-        const wasm = await response.arrayBuffer();
-
-        this.processor.port.postMessage(wasm);
+    // Combined DSP module is compiled once and shared by all processors
+    compileDSPModule()
+      .then((module: WebAssembly.Module) => {
+        this.processor.port.postMessage(module);
         this.activate();
       })
       .catch((error: Error) => {
@@ -71,6 +79,11 @@ export class VocalCanceler extends Effector {
       this.input.connect(this.output);
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this.output;
   }
 
@@ -86,6 +99,7 @@ export class VocalCanceler extends Effector {
   public param(params: 'minFrequency'): number;
   public param(params: 'maxFrequency'): number;
   public param(params: 'threshold'): number;
+  public param(params: 'lowLatency'): boolean;
   public param(params: VocalCancelerParams): VocalCanceler;
   public param(params: keyof VocalCancelerParams | VocalCancelerParams): VocalCancelerParams[keyof VocalCancelerParams] | VocalCanceler {
     if (typeof params === 'string') {
@@ -113,6 +127,10 @@ export class VocalCanceler extends Effector {
         case 'threshold': {
           return this.threshold;
         }
+
+        case 'lowLatency': {
+          return this.lowLatency;
+        }
       }
     }
 
@@ -189,9 +207,26 @@ export class VocalCanceler extends Effector {
 
           break;
         }
+
+        case 'lowLatency': {
+          if (typeof value === 'boolean') {
+            this.lowLatency = value;
+
+            const message: VocalCancelerParams = { lowLatency: value };
+
+            this.processor.port.postMessage(message);
+          }
+
+          break;
+        }
       }
     }
 
+    // Stage of fused effector is updated (bypass if not active)
+    if (this.chain) {
+      this.chain.update();
+    }
+
     return this;
   }
 
@@ -206,7 +241,65 @@ export class VocalCanceler extends Effector {
       depth       : this.depth.gain.value,
       minFrequency: this.minFrequency,
       maxFrequency: this.maxFrequency,
+      threshold   : this.threshold,
+      lowLatency  : this.lowLatency
+    };
+  }
+
+  /** @override */
+  public stage(): SpectralStageParams | null {
+    // Low-latency mode has its own frame, so it is not fused
+    if (this.lowLatency) {
+      return null;
+    }
+
+    return {
+      type        : 'vocalcanceler',
+      algorithm   : this.algorithm,
+      depth       : this.isActive ? this.depth.gain.value : 0,
+      minFrequency: this.minFrequency,
+      maxFrequency: this.maxFrequency,
       threshold   : this.threshold
     };
   }
+
+  /** @override */
+  public fuse(chain: SpectralChain | null): void {
+    this.chain = chain;
+  }
+
+  /**
+   * This method starts or stops instrumentation of WebAssembly Module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {VocalCanceler} Return value is for method chain.
+   */
+  public profile(enabled: boolean): VocalCanceler {
+    const message: DSPProfileMessageEventData = { profile: enabled };
+
+    this.processor.port.postMessage(message);
+
+    return this;
+  }
+
+  /**
+   * This method gets instrumentation of WebAssembly Module.
+   * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves counters since instrumentation is started (`null` until processor is ready).
+   */
+  public stats(): Promise<DSPProfile | null> {
+    return queryDSPProfile(this.processor);
+  }
+
+  /**
+   * This method gets algorithmic latency of WebAssembly Module (in order to compensate delay of parallel paths).
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds, `0` until processor is ready).
+   */
+  public latency(): Promise<number> {
+    // If not active, processor is not connected. If fused, latency is reported by spectral chain
+    if (!this.isActive || ((this.chain !== null) && this.chain.isFused())) {
+      return Promise.resolve(0);
+    }
+
+    return queryDSPLatency(this.processor)
+      .then((latency: number | null) => (latency ?? 0) / this.context.sampleRate);
+  }
 }
@@ -1,4 +1,5 @@
-import type { Connectable } from '../interfaces';
+import type { Compensable, Connectable, Profilable } from '../interfaces';
+import type { DSPLoadReport } from '../XSound';
 import type { Effector } from './Effectors/Effector';
 import type { AutopannerParams } from './Effectors/Autopanner';
 import type { BitCrusherParams } from './Effectors/BitCrusher';
@@ -22,6 +23,7 @@ import type { PreampParams } from './Effectors/Preamp';
 import type { ReverbParams } from './Effectors/Reverb';
 import type { RingmodulatorParams } from './Effectors/Ringmodulator';
 import type { SlicerParams } from './Effectors/Slicer';
+import type { SpectralEffector } from './Effectors/SpectralChain';
 import type { StereoParams } from './Effectors/Stereo';
 import type { TremoloParams } from './Effectors/Tremolo';
 import type { VocalCancelerParams } from './Effectors/VocalCanceler';
@@ -52,10 +54,12 @@ import { Preamp } from './Effectors/Preamp';
 import { Reverb } from './Effectors/Reverb';
 import { Ringmodulator } from './Effectors/Ringmodulator';
 import { Slicer } from './Effectors/Slicer';
+import { SpectralChain, isSpectralEffector } from './Effectors/SpectralChain';
 import { Stereo } from './Effectors/Stereo';
 import { Tremolo } from './Effectors/Tremolo';
 import { VocalCanceler } from './Effectors/VocalCanceler';
 import { Wah } from './Effectors/Wah';
+import { reportDSPLoad } from '../XSound';
 
 export type Module =
   Analyser          |
@@ -195,9 +199,15 @@ export abstract class SoundModule implements Connectable {
   protected vocalcanceler: VocalCanceler;
   protected wah: Wah;
 
+  // Adjacent spectral effectors are fused (created on demand)
+  protected spectralchains: SpectralChain[] = [];
+
   protected runningAnalyser = false;
   protected mixed = false;
 
+  // Instrumentation of effectors that are processed by combined DSP module (`profile`)
+  protected profiling = false;
+
   /**
    * @param {AudioContext} context This argument is in order to use Web Audio API.
    */
@@ -272,8 +282,10 @@ export abstract class SoundModule implements Connectable {
     // AudioSourceNode (Input)-> AudioNode -> ... -> AudioNode -> GainNode (Master Volume) -> AnalyserNode  -> AudioDestinationNode (Output)
     source.disconnect(0);  // Clear connection
 
-    if (this.modules.length > 0) {
-      const input = this.modules[0].INPUT;
+    const modules = this.fuse();
+
+    if (modules.length > 0) {
+      const input = modules[0].INPUT;
 
       if (input === null) {
         return;
@@ -284,8 +296,8 @@ export abstract class SoundModule implements Connectable {
       source.connect(this.mastervolume);
     }
 
-    for (let i = 0, len = this.modules.length; i < len; i++) {
-      const output = this.modules[i].OUTPUT;
+    for (let i = 0, len = modules.length; i < len; i++) {
+      const output = modules[i].OUTPUT;
 
       if (output === null) {
         continue;
@@ -294,8 +306,8 @@ export abstract class SoundModule implements Connectable {
       // Clear connection
       output.disconnect(0);
 
-      if (i < (this.modules.length - 1)) {
-        const input = this.modules[i + 1].INPUT;
+      if (i < (modules.length - 1)) {
+        const input = modules[i + 1].INPUT;
 
         if (input === null) {
           continue;
@@ -318,6 +330,74 @@ export abstract class SoundModule implements Connectable {
     this.recorder.OUTPUT.connect(this.destination);
   }
 
+  /**
+   * This method fuses runs of adjacent spectral effectors (2 or more) into `SpectralChain`, so that they share one FFT / IFFT pair.
+   * @return {Array<Connectable>} Return value is modules to connect (spectral effectors in run are replaced by spectral chain).
+   */
+  protected fuse(): Connectable[] {
+    const modules: Connectable[] = [];
+
+    // Release spectral effectors (modules may have been edited), then fuse them again
+    for (const chain of this.spectralchains) {
+      chain.fuse([]);
+    }
+
+    let numberOfChains = 0;
+
+    for (let i = 0, len = this.modules.length; i < len;) {
+      const effectors: SpectralEffector[] = [];
+
+      for (let j = i; j < len; j++) {
+        const module = this.modules[j];
+
+        if (!isSpectralEffector(module)) {
+          break;
+        }
+
+        effectors.push(module);
+      }
+
+      if (effectors.length < 2) {
+        const module = this.modules[i];
+
+        if (isSpectralEffector(module)) {
+          module.fuse(null);
+        }
+
+        modules.push(module);
+
+        i++;
+        continue;
+      }
+
+      if (numberOfChains === this.spectralchains.length) {
+        const chain = new SpectralChain(this.context);
+
+        // Spectral chain that is created while instrumentation
+        if (this.profiling) {
+          chain.profile(true);
+        }
+
+        this.spectralchains.push(chain);
+      }
+
+      const chain = this.spectralchains[numberOfChains++];
+
+      chain.fuse(effectors);
+
+      modules.push(chain);
+
+      i += effectors.length;
+    }
+
+    // Spectral chains that are not used
+    for (let i = numberOfChains, len = this.spectralchains.length; i < len; i++) {
+      this.spectralchains[i].OUTPUT.disconnect(0);
+    }
+
+    return modules;
+  }
+
   /**
    * This method disconnects instance of `AudioWorkletNode` as sound source.
    */
@@ -550,6 +630,67 @@ export abstract class SoundModule implements Connectable {
     return JSON.stringify(this.params());
   }
 
+  /**
+   * This method starts or stops instrumentation of effectors that are processed by combined DSP module (counters are reset when instrumentation is started).
+   * @param {boolean} enabled This argument is `true` in order to start instrumentation.
+   * @return {SoundModule} Return value is for method chain.
+   */
+  public profile(enabled: boolean) {
+    this.profiling = enabled;
+
+    for (const profilable of Object.values(this.profilables())) {
+      profilable.profile(enabled);
+    }
+
+    // Type inference every subclass
+    return this;
+  }
+
+  /**
+   * This method reports DSP load per effect (ratio of processing time to time of render quantum) since instrumentation is started.
+   * Effects that have not processed (not connected, or fused into spectral chain) are not reported.
+   * @return {Promise<DSPLoadReport>} Return value is `Promise` that resolves DSP load per effect, and sum of them.
+   */
+  public report(): Promise<DSPLoadReport> {
+    return reportDSPLoad(this.profilables(), this.context.sampleRate);
+  }
+
+  /**
+   * This method gets algorithmic latency of connected effectors (sum of them, because effectors are connected in series).
+   * Parallel paths (e.g. dry signal) can be delayed by this latency, so that they are aligned with this sound module.
+   * @return {Promise<number>} Return value is `Promise` that resolves latency (seconds).
+   */
+  public latency(): Promise<number> {
+    // Fused effectors report `0`, and spectral chains that fuse them report latency instead
+    const compensables: Compensable[] = [
+      ...this.modules.filter((module: Connectable): module is Connectable & Compensable => 'latency' in module),
+      ...this.spectralchains
+    ];
+
+    return Promise.all(compensables.map((compensable: Compensable) => compensable.latency()))
+      .then((latencies: number[]) => latencies.reduce((sum: number, latency: number) => sum + latency, 0));
+  }
+
+  /**
+   * This method gets effectors that are processed by combined DSP module (spectral chains are named by their order).
+   * @return {{ [name: string]: Profilable }}
+   */
+  protected profilables(): { [name: string]: Profilable } {
+    const profilables: { [name: string]: Profilable } = {
+      noisegate      : this.noisegate,
+      noisesuppressor: this.noisesuppressor,
+      pitchshifter   : this.pitchshifter,
+      vocalcanceler  : this.vocalcanceler,
+      harmonizer     : this.harmonizer
+    };
+
+    this.spectralchains.forEach((chain: SpectralChain, index: number) => {
+      profilables[`spectralchain${index}`] = chain;
+    });
+
+    return profilables;
+  }
+
   /**
    * Connector for input.
    */
@@ -582,6 +723,13 @@ export abstract class SoundModule implements Connectable {
 
     this.modules.length = 0;
 
+    for (const chain of this.spectralchains) {
+      chain.INPUT.disconnect(0);
+      chain.OUTPUT.disconnect(0);
+    }
+
+    this.spectralchains.length = 0;
+
     this.analyser          = new Analyser(context);
     this.recorder          = new Recorder(context);
     this.autopanner        = new Autopanner(context);
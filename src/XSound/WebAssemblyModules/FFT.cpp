@@ -1,172 +1,360 @@
-#include <stdlib.h>
-#include <math.h>
+#include "../../SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/FFT.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
+// FFT buffers per instance (plans are shared across instances by `get_fft_plan`)
+typedef struct {
+  size_t size;
+  Arena arena;
+  float *reals;
+  float *imags;
+} FFTContext;
+
+// Window functions as `windowFunction` in `index.ts` (so that each frame of spectrogram equals `spectrum`)
+typedef enum {
+  SPECTROGRAM_RECTANGULAR,
+  SPECTROGRAM_HANNING,
+  SPECTROGRAM_HAMMING,
+  SPECTROGRAM_BLACKMAN
+} SPECTROGRAM_WINDOW;
+
+// Magnitudes of frames of a whole signal by one call.
+// Frame `i` is inputs[i * hop_size .. i * hop_size + frame_size) (zero-padded after the end of signal),
+// and it is held as `frame_size / 2` bins (as `spectrum`) at outputs[i * (frame_size / 2)].
+typedef struct {
+  size_t frame_size;
+  size_t hop_size;
+  size_t number_of_frames;
+  Arena arena;
+  float *window;
+  float *reals;
+  float *imags;
+  float *inputs;
+  float *outputs;
+  size_t inputs_capacity;
+  size_t outputs_capacity;
+} SpectrogramContext;
+
+// 20 * log10(0.000001) (as `toDecibels` in `index.ts`)
+static const float spectrogram_min_decibels = -120.0f;
+
 static float *reals = nullptr;
 static float *imags = nullptr;
 
+static size_t reals_size = 0;
+static size_t imags_size = 0;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-static inline int pow2(const int n) {
-  if (n == 0) {
-    return 1;
+// FFT size is 2^a * 3^b * 5^c. Return value is `nullptr` if size is not valid.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+FFTContext *fft_create(const size_t size) {
+  if (!fft_is_valid_size(size)) {
+    return nullptr;
   }
 
-  return 2 << (n - 1);
+  FFTContext *context = (FFTContext *)calloc(1, sizeof(FFTContext));
+
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, (2 * arena_size_of(size, sizeof(float))));
+
+  context->size  = size;
+  context->reals = (float *)arena_alloc(arena, size, sizeof(float));
+  context->imags = (float *)arena_alloc(arena, size, sizeof(float));
+
+  // Build FFT plans in advance
+  get_fft_plan(size, FORWARD);
+  get_fft_plan(size, INVERSE);
+
+  return context;
 }
 
-static inline void swap(float *const reals, float *const imags, const int i, const size_t k) {
-  float tmp_real;
-  float tmp_imag;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void fft_destroy(FFTContext *const context) {
+  if (context == nullptr) {
+    return;
+  }
 
-  tmp_real = reals[i];
-  tmp_imag = imags[i];
+  arena_release(&context->arena);
 
-  reals[i] = reals[k];
-  imags[i] = imags[k];
+  free(context);
+}
 
-  reals[k] = tmp_real;
-  imags[k] = tmp_imag;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *fft_reals(FFTContext *const context) {
+  return context->reals;
 }
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
-void FFT(const size_t size) {
-  int number_of_stages = (int)log2f((float)size);
+float *fft_imags(FFTContext *const context) {
+  return context->imags;
+}
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      int rest = number_of_stages - stage;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool fft_process(FFTContext *const context) {
+  return FFT(context->reals, context->imags, context->size);
+}
 
-      for (int j = 0; j < pow2(rest); j++) {
-        int n = i * pow2(rest + 1) + j;
-        int m = pow2(rest) + n;
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool ifft_process(FFTContext *const context) {
+  return IFFT(context->reals, context->imags, context->size);
+}
 
-        float w = 2.0f * M_PI * j * pow2(stage - 1);
+// Algorithm of plans that are built later (`FFT_AUTO` selects by `fft_plan_measure` or the first valid candidate, the others are forced for tests and benchmarks)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void fft_set_algorithm(const FFT_ALGORITHM algorithm) {
+  set_fft_algorithm(algorithm);
+}
 
-        float e_real = reals[n];
-        float e_imag = imags[n];
-        float o_real = reals[m];
-        float o_imag = imags[m];
-        float w_real = cosf(w / size);
-        float w_imag = 0.0f - sinf(w / size);
+// Measures FFT algorithms of `size`, so that later transforms of `FFT_AUTO` run the fastest (it takes milliseconds, so call it before transforms).
+// Return value is selected algorithm of forward transform (`FFT_AUTO` if size is not valid).
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+FFT_ALGORITHM fft_plan_measure(const size_t size) {
+  return measure_fft_plans(size);
+}
 
-        if (stage < number_of_stages) {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = (w_real * (e_real - o_real)) - (w_imag * (e_imag - o_imag));
-          imags[m] = (w_real * (e_imag - o_imag)) + (w_imag * (e_real - o_real));
-        } else {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = e_real - o_real;
-          imags[m] = e_imag - o_imag;
-        }
+// Algorithm that forward transform of `context` runs (selected by `fft_plan_measure` or the first valid candidate if `FFT_AUTO`)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+FFT_ALGORITHM fft_get_algorithm(FFTContext *const context) {
+  return get_fft_plan(context->size, FORWARD)->algorithm;
+}
+
+// Return value is `false` (and nothing is transformed) if size is not 2^a * 3^b * 5^c
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool FFT(const size_t size) {
+  return FFT(reals, imags, size);
+}
+
+// Return value is `false` (and nothing is transformed) if size is not 2^a * 3^b * 5^c
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+bool IFFT(const size_t size) {
+  return IFFT(reals, imags, size);
+}
+
+static void spectrogram_window(float *const window, const size_t size, const SPECTROGRAM_WINDOW type) {
+  for (size_t n = 0; n < size; n++) {
+    const double w = (2.0 * M_PI * n) / (size - 1);
+
+    switch (type) {
+      case SPECTROGRAM_HANNING: {
+        window[n] = 0.5 - (0.5 * cos(w));
+        break;
+      }
+
+      case SPECTROGRAM_HAMMING: {
+        window[n] = 0.54 - (0.46 * cos(w));
+        break;
+      }
+
+      case SPECTROGRAM_BLACKMAN: {
+        window[n] = 0.42 - (0.5 * cos(w)) + (0.08 * cos(2.0 * w));
+        break;
+      }
+
+      default: {
+        window[n] = 1.0f;
+        break;
       }
     }
   }
+}
 
-  size_t *index = (size_t *)calloc(size, sizeof(size_t));
+// Frame size must be even and `frame_size / 2` must be 2^a * 3^b * 5^c (real FFT). Return value is `nullptr` if not valid.
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+SpectrogramContext *spectrogram_create(const size_t frame_size, const size_t hop_size, const SPECTROGRAM_WINDOW window) {
+  if (!rfft_is_valid_size(frame_size) || (hop_size == 0)) {
+    return nullptr;
+  }
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    int rest = number_of_stages - stage;
+  SpectrogramContext *context = (SpectrogramContext *)calloc(1, sizeof(SpectrogramContext));
 
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      index[(size_t)(pow2(stage - 1) + i)] = index[i] + (size_t)pow2(rest);
-    }
+  Arena *arena = &context->arena;
+
+  arena_reserve(arena, (3 * arena_size_of(frame_size, sizeof(float))));
+
+  context->frame_size = frame_size;
+  context->hop_size   = hop_size;
+  context->window     = (float *)arena_alloc(arena, frame_size, sizeof(float));
+  context->reals      = (float *)arena_alloc(arena, frame_size, sizeof(float));
+  context->imags      = (float *)arena_alloc(arena, frame_size, sizeof(float));
+
+  spectrogram_window(context->window, frame_size, window);
+
+  // Build FFT plans in advance
+  get_rfft_plan(frame_size);
+  get_fft_plan((frame_size / 2), FORWARD);
+
+  return context;
+}
+
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+void spectrogram_destroy(SpectrogramContext *const context) {
+  if (context == nullptr) {
+    return;
   }
 
-  for (size_t k = 0; k < size; k++) {
-    if (index[k] <= k) {
-      continue;
-    }
+  arena_release(&context->arena);
+
+  free(context->inputs);
+  free(context->outputs);
+  free(context);
+}
+
+// Buffer for signal of `length` samples (it is reallocated only if longer than before)
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+float *spectrogram_inputs(SpectrogramContext *const context, const size_t length) {
+  if (length > context->inputs_capacity) {
+    free(context->inputs);
+
+    context->inputs          = (float *)calloc(length, sizeof(float));
+    context->inputs_capacity = length;
+
+    memory_layout_changed();
+  }
+
+  return context->inputs;
+}
+
+// Frames cover every sample of signal (the last frame may be zero-padded)
+static size_t spectrogram_number_of_frames(const size_t length, const size_t frame_size, const size_t hop_size) {
+  if (length == 0) {
+    return 0;
+  }
 
-    swap(reals, imags, index[k], k);
+  if (length <= frame_size) {
+    return 1;
   }
 
-  free(index);
+  return 1 + (((length - frame_size) + (hop_size - 1)) / hop_size);
 }
 
+// Signal is `length` samples in `spectrogram_inputs`. If `decibels`, magnitudes are converted as `toDecibels`.
+// Return value is `number_of_frames * (frame_size / 2)` magnitudes (`spectrogram_get_number_of_frames` gets the number of frames).
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
-void IFFT(const size_t size) {
-  int number_of_stages = (int)log2f((float)size);
+float *spectrogram_process(SpectrogramContext *const context, const size_t length, const bool decibels) {
+  const size_t frame_size = context->frame_size;
+  const size_t hop_size   = context->hop_size;
+  const size_t bin_count  = frame_size / 2;
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      int rest = number_of_stages - stage;
+  const float *inputs = context->inputs;
+  const float *window = context->window;
 
-      for (int j = 0; j < pow2(rest); j++) {
-        int n = i * pow2(rest + 1) + j;
-        int m = pow2(rest) + n;
+  float *reals = context->reals;
+  float *imags = context->imags;
 
-        float w = 2.0f * M_PI * j * pow2(stage - 1);
+  const size_t number_of_frames = spectrogram_number_of_frames((inputs == nullptr) ? 0 : length, frame_size, hop_size);
 
-        float e_real = reals[n];
-        float e_imag = imags[n];
-        float o_real = reals[m];
-        float o_imag = imags[m];
-        float w_real = cosf(w / size);
-        float w_imag = sinf(w / size);
+  if ((number_of_frames * bin_count) > context->outputs_capacity) {
+    free(context->outputs);
 
-        if (stage < number_of_stages) {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = (w_real * (e_real - o_real)) - (w_imag * (e_imag - o_imag));
-          imags[m] = (w_real * (e_imag - o_imag)) + (w_imag * (e_real - o_real));
-        } else {
-          reals[n] = e_real + o_real;
-          imags[n] = e_imag + o_imag;
-          reals[m] = e_real - o_real;
-          imags[m] = e_imag - o_imag;
-        }
-      }
-    }
+    context->outputs          = (float *)calloc((number_of_frames * bin_count), sizeof(float));
+    context->outputs_capacity = number_of_frames * bin_count;
+
+    memory_layout_changed();
   }
 
-  size_t *index = (size_t *)calloc(size, sizeof(size_t));
+  context->number_of_frames = number_of_frames;
+
+  for (size_t i = 0; i < number_of_frames; i++) {
+    const size_t offset = i * hop_size;
+    const size_t count  = ((offset + frame_size) <= length) ? frame_size : (length - offset);
+
+    multiply_window(reals, (inputs + offset), window, count);
+
+    memset((reals + count), 0, ((frame_size - count) * sizeof(float)));
 
-  for (int stage = 1; stage <= number_of_stages; stage++) {
-    int rest = number_of_stages - stage;
+    RFFT(reals, imags, frame_size);
 
-    for (int i = 0; i < pow2(stage - 1); i++) {
-      index[(size_t)(pow2(stage - 1) + i)] = index[i] + (size_t)pow2(rest);
+    float *outputs = context->outputs + (i * bin_count);
+
+    size_t k = 0;
+
+#ifdef __wasm_simd128__
+    for (; (k + 4) <= bin_count; k += 4) {
+      const v128_t real = wasm_v128_load(reals + k);
+      const v128_t imag = wasm_v128_load(imags + k);
+
+      wasm_v128_store((outputs + k), wasm_f32x4_sqrt(wasm_f32x4_add(wasm_f32x4_mul(real, real), wasm_f32x4_mul(imag, imag))));
+    }
+#endif
+
+    for (; k < bin_count; k++) {
+      outputs[k] = sqrtf((reals[k] * reals[k]) + (imags[k] * imags[k]));
     }
-  }
 
-  for (size_t k = 0; k < size; k++) {
-    if (index[k] <= k) {
+    if (!decibels) {
       continue;
     }
 
-    swap(reals, imags, index[k], k);
+    for (k = 0; k < bin_count; k++) {
+      outputs[k] = (outputs[k] == 0.0f) ? spectrogram_min_decibels : (20.0f * log10f(outputs[k]));
+    }
   }
 
-  for (size_t k = 0; k < size; k++) {
-    reals[k] /= size;
-    imags[k] /= size;
-  }
+  return context->outputs;
+}
 
-  free(index);
+// The number of frames of the last `spectrogram_process`
+#ifdef __EMSCRIPTEN__
+EMSCRIPTEN_KEEPALIVE
+#endif
+size_t spectrogram_get_number_of_frames(SpectrogramContext *const context) {
+  return context->number_of_frames;
 }
 
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_reals(const size_t buffer_size) {
+  if (reals && (reals_size == buffer_size)) {
+    return reals;
+  }
+
   if (reals) {
     free(reals);
   }
 
   reals = (float *)calloc(buffer_size, sizeof(float));
 
+  reals_size = buffer_size;
+
+  memory_layout_changed();
+
   return reals;
 }
 
@@ -174,12 +362,20 @@ float *alloc_memory_reals(const size_t buffer_size) {
 EMSCRIPTEN_KEEPALIVE
 #endif
 float *alloc_memory_imags(const size_t buffer_size) {
+  if (imags && (imags_size == buffer_size)) {
+    return imags;
+  }
+
   if (imags) {
     free(imags);
   }
 
   imags = (float *)calloc(buffer_size, sizeof(float));
 
+  imags_size = buffer_size;
+
+  memory_layout_changed();
+
   return imags;
 }
 
@@ -1,5 +1,15 @@
+import type { Profilable } from '../interfaces';
+
+import { createDSPImports } from '../worklet';
+
 // @ts-expect-error Because of import WebAssembly Module
 import wasm from './WebAssemblyModules/FFT.wasm';
+// @ts-expect-error Because of import WebAssembly Module
+import wasmSIMD from './WebAssemblyModules/FFT.simd.wasm';
+// @ts-expect-error Because of import WebAssembly Module
+import dsp from '../SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/dsp.wasm';
+// @ts-expect-error Because of import WebAssembly Module
+import dspSIMD from '../SoundModule/Effectors/AudioWorkletProcessors/WebAssemblyModules/dsp.simd.wasm';
 
 // Constants for Music
 
@@ -211,15 +221,331 @@ export function windowFunction(size: number, type: WindowFunction = 'rect'): Flo
 
 export interface FFTWebAssemblyInstance extends WebAssembly.Exports {
   memory: WebAssembly.Memory;
-  FFT: (size: number) => void;
-  IFFT: (size: number) => void;
+  FFT: (size: number) => number;
+  IFFT: (size: number) => number;
   alloc_memory_reals: (size: number) => number;
   alloc_memory_imags: (size: number) => number;
+  spectrogram_create: (frameSize: number, hopSize: number, windowFunctionType: number) => number;
+  spectrogram_destroy: (context: number) => void;
+  spectrogram_inputs: (context: number, length: number) => number;
+  spectrogram_process: (context: number, length: number, decibels: boolean) => number;
+  spectrogram_get_number_of_frames: (context: number) => number;
+};
+
+// (module (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt))
+const SIMD_DETECTION_MODULE = new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11]);
+
+/**
+ * This function determines whether WebAssembly SIMD (128 bits) is supported.
+ * WebAssembly Modules are built both with and without `-msimd128`, and loaders select the build by this function.
+ * @return {boolean} If WebAssembly SIMD is supported, this value is `true`. Otherwise, this value is `false`.
+ */
+export function isSIMDSupported(): boolean {
+  try {
+    return WebAssembly.validate(SIMD_DETECTION_MODULE);
+  } catch {
+    return false;
+  }
+}
+
+/**
+ * This function creates imports that pass clock of main thread to WebAssembly Modules.
+ * FFT plans are measured by it when `fft_plan_measure` is called (`emscripten_get_now`, or `clock_time_get` of WASI in standalone WebAssembly Modules).
+ * @param {function} getMemory This argument is getter of linear memory (`null` until it is instantiated).
+ * @return {WebAssembly.Imports} Return value is imports for `WebAssembly.instantiate`.
+ */
+export function createClockImports(getMemory: () => WebAssembly.Memory | null): WebAssembly.Imports {
+  return createDSPImports(getMemory, () => performance.now());
+}
+
+let dspModule: Promise<WebAssembly.Module> | null = null;
+
+/**
+ * This function compiles combined DSP module (effectors and noise generator) only once per page.
+ * Compiled `WebAssembly.Module` is posted to every `AudioWorkletProcessor`, so that processors only instantiate it (no compilation per effector).
+ * @return {Promise<WebAssembly.Module>} Return value is the same `Promise` for all callers.
+ */
+export function compileDSPModule(): Promise<WebAssembly.Module> {
+  if (dspModule === null) {
+    dspModule = WebAssembly.compileStreaming(fetch(isSIMDSupported() ? dspSIMD : dsp))
+      .catch((error: Error) => {
+        // Compile again by next call
+        dspModule = null;
+
+        throw error;
+      });
+  }
+
+  return dspModule;
+}
+
+/**
+ * Spectral effect of offline rendering (`*_render` of combined DSP module).
+ * `noisesuppressor` uses `threshold`, `pitchshifter` uses `pitch`, `speed`, `dry` and `wet`, and `vocalcanceler` uses `depth`.
+ */
+export type DSPRenderEffect = {
+  type: 'noisesuppressor' | 'pitchshifter' | 'vocalcanceler',
+  frameSize?: number,
+  threshold?: number,
+  pitch?: number,
+  speed?: number,
+  dry?: number,
+  wet?: number,
+  depth?: number
+};
+
+/**
+ * `threadsURL` is URL of combined DSP module that is built with `-pthread` (`dsp.pthread.mjs` by `npm run build:wasm:dsp:pthread`).
+ * It is used only if page is cross-origin isolated (SharedArrayBuffer). Otherwise, `dsp.wasm` renders jobs in order on the calling thread (output is the same).
+ * `numberOfThreads` is the number of threads (`0` is the number of logical cores).
+ */
+export type DSPRenderOptions = {
+  threadsURL?: string,
+  numberOfThreads?: number
+};
+
+type DSPRenderer = {
+  exports: { [name: string]: (...args: number[]) => number },
+  buffer: () => ArrayBufferLike
+};
+
+// Emscripten Module of `-pthread` build (exported functions are prefixed by `_`)
+type DSPThreadsModule = {
+  HEAPF32: Float32Array,
+  [name: string]: unknown
 };
 
+let dspThreadsModule: Promise<DSPRenderer> | null = null;
+
+/**
+ * This function instantiates combined DSP module for offline rendering (`-pthread` build is instantiated only once per page).
+ * @param {string} threadsURL This argument is URL of `-pthread` build.
+ * @return {Promise<DSPRenderer>} Return value is `Promise` that resolves exported functions and linear memory.
+ */
+function instantiateDSPRenderer(threadsURL?: string): Promise<DSPRenderer> {
+  if (threadsURL && (typeof SharedArrayBuffer !== 'undefined') && globalThis.crossOriginIsolated) {
+    if (dspThreadsModule === null) {
+      dspThreadsModule = import(/* webpackIgnore: true */ threadsURL)
+        .then((factory: { default: () => Promise<DSPThreadsModule> }) => factory.default())
+        .then((emscriptenModule: DSPThreadsModule) => {
+          const exports: DSPRenderer['exports'] = {};
+
+          Object.keys(emscriptenModule).forEach((name: string) => {
+            const f = emscriptenModule[name];
+
+            if (name.startsWith('_') && (typeof f === 'function')) {
+              exports[name.slice(1)] = f as DSPRenderer['exports'][string];
+            }
+          });
+
+          // Linear memory may grow while rendering (views of Emscripten are updated)
+          return { exports, buffer: () => emscriptenModule.HEAPF32.buffer };
+        })
+        .catch((error: Error) => {
+          // Instantiate again by next call
+          dspThreadsModule = null;
+
+          throw error;
+        });
+    }
+
+    return dspThreadsModule;
+  }
+
+  let memory: WebAssembly.Memory | null = null;
+
+  return compileDSPModule()
+    .then((module: WebAssembly.Module) => WebAssembly.instantiate(module, createClockImports(() => memory)))
+    .then((instance: WebAssembly.Instance) => {
+      memory = instance.exports.memory as WebAssembly.Memory;
+
+      const linearMemory = memory;
+
+      // HACK:
+      return { exports: instance.exports as DSPRenderer['exports'], buffer: () => linearMemory.buffer };
+    });
+}
+
+/**
+ * This function renders planar signal by spectral effect of combined DSP module on worker threads (offline rendering).
+ * Output is the same as streaming API (`AudioWorkletProcessor`), so it is delayed by latency of kernel (`frameSize - 128` samples).
+ * @param {Array<Float32Array>} channels This argument is signal per channel (the same length).
+ * @param {DSPRenderEffect} effect This argument is effect and its parameters.
+ * @param {DSPRenderOptions} options This argument is URL of `-pthread` build and the number of threads.
+ * @return {Promise<Array<Float32Array>>} Return value is `Promise` that resolves rendered signal per channel.
+ */
+export function renderDSP(channels: Float32Array[], effect: DSPRenderEffect, options?: DSPRenderOptions): Promise<Float32Array[]> {
+  return instantiateDSPRenderer(options?.threadsURL)
+    .then((renderer: DSPRenderer) => {
+      const { exports } = renderer;
+
+      const numberOfChannels = channels.length;
+      const length           = numberOfChannels > 0 ? channels[0].length : 0;
+      const numberOfThreads  = options?.numberOfThreads ?? 0;
+
+      const context = exports[`${effect.type}_create`](effect.frameSize ?? 2048);
+
+      exports[`${effect.type}_set_number_of_channels`](context, numberOfChannels);
+
+      const inputs = new Float32Array(renderer.buffer(), exports[`${effect.type}_render_inputs`](context, length), (numberOfChannels * length));
+
+      channels.forEach((channel: Float32Array, channelNumber: number) => {
+        inputs.set(channel, (channelNumber * length));
+      });
+
+      let offset = 0;
+
+      switch (effect.type) {
+        case 'noisesuppressor':
+          offset = exports.noisesuppressor_render(context, length, (effect.threshold ?? 0), numberOfThreads);
+          break;
+        case 'pitchshifter':
+          offset = exports.pitchshifter_render(context, length, (effect.pitch ?? 1), (effect.speed ?? 1), (effect.dry ?? 0), (effect.wet ?? 1), numberOfThreads);
+          break;
+        case 'vocalcanceler':
+          offset = exports.vocalcanceler_render(context, length, (effect.depth ?? 0), numberOfThreads);
+          break;
+      }
+
+      // Outputs are copied (linear memory may be shared, and it is reused by next rendering)
+      const outputs = new Float32Array(renderer.buffer(), offset, (numberOfChannels * length));
+
+      const rendered = channels.map((_: Float32Array, channelNumber: number) => {
+        return outputs.slice((channelNumber * length), ((channelNumber + 1) * length));
+      });
+
+      exports[`${effect.type}_destroy`](context);
+
+      return rendered;
+    });
+}
+
+// Render quantum size of Web Audio API
+const RENDER_QUANTUM_SIZE = 128;
+
+/**
+ * Instrumentation of one kernel of combined DSP module (since instrumentation is started).
+ * Time is milliseconds per call (render quantum). Allocations and skipped frames (silence) are counted by kernels.
+ */
+export type DSPProfile = {
+  calls: number,
+  totalTime: number,
+  maxTime: number,
+  allocations: number,
+  skippedFrames: number
+};
+
+/**
+ * Message for `AudioWorkletProcessor`s that are processed by combined DSP module.
+ * `profile` starts (counters are reset) or stops instrumentation.
+ * `query` posts `DSPProfile` (`'profile'`) or algorithmic latency of kernel in samples (`'latency'`) to transferred `MessagePort` (`null` until it is instantiated).
+ */
+export type DSPProfileMessageEventData = {
+  profile?: boolean,
+  query?: 'profile' | 'latency'
+};
+
+/**
+ * DSP load is ratio of processing time to time of render quantum (`128 / sampleRate`). If load is over `1`, processing can't be in time.
+ */
+export type DSPLoad = DSPProfile & {
+  averageTime: number,
+  load: number,
+  maxLoad: number
+};
+
+export type DSPLoadReport = {
+  effects: { [name: string]: DSPLoad },
+  load: number,
+  maxLoad: number
+};
+
+/**
+ * This function queries instrumentation of `AudioWorkletProcessor` (by `DSPProfileMessageEventData`).
+ * Reply is posted to transferred `MessagePort`, so queries are not mixed with the other messages (and other queries).
+ * @param {AudioWorkletNode} processor This argument is instance of `AudioWorkletNode` whose processor is processed by combined DSP module.
+ * @return {Promise<DSPProfile|null>} Return value is `Promise` that resolves `DSPProfile` (or `null` until processor instantiates combined DSP module).
+ */
+export function queryDSPProfile(processor: AudioWorkletNode): Promise<DSPProfile | null> {
+  return queryDSP<DSPProfile>(processor, 'profile');
+}
+
+/**
+ * This function queries algorithmic latency of kernel of `AudioWorkletProcessor` (by `DSPProfileMessageEventData`).
+ * Output of spectral kernels is delayed by `frameSize - 128` samples (or `2 * hopSize - 128` samples in low-latency mode), so that mixer can delay parallel paths by latency.
+ * @param {AudioWorkletNode} processor This argument is instance of `AudioWorkletNode` whose processor is processed by combined DSP module.
+ * @return {Promise<number|null>} Return value is `Promise` that resolves latency in samples (or `null` until processor creates kernel).
+ */
+export function queryDSPLatency(processor: AudioWorkletNode): Promise<number | null> {
+  return queryDSP<number>(processor, 'latency');
+}
+
+/**
+ * This function posts query to `AudioWorkletProcessor`, and resolves reply that is posted to transferred `MessagePort`.
+ * @param {AudioWorkletNode} processor This argument is instance of `AudioWorkletNode` whose processor is processed by combined DSP module.
+ * @param {'profile'|'latency'} query This argument is kind of query.
+ * @return {Promise<T|null>} Return value is `Promise` that resolves reply of processor.
+ */
+function queryDSP<T>(processor: AudioWorkletNode, query: 'profile' | 'latency'): Promise<T | null> {
+  return new Promise((resolve: (reply: T | null) => void) => {
+    const channel = new MessageChannel();
+
+    channel.port1.onmessage = (event: MessageEvent<T | null>) => {
+      channel.port1.close();
+
+      resolve(event.data);
+    };
+
+    const message: DSPProfileMessageEventData = { query };
+
+    processor.port.postMessage(message, [channel.port2]);
+  });
+}
+
+/**
+ * This function aggregates instrumentation of effectors into DSP load per effect.
+ * Effects whose instrumentation is not available (not instantiated yet) or not started (no calls) are not reported.
+ * @param {{ [name: string]: Profilable }} profilables This argument is effectors (or modules) that are processed by combined DSP module.
+ * @param {number} sampleRate This argument is sample rate of `AudioContext`.
+ * @return {Promise<DSPLoadReport>} Return value is `Promise` that resolves DSP load per effect, and sum of them.
+ */
+export function reportDSPLoad(profilables: { [name: string]: Profilable }, sampleRate: number): Promise<DSPLoadReport> {
+  const names = Object.keys(profilables);
+
+  return Promise.all(names.map((name: string) => profilables[name].stats()))
+    .then((profiles: (DSPProfile | null)[]) => {
+      // Milliseconds per render quantum
+      const budget = (1000 * RENDER_QUANTUM_SIZE) / sampleRate;
+
+      const report: DSPLoadReport = { effects: {}, load: 0, maxLoad: 0 };
+
+      profiles.forEach((profile: DSPProfile | null, index: number) => {
+        if ((profile === null) || (profile.calls === 0)) {
+          return;
+        }
+
+        const averageTime = profile.totalTime / profile.calls;
+
+        const load: DSPLoad = {
+          ...profile,
+          averageTime,
+          load   : averageTime / budget,
+          maxLoad: profile.maxTime / budget
+        };
+
+        report.effects[names[index]] = load;
+
+        report.load    += load.load;
+        report.maxLoad += load.maxLoad;
+      });
+
+      return report;
+    });
+}
+
 let instance: WebAssembly.Instance | null = null;
 
-WebAssembly.instantiateStreaming(fetch(wasm))
+WebAssembly.instantiateStreaming(fetch(isSIMDSupported() ? wasmSIMD : wasm), createClockImports(() => (instance === null) ? null : (instance.exports.memory as WebAssembly.Memory)))
   .then((source: WebAssembly.WebAssemblyInstantiatedSource) => {
     instance = source.instance;
   })
@@ -231,7 +557,7 @@ WebAssembly.instantiateStreaming(fetch(wasm))
  * This class (static) method executes FFT.
  * @param {Float32Array} reals This argument is instance of `Float32Array` for real number.
  * @param {Float32Array} imags This argument is instance of `Float32Array` for imaginary number.
- * @param {number} size This argument is FFT size (power of two).
+ * @param {number} size This argument is FFT size (2^a * 3^b * 5^c). If size has the other prime factor, `reals` and `imags` are not changed.
  */
 export function fft(reals: Float32Array, imags: Float32Array, size: number): void {
   if (instance === null) {
@@ -252,7 +578,9 @@ export function fft(reals: Float32Array, imags: Float32Array, size: number): voi
   realsLinearMemory.set(reals);
   imagsLinearMemory.set(imags);
 
-  wasm.FFT(size);
+  if (!wasm.FFT(size)) {
+    return;
+  }
 
   reals.set(realsLinearMemory);
   imags.set(imagsLinearMemory);
@@ -262,7 +590,7 @@ export function fft(reals: Float32Array, imags: Float32Array, size: number): voi
  * This class (static) method executes IFFT.
  * @param {Float32Array} reals This argument is instance of `Float32Array` for real number.
  * @param {Float32Array} imags This argument is instance of `Float32Array` for imaginary number.
- * @param {number} size This argument is IFFT size (power of two).
+ * @param {number} size This argument is IFFT size (2^a * 3^b * 5^c). If size has the other prime factor, `reals` and `imags` are not changed.
  */
 export function ifft(reals: Float32Array, imags: Float32Array, size: number): void {
   if (instance === null) {
@@ -283,7 +611,9 @@ export function ifft(reals: Float32Array, imags: Float32Array, size: number): vo
   realsLinearMemory.set(reals);
   imagsLinearMemory.set(imags);
 
-  wasm.IFFT(size);
+  if (!wasm.IFFT(size)) {
+    return;
+  }
 
   reals.set(realsLinearMemory);
   imags.set(imagsLinearMemory);
@@ -291,7 +621,7 @@ export function ifft(reals: Float32Array, imags: Float32Array, size: number): vo
 
 /**
  * This class (static) method gets amplitude spectrum or phase spectrum.
- * @param {Float32Array} data This argument is instance of `Float32Array` as input audio data. This size must be power of 2.
+ * @param {Float32Array} data This argument is instance of `Float32Array` as input audio data. This size must be 2^a * 3^b * 5^c.
  * @param {'amplitude'|'phase'} domain This argument is domain for selecting either amplitude spectrum or phase spectrum. The default is 'amplitude'.
  * @param {WindowFunction} windowFunctionType This argument is window function. The default value is 'hanning'.
  * @param {number} threshold This argument is amplitude threshold for phase spectrum. The default value is `0.05`.
@@ -342,6 +672,52 @@ export function spectrum(data: Float32Array, domain: 'amplitude' | 'phase' = 'am
   }
 }
 
+/**
+ * This class (static) method gets amplitude spectra of frames of the whole signal by one call (for waveform and spectrogram previews of tracks).
+ * Frame `i` starts at `i * hopSize` (the last frame is zero-padded). Each frame is the same as `spectrum(frame, 'amplitude', windowFunctionType)`.
+ * @param {Float32Array} data This argument is instance of `Float32Array` as input audio data.
+ * @param {number} frameSize This argument is frame size. This size must be even and half of this size must be 2^a * 3^b * 5^c.
+ * @param {number} hopSize This argument is interval between frames.
+ * @param {WindowFunction} windowFunctionType This argument is window function. The default value is 'hanning'.
+ * @param {boolean} decibels If this argument is `true`, amplitudes are converted as `toDecibels`. The default value is `false`.
+ * @return {Float32Array} Return value is instance of `Float32Array` that holds `frameSize / 2` amplitudes per frame contiguously.
+ *     If frame size or hop size is not valid, this is empty.
+ */
+export function spectrogram(data: Float32Array, frameSize: number, hopSize: number, windowFunctionType: WindowFunction = 'hanning', decibels = false): Float32Array {
+  if (instance === null) {
+    return new Float32Array(0);
+  }
+
+  // HACK:
+  const wasm = instance.exports as FFTWebAssemblyInstance;
+
+  // Same order as `SPECTROGRAM_WINDOW` in `FFT.cpp`
+  const windowFunctionTypes: WindowFunction[] = ['rect', 'hanning', 'hamming', 'blackman'];
+
+  const context = wasm.spectrogram_create(frameSize, hopSize, windowFunctionTypes.indexOf(windowFunctionType));
+
+  if (context === 0) {
+    return new Float32Array(0);
+  }
+
+  const offsetInputs = wasm.spectrogram_inputs(context, data.length);
+
+  // Linear memory may grow by allocations, so its buffer is got after them
+  new Float32Array(wasm.memory.buffer, offsetInputs, data.length).set(data);
+
+  const offsetOutputs = wasm.spectrogram_process(context, data.length, decibels);
+
+  const length = wasm.spectrogram_get_number_of_frames(context) * (frameSize / 2);
+
+  const amplitudes = new Float32Array(length);
+
+  amplitudes.set(new Float32Array(wasm.memory.buffer, offsetOutputs, length));
+
+  wasm.spectrogram_destroy(context);
+
+  return amplitudes;
+}
+
 /**
  * This class (static) method converts amplitude array (`-1` - `1`) to amplitude array (decibel unit).
  * @param {Float32Array} amplitudes This argument is instance of `Float32Array` which amplitude is no unit (`-1` - `1`).
@@ -4,6 +4,7 @@ import type { StereoEffector } from './SoundModule/Effectors/StereoEffector';
 import type { EnvelopeGenerator } from './SoundModule/Effectors/EnvelopeGenerator';
 import type { Oscillator } from './OscillatorModule/Oscillator';
 import type { Glide } from './OscillatorModule/Glide';
+import type { DSPProfile } from './XSound';
 
 /**
  * This interface is implemented by class that abstracts `AudioNode` connections (such as `Effector` class).
@@ -23,3 +24,21 @@ export interface Statable {
   activate(): Visualizer | Effector | StereoEffector | EnvelopeGenerator | Oscillator | Glide;
   deactivate(): Visualizer | Effector | StereoEffector | EnvelopeGenerator | Oscillator | Glide;
 }
+
+/**
+ * This interface is implemented by class that is processed by combined DSP module (instrumentation of kernels is opt-in).
+ * @interface
+ */
+export interface Profilable {
+  profile(enabled: boolean): void;
+  stats(): Promise<DSPProfile | null>;
+}
+
+/**
+ * This interface is implemented by class whose processing delays output (algorithmic latency of spectral kernels),
+ * so that mixer can delay parallel paths by latency (delay compensation).
+ * @interface
+ */
+export interface Compensable {
+  latency(): Promise<number>;
+}
@@ -56,13 +56,14 @@ import type { FilterParams } from './SoundModule/Effectors/Filter';
 import type { FlangerParams, FlangerType } from './SoundModule/Effectors/Flanger';
 import type { FuzzParams } from './SoundModule/Effectors/Fuzz';
 import type { HarmonizerParams, HarmonizerType, HarmonizerMode } from './SoundModule/Effectors/Harmonizer';
+import type { HarmonizerProcessorParams } from './SoundModule/Effectors/AudioWorkletProcessors/HarmonizerProcessor';
 import type { ListenerParams } from './SoundModule/Effectors/Listener';
 import type { NoiseGateParams } from './SoundModule/Effectors/NoiseGate';
 import type { NoiseSuppressorParams } from './SoundModule/Effectors/NoiseSuppressor';
 import type { OverDriveParams } from './SoundModule/Effectors/OverDrive';
 import type { PannerParams, Position3D } from './SoundModule/Effectors/Panner';
 import type { PhaserParams, PhaserType, PhaserNumberOfStages, PhaserFilterConnectionType } from './SoundModule/Effectors/Phaser';
-import type { PitchShifterParams } from './SoundModule/Effectors/PitchShifter';
+import type { PitchShifterParams, PitchShifterAlgorithm } from './SoundModule/Effectors/PitchShifter';
 import type { PreampParams, PreampType, PreampCurve } from './SoundModule/Effectors/Preamp';
 import type {
   Marshall,
@@ -87,11 +88,12 @@ import type { CabinetParams } from './SoundModule/Effectors/Preamps/Cabinet';
 import type { ReverbParams, ReverbErrorText } from './SoundModule/Effectors/Reverb';
 import type { RingmodulatorParams } from './SoundModule/Effectors/Ringmodulator';
 import type { SlicerParams, SlicerType } from './SoundModule/Effectors/Slicer';
+import type { SpectralChainParams, SpectralStageParams, SpectralEffector } from './SoundModule/Effectors/SpectralChain';
 import type { StereoParams } from './SoundModule/Effectors/Stereo';
 import type { TremoloParams, TremoloType } from './SoundModule/Effectors/Tremolo';
 import type { VocalCancelerParams, VocalCancelerAlgorithm } from './SoundModule/Effectors/VocalCanceler';
 import type { WahParams } from './SoundModule/Effectors/Wah';
-import type { PitchChar, ConvertedTime, FileEvent, FileReaderType, FileReaderErrorText, WindowFunction } from './XSound';
+import type { PitchChar, ConvertedTime, FileEvent, FileReaderType, FileReaderErrorText, WindowFunction, DSPProfile, DSPLoad, DSPLoadReport, DSPRenderEffect, DSPRenderOptions } from './XSound';
 import type { FrozenArray, Inputs, Outputs, Parameters } from './worklet';
 
 import './types';
@@ -131,13 +133,16 @@ import { Preamp } from './SoundModule/Effectors/Preamp';
 import { Reverb } from './SoundModule/Effectors/Reverb';
 import { Ringmodulator } from './SoundModule/Effectors/Ringmodulator';
 import { Slicer } from './SoundModule/Effectors/Slicer';
+import { SpectralChain } from './SoundModule/Effectors/SpectralChain';
 import { Stereo } from './SoundModule/Effectors/Stereo';
 import { Tremolo } from './SoundModule/Effectors/Tremolo';
 import { VocalCanceler } from './SoundModule/Effectors/VocalCanceler';
 import { Wah } from './SoundModule/Effectors/Wah';
+import { HarmonizerProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/HarmonizerProcessor';
 import { NoiseGateProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/NoiseGateProcessor';
 import { NoiseSuppressorProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/NoiseSuppressorProcessor';
 import { PitchShifterProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/PitchShifterProcessor';
+import { SpectralChainProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/SpectralChainProcessor';
 import { VocalCancelerProcessor } from './SoundModule/Effectors/AudioWorkletProcessors/VocalCancelerProcessor';
 import {
   EQUAL_TEMPERAMENT,
@@ -156,6 +161,7 @@ import {
   fft,
   ifft,
   spectrum,
+  spectrogram,
   toDecibels,
   fromDecibels,
   ajax,
@@ -168,7 +174,9 @@ import {
   drop,
   file,
   toFrequencies,
-  toTextFile
+  toTextFile,
+  reportDSPLoad,
+  renderDSP
 } from './XSound';
 import { addAudioWorklet } from './worklet';
 
@@ -207,9 +215,11 @@ const promise = Promise
     addAudioWorklet(audiocontext, MediaModuleProcessor),
     addAudioWorklet(audiocontext, StreamModuleProcessor),
     addAudioWorklet(audiocontext, MixerModuleProcessor),
+    addAudioWorklet(audiocontext, HarmonizerProcessor),
     addAudioWorklet(audiocontext, NoiseGateProcessor),
     addAudioWorklet(audiocontext, NoiseSuppressorProcessor),
     addAudioWorklet(audiocontext, PitchShifterProcessor),
+    addAudioWorklet(audiocontext, SpectralChainProcessor),
     addAudioWorklet(audiocontext, VocalCancelerProcessor)
   ])
   .then(() => {
@@ -320,6 +330,7 @@ XSound.windowFunction      = windowFunction;
 XSound.fft                 = fft;
 XSound.ifft                = ifft;
 XSound.spectrum            = spectrum;
+XSound.spectrogram         = spectrogram;
 XSound.toDecibels          = toDecibels;
 XSound.fromDecibels        = fromDecibels;
 XSound.ajax                = ajax;
@@ -333,6 +344,8 @@ XSound.drop                = drop;
 XSound.file                = file;
 XSound.toFrequencies       = toFrequencies;
 XSound.toTextFile          = toTextFile;
+XSound.reportDSPLoad       = reportDSPLoad;
+XSound.renderDSP           = renderDSP;
 
 // Export classes
 XSound.Analyser = Analyser;
@@ -692,6 +705,8 @@ export type {
   HarmonizerParams,
   HarmonizerType,
   HarmonizerMode,
+  HarmonizerProcessor,
+  HarmonizerProcessorParams,
   Listener,
   ListenerParams,
   NoiseGate,
@@ -712,6 +727,7 @@ export type {
   PhaserFilterConnectionType,
   PitchShifter,
   PitchShifterParams,
+  PitchShifterAlgorithm,
   PitchShifterProcessor,
   Preamp,
   PreampParams,
@@ -739,6 +755,11 @@ export type {
   Slicer,
   SlicerParams,
   SlicerType,
+  SpectralChain,
+  SpectralChainParams,
+  SpectralStageParams,
+  SpectralEffector,
+  SpectralChainProcessor,
   Stereo,
   StereoParams,
   Tremolo,
@@ -756,6 +777,11 @@ export type {
   FileReaderType,
   FileReaderErrorText,
   WindowFunction,
+  DSPProfile,
+  DSPLoad,
+  DSPLoadReport,
+  DSPRenderEffect,
+  DSPRenderOptions,
   FrozenArray,
   Inputs,
   Outputs,
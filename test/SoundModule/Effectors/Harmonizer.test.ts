@@ -36,7 +36,7 @@ describe(Harmonizer.name, () => {
 
       harmonizer.activate();
 
-      expect(inputConnectMock).toHaveBeenCalledTimes(3);
+      expect(inputConnectMock).toHaveBeenCalledTimes(2);
       expect(inputDisconnectMock).toHaveBeenCalledTimes(2);
     });
   });
@@ -93,4 +93,24 @@ describe(NoiseGate.name, () => {
       noisegate['processor'] = originalProcessor;
     });
   });
+
+  describe(noisegate.profile.name, () => {
+    test('should post message that starts instrumentation', () => {
+      // eslint-disable-next-line dot-notation
+      const originalPostMessage = noisegate['processor'].port.postMessage;
+
+      const postMessageMock = jest.fn();
+
+      // eslint-disable-next-line dot-notation
+      noisegate['processor'].port.postMessage = postMessageMock;
+
+      expect(noisegate.profile(true)).toBeInstanceOf(NoiseGate);
+
+      expect(postMessageMock).toHaveBeenCalledTimes(1);
+      expect(postMessageMock).toHaveBeenCalledWith({ profile: true });
+
+      // eslint-disable-next-line dot-notation
+      noisegate['processor'].port.postMessage = originalPostMessage;
+    });
+  });
 });
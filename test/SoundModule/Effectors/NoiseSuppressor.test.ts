@@ -35,13 +35,28 @@ describe(NoiseSuppressor.name, () => {
     test('should return `threshold`', () => {
       expect(noisesuppressor.param('threshold')).toBeCloseTo(0.03, 2);
     });
+
+    test('should post `lowLatency` to processor', () => {
+      // eslint-disable-next-line dot-notation
+      const postMessageMock = jest.spyOn(noisesuppressor['processor'].port, 'postMessage');
+
+      noisesuppressor.param({ lowLatency: true });
+
+      expect(noisesuppressor.param('lowLatency')).toBe(true);
+      expect(postMessageMock).toHaveBeenCalledWith({ lowLatency: true });
+
+      noisesuppressor.param({ lowLatency: false });
+
+      postMessageMock.mockRestore();
+    });
   });
 
   describe(noisesuppressor.params.name, () => {
     test('should return parameters for noise suppressor as associative array', () => {
       expect(noisesuppressor.params()).toStrictEqual({
-        state    : true,
-        threshold: 0
+        state     : true,
+        threshold : 0,
+        lowLatency: false
       });
     });
   });
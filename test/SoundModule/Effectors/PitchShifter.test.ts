@@ -61,17 +61,21 @@ describe(PitchShifter.name, () => {
 
   describe(pitchshifter.param.name, () => {
     const defaultParams: PitchShifterParams = {
-      pitch: 1,
-      speed: 1,
-      dry  : 0,
-      wet  : 1,
+      algorithm: 'peak',
+      pitch    : 1,
+      speed    : 1,
+      dry      : 0,
+      wet      : 1,
+      hopSize  : 128
     };
 
     const params: PitchShifterParams = {
-      pitch: 1.5,
-      speed: 0.7,
-      dry  : 0.8,
-      wet  : 0.2,
+      algorithm: 'vocoder',
+      pitch    : 1.5,
+      speed    : 0.7,
+      dry      : 0.8,
+      wet      : 0.2,
+      hopSize  : 512
     };
 
     beforeAll(() => {
@@ -88,6 +92,10 @@ describe(PitchShifter.name, () => {
     });
 
     // Getter
+    test('should return `algorithm`', () => {
+      expect(pitchshifter.param('algorithm')).toBe('vocoder');
+    });
+
     test('should return `pitch`', () => {
       expect(pitchshifter.param('pitch')).toBeCloseTo(1.5, 1);
     });
@@ -103,16 +111,44 @@ describe(PitchShifter.name, () => {
     test('should return `wet`', () => {
       expect(pitchshifter.param('wet')).toBeCloseTo(0.2, 1);
     });
+
+    test('should return `hopSize`', () => {
+      expect(pitchshifter.param('hopSize')).toBe(512);
+    });
+
+    test('should not set `hopSize` that is not power of two or is greater than a quarter of frame size', () => {
+      pitchshifter.param({ hopSize: 384 });
+      pitchshifter.param({ hopSize: 1024 });
+
+      expect(pitchshifter.param('hopSize')).toBe(512);
+    });
+
+    test('should reset `hopSize` that is greater than half of frame size in low-latency mode', () => {
+      pitchshifter.param({ lowLatency: true });
+
+      expect(pitchshifter.param('lowLatency')).toBe(true);
+      expect(pitchshifter.param('hopSize')).toBe(128);
+
+      pitchshifter.param({ hopSize: 512 });
+      pitchshifter.param({ hopSize: 256 });
+
+      expect(pitchshifter.param('hopSize')).toBe(256);
+
+      pitchshifter.param({ lowLatency: false, hopSize: 512 });
+    });
   });
 
   describe(pitchshifter.params.name, () => {
     test('should return parameters for pitch shifter as associative array', () => {
       expect(pitchshifter.params()).toStrictEqual({
-        state: false,
-        pitch: 1,
-        speed: 1,
-        dry  : 0,
-        wet  : 1
+        state     : false,
+        algorithm : 'peak',
+        pitch     : 1,
+        speed     : 1,
+        dry       : 0,
+        wet       : 1,
+        hopSize   : 128,
+        lowLatency: false
       });
     });
   });
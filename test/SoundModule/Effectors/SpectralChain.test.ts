@@ -0,0 +1,110 @@
+import { AudioContextMock } from '/mock/AudioContextMock';
+import { NoiseSuppressor } from '/src/SoundModule/Effectors/NoiseSuppressor';
+import { PitchShifter } from '/src/SoundModule/Effectors/PitchShifter';
+import { SpectralChain, isSpectralEffector } from '/src/SoundModule/Effectors/SpectralChain';
+
+describe(SpectralChain.name, () => {
+  const context = new AudioContextMock();
+
+  // @ts-expect-error Because there is not Web Audio API in Jest environment (Node.js environment), mocks Web Audio API
+  const chain = new SpectralChain(context);
+
+  // @ts-expect-error Because there is not Web Audio API in Jest environment (Node.js environment), mocks Web Audio API
+  const noisesuppressor = new NoiseSuppressor(context);
+
+  // @ts-expect-error Because there is not Web Audio API in Jest environment (Node.js environment), mocks Web Audio API
+  const pitchshifter = new PitchShifter(context);
+
+  beforeAll(() => {
+    // HACK:
+    // eslint-disable-next-line dot-notation
+    chain['loaded'] = true;
+
+    noisesuppressor.param({ threshold: 0.03 });
+    pitchshifter.param({ pitch: 1.5, hopSize: 256 });
+
+    chain.fuse([noisesuppressor, pitchshifter]);
+  });
+
+  afterAll(() => {
+    chain.fuse([]);
+
+    noisesuppressor.param({ threshold: 0 });
+    pitchshifter.param({ algorithm: 'peak', pitch: 1, hopSize: 128 });
+  });
+
+  describe('isSpectralEffector', () => {
+    test('should return `true` if module is spectral effector', () => {
+      expect(isSpectralEffector(noisesuppressor)).toBe(true);
+      expect(isSpectralEffector(pitchshifter)).toBe(true);
+      expect(isSpectralEffector(chain)).toBe(false);
+    });
+  });
+
+  describe(chain.params.name, () => {
+    test('should return stages of fused effectors in connection order', () => {
+      expect(chain.params()).toStrictEqual({
+        hopSize: 256,
+        stages : [
+          {
+            type     : 'noisesuppressor',
+            threshold: 0.03
+          },
+          {
+            type   : 'pitchshifter',
+            pitch  : 1.5,
+            speed  : 1,
+            dry    : 0,
+            wet    : 1,
+            hopSize: 256
+          }
+        ]
+      });
+    });
+  });
+
+  describe(chain.update.name, () => {
+    test('should update stage if parameter of fused effector is changed', () => {
+      noisesuppressor.param({ threshold: 0.05 });
+
+      expect(chain.params().stages[0]).toStrictEqual({
+        type     : 'noisesuppressor',
+        threshold: 0.05
+      });
+    });
+
+    test('should bypass stage if fused effector is not active', () => {
+      noisesuppressor.param({ state: false });
+
+      expect(chain.params().stages[0]).toStrictEqual({
+        type     : 'noisesuppressor',
+        threshold: 0
+      });
+
+      noisesuppressor.param({ state: true });
+    });
+
+    test('should connect effectors in series if either effector can not be fused', () => {
+      const originalConnect = chain.connect;
+
+      const connectMock = jest.fn();
+
+      chain.connect = connectMock;
+
+      pitchshifter.param({ algorithm: 'vocoder' });
+
+      // HACK:
+      // eslint-disable-next-line dot-notation
+      expect(chain['fused']).toBe(false);
+      expect(connectMock).toHaveBeenCalledTimes(1);
+
+      pitchshifter.param({ algorithm: 'peak' });
+
+      // eslint-disable-next-line dot-notation
+      expect(chain['fused']).toBe(true);
+      expect(connectMock).toHaveBeenCalledTimes(2);
+
+      chain.connect = originalConnect;
+    });
+  });
+});
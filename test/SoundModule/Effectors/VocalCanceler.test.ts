@@ -69,7 +69,8 @@ describe(VocalCanceler.name, () => {
         depth       : 0,
         minFrequency: 200,
         maxFrequency: 8000,
-        threshold   : 0.05
+        threshold   : 0.05,
+        lowLatency  : false
       });
     });
   });
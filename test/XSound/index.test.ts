@@ -1,4 +1,4 @@
-import type { FileEvent, FFTWebAssemblyInstance } from '/src/XSound';
+import type { FileEvent, FFTWebAssemblyInstance, DSPProfile } from '/src/XSound';
 
 import { AudioContextMock } from '/mock/AudioContextMock';
 import {
@@ -8,6 +8,11 @@ import {
   computeHz,
   computePlaybackRate,
   windowFunction,
+  isSIMDSupported,
+  createClockImports,
+  compileDSPModule,
+  reportDSPLoad,
+  renderDSP,
   fft,
   ifft,
   toDecibels,
@@ -129,6 +134,112 @@ describe(windowFunction.name, () => {
   });
 });
 
+describe(isSIMDSupported.name, () => {
+  test('should return `true` if WebAssembly SIMD is supported', () => {
+    expect(isSIMDSupported()).toBe(true);
+  });
+});
+
+describe(compileDSPModule.name, () => {
+  test('should compile combined DSP module only once', async () => {
+    const promise = compileDSPModule();
+
+    expect(compileDSPModule()).toBe(promise);
+
+    await promise;
+
+    expect(compileDSPModule()).toBe(promise);
+  });
+});
+
+describe(reportDSPLoad.name, () => {
+  const stats = (profile: DSPProfile | null) => {
+    return {
+      profile: () => {},
+      stats  : () => Promise.resolve(profile)
+    };
+  };
+
+  test('should report DSP load per effect', async () => {
+    // Render quantum is 128 / 12800 Hz = 10 ms
+    const report = await reportDSPLoad({
+      noisegate      : stats({ calls: 4, totalTime: 8, maxTime: 5, allocations: 0, skippedFrames: 0 }),
+      noisesuppressor: stats({ calls: 2, totalTime: 2, maxTime: 1, allocations: 1, skippedFrames: 3 }),
+      pitchshifter   : stats({ calls: 0, totalTime: 0, maxTime: 0, allocations: 0, skippedFrames: 0 }),
+      vocalcanceler  : stats(null)
+    }, 12800);
+
+    expect(Object.keys(report.effects)).toStrictEqual(['noisegate', 'noisesuppressor']);
+
+    expect(report.effects.noisegate.averageTime).toBeCloseTo(2, 6);
+    expect(report.effects.noisegate.load).toBeCloseTo(0.2, 6);
+    expect(report.effects.noisegate.maxLoad).toBeCloseTo(0.5, 6);
+    expect(report.effects.noisesuppressor.load).toBeCloseTo(0.1, 6);
+    expect(report.effects.noisesuppressor.allocations).toBe(1);
+    expect(report.effects.noisesuppressor.skippedFrames).toBe(3);
+
+    expect(report.load).toBeCloseTo(0.3, 6);
+    expect(report.maxLoad).toBeCloseTo(0.6, 6);
+  });
+});
+
+describe(renderDSP.name, () => {
+  test('should render planar signal by `*_render` of combined DSP module', async () => {
+    const memory = new WebAssembly.Memory({ initial: 1 });
+
+    // Kernel doubles samples (outputs follow inputs in linear memory)
+    const exports = {
+      memory,
+      pitchshifter_create                : jest.fn(() => 1),
+      pitchshifter_set_number_of_channels: jest.fn(),
+      pitchshifter_render_inputs         : jest.fn(() => 0),
+      pitchshifter_render                : jest.fn((context: number, length: number) => {
+        const samples = new Float32Array(memory.buffer);
+
+        for (let n = 0; n < (2 * length); n++) {
+          samples[(2 * length) + n] = 2 * samples[n];
+        }
+
+        return 2 * length * Float32Array.BYTES_PER_ELEMENT;
+      }),
+      pitchshifter_destroy: jest.fn()
+    };
+
+    // Page is not cross-origin isolated, so `dsp.wasm` is instantiated (jobs are rendered on the calling thread)
+    const instantiateMock = jest.spyOn(WebAssembly, 'instantiate').mockImplementation(() => Promise.resolve({ exports } as unknown as WebAssembly.Instance));
+
+    const channels = await renderDSP([new Float32Array([1, 2, 3, 4]), new Float32Array([-1, -2, -3, -4])], { type: 'pitchshifter', pitch: 1.5 }, { threadsURL: '/build/dsp.pthread.mjs', numberOfThreads: 2 });
+
+    instantiateMock.mockRestore();
+
+    expect(exports.pitchshifter_create).toHaveBeenCalledWith(2048);
+    expect(exports.pitchshifter_set_number_of_channels).toHaveBeenCalledWith(1, 2);
+    expect(exports.pitchshifter_render).toHaveBeenCalledWith(1, 4, 1.5, 1, 0, 1, 2);
+    expect(exports.pitchshifter_destroy).toHaveBeenCalledWith(1);
+
+    expect(channels).toStrictEqual([new Float32Array([2, 4, 6, 8]), new Float32Array([-2, -4, -6, -8])]);
+  });
+});
+
+describe(createClockImports.name, () => {
+  test('should pass clock of main thread', () => {
+    const memory  = new WebAssembly.Memory({ initial: 1 });
+    const imports = createClockImports(() => memory);
+
+    jest.spyOn(performance, 'now').mockReturnValue(1.5);
+
+    // HACK:
+    const env  = imports.env as { emscripten_get_now: () => number };
+    const wasi = imports.wasi_snapshot_preview1 as { clock_time_get: (id: number, precision: bigint, offset: number) => number };
+
+    expect(env.emscripten_get_now()).toBeCloseTo(1.5, 6);
+    expect(wasi.clock_time_get(1, 1000n, 8)).toBe(0);
+    expect(new DataView(memory.buffer).getBigUint64(8, true)).toBe(1500000n);
+
+    jest.restoreAllMocks();
+  });
+});
+
 describe(`${fft.name} and ${ifft.name}`, () => {
   const reals = new Float32Array([Math.sin(0), Math.sin(1), Math.sin(2), Math.sin(3)]);
   const imags = new Float32Array([0, 0, 0, 0]);
@@ -138,9 +249,14 @@ describe(`${fft.name} and ${ifft.name}`, () => {
   const buffer  = fs.readFileSync(`${dirname}/src/XSound/WebAssemblyModules/FFT.wasm`);
 
   test('should set `Float32Array`', async () => {
-    const source = await WebAssembly.instantiate(new Uint8Array(buffer));
+    let memory: WebAssembly.Memory | null = null;
+
+    // FFT plans are measured by imported clock (`fft_plan_measure`)
+    const source = await WebAssembly.instantiate(new Uint8Array(buffer), createClockImports(() => memory));
     const wasm   = source.instance.exports as FFTWebAssemblyInstance;  // HACK:
 
+    memory = wasm.memory;
+
     const { FFT, IFFT } = wasm;
 
     const linearMemory = wasm.memory.buffer;
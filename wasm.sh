@@ -2,12 +2,23 @@
 
 # Usage: ./wasm.sh src/**/*.cpp
 
-echo "rm -f src/**/*.wasm"
-rm -f src/**/*.wasm
+echo "rm -f src/**/*.wasm src/**/*.pthread.mjs"
+rm -f src/**/*.wasm src/**/*.pthread.mjs
+
+# Offline rendering on worker threads (`render.hpp`) needs SharedArrayBuffer and JavaScript of Emscripten that creates workers,
+# so modules that include it are built with `-pthread` too (ES Module factory, used by `renderDSP`)
+pthread_flags="-pthread -sMODULARIZE=1 -sEXPORT_ES6=1 -sENVIRONMENT=web,worker -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency -sALLOW_MEMORY_GROWTH=1 -sEXPORTED_RUNTIME_METHODS=HEAPF32"
 
 for source in "$@"
 do
   target=$(echo "${source}" | sed 's/\.cpp$//')
   echo "emcc -O3 -Wall --no-entry -o ${target}.wasm ${source}"
   emcc -O3 -Wall --no-entry -o "${target}.wasm" "${source}"
+  echo "emcc -O3 -Wall -msimd128 --no-entry -o ${target}.simd.wasm ${source}"
+  emcc -O3 -Wall -msimd128 --no-entry -o "${target}.simd.wasm" "${source}"
+
+  if grep -q '#include "render.hpp"' "${source}"; then
+    echo "emcc -O3 -Wall -msimd128 ${pthread_flags} --no-entry -o ${target}.pthread.mjs ${source}"
+    emcc -O3 -Wall -msimd128 ${pthread_flags} --no-entry -o "${target}.pthread.mjs" "${source}"
+  fi
 done